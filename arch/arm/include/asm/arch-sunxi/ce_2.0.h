@@ -153,7 +153,8 @@ typedef struct descriptor_queue {
 	uint padding[(ALIGN(176, CACHE_LINE_SIZE) - 176) / sizeof(uint)];
 } task_queue;
 
-#if defined(SHA256_MULTISTEP_PACKAGE) || defined(SHA512_MULTISTEP_PACKAGE)
+#if defined(SHA256_MULTISTEP_PACKAGE) || defined(SHA512_MULTISTEP_PACKAGE) || \
+	defined(CONFIG_SUNXI_CE_SHA256_MULTISTEP)
 int sunxi_hash_init(u8 *dst_addr, u8 *src_addr, u32 src_len, u32 total_len);
 int sunxi_hash_update(u8 *dst_addr, u8 *src_addr, u32 src_len, u32 total_len);
 int sunxi_hash_final(u8 *dst_addr, u8 *src_addr, u32 src_len, u32 total_len);
@@ -0,0 +1,45 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * State the secondary cores pick up when they enter the worker pool
+ */
+
+#ifndef _SUNXI_WORKER_H
+#define _SUNXI_WORKER_H
+
+/* offsets in struct sunxi_worker_boot, used by worker_entry.S */
+#define SUNXI_WORKER_TTBR0	0x00
+#define SUNXI_WORKER_TTBCR	0x04
+#define SUNXI_WORKER_DACR	0x08
+#define SUNXI_WORKER_VBAR	0x0c
+#define SUNXI_WORKER_SCTLR	0x10
+#define SUNXI_WORKER_GD		0x14
+#define SUNXI_WORKER_STACK	0x18
+
+#ifndef __ASSEMBLY__
+
+#include <linux/types.h>
+
+/*
+ * copied from the boot core, the secondary core reads it with the MMU
+ * and caches still off
+ */
+struct sunxi_worker_boot {
+	u32 ttbr0;
+	u32 ttbcr;
+	u32 dacr;
+	u32 vbar;
+	u32 sctlr;
+	u32 gd;
+	u32 stack[CONFIG_WORKER_POOL_CPUS];	/* top, by core in the cluster */
+};
+
+extern struct sunxi_worker_boot sunxi_worker_boot;
+
+void sunxi_worker_entry(void);
+
+#endif /* __ASSEMBLY__ */
+
+#endif /* _SUNXI_WORKER_H */
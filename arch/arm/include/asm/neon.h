@@ -0,0 +1,23 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ */
+
+#ifndef __ASM_ARM_NEON_H
+#define __ASM_ARM_NEON_H
+
+/**
+ * arm_neon_enable() - Give U-Boot access to VFP/NEON
+ *
+ * U-Boot leaves VFP/NEON off and builds C code without it, so only
+ * assembly routines use the registers, saving d8-d15 as the AAPCS
+ * wants. Access is per core, call this on each core before the first
+ * such routine runs there.
+ *
+ * @return true if NEON can be used, false if the CPU has none or the
+ *	secure side keeps cp10/cp11 to itself (NSACR)
+ */
+bool arm_neon_enable(void);
+
+#endif /* __ASM_ARM_NEON_H */
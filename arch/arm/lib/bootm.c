@@ -26,6 +26,7 @@
 #include <linux/compiler.h>
 #include <bootm.h>
 #include <vxworks.h>
+#include <worker_pool.h>
 
 #ifdef CONFIG_ARMV7_NONSEC
 #include <asm/armv7.h>
@@ -92,6 +93,13 @@ static void announce_and_cleanup(int fake)
 #ifdef CONFIG_BOOTSTAGE_FDT
 	bootstage_fdt_add_report();
 #endif
+#ifdef CONFIG_BOOTSTAGE_STASH
+	/* keep the kernel off the stash so it can be read after boot */
+	if (!bootstage_stash((void *)CONFIG_BOOTSTAGE_STASH_ADDR,
+			     CONFIG_BOOTSTAGE_STASH_SIZE) && working_fdt)
+		fdt_add_mem_rsv(working_fdt, CONFIG_BOOTSTAGE_STASH_ADDR,
+				CONFIG_BOOTSTAGE_STASH_SIZE);
+#endif
 #ifdef CONFIG_BOOTSTAGE_REPORT
 	bootstage_report();
 #endif
@@ -101,6 +109,8 @@ static void announce_and_cleanup(int fake)
 #endif
 
 	board_quiesce_devices();
+	/* the kernel brings the secondary cores up itself */
+	worker_pool_stop();
 
 	/*
 	 * Call remove function of all devices with a removal flag set.
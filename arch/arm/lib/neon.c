@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ */
+
+#include <common.h>
+#include <asm/barriers.h>
+#include <asm/neon.h>
+#include <decomp_fast.h>
+
+#define CPACR_CP10_CP11		(0xf << 20)	/* full access to VFP/NEON */
+#define FPEXC_EN		BIT(30)
+#define MVFR1_SIMDLS(v)		(((v) >> 8) & 0xf)
+#define MVFR1_SIMDINT(v)	(((v) >> 12) & 0xf)
+
+bool arm_neon_enable(void)
+{
+	u32 val;
+
+	asm volatile("mrc p15, 0, %0, c1, c0, 2" : "=r" (val));
+	if ((val & CPACR_CP10_CP11) != CPACR_CP10_CP11) {
+		val |= CPACR_CP10_CP11;
+		asm volatile("mcr p15, 0, %0, c1, c0, 2" : : "r" (val));
+		isb();
+		asm volatile("mrc p15, 0, %0, c1, c0, 2" : "=r" (val));
+		if ((val & CPACR_CP10_CP11) != CPACR_CP10_CP11)
+			return false;
+	}
+
+	/* VFP system registers by number, the compiler knows no FPU */
+	asm volatile("mrc p10, 7, %0, cr8, cr0, 0" : "=r" (val));	/* FPEXC */
+	if (!(val & FPEXC_EN)) {
+		val |= FPEXC_EN;
+		asm volatile("mcr p10, 7, %0, cr8, cr0, 0" : : "r" (val));
+		isb();
+	}
+	asm volatile("mrc p10, 7, %0, cr6, cr0, 0" : "=r" (val));	/* MVFR1 */
+
+	return MVFR1_SIMDLS(val) && MVFR1_SIMDINT(val);
+}
+
+#if CONFIG_IS_ENABLED(DECOMP_NEON)
+/* the copies in decomp_neon.S */
+bool decomp_fast_probe(void)
+{
+	return arm_neon_enable();
+}
+#endif
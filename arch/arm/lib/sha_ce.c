@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * ARMv8 Crypto Extensions in AArch32 for lib/sha1.c and lib/sha256.c,
+ * the block functions are in sha1_ce.S and sha256_ce.S
+ */
+
+#include <common.h>
+#include <asm/neon.h>
+#include <u-boot/sha_arch.h>
+
+#define ID_ISAR5_SHA1_SHIFT	8
+#define ID_ISAR5_SHA2_SHIFT	12
+
+static u32 sha_ce_read_isar5(void)
+{
+	u32 val;
+
+	asm volatile("mrc p15, 0, %0, c0, c2, 5" : "=r" (val));
+
+	return val;
+}
+
+unsigned int sha_arch_probe(void)
+{
+	u32 isar5 = sha_ce_read_isar5();
+	unsigned int algs = 0;
+
+	if ((isar5 >> ID_ISAR5_SHA1_SHIFT) & 0xf)
+		algs |= BIT(SHA_ARCH_SHA1);
+	if ((isar5 >> ID_ISAR5_SHA2_SHIFT) & 0xf)
+		algs |= BIT(SHA_ARCH_SHA256);
+
+	if (algs && !arm_neon_enable()) {
+		debug("sha: no access to NEON, crypto extensions unused\n");
+		return 0;
+	}
+
+	return algs;
+}
+
+const char *sha_arch_name(void)
+{
+	return "armv8-ce";
+}
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Worker pool on sunxi: the other cores of the boot cluster are started
+ * with PSCI CPU_ON at sunxi_worker_entry and leave with CPU_OFF. The
+ * secure firmware makes a core coherent before it hands it over, as it
+ * does for the kernel, so jobs share memory with the boot core as is.
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <smc.h>
+#include <worker_pool.h>
+#include <asm/cache.h>
+#include <asm/system.h>
+#include <asm/arch/worker.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define SUNXI_WORKER_STACK_SIZE	(16 * 1024)
+/* ms a core gets to power down once it left the pool */
+#define SUNXI_WORKER_OFF_TIMEOUT	100
+
+struct sunxi_worker_boot sunxi_worker_boot __aligned(ARCH_DMA_MINALIGN);
+
+static u32 sunxi_worker_mpidr(void)
+{
+	u32 val;
+
+	asm volatile("mrc p15, 0, %0, c0, c0, 5" : "=r" (val));
+
+	return val;
+}
+
+static void sunxi_worker_save(struct sunxi_worker_boot *wb)
+{
+	asm volatile("mrc p15, 0, %0, c2, c0, 0" : "=r" (wb->ttbr0));
+	asm volatile("mrc p15, 0, %0, c2, c0, 2" : "=r" (wb->ttbcr));
+	asm volatile("mrc p15, 0, %0, c12, c0, 0" : "=r" (wb->vbar));
+	wb->dacr = get_dacr();
+	wb->sctlr = get_cr();
+	wb->gd = (u32)gd;
+}
+
+int arch_worker_start(int id)
+{
+	struct sunxi_worker_boot *wb = &sunxi_worker_boot;
+	void *stack;
+
+	/* worker ids are the cores of the cluster, the boot one is core 0 */
+	if (sunxi_worker_mpidr() & 0xff)
+		return -ENODEV;
+
+	if (!wb->gd)
+		sunxi_worker_save(wb);
+	if (!wb->stack[id]) {
+		stack = memalign(ARCH_DMA_MINALIGN, SUNXI_WORKER_STACK_SIZE);
+		if (!stack)
+			return -ENOMEM;
+		wb->stack[id] = (u32)stack + SUNXI_WORKER_STACK_SIZE;
+	}
+	/* the core reads it before its caches are on */
+	flush_dcache_range((ulong)wb,
+			   (ulong)wb + roundup(sizeof(*wb), ARCH_DMA_MINALIGN));
+
+	if (arm_svc_set_cpu_on((sunxi_worker_mpidr() & 0xff00) | id,
+			       (uint)sunxi_worker_entry))
+		return -EIO;
+
+	return 0;
+}
+
+void arch_worker_exit(int id)
+{
+	arm_svc_set_cpu_off(id);
+}
+
+void arch_worker_stopped(int id)
+{
+	u32 mpidr = (sunxi_worker_mpidr() & 0xff00) | id;
+	ulong start = get_timer(0);
+
+	/* the kernel starts the core again, it must really be off by then */
+	while (arm_svc_cpu_affinity(mpidr) == 0 &&
+	       get_timer(start) < SUNXI_WORKER_OFF_TIMEOUT)
+		;
+}
+
+void arch_worker_wait(void)
+{
+	asm volatile("wfe" : : : "memory");
+}
+
+void arch_worker_wake(void)
+{
+	dsb();
+	asm volatile("sev" : : : "memory");
+}
@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Worker pool on sandbox: host threads stand in for the secondary cores
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <os.h>
+#include <worker_pool.h>
+
+static void *sandbox_worker(void *arg)
+{
+	worker_pool_main((long)arg);
+
+	return NULL;
+}
+
+int arch_worker_start(int id)
+{
+	if (id >= os_cpu_count())
+		return -ENODEV;
+
+	return os_thread_start(sandbox_worker, (void *)(long)id);
+}
+
+void arch_worker_wait(void)
+{
+	os_thread_yield();
+}
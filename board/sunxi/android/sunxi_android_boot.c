@@ -78,6 +78,8 @@ int sunxi_android_boot(const char *image_name, ulong os_load_addr)
 {
 	uint count		= 0;
 	uint wait_for_power_key = 1;
+
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "sunxi_android_boot");
 	if (gd->securemode) {
 		/* ORANGE, indicating a device may be freely modified.
 		 * Device integrity is left to the user to verify out-of-band.
@@ -6,6 +6,7 @@
 
 #include <common.h>
 #include <sys_partition.h>
+#include <hash_sg.h>
 #include <asm/arch/ce.h>
 #include <sunxi_avb.h>
 #include <sunxi_verify_boot_info.h>
@@ -327,6 +328,7 @@ int sunxi_vbmeta_self_verify(const uint8_t *meta_data, size_t meta_data_size,
 	const uint8_t *self_sign_key;
 	uint8_t hash_result[32];
 	uint32_t total_len;
+	struct hash_sg sg[2];
 	AvbRSAPublicKeyHeader key_h;
 
 	memcpy(&h, meta_data, sizeof(AvbVBMetaImageHeader));
@@ -353,17 +355,15 @@ int sunxi_vbmeta_self_verify(const uint8_t *meta_data, size_t meta_data_size,
 
 	sunxi_ss_open();
 
-	total_len = sizeof(AvbVBMetaImageHeader) + h.auxiliary_data_block_size;
-	uint8_t *hash_cal_buf = memalign(
-		CACHE_LINE_SIZE, total_len + CONFIG_SUNXI_SHA_CAL_PADDING);
-	if (hash_cal_buf == NULL) {
-		pr_error("not enough memory\n");
+	/* header and auxiliary block hashed in place, around the auth block */
+	sg[0].addr = header_block;
+	sg[0].len  = sizeof(AvbVBMetaImageHeader);
+	sg[1].addr = auxiliary_block;
+	sg[1].len  = h.auxiliary_data_block_size;
+	if (hash_sg_sha256(sg, ARRAY_SIZE(sg), hash_result)) {
+		pr_error("vbmeta hash failed\n");
+		return -1;
 	}
-	memcpy(hash_cal_buf, header_block, sizeof(AvbVBMetaImageHeader));
-	memcpy(hash_cal_buf + sizeof(AvbVBMetaImageHeader), auxiliary_block,
-	       h.auxiliary_data_block_size);
-	sunxi_sha_calc(hash_result, 32, hash_cal_buf, total_len);
-	free(hash_cal_buf);
 
 	if (memcmp(authentication_block + h.hash_offset, hash_result, 32) !=
 	    0) {
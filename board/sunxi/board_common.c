@@ -767,10 +767,18 @@ int board_late_init(void)
 			ubi_nand_update_ubi_env();
 		else
 #endif
-		sunxi_update_partinfo();
+		{
+			bootstage_start(BOOTSTAGE_ID_ACCUM_SUNXI_PARTINFO,
+					"sunxi_partinfo");
+			sunxi_update_partinfo();
+			bootstage_accum(BOOTSTAGE_ID_ACCUM_SUNXI_PARTINFO);
+		}
+		bootstage_start(BOOTSTAGE_ID_ACCUM_SUNXI_ROTPK, "sunxi_rotpk");
 		if (sunxi_update_rotpk_info()) {
+			bootstage_accum(BOOTSTAGE_ID_ACCUM_SUNXI_ROTPK);
 			return -1;
 		}
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_SUNXI_ROTPK);
 #ifdef CONFIG_SUNXI_POWER
 #ifdef CONFIG_SUNXI_BMU
 		axp_battery_status_handle();
@@ -784,6 +792,7 @@ int board_late_init(void)
 #ifdef CONFIG_SUNXI_LRADC_VOL
 		sunxi_read_lradc_vol();
 #endif
+		bootstage_start(BOOTSTAGE_ID_ACCUM_SUNXI_FDT, "sunxi_fdt_update");
 #if !defined(CONFIG_OF_SEPARATE)
 		sunxi_update_fdt_para_for_kernel();
 #elif defined(CONFIG_SUNXI_NECESSARY_REPLACE_FDT)
@@ -793,6 +802,7 @@ int board_late_init(void)
 		sunxi_replace_fdt();
 		sunxi_update_fdt_para_for_kernel();
 #endif
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_SUNXI_FDT);
 #ifdef CONFIG_SUNXI_TV_FASTLOGO
 		if (p_fastlogo) {
 			p_fastlogo->reserve_memory(p_fastlogo);
@@ -11,6 +11,8 @@
 #include <sunxi_board.h>
 #include <sunxi_flash.h>
 #include <fdt_support.h>
+#include <fdt_index.h>
+#include <of_live_fixup.h>
 #include <blk.h>
 #include <part.h>
 #include <asm/arch/rtc.h>
@@ -45,6 +47,99 @@ DECLARE_GLOBAL_DATA_PTR;
 
 int disp_update_lcd_param(int lcd_param_index);
 
+/*
+ * Fixups of the tree for the kernel between sunxi_fdt_fixup_begin() and
+ * sunxi_fdt_fixup_end() are made on a live tree, written back to the blob
+ * once at the end with the result the same fdt_setprop() and
+ * fdt_add_mem_rsv() calls give. Without a live tree they go to the blob.
+ */
+static void *sunxi_fixup_fdt;
+#if CONFIG_IS_ENABLED(OF_LIVE_FIXUP)
+static struct of_live_fixup sunxi_fixup;
+static bool sunxi_fixup_live;
+#endif
+
+static void sunxi_fdt_fixup_begin(void *fdt)
+{
+	__maybe_unused int ret;
+
+	sunxi_fixup_fdt = fdt;
+#if CONFIG_IS_ENABLED(OF_LIVE_FIXUP)
+	ret = of_live_fixup_open(&sunxi_fixup, fdt);
+
+	if (ret)
+		pr_err("## fdt live fixup: %s\n", fdt_strerror(ret));
+	sunxi_fixup_live = !ret;
+#endif
+}
+
+static int sunxi_fdt_fixup_end(void)
+{
+#if CONFIG_IS_ENABLED(OF_LIVE_FIXUP)
+	int ret;
+
+	if (!sunxi_fixup_live)
+		return 0;
+	sunxi_fixup_live = false;
+	ret = of_live_fixup_close(&sunxi_fixup);
+	if (ret)
+		pr_err("## error: %s : %s\n", __func__, fdt_strerror(ret));
+	return ret;
+#else
+	return 0;
+#endif
+}
+
+/* 0 if there is a node at @path, or the libfdt error of its lookup */
+static int sunxi_fdt_fixup_find_node(const char *path)
+{
+#if CONFIG_IS_ENABLED(OF_LIVE_FIXUP)
+	if (sunxi_fixup_live && of_live_fixup_find_node(&sunxi_fixup, path))
+		return 0;
+#endif
+	/* the blob is left alone until the end of the fixups */
+	return min(fdt_index_path_offset(sunxi_fixup_fdt, path), 0);
+}
+
+static int sunxi_fdt_fixup_setprop(const char *path, const char *name,
+				   const void *val, int len)
+{
+	int nodeoffset;
+
+#if CONFIG_IS_ENABLED(OF_LIVE_FIXUP)
+	struct device_node *np;
+
+	if (sunxi_fixup_live) {
+		np = of_live_fixup_find_node(&sunxi_fixup, path);
+		if (!np)
+			return sunxi_fdt_fixup_find_node(path) ?:
+			       -FDT_ERR_NOTFOUND;
+		return of_live_fixup_setprop(&sunxi_fixup, np, name, val, len);
+	}
+#endif
+	nodeoffset = fdt_index_path_offset(sunxi_fixup_fdt, path);
+	if (nodeoffset < 0)
+		return nodeoffset;
+	return fdt_setprop(sunxi_fixup_fdt, nodeoffset, name, val, len);
+}
+
+static int sunxi_fdt_fixup_setprop_u32(const char *path, const char *name,
+				       u32 val)
+{
+	fdt32_t tmp = cpu_to_fdt32(val);
+
+	return sunxi_fdt_fixup_setprop(path, name, &tmp, sizeof(tmp));
+}
+
+static __maybe_unused int sunxi_fdt_fixup_add_mem_rsv(u64 addr, u64 size)
+{
+#if CONFIG_IS_ENABLED(OF_LIVE_FIXUP)
+	if (sunxi_fixup_live)
+		return of_live_fixup_add_mem_rsv(&sunxi_fixup, addr, size);
+#endif
+	return fdt_add_mem_rsv(sunxi_fixup_fdt, addr, size);
+}
+
 int update_fdt_dram_para(void *dtb_base)
 {
 	/*fix dram para*/
@@ -60,28 +155,30 @@ int update_fdt_dram_para(void *dtb_base)
 		return -1;
 	}
 
-	nodeoffset = fdt_path_offset(dtb_base, "/dram");
+	sunxi_fdt_fixup_begin(dtb_base);
+	nodeoffset = sunxi_fdt_fixup_find_node("/dram");
 	if (nodeoffset < 0) {
 		pr_err("## error: %s : %s\n", __func__, fdt_strerror(nodeoffset));
+		sunxi_fdt_fixup_end();
 		return -1;
 	}
 	for (i = 31; i >= 0; i--) {
 		sprintf(dram_str, "dram_para[%02d]", i);
-		fdt_setprop_u32(dtb_base, nodeoffset, dram_str, dram_para[i]);
+		sunxi_fdt_fixup_setprop_u32("/dram", dram_str, dram_para[i]);
 	}
+	if (sunxi_fdt_fixup_end())
+		return -1;
 	pr_msg("update dtb dram  end\n");
 	return 0;
 }
 
 static int fdt_enable_node(char *name, int onoff)
 {
-	int nodeoffset = 0;
+	const char *status = onoff ? "okay" : "disabled";
 	int ret = 0;
 
-	nodeoffset = fdt_path_offset(working_fdt, name);
-	ret = fdt_set_node_status(working_fdt, nodeoffset,
-		onoff ? FDT_STATUS_OKAY: FDT_STATUS_DISABLED, 0);
-
+	ret = sunxi_fdt_fixup_setprop(name, "status", status,
+				      strlen(status) + 1);
 	if (ret < 0) {
 		printf("disable nand error: %s\n", fdt_strerror(ret));
 	}
@@ -673,7 +770,7 @@ int check_printmode(void)
 int open_autoprint(void)
 {
 	int nodeoffset, err;
-	nodeoffset = fdt_path_offset(working_fdt, "/soc/auto_print");
+	nodeoffset = fdt_index_path_offset(working_fdt, "/soc/auto_print");
 	if (nodeoffset < 0) {
 		pr_err("libfdt fdt_path_offset() returned %s\n",
 		       fdt_strerror(nodeoffset));
@@ -721,10 +818,11 @@ int sunxi_update_fdt_para_for_kernel(void)
 		}
 	}
 #endif
+	sunxi_fdt_fixup_begin(working_fdt);
 	/* creat udc dbt para when in charger_mode */
 	if (gd->chargemode == 1) {
-		fdt_find_and_setprop(working_fdt, "/soc/udc-controller",
-					"charger_mode", NULL, 0, 1);
+		sunxi_fdt_fixup_setprop("/soc/udc-controller", "charger_mode",
+					NULL, 0);
 	}
 
 	/* fix nand&sdmmc */
@@ -775,10 +873,13 @@ int sunxi_update_fdt_para_for_kernel(void)
 				fdt_enable_node("mmc2", 1);
 				fdt_enable_node("sunxi-mmc2", 1);
 #ifdef CONFIG_SUNXI_SDMMC
+				/* writes the blob */
+				sunxi_fdt_fixup_end();
 				mmc_update_config_for_dragonboard(2);
 #ifdef CONFIG_MMC3_SUPPORT
 				mmc_update_config_for_dragonboard(3);
 #endif
+				sunxi_fdt_fixup_begin(working_fdt);
 #endif
 			}
 		}
@@ -797,7 +898,7 @@ int sunxi_update_fdt_para_for_kernel(void)
 		if (!smc_tee_probe_drm_configure(&drm_base, &drm_size)) {
 			pr_msg("drm_base=0x%lx\n", drm_base);
 			pr_msg("drm_size=0x%lx\n", drm_size);
-			ret = fdt_add_mem_rsv(working_fdt, drm_base, drm_size);
+			ret = sunxi_fdt_fixup_add_mem_rsv(drm_base, drm_size);
 			if (ret)
 				pr_err("##add mem rsv error: %s : %s\n",
 				       __func__, fdt_strerror(ret));
@@ -809,8 +910,8 @@ int sunxi_update_fdt_para_for_kernel(void)
 	if (os_memory_info.shm_size) {
 		pr_msg("shm_base=0x%lx\n", os_memory_info.shm_base);
 		pr_msg("shm_size=0x%lx\n", os_memory_info.shm_size);
-		ret = fdt_add_mem_rsv(working_fdt, os_memory_info.shm_base,
-				      os_memory_info.shm_size);
+		ret = sunxi_fdt_fixup_add_mem_rsv(os_memory_info.shm_base,
+						  os_memory_info.shm_size);
 		if (ret)
 			pr_err("##add mem rsv error: %s : %s\n", __func__,
 			       fdt_strerror(ret));
@@ -818,8 +919,8 @@ int sunxi_update_fdt_para_for_kernel(void)
 	if (os_memory_info.ta_ram_size) {
 		pr_msg("ta_ram_base=0x%lx\n", os_memory_info.ta_ram_base);
 		pr_msg("ta_ram_size=0x%lx\n", os_memory_info.ta_ram_size);
-		ret = fdt_add_mem_rsv(working_fdt, os_memory_info.ta_ram_base,
-				      os_memory_info.ta_ram_size);
+		ret = sunxi_fdt_fixup_add_mem_rsv(os_memory_info.ta_ram_base,
+						  os_memory_info.ta_ram_size);
 		if (ret)
 			pr_err("##add mem rsv error: %s : %s\n", __func__,
 			       fdt_strerror(ret));
@@ -827,10 +928,11 @@ int sunxi_update_fdt_para_for_kernel(void)
 #endif
 #ifdef CONFIG_SPI_SAMP_DL_EN
 	int nodeoffset = 0;
-	nodeoffset = fdt_path_offset(working_fdt, "spi0");
+	nodeoffset = sunxi_fdt_fixup_find_node("spi0");
 	if (nodeoffset < 0) {
 		pr_err("## error: %s : %s\n", __func__,
 				fdt_strerror(nodeoffset));
+		sunxi_fdt_fixup_end();
 		return -1;
 	}
 
@@ -839,9 +941,9 @@ int sunxi_update_fdt_para_for_kernel(void)
 #ifdef CONFIG_SUNXI_SPINOR
 	{
 		struct sunxi_spi_slave *sspi = get_sspi();
-		fdt_setprop_u32(working_fdt, nodeoffset,
+		sunxi_fdt_fixup_setprop_u32("spi0",
 				"sample_mode", sspi->right_sample_mode);
-		fdt_setprop_u32(working_fdt, nodeoffset,
+		sunxi_fdt_fixup_setprop_u32("spi0",
 				"sample_delay", sspi->right_sample_delay);
 		pr_msg("spinor update sample_mode:%x right_sample_mod:%x\n",
 				sspi->right_sample_mode,
@@ -853,9 +955,9 @@ int sunxi_update_fdt_para_for_kernel(void)
 #ifdef CONFIG_SUNXI_NAND
 	{
 		struct aw_spinand *spinand = get_spinand();
-		fdt_setprop_u32(working_fdt, nodeoffset,
+		sunxi_fdt_fixup_setprop_u32("spi0",
 				"sample_mode", spinand->right_sample_mode);
-		fdt_setprop_u32(working_fdt, nodeoffset,
+		sunxi_fdt_fixup_setprop_u32("spi0",
 				"sample_delay", spinand->right_sample_delay);
 		pr_msg("spinand update sample_mode:%x right_sample_mod:%x\n",
 				spinand->right_sample_mode,
@@ -869,6 +971,7 @@ int sunxi_update_fdt_para_for_kernel(void)
 	}
 
 #endif
+	sunxi_fdt_fixup_end();
 
 	/* fix dram para */
 	update_fdt_dram_para(working_fdt);
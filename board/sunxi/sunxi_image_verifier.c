@@ -21,6 +21,7 @@
 #ifdef CONFIG_SUNXI_IMAGE_HEADER
 #include <sunxi_image_header.h>
 #endif
+#include <hash_sg.h>
 #ifdef CONFIG_CRYPTO
 #include <crypto/sha256.h>
 #include <crypto/ecc.h>
@@ -33,6 +34,11 @@ static int sunxi_verify_embed_signature(void *buff, unsigned int len,
 					const char *cert_name, void *cert,
 					unsigned cert_len);
 static int sunxi_verify_signature(void *buff, uint len, const char *cert_name);
+static int sunxi_verify_embed_hash(u8 *hash_of_file, const char *cert_name,
+				   void *cert, unsigned cert_len);
+static int sunxi_verify_tee_hash(u8 *hash_of_file, const char *cert_name);
+static int sunxi_verify_os_hash_get(ulong os_load_addr, uint32_t len,
+				    u8 *hash);
 static int android_image_get_signature(const struct andr_img_hdr *hdr,
 				       ulong *sign_data, ulong *sign_len);
 
@@ -47,12 +53,13 @@ int smc_tee_check_hash(const char *name, u8 *hash)
 	return 0;
 }
 #endif
-int sunxi_verify_os(ulong os_load_addr, const char *cert_name)
+static int __sunxi_verify_os(ulong os_load_addr, const char *cert_name)
 {
 	struct blk_desc *desc;
 	disk_partition_t info = { 0 };
 	ulong total_len = 0;
 	ulong sign_data, sign_len;
+	u8 hash_of_file[32];
 	int ret;
 	struct andr_img_hdr *fb_hdr = (struct andr_img_hdr *)os_load_addr;
 
@@ -77,6 +84,15 @@ int sunxi_verify_os(ulong os_load_addr, const char *cert_name)
 		pr_err("invalid kernel len\n");
 		return -1;
 	}
+	/* hashed by the loader as the image came in */
+	if (!sunxi_verify_os_hash_get(os_load_addr, total_len, hash_of_file)) {
+		if (android_image_get_signature(fb_hdr, &sign_data, &sign_len))
+			return sunxi_verify_embed_hash(hash_of_file, cert_name,
+						       (void *)sign_data,
+						       sign_len);
+		return sunxi_verify_tee_hash(hash_of_file, cert_name);
+	}
+
 	if (android_image_get_signature(fb_hdr, &sign_data, &sign_len))
 		ret = sunxi_verify_embed_signature((void *)os_load_addr,
 						   (unsigned int)total_len,
@@ -89,6 +105,17 @@ int sunxi_verify_os(ulong os_load_addr, const char *cert_name)
 	return ret;
 }
 
+int sunxi_verify_os(ulong os_load_addr, const char *cert_name)
+{
+	int ret;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_SUNXI_VERIFY, "sunxi_verify");
+	ret = __sunxi_verify_os(os_load_addr, cert_name);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_SUNXI_VERIFY);
+
+	return ret;
+}
+
 static int android_image_get_signature(const struct andr_img_hdr *hdr,
 				       ulong *sign_data, ulong *sign_len)
 {
@@ -220,12 +247,10 @@ static int check_public_in_rootcert(const char *name,
 }
 #endif
 
-static int sunxi_verify_embed_signature(void *buff, uint len,
-					const char *cert_name, void *cert,
-					unsigned cert_len)
+/* check @hash_of_file against the hash carried by the content certificate */
+static int sunxi_verify_embed_hash(u8 *hash_of_file, const char *cert_name,
+				   void *cert, unsigned cert_len)
 {
-	u8 hash_of_file[32];
-	int ret;
 	sunxi_certif_info_t sub_certif;
 	void *cert_buf;
 
@@ -236,13 +261,6 @@ static int sunxi_verify_embed_signature(void *buff, uint len,
 	}
 	memcpy(cert_buf, cert, cert_len);
 
-	memset(hash_of_file, 0, 32);
-	sunxi_ss_open();
-	ret = sunxi_sha_calc(hash_of_file, 32, buff, len);
-	if (ret) {
-		printf("sunxi_verify_signature err: calc hash failed\n");
-		goto __ERROR_END;
-	}
 	if (sunxi_certif_verify_itself(&sub_certif, cert_buf, cert_len)) {
 		printf("%s error: cant verify the content certif\n", __func__);
 		printf("cert dump\n");
@@ -275,6 +293,24 @@ __ERROR_END:
 	return -1;
 }
 
+static int sunxi_verify_embed_signature(void *buff, uint len,
+					const char *cert_name, void *cert,
+					unsigned cert_len)
+{
+	u8 hash_of_file[32];
+	int ret;
+
+	memset(hash_of_file, 0, 32);
+	sunxi_ss_open();
+	ret = sunxi_sha_calc(hash_of_file, 32, buff, len);
+	if (ret) {
+		printf("sunxi_verify_signature err: calc hash failed\n");
+		return -1;
+	}
+
+	return sunxi_verify_embed_hash(hash_of_file, cert_name, cert, cert_len);
+}
+
 static int sunxi_verify_signature(void *buff, uint len, const char *cert_name)
 {
 	u8 hash_of_file[32];
@@ -289,6 +325,14 @@ static int sunxi_verify_signature(void *buff, uint len, const char *cert_name)
 	}
 	pr_msg("show hash of file\n");
 
+	return sunxi_verify_tee_hash(hash_of_file, cert_name);
+}
+
+/* check @hash_of_file against the hash the secure os holds for @cert_name */
+static int sunxi_verify_tee_hash(u8 *hash_of_file, const char *cert_name)
+{
+	int ret;
+
 	ret = smc_tee_check_hash(cert_name, hash_of_file);
 	if (ret == 0xFFFF000F) {
 		sunxi_dump(hash_of_file, 32);
@@ -305,7 +349,6 @@ static int sunxi_verify_signature(void *buff, uint len, const char *cert_name)
 		pr_err("image %s hash not found\n", cert_name);
 		return -1;
 	}
-
 }
 
 int sunxi_verify_preserve_toc1(void *toc1_head_buf)
@@ -491,11 +534,13 @@ static int cal_partioin_len(disk_partition_t *info)
 	if (!rootfs_sb)
 		return -1;
 
-	sunxi_flash_read(
-		info->start,
-		(ALIGN(sizeof(struct squashfs_super_block), SECTOR_SIZE) /
-		 SECTOR_SIZE),
-		rootfs_sb);
+	len = ALIGN(sizeof(struct squashfs_super_block), SECTOR_SIZE) /
+	      SECTOR_SIZE;
+	if (sunxi_flash_read(info->start, len, rootfs_sb) != len) {
+		pr_err("read rootfs super block failed\n");
+		free(rootfs_sb);
+		return -1;
+	}
 
 	if (rootfs_sb->s_magic != SQUASHFS_MAGIC) {
 		printf("unsupport rootfs, magic: %d\n", rootfs_sb->s_magic);
@@ -514,18 +559,235 @@ static int cal_partioin_len(disk_partition_t *info)
 	return len;
 }
 
-int sunxi_verify_partion(struct sunxi_image_verify_pattern_st *pattern,
-			const char *part_name, const char *cert_name, int full)
+/*
+ * The partition is read and hashed a window at a time, two windows taking
+ * turns: the flash reads the next one while the last one is hashed.
+ */
+#define SUNXI_VERIFY_WINDOW (2 * 1024 * 1024)
+
+/* reads of @step bytes, @interval apart, the last one may be short */
+struct sunxi_verify_read {
+	uint start;
+	uint32_t step;
+	uint32_t interval;
+	uint32_t cnt;
+	uint32_t total;
+	uint32_t per_win;	/* reads in a window */
+	uint32_t next;		/* read to issue next */
+	int busy;
+	struct sunxi_flash_req req;
+};
+
+static uint32_t sunxi_verify_read_len(struct sunxi_verify_read *vr)
+{
+	return min(vr->step, vr->total - vr->next * vr->step);
+}
+
+static int sunxi_verify_read_submit(struct sunxi_verify_read *vr, u8 *buf)
+{
+	if (sunxi_flash_submit(&vr->req,
+			       vr->start + vr->next * vr->interval / SECTOR_SIZE,
+			       sunxi_verify_read_len(vr) / SECTOR_SIZE, buf, 0))
+		return -EIO;
+	vr->busy = 1;
+
+	return 0;
+}
+
+static int sunxi_verify_read_wait(struct sunxi_verify_read *vr)
+{
+	uint nblock = sunxi_verify_read_len(vr) / SECTOR_SIZE;
+
+	vr->busy = 0;
+	if (sunxi_flash_complete(&vr->req) != nblock)
+		return -EIO;
+	vr->next++;
+
+	return 0;
+}
+
+/*
+ * Wait for the reads of a window into @buf, the first one is issued
+ * already. Returns the bytes in the window, -EIO if a read failed.
+ */
+static int sunxi_verify_read_window(struct sunxi_verify_read *vr, u8 *buf)
+{
+	uint32_t end = min(vr->next + vr->per_win, vr->cnt);
+	uint32_t fill = 0;
+
+	for (;;) {
+		fill += sunxi_verify_read_len(vr);
+		if (sunxi_verify_read_wait(vr))
+			return -EIO;
+		if (vr->next == end)
+			return fill;
+		if (sunxi_verify_read_submit(vr, buf + fill))
+			return -EIO;
+	}
+}
+
+/*
+ * Boot image hash fed by the loader, see sunxi_verify_os_hash_start().
+ * Each piece is hashed as one job going on from the one before, which
+ * the CE runs while the loader reads the next piece. The last job runs
+ * while the boot goes on, sunxi_verify_os() waits.
+ */
+static struct {
+	u8 hash[CACHE_LINE_SIZE] __aligned(CACHE_LINE_SIZE);
+	/* the header is hashed with the cert fields cleared, from this copy */
+	struct boot_img_hdr_ex hdr __aligned(CACHE_LINE_SIZE);
+	ulong addr;
+	uint32_t len;
+	uint32_t done;
+	struct hash_sg sg[2];	/* of the running job */
+	struct hash_sg_ctx ctx;
+	struct hash_sg_req req;
+} os_hash;
+
+static int sunxi_verify_os_hash_idle(void)
+{
+	if (os_hash.req.state == HASH_SG_IDLE)
+		return 0;
+
+	return hash_sg_wait(&os_hash.req);
+}
+
+int sunxi_verify_os_hash_start(ulong os_load_addr, uint32_t len)
+{
+	/* a hash nobody took still has the CE */
+	sunxi_verify_os_hash_idle();
+	memset(&os_hash.req, 0, sizeof(os_hash.req));
+	os_hash.addr  = os_load_addr;
+	os_hash.len   = len;
+	os_hash.done  = 0;
+	sunxi_ss_open();
+	hash_sg_ctx_init(&os_hash.ctx, len, os_hash.hash);
+
+	return 0;
+}
+
+int sunxi_verify_os_hash_update(void *buf, uint32_t len)
+{
+	struct boot_img_hdr_ex *hdr_ex = buf;
+	int nr_sg = 0;
+
+	if (!os_hash.len || os_hash.done + len > os_hash.len) {
+		os_hash.len = 0;
+		return -1;
+	}
+
+	/* the job before ran while this piece was read, its sg is reused */
+	if (sunxi_verify_os_hash_idle()) {
+		os_hash.len = 0;
+		return -1;
+	}
+
+	/* sunxi_verify_os() hashes the header with the cert fields cleared */
+	if (!os_hash.done && len >= sizeof(*hdr_ex) &&
+	    !strncmp((void *)hdr_ex->cert_magic, AW_CERT_MAGIC,
+		     strlen(AW_CERT_MAGIC))) {
+		memcpy(&os_hash.hdr, hdr_ex, sizeof(*hdr_ex));
+		memset(os_hash.hdr.cert_magic, 0,
+		       ANDR_BOOT_MAGIC_SIZE + sizeof(unsigned));
+		os_hash.sg[nr_sg].addr  = &os_hash.hdr;
+		os_hash.sg[nr_sg++].len = sizeof(*hdr_ex);
+		buf += sizeof(*hdr_ex);
+		len -= sizeof(*hdr_ex);
+		os_hash.done += sizeof(*hdr_ex);
+	}
+	os_hash.sg[nr_sg].addr  = buf;
+	os_hash.sg[nr_sg++].len = len;
+	os_hash.done += len;
+
+	if (hash_sg_ctx_submit(&os_hash.req, &os_hash.ctx, os_hash.sg, nr_sg)) {
+		pr_err("hash boot image piece fail\n");
+		os_hash.len = 0;
+		return -1;
+	}
+
+	return 0;
+}
+
+/* the hash is used once, a failed or partial feed leaves none */
+static int sunxi_verify_os_hash_get(ulong os_load_addr, uint32_t len,
+				    u8 *hash)
+{
+	int ret;
+
+	ret = hash_sg_wait(&os_hash.req);
+	if (!ret && os_hash.len && os_hash.addr == os_load_addr &&
+	    os_hash.len == len && os_hash.ctx.done == len)
+		memcpy(hash, os_hash.hash, 32);
+	else
+		ret = -1;
+	os_hash.len = 0;
+
+	return ret;
+}
+
+/* hash the reads of @vr into @digest, see SUNXI_VERIFY_WINDOW */
+static int sunxi_verify_hash_part(struct sunxi_verify_read *vr, u8 *digest)
+{
+	struct hash_sg_req req = { 0 };
+	struct hash_sg_ctx ctx;
+	struct hash_sg sg;
+	u8 *buf[2];
+	int fill, k, ret = -ENOMEM;
+
+	buf[0] = memalign(CACHE_LINE_SIZE, vr->per_win * vr->step);
+	buf[1] = memalign(CACHE_LINE_SIZE, vr->per_win * vr->step);
+	if (!buf[0] || !buf[1]) {
+		printf("no memory for verify\n");
+		goto out;
+	}
+
+	sunxi_ss_open();
+	hash_sg_ctx_init(&ctx, vr->total, digest);
+	ret = sunxi_verify_read_submit(vr, buf[0]);
+	for (k = 0; !ret && vr->busy; k++) {
+		fill = sunxi_verify_read_window(vr, buf[k & 1]);
+		if (fill < 0) {
+			ret = fill;
+			break;
+		}
+		/* the next window is read where the one before was hashed from */
+		if (req.state != HASH_SG_IDLE)
+			ret = hash_sg_wait(&req);
+		if (!ret && vr->next < vr->cnt)
+			ret = sunxi_verify_read_submit(vr, buf[(k + 1) & 1]);
+		if (!ret) {
+			sg.addr = buf[k & 1];
+			sg.len	= fill;
+			ret = hash_sg_ctx_submit(&req, &ctx, &sg, 1);
+		}
+	}
+
+	/* neither the flash nor the CE may still use the buffers */
+	if (vr->busy)
+		sunxi_flash_complete(&vr->req);
+	if (req.state != HASH_SG_IDLE && hash_sg_wait(&req) && !ret)
+		ret = -EIO;
+	if (!ret && ctx.done != ctx.total)
+		ret = -EIO;
+out:
+	free(buf[0]);
+	free(buf[1]);
+	return ret;
+}
+
+static int __sunxi_verify_partion(struct sunxi_image_verify_pattern_st *pattern,
+				  const char *part_name, const char *cert_name,
+				  int full)
 {
 	int ret = 0;
 	disk_partition_t info = { 0 };
-	int i;
-	uint8_t *p		      = 0;
-	uint8_t *unaligned_sample_buf = 0;
 	void *cert_buf;
 	uint32_t cert_len;
 	uint64_t part_len;
 	uint32_t whole_sample_len;
+	uint nblock;
+	struct sunxi_verify_read vr = { 0 };
+	ALLOC_CACHE_ALIGN_BUFFER(u8, hash_of_file, CACHE_LINE_SIZE);
 
 	if (sunxi_partition_get_info(part_name, &info)) {
 		printf("get part: %s info failed\n", part_name);
@@ -533,14 +795,13 @@ int sunxi_verify_partion(struct sunxi_image_verify_pattern_st *pattern,
 	}
 
 	part_len = cal_partioin_len(&info);
+	if (part_len == -1)
+		return -1;
 
 	if (full == 1) {
 		whole_sample_len = part_len;
 	} else {
 		if (pattern->cnt == -1) {
-			if (part_len == -1) {
-				return -1;
-			}
 			pattern->cnt = part_len / pattern->interval;
 		}
 		whole_sample_len = pattern->cnt * pattern->size;
@@ -552,49 +813,52 @@ int sunxi_verify_partion(struct sunxi_image_verify_pattern_st *pattern,
 		pattern->cnt, whole_sample_len, cert_name, full);
 #endif
 
-	unaligned_sample_buf = (uint8_t *)malloc(whole_sample_len + 256);
-	if (!unaligned_sample_buf) {
-		printf("no memory for verify\n");
-		return -1;
-	}
-	p = (uint8_t *)((((ulong)unaligned_sample_buf) + (CACHE_LINE_SIZE - 1)) &
-			(~(CACHE_LINE_SIZE - 1)));
-
+	/* full reads go by window, samples are gathered whole */
+	vr.start = info.start;
+	vr.total = whole_sample_len;
 	if (full == 1) {
-		sunxi_flash_read(info.start, whole_sample_len / SECTOR_SIZE, p);
+		vr.step	    = SUNXI_VERIFY_WINDOW;
+		vr.interval = SUNXI_VERIFY_WINDOW;
+		vr.cnt	    = DIV_ROUND_UP(whole_sample_len, SUNXI_VERIFY_WINDOW);
 	} else {
-		for (i = 0; i < pattern->cnt; i++) {
-	#if 0
-			pr_msg("from %lx read %d block:to %p\n",
-			    info.start + i * pattern->interval / SECTOR_SIZE,
-			    pattern->size / SECTOR_SIZE, p + i * pattern->size);
-	#endif
-			sunxi_flash_read(
-			    info.start + i * pattern->interval / SECTOR_SIZE,
-			    pattern->size / SECTOR_SIZE, p + i * pattern->size);
-		}
+		vr.step	    = pattern->size;
+		vr.interval = pattern->interval;
+		vr.cnt	    = pattern->cnt;
+	}
+	if (!vr.total || vr.step % SECTOR_SIZE) {
+		printf("sunxi_verify_partion err: bad pattern\n");
+		return -EINVAL;
+	}
+	vr.per_win = max_t(uint32_t, SUNXI_VERIFY_WINDOW / vr.step, 1);
+	if (sunxi_verify_hash_part(&vr, hash_of_file)) {
+		printf("sunxi_verify_partion err: calc hash failed\n");
+		return -1;
 	}
 
 #define SUNXI_X509_CERTIFF_MAX_LEN 4096
-	cert_buf = malloc(ALIGN(SUNXI_X509_CERTIFF_MAX_LEN + 4, SECTOR_SIZE));
+	nblock = ALIGN(SUNXI_X509_CERTIFF_MAX_LEN + 4, SECTOR_SIZE) / SECTOR_SIZE;
+	cert_buf = malloc(nblock * SECTOR_SIZE);
 	if (!cert_buf) {
 		printf("not enough meory\n");
+		ret = -ENOMEM;
+	} else if (sunxi_flash_read(info.start + (part_len / SECTOR_SIZE),
+				    nblock, cert_buf) != nblock) {
+		printf("read cert of %s failed\n", part_name);
+		free(cert_buf);
+		ret = -EIO;
 	} else {
-		memset(cert_buf, 0, SUNXI_X509_CERTIFF_MAX_LEN + 4);
-		sunxi_flash_read(info.start + (part_len / SECTOR_SIZE),
-			(ALIGN(SUNXI_X509_CERTIFF_MAX_LEN + 4, SECTOR_SIZE)) /
-				SECTOR_SIZE, cert_buf);
 		memcpy(&cert_len, cert_buf, sizeof(cert_len));
-		memcpy(cert_buf, cert_buf + 4, cert_len);
-		ret = sunxi_verify_embed_signature(p,
-						   whole_sample_len,
-						   cert_name,
-						   cert_buf,
-						   cert_len);
+		if (cert_len > SUNXI_X509_CERTIFF_MAX_LEN) {
+			printf("bad cert len %u\n", cert_len);
+			ret = -EINVAL;
+		} else {
+			memmove(cert_buf, cert_buf + 4, cert_len);
+			ret = sunxi_verify_embed_hash(hash_of_file, cert_name,
+						      cert_buf, cert_len);
+		}
 		free(cert_buf);
 	}
 
-	free(unaligned_sample_buf);
 	if (ret == 0) {
 		printf("partition %s verify pass\n", part_name);
 	} else {
@@ -603,6 +867,19 @@ int sunxi_verify_partion(struct sunxi_image_verify_pattern_st *pattern,
 	return ret;
 }
 
+int sunxi_verify_partion(struct sunxi_image_verify_pattern_st *pattern,
+			const char *part_name, const char *cert_name, int full)
+{
+	int ret;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_SUNXI_PART_VERIFY,
+			"sunxi_part_verify");
+	ret = __sunxi_verify_partion(pattern, part_name, cert_name, full);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_SUNXI_PART_VERIFY);
+
+	return ret;
+}
+
 #if 0
 static int do_part_verify_test(cmd_tbl_t *cmdtp, int flag, int argc,
 			       char *const argv[])
@@ -635,8 +912,7 @@ int verify_image_by_vbmeta(const char *image_name, const uint8_t *image_data,
 	AvbHashDescriptor *hdh;
 	const uint8_t *salt;
 	const uint8_t *expected_hash;
-	uint8_t *salt_buf;
-	size_t salt_buf_len;
+	struct hash_sg sg[2];
 	ALLOC_CACHE_ALIGN_BUFFER(u8, hash_result, 32);
 	char slot_vbmeta[20] = "vbmeta";
 	char *slot_suffix    = env_get("slot_suffix");
@@ -712,30 +988,16 @@ int verify_image_by_vbmeta(const char *image_name, const uint8_t *image_data,
 		goto descriptot_need_free;
 	}
 
-	/*
-	 * hardware require 64Byte align when doing multi step calculation,
-	 * since salt is usually 32Byte, the only way to calc hash of salt +
-	 * image is put salt in front of image_data and calc their hash at once
-	 * memory right before image_data might already be used, recover them
-	 * after hash calculation
-	 */
-	salt_buf_len = ALIGN(hdh->salt_len, CACHE_LINE_SIZE);
-	salt_buf     = (uint8_t *)malloc(salt_buf_len);
-	if (salt_buf == NULL) {
-		pr_error("not enough memory\n");
+	/* salt and image hashed where they are, as one job */
+	sg[0].addr = salt;
+	sg[0].len  = hdh->salt_len;
+	sg[1].addr = image_data;
+	sg[1].len  = image_len;
+	sunxi_ss_open();
+	if (hash_sg_sha256(sg, ARRAY_SIZE(sg), hash_result)) {
+		pr_error("hash of %s failed\n", image_name);
 		goto descriptot_need_free;
 	}
-	memcpy(salt_buf, image_data - salt_buf_len, salt_buf_len);
-	memcpy((uint8_t *)image_data - hdh->salt_len, salt, hdh->salt_len);
-	flush_cache((u32)image_data - salt_buf_len, salt_buf_len);
-
-	sunxi_ss_open();
-	sunxi_sha_calc(hash_result, 32, (uint8_t *)image_data - hdh->salt_len,
-		       hdh->salt_len + image_len);
-
-	memcpy((uint8_t *)image_data - salt_buf_len, salt_buf, salt_buf_len);
-
-	free(salt_buf);
 	free(desc);
 
 	if (memcmp(expected_hash, hash_result, 32) != 0) {
@@ -26,6 +26,7 @@
 #include <asm/io.h>
 #include <sys_config.h>
 #include <fdt_support.h>
+#include <fdt_index.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -1362,13 +1363,13 @@ int fdt_get_all_pin(int nodeoffset,const char* pinctrl_name,user_gpio_set_t* gpi
 	for(i = 0; i < handle_num; i++)
 	{
 		debug("%s:get property handle  %s ok, index %d,value is 0x%x\n",__func__, pinctrl_name,i,handle[i] );
-		nodeoffset = fdt_node_offset_by_phandle(working_fdt,handle[i]);
+		nodeoffset = fdt_index_node_offset_by_phandle(working_fdt,handle[i]);
 		if(nodeoffset < 0 )
 		{
 			FDT_ERR("%s:get property by handle error\n",__func__);
 			return -1;
 		}
-		ret = fdt_get_path(working_fdt,nodeoffset,path_tmp,sizeof(path_tmp));
+		ret = fdt_index_get_path(working_fdt,nodeoffset,path_tmp,sizeof(path_tmp));
 		if(ret < 0 )
 		{
 			FDT_ERR("%s:get path by nodeoffset error\n",__func__);
@@ -1569,7 +1570,7 @@ int fdt_get_pin_num(int nodeoffset,const char* pinctrl_name)
 	for(i = 0; i < handle_num; i++)
 	{
 		//printf("get property handle  %s ok, index %d,value is 0x%x\n", "pinctrl-0",i,handle[i] );
-		nodeoffset = fdt_node_offset_by_phandle(working_fdt,handle[i]);
+		nodeoffset = fdt_index_node_offset_by_phandle(working_fdt,handle[i]);
 		if(nodeoffset < 0 )
 		{
 			FDT_ERR("%s:get property by handle error\n",__func__);
@@ -1609,7 +1610,7 @@ int fdt_set_all_pin(const char* node_path,const char* pinctrl_name)
 	int nodeoffset;
 
 	//get property vaule by handle
-	nodeoffset = fdt_path_offset (working_fdt,node_path );
+	nodeoffset = fdt_index_path_offset(working_fdt,node_path );
 	if(nodeoffset < 0)
 	{
 		FDT_ERR("%s:[%s]-->%s\n",__func__,node_path,fdt_strerror(nodeoffset));
@@ -1763,7 +1764,7 @@ int fdt_get_one_gpio(const char* node_path, const char* prop_name,user_gpio_set_
 
 	memset(data, 0, sizeof(data));
 	//get property vaule by handle
-	nodeoffset = fdt_path_offset (working_fdt,node_path );
+	nodeoffset = fdt_index_path_offset(working_fdt,node_path );
 	if(nodeoffset < 0)
 	{
 		debug ("fdt err returned %s\n",fdt_strerror(nodeoffset));
@@ -1825,7 +1826,7 @@ int script_parser_fetch(char *node_path, char *prop_name, int value[], int def_v
 	int ret;
 
 	//get property vaule by handle
-	nodeoffset = fdt_path_offset (working_fdt, node_path );
+	nodeoffset = fdt_index_path_offset(working_fdt, node_path );
 	if(nodeoffset < 0) {
 		debug ("fdt err returned %s\n",fdt_strerror(nodeoffset));
 		value[0] = def_val;
@@ -1864,7 +1865,7 @@ const char *fdt_get_regulator_name(int nodeoffset, const char *name)
 		return NULL;
 	}
 
-	nodeoffset = fdt_node_offset_by_phandle(working_fdt, handle);
+	nodeoffset = fdt_index_node_offset_by_phandle(working_fdt, handle);
 	if (nodeoffset < 0) {
 		FDT_ERR("%s:get property by handle error\n", __func__);
 		return NULL;
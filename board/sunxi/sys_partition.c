@@ -14,11 +14,17 @@
 #include <sunxi_board.h>
 #include <android_misc.h>
 #include <android_ab.h>
+#include <part_index.h>
 
 #ifndef CONFIG_ENABLE_MTD_CMDLINE_PARTS_BY_ENV
 static sunxi_mbr_t *mbr ;
 #endif
 
+#ifndef CONFIG_ENABLE_MTD_CMDLINE_PARTS_BY_ENV
+/* name index of the partition map, built on the first name query */
+static struct part_index part_idx;
+#endif
+
 extern struct bootloader_control ab_message;
 #define MMC_LOGICAL_OFFSET   (20 * 1024 * 1024/512)
 DECLARE_GLOBAL_DATA_PTR;
@@ -170,10 +176,68 @@ int sunxi_partition_init(void)
 	return 0;
 }
 
+void sunxi_partition_index_invalidate(void)
+{
+#ifndef CONFIG_ENABLE_MTD_CMDLINE_PARTS_BY_ENV
+	part_index_reset(&part_idx);
+#endif
+}
+
+#ifndef CONFIG_ENABLE_MTD_CMDLINE_PARTS_BY_ENV
+static int sunxi_partition_index_build(struct blk_desc *desc)
+{
+	disk_partition_t info;
+	int i;
+
+	part_index_reset(&part_idx);
+	for (i = 1; part_get_info(desc, i, &info) >= 0; i++) {
+		if (part_index_add(&part_idx, (const char *)info.name,
+				   (u32)info.start, (u32)info.size, i))
+			return -1;
+	}
+	/* no partition map on the flash yet, try again next time */
+	if (!part_idx.count)
+		return -1;
+
+	return part_index_build(&part_idx);
+}
+
+/*
+ * partition number of @part_name (or its a/b slot name @ab_name) from the
+ * index, -ENOENT if it has none, -EAGAIN if the map has to be walked
+ */
+static int sunxi_partition_index_find(struct blk_desc *desc,
+				      const char *ab_name,
+				      const char *part_name,
+				      disk_partition_t *info)
+{
+	int partno;
+
+	if (!part_idx.valid && sunxi_partition_index_build(desc))
+		return -EAGAIN;
+
+	partno = part_index_find_name(&part_idx, ab_name);
+	if (partno < 0)
+		partno = part_index_find_name(&part_idx, part_name);
+	if (partno < 0)
+		return -ENOENT;
+
+	/* the index keeps PART_INDEX_NAME_LEN characters of a name */
+	if (part_get_info(desc, partno, info) < 0 ||
+	    (strncmp((const char *)info->name, ab_name, sizeof(info->name)) &&
+	     strncmp((const char *)info->name, part_name, sizeof(info->name))))
+		return -EAGAIN;
+
+	return partno;
+}
+#endif
+
 int sunxi_probe_partition_map(void)
 {
 #ifndef CONFIG_ENABLE_MTD_CMDLINE_PARTS_BY_ENV
 	struct blk_desc *desc;
+
+	sunxi_partition_index_invalidate();
 	desc = blk_get_devnum_by_typename("sunxi_flash", 0);
 	if (desc == NULL) {
 		pr_err("%s: get desc fail\n", __func__);
@@ -232,6 +296,14 @@ int sunxi_partition_get_partno_byname(const char *part_name)
 	}
 	sunxi_replace_android_ab_system((char *)part_name, temp_part_name);
 
+#ifndef CONFIG_ENABLE_MTD_CMDLINE_PARTS_BY_ENV
+	ret = sunxi_partition_index_find(desc, temp_part_name, part_name, &info);
+	if (ret == -ENOENT)
+		printf("partno erro : can't find partition %s\n", part_name);
+	if (ret != -EAGAIN)
+		return ret;
+#endif
+
 	for (i = 1;; i++) {
 		ret = part_get_info(desc, i, &info);
 		debug("%s: try part %d, ret = %d\n", __func__, i, ret);
@@ -301,6 +373,12 @@ int sunxi_flash_try_partition(struct blk_desc *desc, const char *str,
 #endif
 	sunxi_replace_android_ab_system((char *)str, temp_part_name);
 
+#ifndef CONFIG_ENABLE_MTD_CMDLINE_PARTS_BY_ENV
+	ret = sunxi_partition_index_find(desc, temp_part_name, str, info);
+	if (ret != -EAGAIN)
+		return ret < 0 ? ret : 0;
+#endif
+
 	for (i = 1;; i++) {
 #if defined (CONFIG_ENABLE_MTD_CMDLINE_PARTS_BY_ENV) /*Get partitiones by env*/
 		ret = sunxi_partition_parse_get_info(i, info);
@@ -153,52 +153,6 @@ static int do_spi_flash_probe(int argc, char * const argv[])
 	return 0;
 }
 
-/**
- * Write a block of data to SPI flash, first checking if it is different from
- * what is already there.
- *
- * If the data being written is the same, then *skipped is incremented by len.
- *
- * @param flash		flash context pointer
- * @param offset	flash offset to write
- * @param len		number of bytes to write
- * @param buf		buffer to write from
- * @param cmp_buf	read buffer to use to compare data
- * @param skipped	Count of skipped data (incremented by this function)
- * @return NULL if OK, else a string containing the stage which failed
- */
-static const char *spi_flash_update_block(struct spi_flash *flash, u32 offset,
-		size_t len, const char *buf, char *cmp_buf, size_t *skipped)
-{
-	char *ptr = (char *)buf;
-
-	debug("offset=%#x, sector_size=%#x, len=%#zx\n",
-	      offset, flash->sector_size, len);
-	/* Read the entire sector so to allow for rewriting */
-	if (spi_flash_read(flash, offset, flash->sector_size, cmp_buf))
-		return "read";
-	/* Compare only what is meaningful (len) */
-	if (memcmp(cmp_buf, buf, len) == 0) {
-		debug("Skip region %x size %zx: no change\n",
-		      offset, len);
-		*skipped += len;
-		return NULL;
-	}
-	/* Erase the entire sector */
-	if (spi_flash_erase(flash, offset, flash->sector_size))
-		return "erase";
-	/* If it's a partial sector, copy the data into the temp-buffer */
-	if (len != flash->sector_size) {
-		memcpy(cmp_buf, buf, len);
-		ptr = cmp_buf;
-	}
-	/* Write one complete sector */
-	if (spi_flash_write(flash, offset, flash->sector_size, ptr))
-		return "write";
-
-	return NULL;
-}
-
 /**
  * Update an area of SPI flash by erasing and writing any blocks which need
  * to change. Existing blocks with the correct data are left unchanged.
@@ -212,47 +166,20 @@ static const char *spi_flash_update_block(struct spi_flash *flash, u32 offset,
 static int spi_flash_update(struct spi_flash *flash, u32 offset,
 		size_t len, const char *buf)
 {
-	const char *err_oper = NULL;
-	char *cmp_buf;
-	const char *end = buf + len;
-	size_t todo;		/* number of bytes to do in this pass */
-	size_t skipped = 0;	/* statistics */
+	struct spi_flash_update_stats stats;
 	const ulong start_time = get_timer(0);
-	size_t scale = 1;
-	const char *start_buf = buf;
 	ulong delta;
+	int ret;
 
-	if (end - buf >= 200)
-		scale = (end - buf) / 100;
-	cmp_buf = memalign(ARCH_DMA_MINALIGN, flash->sector_size);
-	if (cmp_buf) {
-		ulong last_update = get_timer(0);
-
-		for (; buf < end && !err_oper; buf += todo, offset += todo) {
-			todo = min_t(size_t, end - buf, flash->sector_size);
-			if (get_timer(last_update) > 100) {
-				printf("   \rUpdating, %zu%% %lu B/s",
-				       100 - (end - buf) / scale,
-					bytes_per_second(buf - start_buf,
-							 start_time));
-				last_update = get_timer(0);
-			}
-			err_oper = spi_flash_update_block(flash, offset, todo,
-					buf, cmp_buf, &skipped);
-		}
-	} else {
-		err_oper = "malloc";
-	}
-	free(cmp_buf);
-	putc('\r');
-	if (err_oper) {
-		printf("SPI flash failed in %s step\n", err_oper);
+	ret = spi_flash_update_range(flash, offset, len, buf, &stats);
+	if (ret) {
+		printf("SPI flash update failed: %d\n", ret);
 		return 1;
 	}
 
 	delta = get_timer(start_time);
-	printf("%zu bytes written, %zu bytes skipped", len - skipped,
-	       skipped);
+	printf("%zu bytes written, %zu bytes skipped, %zu bytes erased",
+	       stats.programmed, stats.skipped, stats.erased);
 	printf(" in %ld.%lds, speed %ld B/s\n",
 	       delta / 1000, delta % 1000, bytes_per_second(len, start_time));
 
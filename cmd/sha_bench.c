@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * SHA1/SHA256 throughput of the portable code and the CPU instruction
+ * backend
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <watchdog.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+#include <u-boot/sha_arch.h>
+
+#define SHA_BENCH_BUF		(64 * 1024)
+#define SHA_BENCH_DEF_MB	16
+
+static void sha_bench_sha1(const u8 *buf, ulong total, u8 *digest)
+{
+	sha1_context ctx;
+
+	sha1_starts(&ctx);
+	for (; total; total -= SHA_BENCH_BUF) {
+		sha1_update(&ctx, buf, SHA_BENCH_BUF);
+		WATCHDOG_RESET();
+	}
+	sha1_finish(&ctx, digest);
+}
+
+static void sha_bench_sha256(const u8 *buf, ulong total, u8 *digest)
+{
+	sha256_context ctx;
+
+	sha256_starts(&ctx);
+	for (; total; total -= SHA_BENCH_BUF) {
+		sha256_update(&ctx, buf, SHA_BENCH_BUF);
+		WATCHDOG_RESET();
+	}
+	sha256_finish(&ctx, digest);
+}
+
+static const struct {
+	const char *name;
+	enum sha_arch_alg alg;
+	void (*run)(const u8 *buf, ulong total, u8 *digest);
+} sha_bench_algs[] = {
+	{ "sha1", SHA_ARCH_SHA1, sha_bench_sha1 },
+	{ "sha256", SHA_ARCH_SHA256, sha_bench_sha256 },
+};
+
+static int do_sha_bench(cmd_tbl_t *cmdtp, int flag, int argc,
+			char *const argv[])
+{
+	u8 digest[SHA256_SUM_LEN];
+	ulong mb = SHA_BENCH_DEF_MB, start, ms;
+	int i, arch;
+	u8 *buf;
+
+	if (argc > 1)
+		mb = simple_strtoul(argv[1], NULL, 10);
+	if (!mb)
+		return CMD_RET_USAGE;
+
+	buf = malloc(SHA_BENCH_BUF);
+	if (!buf) {
+		printf("shabench: no memory\n");
+		return CMD_RET_FAILURE;
+	}
+	for (i = 0; i < SHA_BENCH_BUF; i++)
+		buf[i] = i;
+
+	printf("hashing %lu MiB\n", mb);
+	for (i = 0; i < ARRAY_SIZE(sha_bench_algs); i++) {
+		for (arch = 0; arch < 2; arch++) {
+			sha_arch_set_enabled(arch);
+			if (arch && !sha_arch_usable(sha_bench_algs[i].alg))
+				continue;
+
+			start = get_timer(0);
+			sha_bench_algs[i].run(buf, mb << 20, digest);
+			ms = max(get_timer(start), 1UL);
+			printf("%-7s %-9s %6lu ms %6lu KiB/s\n",
+			       sha_bench_algs[i].name,
+			       arch ? sha_arch_name() : "portable", ms,
+			       (mb << 10) * 1000 / ms);
+		}
+	}
+	sha_arch_set_enabled(true);
+	free(buf);
+
+	return CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	shabench,	2,	1,	do_sha_bench,
+	"SHA1/SHA256 throughput of each backend",
+	"[MiB]\n"
+	"    - hash MiB (default 16) from a 64 KiB buffer with the portable\n"
+	"      code and the CPU instruction backend, if usable"
+);
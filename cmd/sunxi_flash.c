@@ -19,42 +19,208 @@
 #include <rtos_image.h>
 #include <sys_partition.h>
 #include <sprite_download.h>
+#include <sunxi_image_verifier.h>
 #include "../sprite/sparse/sparse.h"
 
 DECLARE_GLOBAL_DATA_PTR;
 
 #define SUNXI_FLASH_READ_FIRST_SIZE (32 * 1024)
+/* with hashing, the image is read this much at a time */
+#define SUNXI_FLASH_READ_WINDOW (2 * 1024 * 1024)
+
+/* a run of the image and where it is read to */
+struct sunxi_flash_read_seg {
+	u32 offset;	/* in the image, multiple of 512 */
+	u32 bytes;	/* multiple of 512 */
+	ulong dest;
+};
+
+struct sunxi_flash_read_plan {
+	struct sunxi_flash_read_seg seg[4];
+	int nr_seg;
+	ulong kernel;		/* final addresses, 0 if left in the image */
+	ulong ramdisk;
+	u32 hash_bytes;		/* fed to the boot image hash, 0 for none */
+};
+
+static int sunxi_flash_read_overlap(ulong a, u32 a_len, ulong b, u32 b_len)
+{
+	return a_len && b_len && a < b + b_len && b < a + a_len;
+}
+
+static void sunxi_flash_read_add(struct sunxi_flash_read_plan *plan,
+				 u32 offset, u32 bytes, ulong dest)
+{
+	struct sunxi_flash_read_seg *seg = &plan->seg[plan->nr_seg++];
+
+	seg->offset = offset;
+	seg->bytes  = bytes;
+	seg->dest   = dest;
+}
+
+/*
+ * Send the kernel and ramdisk of an Android image straight to the
+ * addresses bootm and sunxi_update_initrd() would copy them to. The
+ * header and what follows the ramdisk stay in the buffer at their image
+ * offsets. A part whose destination overlaps the buffer, the vendor boot
+ * image or the other part is left in the buffer.
+ */
+static void sunxi_flash_read_plan_android(struct sunxi_flash_read_plan *plan,
+					  struct andr_img_hdr *hdr, u32 nbytes)
+{
+	struct boot_img_hdr *hdr_v3 = (struct boot_img_hdr *)hdr;
+	struct vendor_boot_img_hdr *vhdr = NULL;
+	ulong buffer = (ulong)hdr;
+	ulong vendor = 0, kernel = 0, ramdisk = 0;
+	u32 vendor_len = 0;
+	u32 page = hdr->page_size;
+	u32 kernel_size = hdr->kernel_size;
+	u32 ramdisk_size = hdr->ramdisk_size;
+	u32 klen, rlen, off;
+
+	if (hdr->unused >= 0x3) {
+		vhdr = get_vendor_hdr_addr();
+		if (!vhdr)
+			return;
+		page = vhdr->page_size * 2;
+		kernel_size = hdr_v3->kernel_size;
+		ramdisk_size = hdr_v3->ramdisk_size;
+		vendor = (ulong)vhdr;
+		vendor_len = android_image_get_vendor_get_end(vhdr) - vendor;
+	}
+
+	klen = ALIGN(kernel_size, page);
+	rlen = ALIGN(ramdisk_size, page);
+	if (!page || page % 512 || page + klen + rlen > nbytes)
+		return;
+
+#ifdef CONFIG_SUNXI_COMP_NONE
+	kernel = android_image_get_kload(hdr);
+	if (kernel == buffer + page)
+		kernel = 0;
+#endif
+#ifdef CONFIG_SUNXI_INITRD_ROUTINE
+	if (ramdisk_size && vhdr)
+		ramdisk = env_get_hex("load_ramdisk_addr", vhdr->ramdisk_addr) +
+			  vhdr->vendor_ramdisk_size;
+	else if (ramdisk_size)
+		ramdisk = env_get_hex("load_ramdisk_addr", hdr->ramdisk_addr);
+#endif
+
+	if (kernel && (sunxi_flash_read_overlap(kernel, klen, buffer, nbytes) ||
+		       sunxi_flash_read_overlap(kernel, klen, vendor, vendor_len)))
+		kernel = 0;
+	if (ramdisk && (sunxi_flash_read_overlap(ramdisk, rlen, buffer, nbytes) ||
+			sunxi_flash_read_overlap(ramdisk, rlen, vendor, vendor_len) ||
+			sunxi_flash_read_overlap(ramdisk, rlen, kernel, kernel ? klen : 0)))
+		ramdisk = 0;
+	if (!kernel && !ramdisk)
+		return;
+
+	plan->nr_seg = 0;
+	off = page + klen + rlen;
+	sunxi_flash_read_add(plan, 0, page, buffer);
+	sunxi_flash_read_add(plan, page, klen, kernel ? kernel : buffer + page);
+	sunxi_flash_read_add(plan, page + klen, rlen,
+			     ramdisk ? ramdisk : buffer + page + klen);
+	sunxi_flash_read_add(plan, off, nbytes - off, buffer + off);
+	plan->kernel  = kernel;
+	plan->ramdisk = ramdisk;
+}
+
+static int sunxi_flash_read_hash(struct sunxi_flash_read_plan *plan, void *buf,
+				 u32 offset, u32 bytes)
+{
+#ifdef CONFIG_SUNXI_IMAGE_VERIFIER
+	if (offset < plan->hash_bytes)
+		return sunxi_verify_os_hash_update(buf, min(bytes,
+						   plan->hash_bytes - offset));
+#endif
+	return 0;
+}
+
+/*
+ * Read the plan in image order, the first SUNXI_FLASH_READ_FIRST_SIZE
+ * bytes are in the buffer already. When hashing, the CE job for each
+ * window is started before waiting for the read of the next one, see
+ * sunxi_verify_os_hash_update().
+ */
+static int sunxi_flash_read_run(struct sunxi_flash_read_plan *plan,
+				u32 start_block, ulong buffer)
+{
+	struct sunxi_flash_read_seg *seg;
+	struct sunxi_flash_req req;
+	u32 win = plan->hash_bytes ? SUNXI_FLASH_READ_WINDOW : U32_MAX;
+	u32 pos, len, off, prev_off = 0, prev_len = 0;
+	void *dst, *prev = NULL;
+	int busy, ret;
+
+	for (seg = plan->seg; seg < plan->seg + plan->nr_seg; seg++) {
+		for (pos = 0; pos < seg->bytes; pos += len) {
+			off = seg->offset + pos;
+			dst = (void *)(seg->dest + pos);
+			len = min(seg->bytes - pos, win);
+			busy = off >= SUNXI_FLASH_READ_FIRST_SIZE;
+			if (!busy) {
+				len = min(len, SUNXI_FLASH_READ_FIRST_SIZE - off);
+				if (dst != (void *)(buffer + off))
+					memcpy(dst, (void *)(buffer + off), len);
+			} else if (sunxi_flash_blk_submit(&req,
+							  start_block + off / 512,
+							  len / 512, dst)) {
+				return -EIO;
+			}
+
+			ret = prev ? sunxi_flash_read_hash(plan, prev, prev_off,
+							   prev_len) : 0;
+			if (busy && sunxi_flash_complete(&req) != len / 512)
+				ret = -EIO;
+			if (ret)
+				return ret;
+
+			prev	 = dst;
+			prev_off = off;
+			prev_len = len;
+		}
+	}
+
+	return prev ? sunxi_flash_read_hash(plan, prev, prev_off, prev_len) : 0;
+}
 
 static int sunxi_flash_read_part(struct blk_desc *desc, disk_partition_t *info,
 				 ulong buffer, ulong load_size)
 {
 	int ret;
-	u32 rbytes, rblock, testblock;
+	int android = 0, hash = 0;
+	u32 rbytes, nbytes, testblock;
 	u32 start_block;
 	u8 *addr;
 	struct andr_img_hdr *fb_hdr;
 	image_header_t *uz_hdr;
 	struct rtos_img_hdr *rtos_hdr;
+	struct sunxi_flash_read_plan plan;
 
 	addr	= (void *)buffer;
 	start_block = (uint)info->start;
+	android_image_set_preload(NULL, 0, 0);
 
+	bootstage_start(BOOTSTAGE_ID_ACCUM_SUNXI_IMAGE_LOAD, "sunxi_image_load");
 	testblock = SUNXI_FLASH_READ_FIRST_SIZE / 512;
 	ret       = blk_dread(desc, start_block, testblock, (u_char *)buffer);
 	if (ret != testblock) {
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_SUNXI_IMAGE_LOAD);
 		return 1;
 	}
 
 	fb_hdr = (struct andr_img_hdr *)addr;
 	uz_hdr = (image_header_t *)addr;
 	rtos_hdr = (struct rtos_img_hdr *)addr;
-	if (load_size)
-		rbytes = load_size;
-	else if (!memcmp(fb_hdr->magic, ANDR_BOOT_MAGIC, 8)) {
+	if (!memcmp(fb_hdr->magic, ANDR_BOOT_MAGIC, 8)) {
 		rbytes = android_image_get_end(fb_hdr) - (ulong)fb_hdr;
 
 		/*secure boot img may attached with an embbed cert*/
 		rbytes += sunxi_boot_image_get_embbed_cert_len(fb_hdr);
+		android = 1;
 	} else if (image_check_magic(uz_hdr)) {
 		rbytes = image_get_data_size(uz_hdr) + image_get_header_size();
 	} else if (!memcmp(rtos_hdr->rtos_magic, RTOS_BOOT_MAGIC, 8)) {
@@ -62,14 +228,38 @@ static int sunxi_flash_read_part(struct blk_desc *desc, disk_partition_t *info,
 	} else {
 		debug("bad boot image magic, maybe not a boot.img?\n");
 		rbytes = info->size * 512;
+		if (CONFIG_CMD_SUNXI_FLASH_READ_MAX &&
+		    rbytes > CONFIG_CMD_SUNXI_FLASH_READ_MAX)
+			rbytes = CONFIG_CMD_SUNXI_FLASH_READ_MAX;
+	}
+	if (load_size) {
+		/* the Android parts are only placed and hashed when all read */
+		if (load_size < rbytes)
+			android = 0;
+		rbytes = load_size;
 	}
 
-	rblock = (rbytes + 511) / 512 - testblock;
-	start_block += testblock;
-	addr += SUNXI_FLASH_READ_FIRST_SIZE;
+	nbytes = ALIGN(rbytes, 512);
+	memset(&plan, 0, sizeof(plan));
+	sunxi_flash_read_add(&plan, 0, nbytes, buffer);
+	if (android) {
+#if defined(CONFIG_SUNXI_IMAGE_VERIFIER) && !defined(CONFIG_SUNXI_AVB)
+		/* sunxi_verify_os() takes the hash made on the way in */
+		hash = gd->securemode;
+		if (hash) {
+			plan.hash_bytes = android_image_get_end(fb_hdr) - buffer;
+			sunxi_verify_os_hash_start(buffer, plan.hash_bytes);
+		}
+#endif
+		/* other verification wants the image in one piece */
+		if (!gd->securemode || hash)
+			sunxi_flash_read_plan_android(&plan, fb_hdr, nbytes);
+	}
 
-	ret = blk_dread(desc, start_block, rblock, (u_char *)addr);
-	ret = (ret == rblock) ? 0 : 1;
+	ret = sunxi_flash_read_run(&plan, start_block, buffer) ? 1 : 0;
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_SUNXI_IMAGE_LOAD);
+	if (!ret && android)
+		android_image_set_preload(fb_hdr, plan.kernel, plan.ramdisk);
 	sunxi_mem_info((char *)info->name, (void *)buffer, rbytes);
 	debug("sunxi flash read :offset %x, %d bytes %s\n", (u32)info->start,
 	      rbytes, ret == 0 ? "OK" : "ERROR");
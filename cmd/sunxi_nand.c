@@ -14,6 +14,10 @@
 #include <sunxi_flash.h>
 #include <part.h>
 #include <private_boot0.h>
+#ifdef CONFIG_AW_MTD_RAWNAND
+#include <linux/err.h>
+#include <linux/mtd/mtd.h>
+#endif
 
 extern __s32 check_sum(__u32 *mem_base, __u32 size);
 #define STRING(x) #x
@@ -89,6 +93,11 @@ extern __s32 check_sum(__u32 *mem_base, __u32 size);
 #define DUMP_READ_WRITE_PERFORMANCE_HELP                                       \
 	"  For example:want to test performance,usage:sunxi_nand_test performance\n"
 
+#define MTD_READ_PERFORMANCE                                                   \
+	"\033[0;36m<mtd read performance>: [parm1:mtd_read_perf] [parm2:offset] [parm3:size]\033[0m\n"
+#define MTD_READ_PERFORMANCE_HELP                                              \
+	"  For example:want to compare the zero-copy and page cache read of 4MB at 0x2000000 on nand0,usage:sunxi_nand_test mtd_read_perf 0x2000000 0x400000\n"
+
 #define CHECK_READ_WRITE_FUNCTION                                              \
 	"\033[0;36m<check read-write function>: [parm1:check read-write]\033[0m\n"
 #define CHECK_READ_WRITE_FUNCTION_HELP                                         \
@@ -890,6 +899,72 @@ static void sunxi_nand_performance(void)
 	sunxi_nand_performance_test(&read_speed, &write_speed);
 }
 
+#ifdef CONFIG_AW_MTD_RAWNAND
+static ulong sunxi_nand_mtd_read_time(struct mtd_info *mtd, loff_t from,
+		size_t len, u_char *buf)
+{
+	size_t retlen = 0;
+	ulong time = timer_get_us();
+	int ret = mtd_read(mtd, from, len, &retlen, buf);
+
+	time = timer_get_us() - time;
+	if (ret < 0 && ret != -EUCLEAN)
+		printf("%s read 0x%llx fail ret@%d retlen@0x%zx\n", __func__,
+				from, ret, retlen);
+
+	return time ? time : 1;
+}
+
+/*
+ * Same range read to a dma aligned buffer, which takes the zero-copy
+ * (cache read) path, and to an unaligned one, which goes page by page
+ * through the driver's page cache. Both must read the same data.
+ */
+static void sunxi_nand_mtd_read_perf(loff_t from, size_t len)
+{
+	struct mtd_info *mtd = get_mtd_device_nm("nand0");
+	unsigned char *buf = NULL, *ref = NULL;
+	ulong direct_us = 0, cached_us = 0;
+
+	if (IS_ERR_OR_NULL(mtd)) {
+		printf("%s no nand0 mtd device\n", __func__);
+		return;
+	}
+
+	from &= ~(loff_t)(mtd->writesize - 1);
+	len = ALIGN(len, mtd->writesize);
+	if (!len || from + len > mtd->size) {
+		printf("%s 0x%llx + 0x%zx out of nand0\n", __func__, from, len);
+		goto out;
+	}
+
+	buf = malloc_align(len, ARCH_DMA_MINALIGN);
+	ref = malloc_align(len + ARCH_DMA_MINALIGN, ARCH_DMA_MINALIGN);
+	if (!buf || !ref) {
+		printf("%s malloc buffer fail\n", __func__);
+		goto out;
+	}
+
+	cached_us = sunxi_nand_mtd_read_time(mtd, from, len, ref + 1);
+	direct_us = sunxi_nand_mtd_read_time(mtd, from, len, buf);
+
+	printf("read 0x%llx len 0x%zx (%zu KB)\n", from, len, len >> 10);
+	printf("page cache: time = %lu us, speed = \033[0;31m%llu KB/s \033[0;0m\n",
+			cached_us, (unsigned long long)len * 1000000 / cached_us / 1024);
+	printf("zero-copy : time = %lu us, speed = \033[0;31m%llu KB/s \033[0;0m\n",
+			direct_us, (unsigned long long)len * 1000000 / direct_us / 1024);
+	if (memcmp(buf, ref + 1, len))
+		printf("\033[0;31mdata of the two reads differ\033[0;0m\n");
+
+out:
+	if (buf)
+		free_align(buf);
+	if (ref)
+		free_align(ref);
+	put_mtd_device(mtd);
+}
+#endif
+
 void sunxi_nand_test_read_write_normal(void)
 {
 	int uboot_next_block = get_uboot_next_block();
@@ -1139,6 +1214,13 @@ int do_sunxi_nand_dump(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 		printf("performance start ...");
 		sunxi_nand_performance();
 
+#ifdef CONFIG_AW_MTD_RAWNAND
+	} else if (!strcmp(argv[1], "mtd_read_perf")) {
+		if (argc != 4)
+			return CMD_RET_USAGE;
+		sunxi_nand_mtd_read_perf(simple_strtoull(argv[2], NULL, 0),
+				simple_strtoul(argv[3], NULL, 0));
+#endif
 	} else if (!strcmp(argv[1], "read-write")) {
 		printf("check read-write basic function is noraml?");
 		sunxi_nand_test_read_write_normal();
@@ -1166,6 +1248,7 @@ U_BOOT_CMD(
 		DUMP_BAD_TABLE DUMP_BAD_TABLE_HELP DUMP_BOOT0
 		DUMP_BOOT0_HELP DUMP_READ_WRITE_PERFORMANCE
 		DUMP_READ_WRITE_PERFORMANCE_HELP
+		MTD_READ_PERFORMANCE MTD_READ_PERFORMANCE_HELP
 		CHECK_READ_WRITE_FUNCTION
 		CHECK_READ_WRITE_FUNCTION_HELP
 		"\n");
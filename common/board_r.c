@@ -525,7 +525,9 @@ static int initr_sunxi_plat(void)
 	if (!gd->boot_logo_addr) {
 		tick_printf("flash init start\n");
 #ifdef CONFIG_SUNXI_FLASH
+		bootstage_start(BOOTSTAGE_ID_ACCUM_SUNXI_FLASH, "sunxi_flash_init");
 		ret = sunxi_flash_init_ext();
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_SUNXI_FLASH);
 		if (ret)
 			return ret;
 #endif
@@ -545,7 +547,9 @@ static int initr_sunxi_plat(void)
 #endif
 
 #ifdef CONFIG_BOOT_GUI
+	bootstage_start(BOOTSTAGE_ID_ACCUM_SUNXI_EARLY_LOGO, "sunxi_early_logo");
 	sunxi_early_logo_display();
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_SUNXI_EARLY_LOGO);
 #endif
 
 #ifdef CONFIG_SUNXI_BOX_STANDBY
@@ -559,7 +563,9 @@ static int initr_sunxi_plat(void)
 	if (gd->boot_logo_addr) {
 		tick_printf("flash init start\n");
 #ifdef CONFIG_SUNXI_FLASH
+		bootstage_start(BOOTSTAGE_ID_ACCUM_SUNXI_FLASH, "sunxi_flash_init");
 		ret = sunxi_flash_init_ext();
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_SUNXI_FLASH);
 		if (ret)
 			return ret;
 #endif
@@ -567,19 +573,26 @@ static int initr_sunxi_plat(void)
 	if (workmode == WORK_MODE_BOOT) {
 #ifdef CONFIG_SUNXI_UPDATE_GPT
 		int sunxi_update_gpt(void);
+		bootstage_start(BOOTSTAGE_ID_ACCUM_SUNXI_GPT, "sunxi_update_gpt");
 		sunxi_update_gpt();
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_SUNXI_GPT);
 #endif
 
 #ifdef CONFIG_ENABLE_MTD_CMDLINE_PARTS_BY_ENV
 	initr_env();
 #endif
 
+		bootstage_start(BOOTSTAGE_ID_ACCUM_SUNXI_PART_MAP,
+				"sunxi_part_map");
 		sunxi_probe_partition_map();
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_SUNXI_PART_MAP);
 	}
 
 #ifdef CONFIG_SUNXI_ROTPK_BURN_ENABLE_BY_TOOL
 	if (get_boot_work_mode() == WORK_MODE_BOOT) {
+		bootstage_start(BOOTSTAGE_ID_ACCUM_SUNXI_ROTPK, "sunxi_rotpk");
 		ret = sunxi_burn_rotpk();
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_SUNXI_ROTPK);
 		if (ret)
 			return ret;
 	}
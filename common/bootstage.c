@@ -290,6 +290,11 @@ static int add_bootstages_devicetree(struct fdt_header *blob)
 				rec->start_us ? "accum" : "mark",
 				rec->time_us))
 			return -EINVAL;
+
+		/* When the accum record last started, for a timeline */
+		if (rec->start_us &&
+		    fdt_setprop_cell(blob, node, "start", rec->start_us))
+			return -EINVAL;
 	}
 
 	return 0;
@@ -14,6 +14,7 @@
 #include <asm/global_data.h>
 #include <linux/libfdt.h>
 #include <fdt_support.h>
+#include <fdt_index.h>
 #include <exports.h>
 #include <fdtdec.h>
 
@@ -187,6 +188,7 @@ int fdt_find_and_setprop(void *fdt, const char *node, const char *prop,
 	if ((!create) && (fdt_get_property(fdt, nodeoff, prop, NULL) == NULL))
 		return 0; /* create flag not set; so exit quietly */
 
+	fdt_index_invalidate();
 	return fdt_setprop(fdt, nodeoff, prop, val, len);
 }
 
@@ -1445,6 +1447,8 @@ int fdt_set_phandle(void *fdt, int nodeoffset, uint32_t phandle)
 	}
 #endif
 
+	/* an existing phandle is replaced in place */
+	fdt_index_invalidate();
 	ret = fdt_setprop_cell(fdt, nodeoffset, "phandle", phandle);
 	if (ret < 0)
 		return ret;
@@ -1503,6 +1507,7 @@ int fdt_set_node_status(void *fdt, int nodeoffset,
 	if (nodeoffset < 0)
 		return nodeoffset;
 
+	fdt_index_invalidate();
 	switch (status) {
 	case FDT_STATUS_OKAY:
 		ret = fdt_setprop_string(fdt, nodeoffset, "status", "okay");
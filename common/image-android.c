@@ -21,6 +21,21 @@ static struct vendor_boot_img_hdr *vendor_hdr;
 /* static char img_cmdline[ANDR_BOOT_ARGS_SIZE + ANDR_BOOT_EXTRA_ARGS_SIZE]; */
 static char *img_cmdline;
 
+/* where the loader put the image at @hdr, see android_image_set_preload() */
+static struct {
+	const struct andr_img_hdr *hdr;
+	ulong kernel;
+	ulong ramdisk;
+} andr_preload;
+
+void android_image_set_preload(const struct andr_img_hdr *hdr, ulong kernel,
+			       ulong ramdisk)
+{
+	andr_preload.hdr     = hdr;
+	andr_preload.kernel  = kernel;
+	andr_preload.ramdisk = ramdisk;
+}
+
 int android_image_get_vendor_get_end(const struct vendor_boot_img_hdr *vendor_hdr)
 {
 	uint end = -1;
@@ -268,6 +283,8 @@ int android_image_get_kernel(const struct andr_img_hdr *hdr, int verify,
 	if (os_data) {
 		*os_data = (ulong)hdr;
 		*os_data += page_size;
+		if (andr_preload.hdr == hdr && andr_preload.kernel)
+			*os_data = andr_preload.kernel;
 	}
 	if (os_len)
 		*os_len = kernel_size;
@@ -343,6 +360,8 @@ int android_image_get_ramdisk(const struct andr_img_hdr *hdr,
 	*rd_data = (unsigned long)hdr;
 	*rd_data += page_size;
 	*rd_data += ALIGN(kernel_size, page_size);
+	if (andr_preload.hdr == hdr && andr_preload.ramdisk)
+		*rd_data = andr_preload.ramdisk;
 	*rd_len = ramdisk_size;
 	debug("rd_data:0x%lx, rd_len:0x%lx\n", *rd_data, *rd_len);
 	return 0;
@@ -432,7 +451,9 @@ int android_image_get_dtb(const struct andr_img_hdr *hdr,
 			*dtb_data += ALIGN(hdr->recovery_dtbo_size, hdr->page_size);
 
 			*dtb_len = hdr->dtb_size;
-			part_start = sunxi_partition_get_offset_byname("boot");
+			/* the loader already brought in the whole image */
+			part_start = andr_preload.hdr == hdr ? 0 :
+				     sunxi_partition_get_offset_byname("boot");
 			if (part_start != 0) {
 					sunxi_flash_read(part_start + (*dtb_data - (unsigned long)hdr)/512, ALIGN(hdr->dtb_size, 512)/512, (char *)(*dtb_data));
 			}
@@ -30,9 +30,47 @@ int dm_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 
 int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
 {
+	if (mmc->req)
+		mmc_req_wait(mmc->req);
 	return dm_mmc_send_cmd(mmc->dev, cmd, data);
 }
 
+int dm_mmc_submit_cmd(struct udevice *dev, struct mmc_cmd *cmd,
+		      struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+
+	if (!ops->submit_cmd || !ops->poll_cmd)
+		return -ENOSYS;
+	mmmc_trace_before_send(mmc, cmd);
+	return ops->submit_cmd(dev, cmd, data);
+}
+
+int mmc_submit_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
+{
+	return dm_mmc_submit_cmd(mmc->dev, cmd, data);
+}
+
+int dm_mmc_poll_cmd(struct udevice *dev, struct mmc_cmd *cmd,
+		    struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+	int ret;
+
+	ret = ops->poll_cmd(dev, cmd, data);
+	if (ret != -EBUSY)
+		mmmc_trace_after_send(mmc, cmd, ret);
+
+	return ret;
+}
+
+int mmc_poll_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
+{
+	return dm_mmc_poll_cmd(mmc->dev, cmd, data);
+}
+
 int dm_mmc_set_ios(struct udevice *dev)
 {
 	struct dm_mmc_ops *ops = mmc_get_ops(dev);
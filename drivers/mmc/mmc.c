@@ -19,6 +19,7 @@
 #include <memalign.h>
 #include <linux/list.h>
 #include <div64.h>
+#include <bootstage.h>
 
 #include <private_uboot.h>
 #include "mmc_private.h"
@@ -249,12 +250,33 @@ int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
 {
 	int ret;
 
+	if (mmc->req)
+		mmc_req_wait(mmc->req);
 	mmmc_trace_before_send(mmc, cmd);
 	ret = mmc->cfg->ops->send_cmd(mmc, cmd, data);
 	mmmc_trace_after_send(mmc, cmd, ret);
 
 	return ret;
 }
+
+int mmc_submit_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
+{
+	if (!mmc->cfg->ops->submit_cmd || !mmc->cfg->ops->poll_cmd)
+		return -ENOSYS;
+	mmmc_trace_before_send(mmc, cmd);
+	return mmc->cfg->ops->submit_cmd(mmc, cmd, data);
+}
+
+int mmc_poll_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
+{
+	int ret;
+
+	ret = mmc->cfg->ops->poll_cmd(mmc, cmd, data);
+	if (ret != -EBUSY)
+		mmmc_trace_after_send(mmc, cmd, ret);
+
+	return ret;
+}
 #endif
 
 int mmc_send_status(struct mmc *mmc, int timeout)
@@ -3632,12 +3654,73 @@ __ERROR_END:
 	return;
 }
 
+/* tune all speed modes the card supports, keeps the result in cfg.sdly */
+static int mmc_run_tuning(struct mmc *mmc)
+{
+	int err;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_MMC_TUNING, "mmc_tuning");
+	mmc->msglevel = 0x0;
+	mmc->do_tuning = 0x1;
+	mmc->tuning_end = 0x0;
+
+	err = sunxi_mmc_tuning_init();
+	if (err) {
+		MMCINFO("init tuning failed\n");
+		goto out;
+	}
+
+	err = sunxi_write_tuning(mmc);
+	if (err) {
+		MMCINFO("Write pattern failed\n");
+		goto out;
+	}
+
+	err = sunxi_bus_tuning(mmc);
+	if (err) {
+		MMCINFO("bus tuning fail, err %d\n", err);
+		goto out;
+	}
+
+	mmc->msglevel = 0x1;
+	mmc->do_tuning = 0x0;
+	mmc->tuning_end = 0x1; //comment this line for debug, test tuning during boot.
+
+	err = sunxi_mmc_tuning_exit();
+	if (err)
+		MMCINFO("exit tuning failed\n");
+
+out:
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_MMC_TUNING);
+	return err;
+}
+
+/*
+ * load the tuning result stored for this card and switch to the best speed
+ * mode with it. the card needs a fresh init if this fails.
+ */
+static int mmc_use_stored_tuning(struct mmc *mmc)
+{
+	int err;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_MMC_TUNING_CHECK, "mmc_tuning_check");
+	err = sunxi_mmc_tuning_cache_load(mmc);
+	if (!err)
+		err = sunxi_switch_to_best_bus(mmc);
+	if (!err)
+		err = sunxi_mmc_tuning_cache_check(mmc);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_MMC_TUNING_CHECK);
+
+	return err;
+}
+
 int mmc_init_product(struct mmc *mmc)
 {
 	struct sunxi_mmc_priv *priv = mmc->priv;
 	struct mmc_config *cfg = &priv->cfg;
 	int err = 0;
 	bool uhs_en = supports_uhs(cfg->host_caps);
+	int use_stored_tuning = !cfg->force_boot_tuning;
 
 	mmc->msglevel = 0x1;
 retry:
@@ -3727,37 +3810,21 @@ retry:
 		}
     }
 */
-	mmc->msglevel = 0x0;
-	mmc->do_tuning = 0x1;
-	mmc->tuning_end = 0x0;
-
-	err = sunxi_mmc_tuning_init();
-	if (err) {
-		MMCINFO("init tuning failed\n");
-		return err;
-	}
-
-	err = sunxi_write_tuning(mmc);
-	if (err) {
-		MMCINFO("Write pattern failed\n");
-		return err;
+	if (use_stored_tuning && mmc_use_stored_tuning(mmc) == 0) {
+		mmc->msglevel = 0x1;
+		mmc->do_tuning = 0x0;
+		mmc->tuning_end = 0x1;
+		return 0;
 	}
-
-	err = sunxi_bus_tuning(mmc);
-	if (err) {
-		MMCINFO("bus tuning fail, err %d\n", err);
-		return err;
+	if (use_stored_tuning) {
+		/* start over from an untuned card */
+		use_stored_tuning = 0;
+		goto retry;
 	}
 
-	mmc->msglevel = 0x1;
-	mmc->do_tuning = 0x0;
-	mmc->tuning_end = 0x1; //comment this line for debug, test tuning during boot.
-
-	err = sunxi_mmc_tuning_exit();
-	if (err) {
-		MMCINFO("exit tuning failed\n");
+	err = mmc_run_tuning(mmc);
+	if (err)
 		return err;
-	}
 
 	err = sunxi_switch_to_best_bus(mmc);
 	if (err) {
@@ -3892,39 +3959,26 @@ int mmc_init(struct mmc *mmc)
 
 			}
 
-			if (need_tuning) {
-				mmc->msglevel = 0x0;
-				mmc->do_tuning = 0x1;
-				mmc->tuning_end = 0x0;
-
-				err = sunxi_mmc_tuning_init();
-				if (err) {
-					MMCINFO("init tuning failed\n");
-					goto ERR_RET;
-				}
-
-				err = sunxi_write_tuning(mmc);
-				if (err) {
-					MMCINFO("Write pattern failed\n");
-					goto ERR_RET;
-				}
+			if (!need_tuning) {
+				if (mmc_use_stored_tuning(mmc) == 0)
+					goto DONE;
 
-				err = sunxi_bus_tuning(mmc);
+				/* start over from an untuned card */
+				mmc->has_init = 0;
+				err = mmc_start_init(mmc);
+				if (!err)
+					err = mmc_complete_init(mmc);
 				if (err) {
-					MMCINFO("bus tuning fail, err %d\n", err);
+					MMCINFO("%s: mmc init fail, err %d\n", __FUNCTION__, err);
 					goto ERR_RET;
 				}
+				need_tuning = 1;
+			}
 
-				mmc->msglevel = 0x1;
-				mmc->do_tuning = 0x0;
-				mmc->tuning_end = 0x1; //comment this line for debug, test tuning during boot.
-
-				err = sunxi_mmc_tuning_exit();
-				if (err) {
-					MMCINFO("exit tuning failed\n");
+			if (need_tuning) {
+				err = mmc_run_tuning(mmc);
+				if (err)
 					goto ERR_RET;
-				}
-
 			}
 		}
 
@@ -3933,6 +3987,7 @@ int mmc_init(struct mmc *mmc)
 			MMCINFO("switch to best speed mode fail\n");
 			goto ERR_RET;
 		}
+DONE:
 
 		if (need_tuning) {
 			err = mmc_write_info(priv->mmc_no, NULL,
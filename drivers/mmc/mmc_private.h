@@ -15,6 +15,9 @@ extern int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 			struct mmc_data *data);
 extern int mmc_send_status(struct mmc *mmc, int timeout);
 extern int mmc_set_blocklen(struct mmc *mmc, int len);
+int mmc_submit_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
+		   struct mmc_data *data);
+int mmc_poll_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data);
 #ifdef CONFIG_FSL_ESDHC_ADAPTER_IDENT
 void mmc_adapter_card_type_ident(void);
 #endif
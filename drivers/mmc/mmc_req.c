@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Block requests that run while the caller works
+ *
+ * The data command is started with the host's submit_cmd() and checked
+ * with poll_cmd(). What follows it, the stop command and for writes the
+ * wait for the card to leave the programming state, is sent once the
+ * data command is found finished. A request that fails is done again
+ * through the blocking block read/write path, which carries the host
+ * retry and re-init handling.
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <errno.h>
+#include <memalign.h>
+#include <mmc.h>
+#include "mmc_private.h"
+#include "mmc_def.h"
+
+static void mmc_req_finish(struct mmc_req *req, int ret)
+{
+	req->state = MMC_REQ_DONE;
+	req->ret = ret;
+}
+
+static void mmc_req_sync(struct mmc_req *req)
+{
+	struct blk_desc *desc = mmc_get_blk_desc(req->mmc);
+	ulong n;
+
+	if (req->write)
+		n = blk_dwrite(desc, req->start, req->blkcnt, req->buf);
+	else
+		n = blk_dread(desc, req->start, req->blkcnt, req->buf);
+
+	mmc_req_finish(req, n == req->blkcnt ? (int)n : -EIO);
+}
+
+static int mmc_req_start(struct mmc_req *req)
+{
+	struct mmc *mmc = req->mmc;
+	struct blk_desc *desc = mmc_get_blk_desc(mmc);
+	uint blksz = mmc->read_bl_len;
+	int ret;
+
+#if CONFIG_IS_ENABLED(MMC_WRITE)
+	if (req->write)
+		blksz = mmc->write_bl_len;
+#else
+	if (req->write)
+		return -ENOSYS;
+#endif
+
+	ret = blk_dselect_hwpart(desc, desc->hwpart);
+	if (ret < 0)
+		return ret;
+
+	ret = mmc_set_blocklen(mmc, blksz);
+	if (ret)
+		return ret;
+
+	if (req->write)
+		req->cmd.cmdidx = req->blkcnt > 1 ?
+			MMC_CMD_WRITE_MULTIPLE_BLOCK :
+			MMC_CMD_WRITE_SINGLE_BLOCK;
+	else
+		req->cmd.cmdidx = req->blkcnt > 1 ?
+			MMC_CMD_READ_MULTIPLE_BLOCK :
+			MMC_CMD_READ_SINGLE_BLOCK;
+	req->cmd.cmdarg = mmc->high_capacity ? req->start : req->start * blksz;
+	req->cmd.resp_type = MMC_RSP_R1;
+
+	req->data.dest = req->buf;
+	req->data.blocks = req->blkcnt;
+	req->data.blocksize = blksz;
+	req->data.flags = req->write ? MMC_DATA_WRITE : MMC_DATA_READ;
+
+	return mmc_submit_cmd(mmc, &req->cmd, &req->data);
+}
+
+/* Commands that follow the data, once it is through */
+static int mmc_req_end(struct mmc_req *req)
+{
+	struct mmc *mmc = req->mmc;
+	struct mmc_cmd cmd;
+
+	if (req->blkcnt > 1 && !mmc_host_is_spi(mmc)) {
+		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
+		cmd.cmdarg = 0;
+		cmd.resp_type = MMC_RSP_R1b;
+		mmc->manual_stop_flag = 0;
+		if (mmc_send_cmd(mmc, &cmd, NULL)) {
+			MMCINFO("mmc fail to send stop cmd\n");
+			return -EIO;
+		}
+	}
+
+	if (req->write)
+		return mmc_send_status(mmc, 1000);
+
+	return 0;
+}
+
+int mmc_req_submit(struct mmc *mmc, struct mmc_req *req, lbaint_t start,
+		   lbaint_t blkcnt, void *buf, bool write)
+{
+	if (mmc->req)
+		return -EBUSY;
+	if (!blkcnt || start + blkcnt > mmc_get_blk_desc(mmc)->lba)
+		return -EINVAL;
+
+	memset(req, 0, sizeof(*req));
+	req->mmc = mmc;
+	req->start = start;
+	req->blkcnt = blkcnt;
+	req->buf = buf;
+	req->write = write;
+	req->state = MMC_REQ_BUSY;
+
+	/* the blocking path splits and bounces what one command can't take */
+	if (blkcnt > mmc->cfg->b_max ||
+	    (ulong)buf & (ARCH_DMA_MINALIGN - 1) ||
+	    mmc_req_start(req)) {
+		mmc_req_sync(req);
+		return 0;
+	}
+
+	mmc->req = req;
+
+	return 0;
+}
+
+int mmc_req_poll(struct mmc_req *req)
+{
+	struct mmc *mmc = req->mmc;
+	int ret;
+
+	if (req->state == MMC_REQ_IDLE)
+		return -EINVAL;
+	if (req->state == MMC_REQ_DONE)
+		return req->ret < 0 ? req->ret : 0;
+
+	ret = mmc_poll_cmd(mmc, &req->cmd, &req->data);
+	if (ret == -EBUSY)
+		return ret;
+
+	mmc->req = NULL;
+	if (!ret)
+		ret = mmc_req_end(req);
+	if (ret) {
+		MMCINFO("mmc request at 0x" LBAF " failed, retry blocking\n",
+			req->start);
+		mmc_req_sync(req);
+	} else {
+		mmc_req_finish(req, req->blkcnt);
+	}
+
+	return req->ret < 0 ? req->ret : 0;
+}
+
+int mmc_req_wait(struct mmc_req *req)
+{
+	int ret;
+
+	do {
+		ret = mmc_req_poll(req);
+	} while (ret == -EBUSY);
+
+	return ret ? ret : req->ret;
+}
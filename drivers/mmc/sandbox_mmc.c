@@ -11,9 +11,15 @@
 #include <mmc.h>
 #include <asm/test.h>
 
+/* Polls a submitted command stays busy for, to test deferred completion */
+#define SANDBOX_MMC_REQ_POLLS	2
+
 struct sandbox_mmc_plat {
 	struct mmc_config cfg;
 	struct mmc mmc;
+	struct mmc_cmd *req_cmd;	/* command waiting in poll_cmd() */
+	struct mmc_data *req_data;
+	int req_polls;
 };
 
 /**
@@ -85,6 +91,36 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	return 0;
 }
 
+static int sandbox_mmc_submit_cmd(struct udevice *dev, struct mmc_cmd *cmd,
+				  struct mmc_data *data)
+{
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
+	if (plat->req_cmd)
+		return -EBUSY;
+	plat->req_cmd = cmd;
+	plat->req_data = data;
+	plat->req_polls = SANDBOX_MMC_REQ_POLLS;
+
+	return 0;
+}
+
+/* The command only runs once it has been polled a few times */
+static int sandbox_mmc_poll_cmd(struct udevice *dev, struct mmc_cmd *cmd,
+				struct mmc_data *data)
+{
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
+	if (plat->req_cmd != cmd || plat->req_data != data)
+		return -EINVAL;
+	if (--plat->req_polls > 0)
+		return -EBUSY;
+	plat->req_cmd = NULL;
+	plat->req_data = NULL;
+
+	return sandbox_mmc_send_cmd(dev, cmd, data);
+}
+
 static int sandbox_mmc_set_ios(struct udevice *dev)
 {
 	return 0;
@@ -99,6 +135,8 @@ static const struct dm_mmc_ops sandbox_mmc_ops = {
 	.send_cmd = sandbox_mmc_send_cmd,
 	.set_ios = sandbox_mmc_set_ios,
 	.get_cd = sandbox_mmc_get_cd,
+	.submit_cmd = sandbox_mmc_submit_cmd,
+	.poll_cmd = sandbox_mmc_poll_cmd,
 };
 
 int sandbox_mmc_probe(struct udevice *dev)
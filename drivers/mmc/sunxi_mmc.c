@@ -534,30 +534,15 @@ static void sunxi_mmc_set_rdtmout_reg(struct sunxi_mmc_priv *priv, struct mmc *m
 		mmc->speed_mode, mmc->clock, readl(&priv->reg->ntsr));
 }
 
-static int sunxi_mmc_do_send_cmd_common(struct sunxi_mmc_priv *priv,
-				     struct mmc *mmc, struct mmc_cmd *cmd,
-				     struct mmc_data *data)
+/* Write the command and, for a data command, start the transfer */
+static int sunxi_mmc_start_cmd(struct sunxi_mmc_priv *priv,
+			       struct mmc *mmc, struct mmc_cmd *cmd,
+			       struct mmc_data *data, unsigned int *usedma)
 {
 	unsigned int cmdval = SUNXI_MMC_CMD_START;
-	unsigned int timeout_msecs;
 	int error = 0;
-	unsigned int status = 0;
-	unsigned int usedma = 0;
 	unsigned int bytecnt = 0;
 
-	if (priv->fatal_err) {
-		MMCINFO("mmc %d Found fatal err,so no send cmd\n", priv->mmc_no);
-		return -1;
-	}
-	if (cmd->resp_type & MMC_RSP_BUSY)
-		MMCDBG("mmc cmd %d check rsp busy\n", cmd->cmdidx);
-	if (cmd->cmdidx == 12 && mmc->manual_stop_flag == 0) {
-		MMCDBG("usually, cmd12 is sent after cmd18/cmd25 automantically.\n");
-		/* don't wait write busy here, because no cmd12 will be sent for cmd24.
-		 * write busy status will be check after sent cmd25. */
-		return 0;
-	}
-
 	if (!cmd->cmdidx)
 		cmdval |= SUNXI_MMC_CMD_SEND_INIT_SEQ;
 	if (cmd->resp_type & MMC_RSP_PRESENT)
@@ -805,7 +790,7 @@ static int sunxi_mmc_do_send_cmd_common(struct sunxi_mmc_priv *priv,
 		if ((u32)(long)data->dest & 0x3) {
 			error = -1;
 			MMCINFO("%s,%d,dest is not 4 aligned\n", __FUNCTION__, __LINE__);
-			goto out;
+			return error;
 		}
 
 		cmdval |= SUNXI_MMC_CMD_DATA_EXPIRE|SUNXI_MMC_CMD_WAIT_PRE_OVER;
@@ -848,7 +833,7 @@ static int sunxi_mmc_do_send_cmd_common(struct sunxi_mmc_priv *priv,
 #else
 		if (0) {
 #endif
-			usedma = 1;
+			*usedma = 1;
 			writel(readl(&priv->reg->gctrl) & (~SUNXI_MMC_GCTRL_ACCESS_BY_AHB), &priv->reg->gctrl);
 			ret = mmc_trans_data_by_dma(priv, mmc, data);
 			writel(cmdval | cmd->cmdidx, &priv->reg->cmd);
@@ -861,10 +846,29 @@ static int sunxi_mmc_do_send_cmd_common(struct sunxi_mmc_priv *priv,
 			error = readl(&priv->reg->rint) &
 				SUNXI_MMC_RINT_INTERRUPT_ERROR_BIT;
 			error = -ETIMEDOUT;
-			goto out;
 		}
 	}
 
+	return error;
+}
+
+/*
+ * Wait for the command started by sunxi_mmc_start_cmd(), read the response
+ * and put the host back in shape for the next one. @error is what the
+ * start returned, on error only the cleanup is done.
+ */
+static int sunxi_mmc_end_cmd(struct sunxi_mmc_priv *priv,
+			     struct mmc *mmc, struct mmc_cmd *cmd,
+			     struct mmc_data *data, unsigned int usedma,
+			     int error)
+{
+	unsigned int timeout_msecs;
+	unsigned int status = 0;
+	unsigned int bytecnt = data ? data->blocksize * data->blocks : 0;
+
+	if (error)
+		goto out;
+
 	error = mmc_rint_wait(priv, mmc, 1000, SUNXI_MMC_RINT_COMMAND_DONE,
 			      "cmd", usedma);
 	if (error) {
@@ -1004,6 +1008,90 @@ out:
 	return error;
 }
 
+static int sunxi_mmc_do_send_cmd_common(struct sunxi_mmc_priv *priv,
+				     struct mmc *mmc, struct mmc_cmd *cmd,
+				     struct mmc_data *data)
+{
+	unsigned int usedma = 0;
+	int error;
+
+	if (priv->fatal_err) {
+		MMCINFO("mmc %d Found fatal err,so no send cmd\n", priv->mmc_no);
+		return -1;
+	}
+	if (cmd->resp_type & MMC_RSP_BUSY)
+		MMCDBG("mmc cmd %d check rsp busy\n", cmd->cmdidx);
+	if (cmd->cmdidx == 12 && mmc->manual_stop_flag == 0) {
+		MMCDBG("usually, cmd12 is sent after cmd18/cmd25 automantically.\n");
+		/* don't wait write busy here, because no cmd12 will be sent for cmd24.
+		 * write busy status will be check after sent cmd25. */
+		return 0;
+	}
+
+	error = sunxi_mmc_start_cmd(priv, mmc, cmd, data, &usedma);
+
+	return sunxi_mmc_end_cmd(priv, mmc, cmd, data, usedma, error);
+}
+
+/*
+ * Start a data command and return, the DMA runs while the caller works.
+ * A failed start is cleaned up here and reported to the caller, which
+ * falls back to the blocking path with its retries.
+ */
+static int sunxi_mmc_submit_cmd_common(struct sunxi_mmc_priv *priv,
+				       struct mmc *mmc, struct mmc_cmd *cmd,
+				       struct mmc_data *data)
+{
+	unsigned int usedma = 0;
+	int error;
+
+	if (!data)
+		return -EINVAL;
+	if (priv->fatal_err)
+		return -EIO;
+
+	error = sunxi_mmc_start_cmd(priv, mmc, cmd, data, &usedma);
+	if (error)
+		return sunxi_mmc_end_cmd(priv, mmc, cmd, data, usedma, error);
+
+	priv->req_usedma = usedma;
+	priv->req_start = get_timer(0);
+
+	return 0;
+}
+
+/* Worst case of the cmd, data and card busy waits in sunxi_mmc_end_cmd() */
+#define SUNXI_MMC_REQ_TIMEOUT_MS	(1000 + 6000 + 2000)
+
+static int sunxi_mmc_poll_cmd_common(struct sunxi_mmc_priv *priv,
+				     struct mmc *mmc, struct mmc_cmd *cmd,
+				     struct mmc_data *data)
+{
+	unsigned int rint = readl(&priv->reg->rint);
+	unsigned int done_bit = data->blocks > 1 ?
+				SUNXI_MMC_RINT_AUTO_COMMAND_DONE :
+				SUNXI_MMC_RINT_DATA_OVER;
+	int error = 0;
+
+	if (get_timer(priv->req_start) > SUNXI_MMC_REQ_TIMEOUT_MS) {
+		MMCMSG(mmc, "mmc %d request timeout, status %x\n",
+		       priv->mmc_no, rint);
+		error = -ETIMEDOUT;
+	} else if (!(rint & SUNXI_MMC_RINT_INTERRUPT_ERROR_BIT)) {
+		if (!(rint & SUNXI_MMC_RINT_COMMAND_DONE) ||
+		    !(rint & done_bit) ||
+		    (priv->req_usedma && !(readl(&priv->reg->idst) & 0x3)))
+			return -EBUSY;
+		if ((data->flags & MMC_DATA_WRITE) &&
+		    (readl(&priv->reg->status) &
+		     SUNXI_MMC_STATUS_CARD_DATA_BUSY))
+			return -EBUSY;
+	}
+
+	/* finished or failed, the waits in the end half return at once */
+	return sunxi_mmc_end_cmd(priv, mmc, cmd, data, priv->req_usedma, error);
+}
+
 static int mmc_raw_send_manual_stop(struct mmc *mmc)
 {
 	int ret = 0;
@@ -1113,6 +1201,22 @@ static int sunxi_mmc_send_cmd_legacy(struct mmc *mmc, struct mmc_cmd *cmd,
 	return sunxi_mmc_send_cmd_common(priv, mmc, cmd, data);
 }
 
+static int sunxi_mmc_submit_cmd_legacy(struct mmc *mmc, struct mmc_cmd *cmd,
+				       struct mmc_data *data)
+{
+	struct sunxi_mmc_priv *priv = mmc->priv;
+
+	return sunxi_mmc_submit_cmd_common(priv, mmc, cmd, data);
+}
+
+static int sunxi_mmc_poll_cmd_legacy(struct mmc *mmc, struct mmc_cmd *cmd,
+				     struct mmc_data *data)
+{
+	struct sunxi_mmc_priv *priv = mmc->priv;
+
+	return sunxi_mmc_poll_cmd_common(priv, mmc, cmd, data);
+}
+
 static int sunxi_mmc_getcd_legacy(struct mmc *mmc)
 {
 	struct sunxi_mmc_priv *priv = mmc->priv;
@@ -1268,6 +1372,8 @@ static const struct mmc_ops sunxi_mmc_ops = {
 	.getcd		= sunxi_mmc_getcd_legacy,
 	.decide_retry		= sunxi_decide_rty,
 	.get_detail_errno	= sunxi_detail_errno,
+	.submit_cmd	= sunxi_mmc_submit_cmd_legacy,
+	.poll_cmd	= sunxi_mmc_poll_cmd_legacy,
 };
 
 
@@ -1455,6 +1561,24 @@ static int sunxi_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	return sunxi_mmc_send_cmd_common(priv, &plat->mmc, cmd, data);
 }
 
+static int sunxi_mmc_submit_cmd(struct udevice *dev, struct mmc_cmd *cmd,
+				struct mmc_data *data)
+{
+	struct sunxi_mmc_plat *plat = dev_get_platdata(dev);
+	struct sunxi_mmc_priv *priv = dev_get_priv(dev);
+
+	return sunxi_mmc_submit_cmd_common(priv, &plat->mmc, cmd, data);
+}
+
+static int sunxi_mmc_poll_cmd(struct udevice *dev, struct mmc_cmd *cmd,
+			      struct mmc_data *data)
+{
+	struct sunxi_mmc_plat *plat = dev_get_platdata(dev);
+	struct sunxi_mmc_priv *priv = dev_get_priv(dev);
+
+	return sunxi_mmc_poll_cmd_common(priv, &plat->mmc, cmd, data);
+}
+
 static int sunxi_mmc_getcd(struct udevice *dev)
 {
 	struct sunxi_mmc_priv *priv = dev_get_priv(dev);
@@ -1471,6 +1595,8 @@ static const struct dm_mmc_ops sunxi_mmc_ops = {
 	.send_cmd	= sunxi_mmc_send_cmd,
 	.set_ios	= sunxi_mmc_set_ios,
 	.get_cd		= sunxi_mmc_getcd,
+	.submit_cmd	= sunxi_mmc_submit_cmd,
+	.poll_cmd	= sunxi_mmc_poll_cmd,
 };
 
 static int sunxi_mmc_probe(struct udevice *dev)
@@ -321,6 +321,9 @@ struct sunxi_mmc_priv {
 	u32 sample_mode;
 
 	u32 dma_tl;
+	/* data command started by submit_cmd, see sunxi_mmc_poll_cmd_common() */
+	u32 req_usedma;
+	ulong req_start;
 	int (*mmc_init_default_timing_para)(int sdc_no);
 	int (*mmc_set_mod_clk)(struct sunxi_mmc_priv *priv, unsigned int hz);
 	void (*sunxi_mmc_set_speed_mode)(struct sunxi_mmc_priv *priv,
@@ -345,11 +348,23 @@ struct sunxi_sdmmc_parameter_region_header {
 	u8 reserved[16];
 };
 
+/* what a tuning result stored in the parameter region was found for */
+struct sunxi_sdmmc_tuning_key {
+#define SDMMC_TUNING_KEY_MAGIC 0x6D6D636B // mmck
+	u32 magic;
+	u32 cid[4];
+	u32 host_version;
+	u32 timing_mode;
+	u32 card_caps; // speed modes and bus width tuned
+};
+
 struct sunxi_sdmmc_parameter_region {
 #define SUNXI_SDMMC_PARAMETER_REGION_LBA_START 24504
 #define SUNXI_SDMMC_PARAMETER_REGION_SIZE_BYTE 512
 	struct sunxi_sdmmc_parameter_region_header header;
 	struct boot_sdmmc_private_info_t info;
+	/* boot0 only reads up to info, older regions end there */
+	struct sunxi_sdmmc_tuning_key key;
 };
 
 /* Struct for Intrrrupt Information */
@@ -338,11 +338,11 @@ OUT:
 
 int sunxi_mmc_tuning_exit(void)
 {
-	if (!tuning_blk_4b)
-		free(tuning_blk_4b);
+	free(tuning_blk_4b);
+	tuning_blk_4b = NULL;
 
-	if (!tuning_blk_8b)
-		free(tuning_blk_8b);
+	free(tuning_blk_8b);
+	tuning_blk_8b = NULL;
 
 	return 0;
 }
@@ -1510,6 +1510,55 @@ int sunxi_pack_tuning_result(struct mmc *mmc)
 	return 0;
 }
 
+/* inverse of sunxi_pack_tuning_result() */
+static int sunxi_unpack_tuning_result(struct mmc *mmc)
+{
+	struct sunxi_mmc_priv *priv = mmc->priv;
+	u32 tm = priv->timing_mode;
+	int spd_md, freq, g, group;
+	u32 val;
+	u8 *p = NULL;
+
+	for (spd_md = 0; spd_md < MAX_SPD_MD_NUM; spd_md++) {
+		if (spd_md == HS400 && tm != SUNXI_MMC_TIMING_MODE_5)
+			group = 2;
+		else
+			group = 1;
+
+		for (g = 0; g < group; g++) {
+			if (tm == SUNXI_MMC_TIMING_MODE_2) {
+				if ((spd_md == HS400) && (g == 0))
+					p = priv->tm2.dsdly;
+				else
+					p = priv->tm2.sdly;
+			} else if (tm == SUNXI_MMC_TIMING_MODE_4) {
+				if ((spd_md == HS400) && (g == 0))
+					p = priv->tm4.dsdly;
+				else
+					p = priv->tm4.sdly;
+			} else if (tm == SUNXI_MMC_TIMING_MODE_5) {
+				if ((spd_md == HS400) && (g == 0))
+					p = priv->tm5.dsdly;
+				else
+					p = priv->tm5.sdly;
+			} else {
+				return -1;
+			}
+
+			for (freq = 0; freq < MAX_CLK_FREQ_NUM; freq++) {
+				val = priv->cfg.sdly.tm4_smx_fx[spd_md*2 + g*2 + freq/4];
+				val = (val >> (8*(freq%4))) & 0xFF;
+				if ((spd_md == HS400) && (g == 0))
+					p[freq] = val;
+				else
+					p[spd_md*MAX_CLK_FREQ_NUM+freq] = val;
+			}
+		}
+	}
+
+	return 0;
+}
+
 int sunxi_bus_tuning(struct mmc *mmc)
 {
 	int err = 0, ret = 0;
@@ -1735,6 +1784,119 @@ OUT:
 	return ret;
 }
 
+/*
+ * tuning result cache
+ *
+ * mmc_write_info() stores the key of the tuning result next to it in the
+ * parameter region. A later init of the same card on the same host loads
+ * the result back instead of tuning all speed modes again, and checks it
+ * by reading the tuning pattern once at the speed mode it ends up in.
+ */
+static void sunxi_tuning_cache_key(struct mmc *mmc, struct sunxi_sdmmc_tuning_key *key)
+{
+	struct sunxi_mmc_priv *priv = mmc->priv;
+
+	memset(key, 0, sizeof(*key));
+	key->magic = SDMMC_TUNING_KEY_MAGIC;
+	memcpy(key->cid, mmc->cid, sizeof(key->cid));
+	key->host_version = priv->version;
+	key->timing_mode = priv->timing_mode;
+	key->card_caps = mmc->card_caps & (MMC_MODE_HS_52MHz | MMC_MODE_DDR_52MHz |
+			MMC_MODE_HS200 | MMC_MODE_HS400 | MMC_MODE_4BIT | MMC_MODE_8BIT);
+}
+
+/*
+ * sunxi_mmc_tuning_cache_load : load the tuning result stored for this card
+ *
+ * return 0 if the stored result was tuned for this card, host and speed
+ * modes, -1 if tuning is needed
+ * */
+int sunxi_mmc_tuning_cache_load(struct mmc *mmc)
+{
+	struct sunxi_mmc_priv *priv = mmc->priv;
+	struct sunxi_sdmmc_parameter_region *region = NULL;
+	struct sunxi_sdmmc_tuning_key key;
+	u32 blkcnt = SUNXI_SDMMC_PARAMETER_REGION_SIZE_BYTE >> 9;
+	u32 sum = 0, add_sum;
+	int i, ret = -1;
+
+	if (mmc->cfg->sample_mode != AUTO_SAMPLE_MODE)
+		return -1;
+
+	region = memalign(512, SUNXI_SDMMC_PARAMETER_REGION_SIZE_BYTE);
+	if (region == NULL) {
+		MMCINFO("%s malloc pregion fail\n", __func__);
+		return -1;
+	}
+
+	if (mmc_bread(mmc_get_blk_desc(mmc), SUNXI_SDMMC_PARAMETER_REGION_LBA_START,
+			blkcnt, region) != blkcnt)
+		goto out;
+
+	if ((region->header.magic != SDMMC_PARAMETER_MAGIC)
+		|| (region->header.length < sizeof(*region))
+		|| (region->header.length > SUNXI_SDMMC_PARAMETER_REGION_SIZE_BYTE))
+		goto out;
+
+	add_sum = region->header.add_sum;
+	region->header.add_sum = 0;
+	for (i = 0; i < region->header.length; i++)
+		sum += ((unsigned char *)region)[i];
+	if (sum != add_sum)
+		goto out;
+
+	if (!(((region->info.ext_para0 & 0xFF000000) == EXT_PARA0_ID)
+		&& (region->info.ext_para0 & EXT_PARA0_TUNING_SUCCESS_FLAG)))
+		goto out;
+
+	sunxi_tuning_cache_key(mmc, &key);
+	if (memcmp(&key, &region->key, sizeof(key))) {
+		MMCINFO("stored tuning result is not for this card\n");
+		goto out;
+	}
+
+	memcpy(&priv->cfg.sdly, &region->info.tune_sdly, sizeof(struct tune_sdly));
+	ret = sunxi_unpack_tuning_result(mmc);
+	if (!ret)
+		MMCINFO("use stored tuning result\n");
+
+out:
+	free(region);
+	return ret;
+}
+
+/*
+ * sunxi_mmc_tuning_cache_check : read the tuning pattern once at the
+ * current speed mode
+ *
+ * return 0 if the pattern reads back right
+ * */
+int sunxi_mmc_tuning_cache_check(struct mmc *mmc)
+{
+	u32 msglevel = mmc->msglevel;
+	int ret;
+
+	ret = sunxi_mmc_tuning_init();
+	if (ret)
+		return ret;
+
+	mmc->msglevel = 0x0;
+	mmc->do_tuning = 0x1;
+	mmc->tuning_end = 0x0;
+
+	ret = sunxi_tuning_method_0(mmc, 1);
+
+	mmc->msglevel = msglevel;
+	mmc->do_tuning = 0x0;
+	mmc->tuning_end = 0x1;
+
+	sunxi_mmc_tuning_exit();
+	if (ret)
+		MMCINFO("stored tuning result fails the pattern check\n");
+
+	return ret;
+}
+
 int mmc_request_update_boot0(int dev_num)
 {
 #if 0
@@ -1971,6 +2133,8 @@ int mmc_write_info(int dev_num, void *buffer, u32 buffer_size)
 		region->header.length = sizeof(struct sunxi_sdmmc_parameter_region);
 
 		memcpy((void *)&region->info, (void *)&priv_info, sizeof(priv_info));
+		if ((mmc->cfg->sample_mode == AUTO_SAMPLE_MODE) && mmc->tuning_end)
+			sunxi_tuning_cache_key(mmc, &region->key);
 
 		for (i = 0; i < region->header.length; i++)
 			sum += pregion[i];
@@ -11,6 +11,7 @@
 #include <linux/errno.h>
 #include <linux/kernel.h>
 #include <malloc.h>
+#include <memalign.h>
 #include <linux/mtd/mtd.h>
 #include <linux/mtd/aw-rawnand.h>
 #include "aw_rawnand_nfc.h"
@@ -856,6 +857,151 @@ int aw_rawnand_chip_multi_read_page(struct mtd_info *mtd, struct aw_nand_chip *c
 	return ret;
 }
 
+/*physical page @plane of simu page @page*/
+static int aw_rawnand_chip_simu_to_page(struct aw_nand_chip *chip, int page, int plane)
+{
+#if SIMULATE_MULTIPLANE
+	int blkA = ((page >> chip->pages_per_blk_shift) << 1);
+
+	return ((blkA + plane) << chip->pages_per_blk_shift) + (page & chip->pages_per_blk_mask);
+#else
+	return page;
+#endif
+}
+
+/*00h-addr-30h, the first page goes to the cache register*/
+static int aw_rawnand_chip_cache_read_start(struct mtd_info *mtd, struct aw_nand_chip *chip,
+		int page)
+{
+	struct aw_nand_host *host = awnand_chip_to_host(chip);
+	uint8_t row1 = page & 0xff;
+	uint8_t row2 = (page >> 8) & 0xff;
+	uint8_t row3 = (page >> 16) & 0xff;
+	int ret = 0;
+
+	if (!chip->dev_ready_wait(mtd)) {
+		awrawnand_err("dev is busy read page@%d fail\n", page);
+		return -EIO;
+	}
+
+	if (chip->row_cycles == 2) {
+		NORMAL_REQ_CMD_WITH_ADDR_N4(req, RAWNAND_CMD_READ0, 0, 0, row1, row2);
+		ret = host->normal_op(chip, &req);
+	} else {
+		NORMAL_REQ_CMD_WITH_ADDR_N5(req, RAWNAND_CMD_READ0, 0, 0, row1, row2, row3);
+		ret = host->normal_op(chip, &req);
+	}
+	if (ret) {
+		awrawnand_err("%s cmd@%d page@%d fail\n", __func__, RAWNAND_CMD_READ0, page);
+		return ret;
+	}
+
+	NORMAL_REQ_CMD(req2, RAWNAND_CMD_READSTART);
+	ret = host->normal_op(chip, &req2);
+	if (ret) {
+		awrawnand_err("%s cmd@%d page@%d fail\n", __func__, RAWNAND_CMD_READSTART, page);
+		return ret;
+	}
+
+	if (!chip->dev_ready_wait(mtd)) {
+		awrawnand_err("dev is busy read page@%d fail\n", page);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+/*data out of @page while @next_page is read, 3Fh for the last (-1)*/
+static int aw_rawnand_chip_cache_read_page(struct mtd_info *mtd, struct aw_nand_chip *chip,
+		uint8_t *mdata, int page, int next_page)
+{
+	struct aw_nand_host *host = awnand_chip_to_host(chip);
+	int row_cycles = chip->row_cycles;
+
+	int ret = 0;
+
+	BATCH_REQ_CACHE_READ(req, page, next_page, row_cycles, mdata, chip->pagesize);
+
+	awrawnand_chip_trace("Enter %s page@%d\n", __func__, page);
+	if (!chip->dev_ready_wait(mtd)) {
+		awrawnand_err("dev is busy read page@%d fail\n", page);
+		ret = -EIO;
+		goto out;
+	}
+
+	ret = host->batch_op(chip, &req);
+	if (ret == ECC_ERR)
+		awrawnand_err("cache read page@%d fail\n", page);
+
+out:
+	awrawnand_chip_trace("Exit %s ret@%d\n", __func__, ret);
+	return ret;
+}
+
+/**
+ * aw_rawnand_chip_read_pages - read whole simu pages without the page cache
+ * @mtd: MTD structure
+ * @chip: aw nand chip strucutre
+ * @mdata: npages simu pages, dma aligned
+ * @page: first simu page in chip
+ * @npages: simu pages, all in the simu block of @page
+ *
+ * Each physical page is dma'ed straight to @mdata. With cache read the
+ * array reads the next page while the previous one is transferred.
+ * Returns the worst ecc status of the pages, chip->bitflips is the
+ * highest count of a page over the limit, or < 0 on error.
+ * **/
+int aw_rawnand_chip_read_pages(struct mtd_info *mtd, struct aw_nand_chip *chip,
+		uint8_t *mdata, int page, int npages)
+{
+	int planes_shift = chip->simu_pagesize_shift - chip->pagesize_shift;
+	int nr = npages << planes_shift;
+	int planes_mask = (1 << planes_shift) - 1;
+	bool cache = RAWNAND_HAS_CACHE_READ(chip) && nr > 1;
+	uint8_t max_bitflips = 0;
+	int status = ECC_GOOD;
+	int ret = 0, i = 0, cur = 0, next = 0;
+
+	awrawnand_chip_trace("Enter %s page@%d npages@%d\n", __func__, page, npages);
+
+	cur = aw_rawnand_chip_simu_to_page(chip, page, 0);
+	if (cache) {
+		ret = aw_rawnand_chip_cache_read_start(mtd, chip, cur);
+		if (ret)
+			goto out;
+	}
+
+	for (i = 0; i < nr; i++, cur = next) {
+		uint8_t *buf = mdata + (i << chip->pagesize_shift);
+
+		next = -1;
+		if (i + 1 < nr)
+			next = aw_rawnand_chip_simu_to_page(chip, page + ((i + 1) >> planes_shift),
+					(i + 1) & planes_mask);
+
+		if (cache)
+			ret = aw_rawnand_chip_cache_read_page(mtd, chip, buf, cur, next);
+		else
+			ret = chip->read_page(mtd, chip, buf, chip->pagesize, NULL, 0, cur);
+		if (ret < 0)
+			goto out;
+
+		if (ret == ECC_ERR) {
+			status = ECC_ERR;
+		} else if (ret == ECC_LIMIT) {
+			max_bitflips = max_t(uint8_t, max_bitflips, chip->bitflips);
+			if (status == ECC_GOOD)
+				status = ECC_LIMIT;
+		}
+	}
+
+	chip->bitflips = max_bitflips;
+	ret = status;
+out:
+	awrawnand_chip_trace("Exit %s ret@%d\n", __func__, ret);
+	return ret;
+}
+
 int aw_rawnand_setup_read_retry(struct mtd_info *mtd, struct aw_nand_chip *chip)
 {
 	int ret = 0;
@@ -1019,6 +1165,9 @@ void aw_rawnand_chip_init_pre(struct aw_nand_chip *chip)
 	if (!chip->read_page_spare)
 		chip->read_page_spare = aw_rawnand_chip_read_page_spare;
 
+	if (!chip->read_pages)
+		chip->read_pages = aw_rawnand_chip_read_pages;
+
 	if (!chip->setup_read_retry)
 		chip->setup_read_retry = aw_rawnand_setup_read_retry;
 #if 0
@@ -1229,13 +1378,13 @@ static int aw_rawnand_mtd_panic_write (struct mtd_info *mtd, loff_t to, size_t l
 
 
 /**
- * aw_rawnand_mtd_read - read data without oob
+ * aw_rawnand_mtd_read_cached - read data through the one page cache
  * @mtd: MTD device structure
  * @from: offset to read from
  * @ops: oob operation descrition structure
  * */
 
-static int aw_rawnand_mtd_read(struct mtd_info *mtd, loff_t from, size_t len,
+static int aw_rawnand_mtd_read_cached(struct mtd_info *mtd, loff_t from, size_t len,
 		      size_t *retlen, u_char *buf)
 {
 	struct aw_nand_chip *chip = awnand_mtd_to_chip(mtd);
@@ -1359,8 +1508,151 @@ static int aw_rawnand_mtd_read(struct mtd_info *mtd, loff_t from, size_t len,
 	return max_bitflips;
 }
 
+/**
+ * aw_rawnand_mtd_read_pages - read whole pages straight to buf
+ * @mtd: MTD device structure
+ * @from: page aligned offset to read from
+ * @len: whole pages
+ * @buf: dma aligned
+ *
+ * The pages go by runs up to the end of a block, see
+ * aw_rawnand_chip_read_pages. The page cache is left alone.
+ * */
+static int aw_rawnand_mtd_read_pages(struct mtd_info *mtd, loff_t from, size_t len,
+		      size_t *retlen, u_char *buf)
+{
+	struct aw_nand_chip *chip = awnand_mtd_to_chip(mtd);
+	int ret = 0;
+	int chipnr = 0, page = 0, page_in_chip = 0;
+	int pages = len >> chip->simu_pagesize_shift;
+	int pages_per_blk = 1 << chip->simu_pages_per_blk_shift;
+	int npages = 0;
+	unsigned int max_bitflips = 0;
+	bool ecc_failed = false;
+
+	awrawnand_mtd_trace("Enter %s [%llx:%lx]\n", __func__, from, len);
+
+	*retlen = 0;
+
+	chipnr = (int)(from >> chip->simu_chip_shift);
+	page = (int)(from >> chip->simu_pagesize_shift);
+	page_in_chip = page & chip->simu_chip_pages_mask;
+
+	mutex_lock(&chip->lock);
+
+	chip->select_chip(mtd, chipnr);
 
+	while (pages) {
+		npages = min_t(int, pages,
+				pages_per_blk - (page_in_chip & chip->simu_pages_per_blk_mask));
+
+		ret = chip->read_pages(mtd, chip, buf + *retlen, page_in_chip, npages);
+		if (ret == ECC_LIMIT) {
+			ret = mtd->bitflip_threshold;
+			mtd->ecc_stats.corrected += chip->bitflips;
+			max_bitflips = max_t(unsigned int, max_bitflips, ret);
+			awrawnand_info("ecc limit from@0x%llx len@0x%lx in page@%d\n",
+					from, len, page);
+		} else if (ret == ECC_ERR) {
+			ecc_failed = true;
+			mtd->ecc_stats.failed++;
+			awrawnand_err("ecc err from@0x%llx len@0x%lx in page@%d\n",
+					from, len, page);
+		} else if (ret < 0) {
+			awrawnand_err("read from @0x%llx len@0x%lx fail in page@%d\n",
+					from, len, page);
+			break;
+		}
 
+		*retlen += npages << chip->simu_pagesize_shift;
+		pages -= npages;
+		page += npages;
+		page_in_chip = page & chip->simu_chip_pages_mask;
+
+		if (pages && !page_in_chip) {
+			chip->select_chip(mtd, -1);
+			chip->select_chip(mtd, ++chipnr);
+		}
+	}
+
+	chip->select_chip(mtd, -1);
+
+	mutex_unlock(&chip->lock);
+
+	awrawnand_mtd_trace("Exit %s ret@%d\n", __func__, ret);
+
+	if (ret < 0)
+		return ret;
+
+	if (ecc_failed)
+		return -EBADMSG;
+
+	return max_bitflips;
+}
+
+/**
+ * aw_rawnand_mtd_read - read data without oob
+ * @mtd: MTD device structure
+ * @from: offset to read from
+ * @ops: oob operation descrition structure
+ *
+ * Whole pages going to a dma aligned buffer, such as images and UBI LEBs,
+ * skip the page cache, only the unaligned head and tail go through it.
+ * */
+static int aw_rawnand_mtd_read(struct mtd_info *mtd, loff_t from, size_t len,
+		      size_t *retlen, u_char *buf)
+{
+	struct aw_nand_chip *chip = awnand_mtd_to_chip(mtd);
+	size_t head = min_t(size_t, len, (-from) & chip->simu_pagesize_mask);
+	size_t body = (len - head) & ~(size_t)chip->simu_pagesize_mask;
+	size_t tail = len - head - body;
+	unsigned int max_bitflips = 0;
+	bool ecc_failed = false;
+	size_t done = 0;
+	int ret = 0;
+
+	if (!body || !IS_ALIGNED((unsigned long)buf + head, ARCH_DMA_MINALIGN))
+		return aw_rawnand_mtd_read_cached(mtd, from, len, retlen, buf);
+
+	*retlen = 0;
+
+	if (head) {
+		ret = aw_rawnand_mtd_read_cached(mtd, from, head, &done, buf);
+		*retlen += done;
+		if (ret == -EBADMSG)
+			ecc_failed = true;
+		else if (ret < 0)
+			return ret;
+		else
+			max_bitflips = max_t(unsigned int, max_bitflips, ret);
+	}
+
+	ret = aw_rawnand_mtd_read_pages(mtd, from + head, body, &done, buf + head);
+	*retlen += done;
+	if (ret == -EBADMSG)
+		ecc_failed = true;
+	else if (ret < 0)
+		return ret;
+	else
+		max_bitflips = max_t(unsigned int, max_bitflips, ret);
+
+	if (tail) {
+		ret = aw_rawnand_mtd_read_cached(mtd, from + head + body, tail, &done,
+				buf + head + body);
+		*retlen += done;
+		if (ret == -EBADMSG)
+			ecc_failed = true;
+		else if (ret < 0)
+			return ret;
+		else
+			max_bitflips = max_t(unsigned int, max_bitflips, ret);
+	}
+
+	if (ecc_failed)
+		return -EBADMSG;
+
+	return max_bitflips;
+}
 
 /**
  * aw_rawnand_mtd_read_oob - read data with oob
@@ -1825,6 +2117,7 @@ static int aw_rawnand_mtd_block_markbad(struct mtd_info *mtd, loff_t ofs)
 
 	struct aw_nand_chip *chip = awnand_mtd_to_chip(mtd);
 	int ret = 0;
+	int err = 0;
 
 	awrawnand_mtd_trace("Enter %s [%llx]\n", __func__, ofs);
 
@@ -1839,6 +2132,11 @@ static int aw_rawnand_mtd_block_markbad(struct mtd_info *mtd, loff_t ofs)
 	chip->select_chip(mtd, -1);
 	mutex_unlock(&chip->lock);
 
+	/*bbt is updated even if writing the marker fails, keep it on flash*/
+	err = aw_rawnand_chip_store_bbt(mtd);
+	if (!ret)
+		ret = err;
+
 	awrawnand_mtd_trace("Exit %s ret@%d\n", __func__, ret);
 	return ret;
 }
@@ -2209,6 +2507,9 @@ int aw_rawnand_probe(struct udevice *dev)
 		goto out;
 	}
 
+	if (aw_rawnand_chip_load_bbt(mtd))
+		awrawnand_warn("no bbt on flash, check blocks when used\n");
+
 	ret = add_mtd_device(mtd);
 	if (ret) {
 		awrawnand_err("add mtd fail\n");
@@ -464,33 +464,107 @@ int aw_rawnand_chip_simu_block_markbad(struct mtd_info *mtd, int block)
 	return ret;
 }
 
+/**
+ * aw_rawnand_chip_scan_bbt - read the bad block marker of every block to bbt
+ * @mtd: MTD device structure
+ * */
 int aw_rawnand_chip_scan_bbt(struct mtd_info *mtd)
 {
 	struct aw_nand_chip *chip = awnand_mtd_to_chip(mtd);
 
-	int total_blocks = chip->chipsize >> chip->erase_shift;
+	int blocks_per_chip = chip->chipsize >> chip->erase_shift;
+	unsigned int boot0_blocks = 0;
 
 	int b = 0;
 	int c = 0;
-	int pos_byte = 0;
-	int pos_bit = 0;
-	uint32_t time_start = get_timer(0);
+	int block = 0;
+	ulong time_start = get_timer(0);
+
+	/*
+	 * boot0 data is different, can't used this to check, leave its
+	 * blocks unresolved. The uboot copies are checked like any block.
+	 */
+	rawnand_uboot_blknum(&boot0_blocks, NULL);
 
 	for (c = 0; c < chip->chips; c++) {
 		chip->select_chip(mtd, c);
-		for (b = 0; b < total_blocks; b++) {
-			pos_byte = b >> 3;
-			pos_bit = b & 0x7;
-			if (chip->block_bad(mtd, b)) {
-				chip->block_markbad(mtd, b);
-			} else {
-				chip->bbt[pos_byte] &= ~(1 << pos_bit);
-			}
-			chip->bbtd[pos_byte] |= (1 << pos_bit);
+		for (b = 0; b < blocks_per_chip; b++) {
+			block = c * blocks_per_chip + b;
+			/*block_bad updates bbt itself*/
+			if (block >= boot0_blocks)
+				chip->block_bad(mtd, block);
 		}
 		chip->select_chip(mtd, -1);
 	}
-	printf("c@%d b@%d times@%lu\n", c, b, get_timer(time_start));
+	awrawnand_info("scan bbt: %d blocks in %lu ms\n",
+			chip->chips * blocks_per_chip, get_timer(time_start));
 
 	return 0;
 }
+
+/**
+ * aw_rawnand_chip_load_bbt - fill bbt from its copies on flash
+ * @mtd: MTD device structure
+ *
+ * Without a valid copy, all blocks are scanned and the copies written.
+ * Without CONFIG_AW_RAWNAND_BBT, blocks are checked when first used.
+ * */
+int aw_rawnand_chip_load_bbt(struct mtd_info *mtd)
+{
+	struct aw_nand_chip *chip = awnand_mtd_to_chip(mtd);
+	int blocks = (chip->chips * chip->chipsize) >> chip->erase_shift;
+	unsigned int uboot_start = 0, uboot_end = 0;
+	loff_t start = 0, end = 0;
+	int block = 0;
+	int ret = 0;
+
+	if (!IS_ENABLED(CONFIG_AW_RAWNAND_BBT))
+		return 0;
+
+	/*the copies have their own blocks, right after secure storage*/
+	rawnand_uboot_blknum(&uboot_start, &uboot_end);
+	start = (loff_t)(uboot_end + AW_RAWNAND_RESERVED_PHY_BLK_FOR_SECURE_STORAGE)
+		<< chip->erase_shift;
+	end = start + ((loff_t)AW_RAWNAND_RESERVED_PHY_BLK_FOR_BBT
+			<< chip->erase_shift);
+
+	ret = mtd_bbt_init(&chip->flash_bbt, mtd, start,
+			(end - start) >> mtd->erasesize_shift, chip->bbt, blocks);
+	if (ret) {
+		awrawnand_err("bbt area@%llx can't be used\n", start);
+		return ret;
+	}
+
+	ret = mtd_bbt_load(&chip->flash_bbt);
+	if (!ret) {
+		memset(chip->bbtd, 0xff, DIV_ROUND_UP(blocks, 8));
+		/*boot0 blocks are never scanned, their bits mean nothing*/
+		for (block = 0; block < uboot_start; block++)
+			chip->bbtd[block >> 3] &= ~(1 << (block & 0x7));
+		awrawnand_info("bbt: version@%u from flash\n",
+				chip->flash_bbt.version);
+		return 0;
+	}
+
+	awrawnand_info("bbt: no valid copy on flash, scan all blocks\n");
+	chip->scan_bbt(mtd);
+
+	return mtd_bbt_store(&chip->flash_bbt);
+}
+
+/**
+ * aw_rawnand_chip_store_bbt - write bbt to its copies on flash
+ * @mtd: MTD device structure
+ *
+ * Called after blocks are marked bad, nothing to do before the copies
+ * are loaded.
+ * */
+int aw_rawnand_chip_store_bbt(struct mtd_info *mtd)
+{
+	struct aw_nand_chip *chip = awnand_mtd_to_chip(mtd);
+
+	if (!IS_ENABLED(CONFIG_AW_RAWNAND_BBT) || !chip->flash_bbt.mtd)
+		return 0;
+
+	return mtd_bbt_store(&chip->flash_bbt);
+}
@@ -103,7 +103,7 @@ struct aw_nand_flash_dev mircon[] = {
 		.access_freq = 40,
 		.badblock_flag_pos = PST_FIRST_PAGE,
 		.pe_cycles = PE_CYCLES_100K,
-		.options = RAWNAND_ITF_SDR | RAWNAND_NFC_RANDOM | RAWNAND_MULTI_WRITE | RAWNAND_MULTI_ONFI_ERASE,
+		.options = RAWNAND_ITF_SDR | RAWNAND_NFC_RANDOM | RAWNAND_MULTI_WRITE | RAWNAND_MULTI_ONFI_ERASE | RAWNAND_CACHE_READ,
 	},
 	{
 		.name = "MT29F2G08ABAGA",
@@ -117,7 +117,7 @@ struct aw_nand_flash_dev mircon[] = {
 		.access_freq = 40,
 		.badblock_flag_pos = PST_FIRST_PAGE,
 		.pe_cycles = PE_CYCLES_100K,
-		.options = RAWNAND_ITF_SDR | RAWNAND_NFC_RANDOM | RAWNAND_MULTI_WRITE | RAWNAND_MULTI_ONFI_ERASE,
+		.options = RAWNAND_ITF_SDR | RAWNAND_NFC_RANDOM | RAWNAND_MULTI_WRITE | RAWNAND_MULTI_ONFI_ERASE | RAWNAND_CACHE_READ,
 	},
 };
 
@@ -762,242 +762,119 @@ static void aw_host_nfc_get_spare_data(struct nfc_reg *nfc, uint8_t *spare, uint
 	}
 }
 
-static int aw_host_nfc_batch_op(struct aw_nand_chip *chip, struct aw_nfc_batch_req *req)
+/*
+ * CACHE_READ: 00h-addr(next_page)-31h, or 3Fh alone for the last page,
+ * then the data out of addr.page, which the command moved to the cache
+ * register, while the array already reads the next page.
+ */
+static int aw_host_nfc_batch_op_cache_read(struct aw_nand_chip *chip, struct aw_nfc_batch_req *req)
 {
 	struct aw_nand_host *host = awnand_chip_to_host(chip);
 	struct nfc_reg *nfc = &host->nfc_reg;
-	/*int rb_no = aw_host_nfc_get_selected_rb_no(nfc);*/
 	uint32_t page = req->addr.page;
+	uint32_t next_page = req->addr.next_page;
 	uint32_t page_in_block = page & chip->pages_per_blk_mask;
 
 	int ret = 0;
 	uint32_t val = 0;
-	uint8_t col1 = 0, col2 = 0, row1 = 0, row2 = 0, row3 = 0;
+	uint8_t row1 = 0, row2 = 0, row3 = 0;
 	uint32_t low = 0, high = 0;
 	uint32_t read_set0 = 0;
 	uint32_t cmd = 0;
-	uint32_t ecc_block = 0, ecc_block_bitmap = 0;
-	uint8_t spare[MAX_SPARE_SIZE];
-	int dummy_byte = 0;
-
-	AWRAWNAND_TRACE_NFC("Enter %s\n", __func__);
+	uint32_t ecc_block_bitmap = ((1 << B_TO_KB(req->data.main_len)) - 1);
+	uint8_t default_spare[MAX_SPARE_SIZE];
 
-	if (req->data.type == ONLY_SPARE) {
-		/*data layout interleave mode, ecc and oob store in spare area
-		 * need to read main data and spare data to do ecc,though user only read spare*/
-		req->data.main_len = SZ_1K;
-		ecc_block = B_TO_KB(chip->pagesize);
-		ecc_block_bitmap = ((1 << ecc_block) - 1);
-		/*one ecc_block can attach to 32 bytes*/
-		if (req->data.spare_len < 32)
-			ecc_block_bitmap = 0x1;
-		/*to do : ecc_block_bitmap from req.data.spare_len*/
-	} else {
-		ecc_block = B_TO_KB(req->data.main_len);
-		ecc_block_bitmap = ((1 << ecc_block) - 1);
-	}
+	AWRAWNAND_TRACE_NFC("Enter %s page@%d\n", __func__, page);
 
 	val = readl(nfc->sta);
 	val &= (NFC_RB_B2R | NFC_CMD_INT_FLAG | NFC_DMA_INT_FLAG);
 	val |= readl(nfc->sta);
 	writel(val, nfc->sta);
 
-	/*set ecc mode, randomizer,exception,pipeline*/
-	if (!chip->operate_boot0) {
-		aw_host_nfc_set_ecc_mode(nfc, chip->ecc_mode);
-		aw_host_nfc_ecc_enable(nfc, 1);
-		if (chip->random) {
-			aw_host_nfc_randomize_enable(nfc, page_in_block);
-		} else
-			aw_host_nfc_randomize_disable(nfc);
-	} else {
-		aw_host_nfc_set_ecc_mode(nfc, chip->boot0_ecc_mode);
-		aw_host_nfc_ecc_enable(nfc, 1);
-		aw_host_nfc_randomize_enable(nfc, page);
-	}
-
-	/*configure addr*/
-	row1 = (page & 0xff);
-	row2 = ((page >> 8) & 0xff);
-	row3 = ((page >> 16) & 0xff);
+	/*ecc and randomizer of the page coming out, not of next_page*/
+	aw_host_nfc_set_ecc_mode(nfc, chip->ecc_mode);
+	aw_host_nfc_ecc_enable(nfc, 1);
+	if (chip->random)
+		aw_host_nfc_randomize_enable(nfc, page_in_block);
+	else
+		aw_host_nfc_randomize_disable(nfc);
 
-	low = (col1 | (col2 << 8) | (row1 << 16) | (row2 << 24));
-	high |= row3;
+	if (req->cmd.cr.CACHEREAD == RAWNAND_CMD_READCACHEEND) {
+		cmd |= req->cmd.cr.CACHEREAD;
+	} else {
+		row1 = (next_page & 0xff);
+		row2 = ((next_page >> 8) & 0xff);
+		row3 = ((next_page >> 16) & 0xff);
 
-	writel(low, nfc->addr_low);
-	writel(high, nfc->addr_high);
+		low = ((row1 << 16) | (row2 << 24));
+		high |= row3;
 
-	cmd |= NFC_ADR_NUM((req->addr.row_cycles + 2));
-	cmd |= NFC_SEND_ADR;
+		writel(low, nfc->addr_low);
+		writel(high, nfc->addr_high);
 
+		cmd |= NFC_ADR_NUM((req->addr.row_cycles + 2));
+		cmd |= NFC_SEND_ADR;
+		cmd |= NFC_SEND_CMD2;
+		cmd |= req->cmd.cr.READ0;
+	}
 
-	cmd |= NFC_SEND_CMD2;
 	cmd |= NFC_SEND_CMD1;
 	cmd |= NFC_DATA_TRANS;
-
-	/*default:batch mode use dma*/
-	if (req->data.type != ONLY_SPARE)
-		cmd |= NFC_DATA_SWAP_METHOD;
-
-	if (req->layout == SEQUENCE) {
-		cmd |= NFC_SEQ;
-	}
-
+	cmd |= NFC_DATA_SWAP_METHOD;
 	cmd |= NFC_BATCH_OP;
-	/*configure read command set*/
-	if (req->type == READ) {
-		/*cmd |= req->cmd.r.READ0;*/
-		cmd |= req->cmd.val.first;
-		cmd |= NFC_WAIT_FLAG;
-
-		/*
-		 *read_set0 = ((req->cmd.r.READSTART << 0) | (req->cmd.r.RNOUT << 8) |
-		 *                (req->cmd.r.RNOUTSTART << 16));
-		 */
-
-		read_set0 = ((req->cmd.val.snd << 0) | (req->cmd.val.rnd1 << 8) |
-				(req->cmd.val.rnd2 << 16));
-		writel(read_set0, nfc->read_cmd_set);
+	cmd |= NFC_WAIT_FLAG;
 
-		/*configure user data len*/
-		if (req->data.spare_len) {
-			aw_host_nfc_set_user_data_len(nfc, req->data.spare_len);
-			uint8_t default_spare[req->data.spare_len];
-			memset(default_spare, 0x99, req->data.spare_len);
-			aw_host_nfc_set_user_data(nfc, default_spare, req->data.spare_len);
-		} else {
-			aw_host_nfc_set_user_data_len(nfc, chip->avalid_sparesize);
-			uint8_t default_spare[chip->avalid_sparesize];
-			memset(default_spare, 0x99, chip->avalid_sparesize);
-			aw_host_nfc_set_user_data(nfc, default_spare, chip->avalid_sparesize);
-		}
+	read_set0 = ((req->cmd.cr.CACHEREAD << 0) | (req->cmd.cr.RNOUT << 8) |
+			(req->cmd.cr.RNOUTSTART << 16));
+	writel(read_set0, nfc->read_cmd_set);
 
-	} else {
-
-		/*configure user data len*/
-		if (req->data.spare_len) {
-			memset(spare, 0xff, MAX_SPARE_SIZE);
-			/*data.spare_len should be less than MAX_SPARE_SIZE or equal*/
-			memcpy(spare, req->data.spare, req->data.spare_len);
-			/*avalid_sparesize maximum equal to MAX_SPARE_SIZE*/
-			aw_host_nfc_set_user_data(nfc, spare, req->data.spare_len);
-		} else {
-			aw_host_nfc_set_user_data(nfc, host->spare_default, chip->avalid_sparesize);
-		}
-
-		if (!chip->operate_boot0)
-			aw_host_nfc_set_user_data_len(nfc, req->data.spare_len);
-		else
-			aw_host_nfc_set_boot0_user_data_len(nfc, req->data.spare_len);
-
-		cmd |= NFC_ACCESS_DIR;
-		/*cmd |= req->cmd.w.SEQIN;*/
-		cmd |= req->cmd.val.first;
-
-		/*writel((req->cmd.w.PAGEPROG | (req->cmd.w.RNDIN << 8)), nfc->write_cmd_set);*/
-		writel((req->cmd.val.snd | (req->cmd.val.rnd1 << 8)), nfc->write_cmd_set);
-
-		int real_pagesize = chip->real_pagesize;
-		int ecc_mode = chip->ecc_mode;
-		int w_ecc_block_cnt = B_TO_KB(chip->pagesize);
-		int w_user_data_len = chip->avalid_sparesize;
-
-		dummy_byte = aw_host_nfc_get_dummy_byte(real_pagesize, ecc_mode, w_ecc_block_cnt, w_user_data_len);
-		if (dummy_byte > 0)
-			aw_host_nfc_set_dummy_byte(nfc, dummy_byte);
-
-	}
+	aw_host_nfc_set_user_data_len(nfc, chip->avalid_sparesize);
+	memset(default_spare, 0x99, chip->avalid_sparesize);
+	aw_host_nfc_set_user_data(nfc, default_spare, chip->avalid_sparesize);
 
 	if (aw_host_nfc_wait_cmd_fifo_empty(nfc) || aw_host_nfc_wait_fsm_idle(nfc)) {
 		ret = -ETIMEDOUT;
 		awrawnand_err("fifo or fsm is not empty\n");
-		goto out_err;
+		goto out;
 	}
 
-
-	if (req->data.type != ONLY_SPARE) {
-		aw_host_nfc_dma_config_start(host, req->type, req->data.main, req->data.main_len);
-		/*write command*/
-		writel(ecc_block_bitmap, nfc->data_block_mask);
-		writel(cmd, nfc->cmd);
-		/*aw_nfc_reg_dump(nfc);*/
-		ret = aw_host_nfc_dma_wait_end(host, req->type, req->data.main, req->data.main_len);
-		if (ret) {
-			awrawnand_err("%s wait dma end fail\n", __func__);
-			goto out_err;
-		}
-	} else {
-		writel(ecc_block_bitmap, nfc->data_block_mask);
-		/*write command*/
-		writel(cmd, nfc->cmd);
+	aw_host_nfc_dma_config_start(host, READ, req->data.main, req->data.main_len);
+	writel(ecc_block_bitmap, nfc->data_block_mask);
+	writel(cmd, nfc->cmd);
+	ret = aw_host_nfc_dma_wait_end(host, READ, req->data.main, req->data.main_len);
+	if (ret) {
+		awrawnand_err("%s wait dma end fail\n", __func__);
+		goto out;
 	}
 
 	ret = aw_host_nfc_wait_cmd_finish(nfc);
 	if (ret) {
 		awrawnand_err("%s wait cmd finish fail\n", __func__);
-		goto out_err;
-	}
-
-	if (host->use_rb_int) {
-		/*to do*/
-	} else {
-		ret = aw_host_nfc_wait_rb_ready(chip, host);
-		if (!ret) {
-			awrawnand_err("%s wait rb ready fail\n", __func__);
-			aw_nfc_reg_dump(nfc);
-			ret = -ETIMEDOUT;
-			goto out_err;
-		}
-		ret = 0;
+		goto out;
 	}
 
-	if (req->type == READ) {
-		ret = aw_host_nfc_check_ecc_status(nfc, req->data.main_len);
-		if (ret == ECC_GOOD) {
-			int len = req->data.main_len ? req->data.main_len : req->data.spare_len;
-			len = ((len < 1024) ? 1024 : len);
-			if (aw_host_nfc_is_blank_page(nfc, len)) {
-				memset(req->data.main, 0xff, req->data.main_len);
-				memset(req->data.spare, 0xff, req->data.spare_len);
-			} else {
-				aw_host_nfc_get_spare_data(nfc, spare, MAX_SPARE_SIZE);
-				memcpy(req->data.spare, spare, req->data.spare_len);
-			}
-		} else {
-			aw_host_nfc_get_spare_data(nfc, spare, MAX_SPARE_SIZE);
-			memcpy(req->data.spare, spare, req->data.spare_len);
-		}
-
-		chip->bitflips = host->bitflips;
-
-		aw_host_nfc_ecc_disable(nfc);
-		if (chip->random) {
-			aw_host_nfc_randomize_disable(nfc);
-		}
-	} else {
-		aw_host_nfc_ecc_disable(nfc);
-		if (chip->random) {
-			aw_host_nfc_randomize_disable(nfc);
-		}
-		aw_host_nfc_set_dummy_byte(nfc, 0);
+	if (!aw_host_nfc_wait_rb_ready(chip, host)) {
+		awrawnand_err("%s wait rb ready fail\n", __func__);
+		aw_nfc_reg_dump(nfc);
+		ret = -ETIMEDOUT;
+		goto out;
 	}
 
+	ret = aw_host_nfc_check_ecc_status(nfc, req->data.main_len);
+	if (ret == ECC_GOOD && aw_host_nfc_is_blank_page(nfc, req->data.main_len))
+		memset(req->data.main, 0xff, req->data.main_len);
 
-	AWRAWNAND_TRACE_NFC("Exit %s\n", __func__);
-	return ret;
+	chip->bitflips = host->bitflips;
 
-out_err:
+out:
 	aw_host_nfc_ecc_disable(nfc);
-	if (chip->random) {
+	if (chip->random)
 		aw_host_nfc_randomize_disable(nfc);
-	}
-	if (req->type == WRITE)
-		aw_host_nfc_set_dummy_byte(nfc, 0);
 	AWRAWNAND_TRACE_NFC("Exit %s\n", __func__);
 	return ret;
 }
-#if 0
-static int aw_host_nfc_batch_op_cache_rw(struct aw_nand_chip *chip, struct aw_nfc_batch_req *req)
+
+static int aw_host_nfc_batch_op(struct aw_nand_chip *chip, struct aw_nfc_batch_req *req)
 {
 	struct aw_nand_host *host = awnand_chip_to_host(chip);
 	struct nfc_reg *nfc = &host->nfc_reg;
@@ -1015,12 +892,15 @@ static int aw_host_nfc_batch_op_cache_rw(struct aw_nand_chip *chip, struct aw_nf
 	uint8_t spare[MAX_SPARE_SIZE];
 	int dummy_byte = 0;
 
+	if (req->type == CACHE_READ)
+		return aw_host_nfc_batch_op_cache_read(chip, req);
 
 	AWRAWNAND_TRACE_NFC("Enter %s\n", __func__);
 
 	if (req->data.type == ONLY_SPARE) {
 		/*data layout interleave mode, ecc and oob store in spare area
 		 * need to read main data and spare data to do ecc,though user only read spare*/
+		req->data.main_len = SZ_1K;
 		ecc_block = B_TO_KB(chip->pagesize);
 		ecc_block_bitmap = ((1 << ecc_block) - 1);
 		/*one ecc_block can attach to 32 bytes*/
@@ -1043,7 +923,8 @@ static int aw_host_nfc_batch_op_cache_rw(struct aw_nand_chip *chip, struct aw_nf
 		aw_host_nfc_ecc_enable(nfc, 1);
 		if (chip->random) {
 			aw_host_nfc_randomize_enable(nfc, page_in_block);
-		}
+		} else
+			aw_host_nfc_randomize_disable(nfc);
 	} else {
 		aw_host_nfc_set_ecc_mode(nfc, chip->boot0_ecc_mode);
 		aw_host_nfc_ecc_enable(nfc, 1);
@@ -1080,18 +961,31 @@ static int aw_host_nfc_batch_op_cache_rw(struct aw_nand_chip *chip, struct aw_nf
 	cmd |= NFC_BATCH_OP;
 	/*configure read command set*/
 	if (req->type == READ) {
-		cmd |= req->cmd.r.READ0;
+		/*cmd |= req->cmd.r.READ0;*/
+		cmd |= req->cmd.val.first;
 		cmd |= NFC_WAIT_FLAG;
 
-		read_set0 = ((req->cmd.r.READSTART << 0) | (req->cmd.r.RNOUT << 8) |
-				(req->cmd.r.RNOUTSTART << 16));
+		/*
+		 *read_set0 = ((req->cmd.r.READSTART << 0) | (req->cmd.r.RNOUT << 8) |
+		 *                (req->cmd.r.RNOUTSTART << 16));
+		 */
+
+		read_set0 = ((req->cmd.val.snd << 0) | (req->cmd.val.rnd1 << 8) |
+				(req->cmd.val.rnd2 << 16));
 		writel(read_set0, nfc->read_cmd_set);
 
 		/*configure user data len*/
-		aw_host_nfc_set_user_data_len(nfc, chip->avalid_sparesize);
-		uint8_t default_spare[chip->avalid_sparesize];
-		memset(default_spare, 0x99, chip->avalid_sparesize);
-		aw_host_nfc_set_user_data(nfc, default_spare, chip->avalid_sparesize);
+		if (req->data.spare_len) {
+			aw_host_nfc_set_user_data_len(nfc, req->data.spare_len);
+			uint8_t default_spare[req->data.spare_len];
+			memset(default_spare, 0x99, req->data.spare_len);
+			aw_host_nfc_set_user_data(nfc, default_spare, req->data.spare_len);
+		} else {
+			aw_host_nfc_set_user_data_len(nfc, chip->avalid_sparesize);
+			uint8_t default_spare[chip->avalid_sparesize];
+			memset(default_spare, 0x99, chip->avalid_sparesize);
+			aw_host_nfc_set_user_data(nfc, default_spare, chip->avalid_sparesize);
+		}
 
 	} else {
 
@@ -1099,22 +993,24 @@ static int aw_host_nfc_batch_op_cache_rw(struct aw_nand_chip *chip, struct aw_nf
 		if (req->data.spare_len) {
 			memset(spare, 0xff, MAX_SPARE_SIZE);
 			/*data.spare_len should be less than MAX_SPARE_SIZE or equal*/
-			memcpy(spare, req->data.spare_in, req->data.spare_len);
+			memcpy(spare, req->data.spare, req->data.spare_len);
 			/*avalid_sparesize maximum equal to MAX_SPARE_SIZE*/
-			aw_host_nfc_set_user_data(nfc, spare, chip->avalid_sparesize);
+			aw_host_nfc_set_user_data(nfc, spare, req->data.spare_len);
 		} else {
 			aw_host_nfc_set_user_data(nfc, host->spare_default, chip->avalid_sparesize);
 		}
 
 		if (!chip->operate_boot0)
-			aw_host_nfc_set_user_data_len(nfc, chip->avalid_sparesize);
+			aw_host_nfc_set_user_data_len(nfc, req->data.spare_len);
 		else
 			aw_host_nfc_set_boot0_user_data_len(nfc, req->data.spare_len);
 
 		cmd |= NFC_ACCESS_DIR;
-		cmd |= req->cmd.cw.SEQIN;
+		/*cmd |= req->cmd.w.SEQIN;*/
+		cmd |= req->cmd.val.first;
 
-		writel((req->cmd.cw.CACHEDPROG | (req->cmd.cw.RNDIN << 8)), nfc->write_cmd_set);
+		/*writel((req->cmd.w.PAGEPROG | (req->cmd.w.RNDIN << 8)), nfc->write_cmd_set);*/
+		writel((req->cmd.val.snd | (req->cmd.val.rnd1 << 8)), nfc->write_cmd_set);
 
 		int real_pagesize = chip->real_pagesize;
 		int ecc_mode = chip->ecc_mode;
@@ -1135,13 +1031,12 @@ static int aw_host_nfc_batch_op_cache_rw(struct aw_nand_chip *chip, struct aw_nf
 
 
 	if (req->data.type != ONLY_SPARE) {
-		aw_host_nfc_dma_config_start(host, req->type, req->data.main_in, req->data.main_len);
+		aw_host_nfc_dma_config_start(host, req->type, req->data.main, req->data.main_len);
 		/*write command*/
 		writel(ecc_block_bitmap, nfc->data_block_mask);
 		writel(cmd, nfc->cmd);
-		/*printf("cmd_cfg@%x cmd reg@%x\n", cmd, readl(nfc->cmd));*/
 		/*aw_nfc_reg_dump(nfc);*/
-		ret = aw_host_nfc_dma_wait_end(host, req->type, req->data.main_in, req->data.main_len);
+		ret = aw_host_nfc_dma_wait_end(host, req->type, req->data.main, req->data.main_len);
 		if (ret) {
 			awrawnand_err("%s wait dma end fail\n", __func__);
 			goto out_err;
@@ -1177,16 +1072,15 @@ static int aw_host_nfc_batch_op_cache_rw(struct aw_nand_chip *chip, struct aw_nf
 			int len = req->data.main_len ? req->data.main_len : req->data.spare_len;
 			len = ((len < 1024) ? 1024 : len);
 			if (aw_host_nfc_is_blank_page(nfc, len)) {
-				AWRAWNAND_TRACE_NFC("%s-%d page%d is blank\n", __func__, __LINE__, page);
-				memset(req->data.main_in, 0xff, req->data.main_len);
-				memset(req->data.spare_in, 0xff, req->data.spare_len);
+				memset(req->data.main, 0xff, req->data.main_len);
+				memset(req->data.spare, 0xff, req->data.spare_len);
 			} else {
 				aw_host_nfc_get_spare_data(nfc, spare, MAX_SPARE_SIZE);
-				memcpy(req->data.spare_in, spare, req->data.spare_len);
+				memcpy(req->data.spare, spare, req->data.spare_len);
 			}
 		} else {
 			aw_host_nfc_get_spare_data(nfc, spare, MAX_SPARE_SIZE);
-			memcpy(req->data.spare_in, spare, req->data.spare_len);
+			memcpy(req->data.spare, spare, req->data.spare_len);
 		}
 
 		chip->bitflips = host->bitflips;
@@ -1217,7 +1111,7 @@ out_err:
 	AWRAWNAND_TRACE_NFC("Exit %s\n", __func__);
 	return ret;
 }
-
+#if 0
 static int aw_host_nfc_batch_op_mrw(struct aw_nand_chip *chip, struct aw_nfc_batch_req *req)
 {
 	struct aw_nand_host *host = awnand_chip_to_host(chip);
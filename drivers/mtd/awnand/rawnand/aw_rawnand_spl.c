@@ -457,7 +457,8 @@ int rawnand_mtd_get_flash_info(void *data, unsigned int len)
 	/* others */
 	boot_info->uboot_start_block = uboot_start;
 	boot_info->uboot_next_block = uboot_end;
-	boot_info->logic_start_block = uboot_end + AW_RAWNAND_RESERVED_PHY_BLK_FOR_SECURE_STORAGE;
+	boot_info->logic_start_block = uboot_end + AW_RAWNAND_RESERVED_PHY_BLK_FOR_SECURE_STORAGE
+		+ AW_RAWNAND_RESERVED_PHY_BLK_FOR_BBT;
 	boot_info->physic_block_reserved = 0;
 
 	awrawnand_info("flash id@%02x %02x %02x %02x %02x %02x %02x %02x\n",
@@ -189,6 +189,7 @@ static int rawnand_mtd_erase_data(void)
 
 	rawnand_uboot_blknum(NULL, &start);
 	start += AW_RAWNAND_RESERVED_PHY_BLK_FOR_SECURE_STORAGE;
+	start += AW_RAWNAND_RESERVED_PHY_BLK_FOR_BBT;
 	end = total_size >> chip->erase_shift;
 
 	/* [start, end) */
@@ -15,6 +15,7 @@
 #include <linux/mtd/mtd.h>
 #include <linux/sizes.h>
 #include <linux/mtd/aw-ubi.h>
+#include <part_index.h>
 /*
 * undef crc32 -> crc32_le in linux/crc32.h
 * crc32 for sunxi_mbr
@@ -90,6 +91,17 @@ struct ubi_info {
 	unsigned int ubootblks;
 
 	unsigned int last_vol_sects;
+
+	/* lookup of nand_mbr addresses, ubi_mbr and mtd part names */
+	struct part_index nand_idx;
+	struct part_index vol_idx;
+	struct part_index mtd_idx;
+
+	/*
+	 * kapi descriptors of the ubi_mbr volumes on ubi0, see
+	 * ubi_vol_desc_get(), closed before that device is detached
+	 */
+	struct ubi_volume_desc *vol_desc[NAND_MAX_PART_CNT];
 };
 static struct ubi_info g_ubi_info;
 
@@ -147,6 +159,21 @@ static int get_partno_by_addr(unsigned int offset, unsigned int sec_cnt)
 		return -ENODEV;
 	}
 
+	if (ubinfo->nand_idx.valid) {
+		i = part_index_find_addr(&ubinfo->nand_idx, offset, sec_cnt);
+		if (i >= 0)
+			return i;
+		if (i == -ERANGE) {
+			i = part_index_find_addr(&ubinfo->nand_idx, offset, 1);
+			pr_err("offset 0x%x with sects 0x%x over volume %s [0x%x 0x%x)\n",
+					offset, sec_cnt,
+					nand_mbr->vols[i].name, nand_mbr->vols[i].addr,
+					nand_mbr->vols[i].addr + nand_mbr->vols[i].sects);
+			return -EINVAL;
+		}
+		goto not_found;
+	}
+
 	for (i = 0; i < nand_mbr->part_cnt; i++) {
 		addr = nand_mbr->vols[i].addr;
 		sects = nand_mbr->vols[i].sects;
@@ -162,6 +189,7 @@ static int get_partno_by_addr(unsigned int offset, unsigned int sec_cnt)
 		return i;
 	}
 
+not_found:
 	pr_err("get partno from nand_mbr failed: offset 0x%x sects %u\n",
 			offset, sec_cnt);
 	print_ubi_mbr(nand_mbr);
@@ -174,6 +202,18 @@ static int get_volnum_by_name(char *name)
 	struct ubi_info *ubinfo = get_ubi_info();
 	struct ubi_mbr *ubi_mbr = ubi_to_ubi_mbr(ubinfo);;
 
+	/*
+	 * the index only tells names apart by their first
+	 * PART_INDEX_NAME_LEN characters, walk the map on a mismatch
+	 */
+	if (ubinfo->vol_idx.valid && name) {
+		i = part_index_find_name(&ubinfo->vol_idx, name);
+		if (i < 0)
+			return -ENODEV;
+		if (!strcmp((char *)ubi_mbr->vols[i].name, name))
+			return i;
+	}
+
 	for (i = 0; i < ubi_mbr->part_cnt; i++) {
 		if (name == NULL)
 			continue;
@@ -193,6 +233,15 @@ static int get_mtd_num_by_name(char *name)
 	if (name == NULL)
 		return -EINVAL;
 
+	/* as for the volumes, a hit in the index may only share a prefix */
+	if (ubinfo->mtd_idx.valid) {
+		i = part_index_find_name(&ubinfo->mtd_idx, name);
+		if (i < 0)
+			return -EINVAL;
+		if (!strcmp(mtd_info->part[i].name, name))
+			return i;
+	}
+
 	for (i = 0; i < mtd_info->part_cnt; i++)
 		if (!strcmp(mtd_info->part[i].name, name))
 			return i;
@@ -220,6 +269,204 @@ static inline unsigned int offset_on_part(int partno, unsigned int addr)
 	return addr - nand_mbr->vols[partno].addr;
 }
 
+/*
+ * Native volume access.
+ * The sector path used to build 'ubi check/write.part/read' command lines
+ * for every batch, the command parsed them and looked the volume up by
+ * name again. Now a volume is opened once through the ubi kapi and its
+ * descriptor is kept per ubi_mbr volume until ubi is attached again.
+ * The offline burn simulator has no real ubi device behind it, it keeps
+ * the command path.
+ */
+static int ubi_native_enabled(void)
+{
+#ifdef CONFIG_UBI_OFFLINE_BURN
+	if (WORK_MODE_BOOT != get_boot_work_mode())
+		return 0;
+#endif
+	return 1;
+}
+
+static void ubi_vol_desc_put_all(struct ubi_info *ubinfo)
+{
+	int i;
+
+	for (i = 0; i < NAND_MAX_PART_CNT; i++) {
+		if (!ubinfo->vol_desc[i])
+			continue;
+		ubi_close_volume(ubinfo->vol_desc[i]);
+		ubinfo->vol_desc[i] = NULL;
+	}
+}
+
+void ubi_detach_notify(int ubi_num)
+{
+	if (!ubi_num)
+		ubi_vol_desc_put_all(get_ubi_info());
+}
+
+static struct ubi_volume_desc *ubi_vol_desc_get(struct ubi_info *ubinfo,
+		int num)
+{
+	struct ubi_mbr *ubi_mbr = ubi_to_ubi_mbr(ubinfo);
+	struct ubi_volume_desc *desc;
+
+	if (num < 0 || num >= ubi_mbr->part_cnt)
+		return NULL;
+
+	if (ubinfo->vol_desc[num])
+		return ubinfo->vol_desc[num];
+
+	desc = ubi_open_volume_nm(0, (char *)ubi_mbr->vols[num].name,
+			UBI_READWRITE);
+	if (IS_ERR(desc))
+		return NULL;
+
+	ubinfo->vol_desc[num] = desc;
+	return desc;
+}
+
+static int ubi_native_write(struct ubi_info *ubinfo, int num, void *buf,
+		size_t bytes, size_t full_bytes)
+{
+	int err;
+	long long rsvd_bytes;
+	struct ubi_volume_desc *desc;
+	struct ubi_volume *vol;
+	struct ubi_device *ubi;
+
+	desc = ubi_vol_desc_get(ubinfo, num);
+	if (!desc)
+		return -ENODEV;
+	vol = desc->vol;
+	ubi = vol->ubi;
+
+	/* write.part with fullsize, start the update of the volume */
+	if (full_bytes) {
+		rsvd_bytes = (long long)vol->reserved_pebs *
+			(ubi->leb_size - vol->data_pad);
+		if (bytes > rsvd_bytes) {
+			pr_err("size > volume size! Aborting!\n");
+			return -EINVAL;
+		}
+
+		err = ubi_start_update(ubi, vol, full_bytes);
+		if (err < 0) {
+			pr_err("cannot start volume %s update\n", vol->name);
+			return err;
+		}
+	}
+
+	err = ubi_more_update_data(ubi, vol, buf, bytes);
+	if (err < 0) {
+		pr_err("couldnt or partially wrote data\n");
+		return err;
+	}
+
+	if (err) {
+		/* the last data of the update, check the volume like ubi does */
+		err = ubi_check_volume(ubi, vol->vol_id);
+		if (err < 0)
+			return err;
+
+		if (err) {
+			ubi_warn(ubi, "volume %d on UBI device %d is corrupt",
+				 vol->vol_id, ubi->ubi_num);
+			vol->corrupted = 1;
+		}
+
+		vol->checked = 1;
+		ubi_gluebi_updated(vol);
+	}
+
+	return 0;
+}
+
+static int ubi_native_read(struct ubi_info *ubinfo, int num, loff_t offp,
+		void *buf, size_t size)
+{
+	int err;
+	u32 off;
+	int lnum, len;
+	struct ubi_volume_desc *desc;
+	struct ubi_volume *vol;
+
+	desc = ubi_vol_desc_get(ubinfo, num);
+	if (!desc)
+		return -ENODEV;
+	vol = desc->vol;
+
+	if (vol->updating) {
+		pr_err("volume %s is updating\n", vol->name);
+		return -EBUSY;
+	}
+	if (vol->upd_marker) {
+		pr_err("damaged volume %s, update marker is set\n", vol->name);
+		return -EBADF;
+	}
+	if (offp >= vol->used_bytes)
+		return 0;
+	if (!size || offp + size > vol->used_bytes)
+		size = vol->used_bytes - offp;
+
+	/* straight into the caller buffer, leb by leb */
+	lnum = div_u64_rem(offp, vol->usable_leb_size, &off);
+	while (size) {
+		len = min_t(size_t, size, vol->usable_leb_size - off);
+		err = ubi_leb_read(desc, lnum, buf, off, len, 0);
+		if (err) {
+			pr_err("read volume %s leb %d err %d\n", vol->name,
+					lnum, err);
+			return err;
+		}
+		lnum++;
+		off = 0;
+		buf += len;
+		size -= len;
+	}
+
+	return 0;
+}
+
+/*
+ * (re)build the lookup indexes of the maps, the lookups above walk the
+ * maps themselves while an index is not valid
+ */
+static void ubi_build_index(struct ubi_info *ubinfo)
+{
+	int i;
+	struct ubi_mbr *nand_mbr = ubi_to_nand_mbr(ubinfo);
+	struct ubi_mbr *ubi_mbr = ubi_to_ubi_mbr(ubinfo);
+	struct ubi_mtd_info *mtd_info = ubi_to_mtd(ubinfo);
+
+	part_index_reset(&ubinfo->nand_idx);
+	for (i = 0; i < nand_mbr->part_cnt; i++)
+		if (part_index_add(&ubinfo->nand_idx, nand_mbr->vols[i].name,
+				nand_mbr->vols[i].addr,
+				nand_mbr->vols[i].sects, i))
+			break;
+	if (i == nand_mbr->part_cnt)
+		part_index_build(&ubinfo->nand_idx);
+
+	part_index_reset(&ubinfo->vol_idx);
+	for (i = 0; i < ubi_mbr->part_cnt; i++)
+		if (part_index_add(&ubinfo->vol_idx, ubi_mbr->vols[i].name,
+				ubi_mbr->vols[i].addr,
+				ubi_mbr->vols[i].sects, i))
+			break;
+	if (i == ubi_mbr->part_cnt)
+		part_index_build(&ubinfo->vol_idx);
+
+	part_index_reset(&ubinfo->mtd_idx);
+	for (i = 0; i < mtd_info->part_cnt; i++)
+		if (part_index_add(&ubinfo->mtd_idx, mtd_info->part[i].name,
+				to_sects(mtd_info->part[i].offset),
+				to_sects(mtd_info->part[i].bytes), i))
+			break;
+	if (i == mtd_info->part_cnt)
+		part_index_build(&ubinfo->mtd_idx);
+}
+
 static int check_sunxi_mbr(sunxi_mbr_t *sunxi_mbr)
 {
 	if (strncmp((const char *)sunxi_mbr->magic, SUNXI_MBR_MAGIC, 8)) {
@@ -355,6 +602,8 @@ static void init_ubi_mbr(struct ubi_info *ubinfo)
 	struct ubi_status *ubi_status = ubi_to_ubi_status(ubinfo);
 	struct ubi_mtd_info *mtd_info = ubi_to_mtd(ubinfo);
 
+	/* volume numbers change with the new mbr */
+	ubi_vol_desc_put_all(ubinfo);
 	memset(ubi_mbr, 0x00, sizeof(struct ubi_mbr));
 	memset(ubi_status, 0x00, sizeof(struct ubi_status));
 	ubi_status->last_partno = -1;
@@ -433,6 +682,8 @@ static int ubi_attach_mtd_do(int mtdnum)
 		pr_err("mtd_name is NULL !!!\n");
 		return -EINVAL;
 	}
+	ubi_vol_desc_put_all(get_ubi_info());
+
 	for (i = 0; i < 6; i++)
 		argv[i] = cmd[i];
 
@@ -454,13 +705,17 @@ static int check_volume_existed_do(char *name)
 {
 	char cmd[6][20];
 	char *argv[6];
-	int i;
+	int i, num;
 
-	if (get_volnum_by_name(name) < 0) {
+	num = get_volnum_by_name(name);
+	if (num < 0) {
 		pr_err("not found volume %s in mbr !!!\n", name);
 		return -ENODEV;
 	}
 
+	if (ubi_native_enabled())
+		return ubi_vol_desc_get(get_ubi_info(), num) ? 0 : 1;
+
 	for (i = 0; i < 6; i++)
 		argv[i] = cmd[i];
 
@@ -573,6 +828,7 @@ static int create_ubi_volume(struct ubi_info *ubinfo)
 	 */
 	nand_mbr->vols[i - 1].sects = ubinfo->last_vol_sects;
 	ubi_mbr->vols[i - 1].sects = ubinfo->last_vol_sects;
+	ubi_build_index(ubinfo);
 
 	return ret;
 }
@@ -586,6 +842,10 @@ static int read_ubi_volume_do(char *vol_name, unsigned int sectors, void *buf)
 
 	bytes = to_bytes(sectors);
 
+	if (ubi_native_enabled())
+		return ubi_native_read(get_ubi_info(),
+				get_volnum_by_name(vol_name), 0, buf, bytes);
+
 	for (i = 0; i < 6; i++)
 		argv[i] = cmd[i];
 
@@ -676,7 +936,10 @@ static int write_ubi_volume(struct ubi_info *ubinfo, char *name,
 		strcpy(last_name, name);
 		full_bytes = to_bytes(plan_wr_sects);
 	}
-	ret = write_ubi_volume_do(name, buf, bytes, full_bytes);
+	if (ubi_native_enabled())
+		ret = ubi_native_write(ubinfo, num, buf, bytes, full_bytes);
+	else
+		ret = write_ubi_volume_do(name, buf, bytes, full_bytes);
 	if (ret)
 		pr_err("write volume %s with bytes %u full_bytes %u failed\n",
 				name, bytes, full_bytes);
@@ -1031,6 +1294,9 @@ static int read_ubi_volume(struct ubi_info *ubinfo, char *name,
 		}
 	}
 
+	if (ubi_native_enabled())
+		return ubi_native_read(ubinfo, num, offp, buf, size);
+
 	return sunxi_ubi_volume_read(name, offp, (char *)buf, size);
 }
 
@@ -1041,6 +1307,11 @@ static int init_ubi_info(struct ubi_info *ubinfo,
 	struct ubi_mtd_info *mtd_info = ubi_to_mtd(ubinfo);
 	struct ubi_mbr *nand_mbr = ubi_to_nand_mbr(ubinfo);
 
+	/* the maps change below, walk them until the indexes are rebuilt */
+	part_index_reset(&ubinfo->nand_idx);
+	part_index_reset(&ubinfo->vol_idx);
+	part_index_reset(&ubinfo->mtd_idx);
+
 	ret = init_mtd_info(mtd_info);
 	if (ret)
 		return ret;
@@ -1050,6 +1321,7 @@ static int init_ubi_info(struct ubi_info *ubinfo,
 		return ret;
 
 	init_ubi_mbr(ubinfo);
+	ubi_build_index(ubinfo);
 	ubinfo->last_offset = ubinfo->last_partno = -1;
 	return 0;
 }
@@ -1545,6 +1817,17 @@ static void set_env_mtdparts_rawnand(void)
 	wlen += snprintf(ubinfo->mtdparts + wlen, 512 - wlen,
 			"%uk@%u(%s)ro,", mtd_part.bytes / SZ_1K,
 			mtd_part.offset, mtd_part.name);
+#if IS_ENABLED(CONFIG_AW_RAWNAND_BBT)
+	/* bad block table */
+	snprintf((char *)&mtd_part.name, PART_NAME_MAX_SIZE, "bbt");
+	mtd_part.offset = offset;
+	mtd_part.bytes = AW_RAWNAND_RESERVED_PHY_BLK_FOR_BBT;
+	mtd_part.bytes *= phy_blk_bytes;
+	offset += mtd_part.bytes;
+	wlen += snprintf(ubinfo->mtdparts + wlen, 512 - wlen,
+			"%uk@%u(%s)ro,", mtd_part.bytes / SZ_1K,
+			mtd_part.offset, mtd_part.name);
+#endif
 #if IS_ENABLED(CONFIG_AW_RAWNAND_PSTORE_MTD_PART)
 	/* pstore */
 	snprintf((char *)&mtd_part.name, PART_NAME_MAX_SIZE, "pstore");
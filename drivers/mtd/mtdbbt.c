@@ -0,0 +1,257 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Bad block table kept on flash, see include/linux/mtd/mtdbbt.h
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <memalign.h>
+#include <u-boot/crc.h>
+#include <linux/mtd/mtd.h>
+#include <linux/mtd/mtdbbt.h>
+
+/* failed blocks of the area are tracked in a u32 while storing */
+#define MTD_BBT_MAX_BLOCKS	32
+
+static size_t mtd_bbt_bytes(const struct mtd_bbt *bbt)
+{
+	return DIV_ROUND_UP(bbt->nr_bits, 8);
+}
+
+/* header and bitmap in whole pages */
+static size_t mtd_bbt_len(const struct mtd_bbt *bbt)
+{
+	return roundup(sizeof(struct mtd_bbt_hdr) + mtd_bbt_bytes(bbt),
+		       bbt->mtd->writesize);
+}
+
+static loff_t mtd_bbt_block_offs(const struct mtd_bbt *bbt, int block)
+{
+	return bbt->offs + (loff_t)block * bbt->mtd->erasesize;
+}
+
+static u32 mtd_bbt_crc(const struct mtd_bbt *bbt, const struct mtd_bbt_hdr *hdr)
+{
+	u32 crc;
+
+	crc = crc32(0, (const u8 *)&hdr->version,
+		    sizeof(hdr->version) + sizeof(hdr->nr_bits));
+
+	return crc32(crc, (const u8 *)(hdr + 1), mtd_bbt_bytes(bbt));
+}
+
+int mtd_bbt_init(struct mtd_bbt *bbt, struct mtd_info *mtd, loff_t offs,
+		 int nr_blocks, u8 *bitmap, int nr_bits)
+{
+	int i;
+
+	memset(bbt, 0, sizeof(*bbt));
+	bbt->mtd = mtd;
+	bbt->offs = offs;
+	bbt->nr_blocks = nr_blocks;
+	bbt->bitmap = bitmap;
+	bbt->nr_bits = nr_bits;
+	for (i = 0; i < MTD_BBT_COPIES; i++)
+		bbt->copy[i] = -1;
+
+	if (nr_blocks < MTD_BBT_COPIES || nr_blocks > MTD_BBT_MAX_BLOCKS ||
+	    offs < 0 || (offs & (mtd->erasesize - 1)) ||
+	    mtd_bbt_block_offs(bbt, nr_blocks) > mtd->size ||
+	    mtd_bbt_len(bbt) > mtd->erasesize) {
+		bbt->mtd = NULL;
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* Version of the copy in @block, read to @buf, 0 if there is no valid one */
+static u32 mtd_bbt_read_copy(struct mtd_bbt *bbt, int block, u8 *buf)
+{
+	struct mtd_info *mtd = bbt->mtd;
+	struct mtd_bbt_hdr *hdr = (struct mtd_bbt_hdr *)buf;
+	loff_t offs = mtd_bbt_block_offs(bbt, block);
+	size_t len = mtd_bbt_len(bbt), retlen;
+	int ret;
+
+	/* the first page tells whether the rest is worth reading */
+	ret = mtd_read(mtd, offs, mtd->writesize, &retlen, buf);
+	if (ret && ret != -EUCLEAN)
+		return 0;
+	if (le32_to_cpu(hdr->magic) != MTD_BBT_MAGIC ||
+	    le32_to_cpu(hdr->nr_bits) != bbt->nr_bits || !hdr->version)
+		return 0;
+
+	if (len > mtd->writesize) {
+		ret = mtd_read(mtd, offs + mtd->writesize, len - mtd->writesize,
+			       &retlen, buf + mtd->writesize);
+		if (ret && ret != -EUCLEAN)
+			return 0;
+	}
+	if (le32_to_cpu(hdr->crc) != mtd_bbt_crc(bbt, hdr))
+		return 0;
+
+	return le32_to_cpu(hdr->version);
+}
+
+static int mtd_bbt_write_copy(struct mtd_bbt *bbt, int block, const u8 *buf)
+{
+	struct mtd_info *mtd = bbt->mtd;
+	struct erase_info instr = {
+		.mtd = mtd,
+		.addr = mtd_bbt_block_offs(bbt, block),
+		.len = mtd->erasesize,
+	};
+	size_t len = mtd_bbt_len(bbt), retlen;
+	int ret;
+
+	ret = mtd_erase(mtd, &instr);
+	if (ret)
+		return ret;
+
+	ret = mtd_write(mtd, instr.addr, len, &retlen, buf);
+	if (!ret && retlen != len)
+		ret = -EIO;
+
+	return ret;
+}
+
+static bool mtd_bbt_is_copy(const struct mtd_bbt *bbt, int block)
+{
+	int i;
+
+	for (i = 0; i < MTD_BBT_COPIES; i++) {
+		if (bbt->copy[i] == block)
+			return true;
+	}
+
+	return false;
+}
+
+/* A good block of the area holding no copy and not failed yet */
+static int mtd_bbt_free_block(const struct mtd_bbt *bbt, u32 failed)
+{
+	int block;
+
+	for (block = 0; block < bbt->nr_blocks; block++) {
+		if (failed & BIT(block) || mtd_bbt_is_copy(bbt, block))
+			continue;
+		if (!mtd_block_isbad(bbt->mtd, mtd_bbt_block_offs(bbt, block)))
+			return block;
+	}
+
+	return -ENOSPC;
+}
+
+int mtd_bbt_store(struct mtd_bbt *bbt)
+{
+	struct mtd_bbt_hdr *hdr;
+	int i, written = 0;
+	u32 failed = 0;
+	u8 *buf;
+
+	if (!bbt->mtd)
+		return -EINVAL;
+
+	buf = malloc_cache_aligned(mtd_bbt_len(bbt));
+	if (!buf)
+		return -ENOMEM;
+
+	memset(buf, 0xff, mtd_bbt_len(bbt));
+	hdr = (struct mtd_bbt_hdr *)buf;
+	hdr->magic = cpu_to_le32(MTD_BBT_MAGIC);
+	hdr->version = cpu_to_le32(bbt->version + 1);
+	hdr->nr_bits = cpu_to_le32(bbt->nr_bits);
+	memcpy(hdr + 1, bbt->bitmap, mtd_bbt_bytes(bbt));
+	hdr->crc = cpu_to_le32(mtd_bbt_crc(bbt, hdr));
+
+	/* one copy at a time, the other one stays complete meanwhile */
+	for (i = 0; i < MTD_BBT_COPIES; i++) {
+		for (;;) {
+			if (bbt->copy[i] < 0)
+				bbt->copy[i] = mtd_bbt_free_block(bbt, failed);
+			if (bbt->copy[i] < 0) {
+				bbt->copy[i] = -1;
+				break;
+			}
+			if (!mtd_bbt_write_copy(bbt, bbt->copy[i], buf)) {
+				written++;
+				break;
+			}
+
+			pr_warn("mtd_bbt: writing block %d of the area failed\n",
+				bbt->copy[i]);
+			failed |= BIT(bbt->copy[i]);
+			bbt->copy[i] = -1;
+		}
+	}
+	free(buf);
+
+	if (!written)
+		return -EIO;
+	bbt->version++;
+	if (written < MTD_BBT_COPIES)
+		pr_warn("mtd_bbt: version %u has %d copy only\n", bbt->version,
+			written);
+
+	return 0;
+}
+
+int mtd_bbt_load(struct mtd_bbt *bbt)
+{
+	u32 version[MTD_BBT_MAX_BLOCKS] = { 0 };
+	int block, i, current = 0;
+	u32 newest = 0;
+	u8 *buf;
+
+	if (!bbt->mtd)
+		return -EINVAL;
+
+	buf = malloc_cache_aligned(mtd_bbt_len(bbt));
+	if (!buf)
+		return -ENOMEM;
+
+	for (block = 0; block < bbt->nr_blocks; block++) {
+		if (mtd_block_isbad(bbt->mtd, mtd_bbt_block_offs(bbt, block)))
+			continue;
+
+		version[block] = mtd_bbt_read_copy(bbt, block, buf);
+		if (version[block] > newest) {
+			newest = version[block];
+			memcpy(bbt->bitmap, buf + sizeof(struct mtd_bbt_hdr),
+			       mtd_bbt_bytes(bbt));
+		}
+	}
+	free(buf);
+
+	if (!newest)
+		return -ENOENT;
+	bbt->version = newest;
+
+	/*
+	 * Newest copies go to the last slots and older ones to the first,
+	 * a rewrite then replaces a newest copy last.
+	 */
+	for (i = 0; i < MTD_BBT_COPIES; i++)
+		bbt->copy[i] = -1;
+	i = MTD_BBT_COPIES - 1;
+	for (block = 0; block < bbt->nr_blocks && i >= 0; block++) {
+		if (version[block] == newest) {
+			bbt->copy[i--] = block;
+			current++;
+		}
+	}
+	for (block = 0; block < bbt->nr_blocks && i >= 0; block++) {
+		if (version[block] && version[block] != newest)
+			bbt->copy[i--] = block;
+	}
+	debug("mtd_bbt: version %u, %d current copies\n", newest, current);
+
+	if (current < MTD_BBT_COPIES)
+		mtd_bbt_store(bbt);
+
+	return 0;
+}
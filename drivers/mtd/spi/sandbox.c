@@ -277,9 +277,14 @@ static int sandbox_sf_process_cmd(struct sandbox_spi_flash *sbsf, const u8 *rx,
 		if (sbsf->cmd == SPINOR_OP_CHIP_ERASE) {
 			sbsf->erase_size = sbsf->data->sector_size *
 				sbsf->data->n_sectors;
+			/* no address, the erase starts right away */
+			sbsf->state = SF_ERASE;
+			break;
 		} else if (sbsf->cmd == SPINOR_OP_BE_4K && (flags & SECT_4K)) {
 			sbsf->erase_size = 4 << 10;
-		} else if (sbsf->cmd == SPINOR_OP_SE && !(flags & SECT_4K)) {
+		} else if (sbsf->cmd == SPINOR_OP_BE_32K && (flags & SECT_4K)) {
+			sbsf->erase_size = 32 << 10;
+		} else if (sbsf->cmd == SPINOR_OP_SE) {
 			sbsf->erase_size = 64 << 10;
 		} else {
 			debug(" cmd unknown: %#x\n", sbsf->cmd);
@@ -335,6 +340,14 @@ static int sandbox_sf_xfer(struct udevice *dev, unsigned int bitlen,
 		if (ret)
 			return ret;
 		++pos;
+
+		if (sbsf->state == SF_ERASE) {
+			if (os_lseek(sbsf->fd, 0, OS_SEEK_SET) < 0) {
+				puts("sandbox_sf: os_lseek() failed");
+				return -EIO;
+			}
+			goto case_sf_erase;
+		}
 	}
 
 	/* Process the remaining data */
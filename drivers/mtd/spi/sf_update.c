@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * SPI flash update planner
+ *
+ * The range to update is read back and compared in one pass first. Each
+ * run of sectors that needs erasing then goes to the driver as a single
+ * erase request, so it can use block or chip erase, and only the sectors
+ * whose contents change are programmed.
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <spi_flash.h>
+#include <linux/sizes.h>
+
+/* Read back in windows of this size, rounded up to whole sectors */
+#define SF_UPDATE_WINDOW	SZ_64K
+
+enum {
+	SF_UPDATE_SAME,		/* data already on the flash */
+	SF_UPDATE_BLANK,	/* sector erased, only needs programming */
+	SF_UPDATE_DIRTY,	/* sector needs erasing and programming */
+	SF_UPDATE_ERASE,	/* new data all 0xff, only needs erasing */
+};
+
+static bool sf_update_blank(const void *buf, size_t len)
+{
+	const u8 *p = buf;
+	const ulong *w;
+
+	for (; len && ((ulong)p & (sizeof(ulong) - 1)); len--)
+		if (*p++ != 0xff)
+			return false;
+
+	for (w = (const ulong *)p; len >= sizeof(ulong); len -= sizeof(ulong))
+		if (*w++ != ~0UL)
+			return false;
+
+	for (p = (const u8 *)w; len; len--)
+		if (*p++ != 0xff)
+			return false;
+
+	return true;
+}
+
+static inline bool sf_update_needs_erase(u8 state)
+{
+	return state == SF_UPDATE_DIRTY || state == SF_UPDATE_ERASE;
+}
+
+static inline bool sf_update_needs_program(u8 state)
+{
+	return state == SF_UPDATE_DIRTY || state == SF_UPDATE_BLANK;
+}
+
+int spi_flash_update_range(struct spi_flash *flash, u32 offset, size_t len,
+			   const void *buf, struct spi_flash_update_stats *stats)
+{
+	const u8 *src = buf;
+	u32 sect = flash->erase_size;
+	size_t win, pos, todo, cnt, run;
+	u8 *state = NULL, *cmp_buf = NULL, *tail_buf = NULL;
+	u32 nr_sect, last, i, j;
+	int ret = 0;
+
+	memset(stats, 0, sizeof(*stats));
+	if (!len)
+		return 0;
+
+	if (!sect || offset % sect || len > flash->size ||
+	    offset > flash->size - len) {
+		printf("SF: update offset not multiple of erase size or past the end\n");
+		return -EINVAL;
+	}
+
+	win = roundup(SF_UPDATE_WINDOW, sect);
+	nr_sect = DIV_ROUND_UP(len, sect);
+	state = malloc(nr_sect);
+	cmp_buf = memalign(ARCH_DMA_MINALIGN, win);
+	if (!state || !cmp_buf) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	/* Sort every sector of the range before touching the flash */
+	for (pos = 0; pos < len; pos += todo) {
+		todo = min_t(size_t, len - pos, win);
+		ret = spi_flash_read(flash, offset + pos, roundup(todo, sect),
+				     cmp_buf);
+		if (ret)
+			goto out;
+
+		for (j = 0; j < todo; j += sect) {
+			i = (pos + j) / sect;
+			cnt = min_t(size_t, todo - j, sect);
+			if (!memcmp(cmp_buf + j, src + pos + j, cnt)) {
+				state[i] = SF_UPDATE_SAME;
+				stats->skipped += cnt;
+			} else if (sf_update_blank(cmp_buf + j, sect)) {
+				state[i] = SF_UPDATE_BLANK;
+			} else if (cnt == sect &&
+				   sf_update_blank(src + pos + j, cnt)) {
+				state[i] = SF_UPDATE_ERASE;
+			} else {
+				state[i] = SF_UPDATE_DIRTY;
+			}
+
+			/* A partial last sector keeps what follows the data */
+			if (cnt != sect && state[i] == SF_UPDATE_DIRTY) {
+				tail_buf = memalign(ARCH_DMA_MINALIGN, sect);
+				if (!tail_buf) {
+					ret = -ENOMEM;
+					goto out;
+				}
+				memcpy(tail_buf, cmp_buf + j, sect);
+				memcpy(tail_buf, src + pos + j, cnt);
+			}
+		}
+	}
+
+	/* One erase request per run, the driver picks the erase commands */
+	for (i = 0; i < nr_sect; i = j) {
+		for (j = i; j < nr_sect && sf_update_needs_erase(state[j]); j++)
+			;
+		if (j == i) {
+			j++;
+			continue;
+		}
+
+		run = (size_t)(j - i) * sect;
+		ret = spi_flash_erase(flash, offset + i * sect, run);
+		if (ret)
+			goto out;
+		stats->erased += run;
+	}
+
+	/* The merged partial last sector is programmed on its own */
+	last = tail_buf ? nr_sect - 1 : nr_sect;
+	for (i = 0; i < last; i = j) {
+		for (j = i; j < last && sf_update_needs_program(state[j]); j++)
+			;
+		if (j == i) {
+			j++;
+			continue;
+		}
+
+		pos = (size_t)i * sect;
+		run = min_t(size_t, len, (size_t)j * sect) - pos;
+		ret = spi_flash_write(flash, offset + pos, run, src + pos);
+		if (ret)
+			goto out;
+		stats->programmed += run;
+	}
+
+	if (tail_buf) {
+		ret = spi_flash_write(flash, offset + last * sect, sect,
+				      tail_buf);
+		if (ret)
+			goto out;
+		stats->programmed += sect;
+	}
+
+out:
+	free(tail_buf);
+	free(cmp_buf);
+	free(state);
+
+	return ret;
+}
@@ -925,10 +925,10 @@ static int read_bar(struct spi_nor *nor, const struct flash_info *info)
 /*
  * Initiate the erasure of a single sector
  */
-static int spi_nor_erase_sector(struct spi_nor *nor, u32 addr)
+static int spi_nor_erase_sector(struct spi_nor *nor, u8 opcode, u32 addr)
 {
 	struct spi_mem_op op =
-		SPI_MEM_OP(SPI_MEM_OP_CMD(nor->erase_opcode, 1),
+		SPI_MEM_OP(SPI_MEM_OP_CMD(opcode, 1),
 			   SPI_MEM_OP_ADDR(nor->addr_width, addr, 1),
 			   SPI_MEM_OP_NO_DUMMY,
 			   SPI_MEM_OP_NO_DATA);
@@ -943,6 +943,37 @@ static int spi_nor_erase_sector(struct spi_nor *nor, u32 addr)
 	return spi_mem_exec_op(nor->spi, &op);
 }
 
+/*
+ * Pick the erase command for the next chunk of an erase. Parts set up for
+ * 4K sector erase also have 32K and 64K block erase, the largest one that
+ * fits the alignment and the length left is used.
+ */
+static u8 spi_nor_erase_opcode(struct spi_nor *nor, u32 addr, u32 len,
+			       u32 *size)
+{
+	bool addr4 = nor->erase_opcode == SPINOR_OP_BE_4K_4B;
+
+	*size = nor->mtd.erasesize;
+	if (!IS_ENABLED(CONFIG_SPI_FLASH_ERASE_COALESCE) || nor->erase ||
+	    (nor->erase_opcode != SPINOR_OP_BE_4K && !addr4))
+		return nor->erase_opcode;
+
+	if (nor->info->sector_size == SZ_64K && !(addr % SZ_64K) &&
+	    len >= SZ_64K) {
+		*size = SZ_64K;
+		return addr4 ? SPINOR_OP_SE_4B : SPINOR_OP_SE;
+	}
+
+	if (!(addr % SZ_32K) && len >= SZ_32K) {
+		*size = SZ_32K;
+		return addr4 ? SPINOR_OP_BE_32K_4B : SPINOR_OP_BE_32K;
+	}
+
+	return nor->erase_opcode;
+}
+
+static int spi_nor_force_erase(struct mtd_info *mtd);
+
 /*
  * Erase an address range on the nor chip.  The address range may extend
  * one or more erase sectors.  Return an error is there is a problem erasing.
@@ -950,8 +981,9 @@ static int spi_nor_erase_sector(struct spi_nor *nor, u32 addr)
 static int spi_nor_erase(struct mtd_info *mtd, struct erase_info *instr)
 {
 	struct spi_nor *nor = mtd_to_spi_nor(mtd);
-	u32 addr, len, rem;
-	int ret;
+	u32 addr, len, rem, size;
+	u8 opcode;
+	int ret = 0;
 
 	dev_dbg(nor->dev, "at 0x%llx, len %lld\n", (long long)instr->addr,
 		(long long)instr->len);
@@ -963,6 +995,12 @@ static int spi_nor_erase(struct mtd_info *mtd, struct erase_info *instr)
 	addr = instr->addr;
 	len = instr->len;
 
+	/* The whole chip goes in one command */
+	if (IS_ENABLED(CONFIG_SPI_FLASH_ERASE_COALESCE) && !nor->erase &&
+	    !(nor->flags & SNOR_F_NO_OP_CHIP_ERASE) &&
+	    !addr && len == mtd->size && len >= SZ_1M)
+		return spi_nor_force_erase(mtd);
+
 	while (len) {
 #ifdef CONFIG_SPI_FLASH_BAR
 		ret = write_bar(nor, addr);
@@ -971,12 +1009,13 @@ static int spi_nor_erase(struct mtd_info *mtd, struct erase_info *instr)
 #endif
 		write_enable(nor);
 
-		ret = spi_nor_erase_sector(nor, addr);
+		opcode = spi_nor_erase_opcode(nor, addr, len, &size);
+		ret = spi_nor_erase_sector(nor, opcode, addr);
 		if (ret)
 			goto erase_err;
 
-		addr += mtd->erasesize;
-		len -= mtd->erasesize;
+		addr += size;
+		len -= size;
 
 		ret = spi_nor_wait_till_ready(nor);
 		if (ret)
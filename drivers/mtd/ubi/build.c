@@ -1088,6 +1088,13 @@ out_free:
 	return err;
 }
 
+#ifdef __UBOOT__
+/* users keeping volumes open across commands close them here */
+void __weak ubi_detach_notify(int ubi_num)
+{
+}
+#endif
+
 /**
  * ubi_detach_mtd_dev - detach an MTD device.
  * @ubi_num: UBI device number to detach from
@@ -1108,6 +1115,11 @@ int ubi_detach_mtd_dev(int ubi_num, int anyway)
 	if (ubi_num < 0 || ubi_num >= UBI_MAX_DEVICES)
 		return -EINVAL;
 
+#ifdef __UBOOT__
+	if (ubi_devices[ubi_num])
+		ubi_detach_notify(ubi_num);
+#endif
+
 	ubi = ubi_get_device(ubi_num);
 	if (!ubi)
 		return -EINVAL;
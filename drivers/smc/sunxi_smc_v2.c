@@ -34,6 +34,7 @@ DECLARE_GLOBAL_DATA_PTR;
 
 #define PSCI_CPU_OFF                0x84000002
 #define PSCI_CPU_ON_AARCH32         0x84000003
+#define PSCI_AFFINITY_INFO_AARCH32  0x84000004
 
 #define SUNXI_CPU_ON_AARCH32        0x84000010
 #define SUNXI_CPU_OFF_AARCH32       0x84000011
@@ -93,6 +94,12 @@ int arm_svc_set_cpu_off(int cpu)
 	return sunxi_smc_call(PSCI_CPU_OFF, cpu, 0, 0, 0);
 }
 
+/* 0 on, 1 off, 2 on pending, negative if the firmware can't tell */
+int arm_svc_cpu_affinity(int cpu)
+{
+	return sunxi_smc_call(PSCI_AFFINITY_INFO_AARCH32, cpu, 0, 0, 0);
+}
+
 /*for multi cluster*/
 int sunxi_smc_set_cpu_entry(u32 entry, int cpu)
 {
@@ -0,0 +1,237 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * hash_sg backend of the CE 2.1 and 2.3, see include/hash_sg.h
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <hash_sg.h>
+#include <malloc.h>
+#include <memalign.h>
+#include <asm/io.h>
+#include <asm/arch/ce.h>
+#include "ss_op.h"
+
+#ifdef CONFIG_HASH_SG
+/*
+ * A hash_sg job owns the CE until it is polled done. Its pieces are spread
+ * over chained hash tasks of up to SS_SG_SOURCES sources each; every task
+ * leaves the hash state in its destination, which the next task takes as
+ * IV. The first task takes the state of an earlier job as IV when the job
+ * goes on with a message. The last task raises the pending bit, and pads
+ * if the job ends the message.
+ */
+#define SS_SG_SOURCES	8
+/* the CE takes the total length in bits as one 32-bit word */
+#define SS_SG_MAX_BYTES	(0xffffffffU >> 3)
+
+#ifdef CONFIG_SUNXI_CE_23
+typedef struct hash_task_descriptor ss_sg_task;
+
+/* addresses are 40 bits wide here, the top byte stays 0 */
+static void ss_sg_addr(u8 *field, const void *addr)
+{
+	u32 val = GET_LO32(addr);
+
+	memcpy(field, &val, 4);
+}
+
+static void ss_sg_task_fill(ss_sg_task *task, const struct hash_sg *piece,
+			    int nr_piece, u32 bits, const u8 *iv, u8 *state,
+			    int last, int pad)
+{
+	int s;
+
+	task->ctrl = (CHANNEL_0 << CHN) | ((iv != NULL) << IVE) |
+		     (pad << LPKG) | (last << IE);
+	task->cmd = SUNXI_SHA256;
+	memcpy(task->data_toal_len_addr, &bits, 4);
+	if (iv)
+		ss_sg_addr(task->iv_addr, iv);
+	for (s = 0; s < nr_piece; s++) {
+		ss_sg_addr(task->sg[s].source_addr, piece[s].addr);
+		task->sg[s].source_len = piece[s].len;
+	}
+	ss_sg_addr(task->sg[0].dest_addr, state);
+	task->sg[0].dest_len = 32;
+}
+
+static void ss_sg_task_link(ss_sg_task *task, ss_sg_task *next)
+{
+	ss_sg_addr(task->next_task_addr, next);
+}
+
+static u32 ss_sg_task_addr(ss_sg_task *task)
+{
+	return GET_LO32(task);
+}
+#else
+/* the 2.1 hash task is no whole number of cache lines, pad it to one */
+typedef struct {
+	task_queue_other t;
+} __aligned(CACHE_LINE_SIZE) ss_sg_task;
+
+static void ss_sg_task_fill(ss_sg_task *task, const struct hash_sg *piece,
+			    int nr_piece, u32 bits, const u8 *iv, u8 *state,
+			    int last, int pad)
+{
+	u32 align_shift = ss_get_addr_align();
+	int s;
+
+	task->t.ctrl = (CHANNEL_0 << CHN) | ((iv != NULL) << IVE) |
+		       (pad << LPKG) | (last << IE);
+	task->t.cmd = SUNXI_SHA256;
+	task->t.data_toal_len_addr = bits;
+	if (iv)
+		task->t.iv_addr = GET_LO32(iv) >> align_shift;
+	for (s = 0; s < nr_piece; s++) {
+		task->t.source[s].addr = GET_LO32(piece[s].addr) >> align_shift;
+		task->t.source[s].length = ALIGN(piece[s].len, 4);
+	}
+	task->t.destination[0].addr = GET_LO32(state) >> align_shift;
+	task->t.destination[0].length = 32;
+}
+
+static void ss_sg_task_link(ss_sg_task *task, ss_sg_task *next)
+{
+	task->t.next_descriptor_addr = GET_LO32(next) >> ss_get_addr_align();
+}
+
+static u32 ss_sg_task_addr(ss_sg_task *task)
+{
+	return GET_LO32(task) >> ss_get_addr_align();
+}
+#endif
+
+static struct {
+	struct hash_sg_req *req;
+	void *buf;
+	u8 *digest;	/* destination of the last task */
+} ss_sg;
+
+void ss_sg_wait_idle(void)
+{
+	if (ss_sg.req)
+		hash_sg_wait(ss_sg.req);
+}
+
+static void ss_sg_flush(const void *addr, u32 len)
+{
+	ulong start = round_down((ulong)addr, CACHE_LINE_SIZE);
+
+	flush_cache(start, ALIGN((ulong)addr + len, CACHE_LINE_SIZE) - start);
+}
+
+int hash_sg_hw_submit(struct hash_sg_req *req)
+{
+	int max_piece = 2 * req->nr_sg + 1;
+	int max_task = DIV_ROUND_UP(max_piece, SS_SG_SOURCES);
+	struct hash_sg *piece = NULL;
+	u32 bytes, size;
+	ss_sg_task *task;
+	u8 *state, *iv, *bounce;
+	int nr_piece, i, n, s, t, last, pad, ret;
+
+	if (ss_sg.req)
+		return -EBUSY;
+	if (!req->len || req->msg_len > SS_SG_MAX_BYTES)
+		return -EINVAL;
+
+	size = max_task * (sizeof(*task) + CACHE_LINE_SIZE) + CACHE_LINE_SIZE +
+	       ALIGN((req->nr_sg + 1) * HASH_SG_BLOCK, CACHE_LINE_SIZE);
+	ss_sg.buf = memalign(CACHE_LINE_SIZE, size);
+	piece = malloc(max_piece * sizeof(*piece));
+	if (!ss_sg.buf || !piece) {
+		ret = -ENOMEM;
+		goto fail;
+	}
+	memset(ss_sg.buf, 0, size);
+	task = ss_sg.buf;
+	state = (u8 *)(task + max_task);
+	iv = state + max_task * CACHE_LINE_SIZE;
+	bounce = iv + CACHE_LINE_SIZE;
+	if (req->iv)
+		memcpy(iv, req->iv, 32);
+
+	nr_piece = hash_sg_plan(req->sg, req->nr_sg, piece, bounce);
+	if (nr_piece <= 0) {
+		ret = nr_piece ? nr_piece : -EINVAL;
+		goto fail;
+	}
+
+	for (i = 0, t = 0; i < nr_piece; i += n, t++) {
+		n = min(nr_piece - i, SS_SG_SOURCES);
+		bytes = 0;
+		for (s = i; s < i + n; s++) {
+			bytes += piece[s].len;
+			ss_sg_flush(piece[s].addr, ALIGN(piece[s].len, 4));
+		}
+		last = i + n == nr_piece;
+		pad = last && req->last;
+
+		/* the padding task needs the length of the whole message */
+		ss_sg_task_fill(task + t, piece + i, n,
+				(pad ? (u32)req->msg_len : bytes) << 3,
+				t ? state + (t - 1) * CACHE_LINE_SIZE :
+				    (req->iv ? iv : NULL),
+				state + t * CACHE_LINE_SIZE, last, pad);
+		if (!last)
+			ss_sg_task_link(task + t, task + t + 1);
+	}
+	free(piece);
+	ss_sg.digest = state + (t - 1) * CACHE_LINE_SIZE;
+	flush_cache((ulong)ss_sg.buf, size);
+
+	ss_set_drq(ss_sg_task_addr(task));
+	ss_irq_enable(CHANNEL_0);
+	ss_ctrl_start(HASH_RBG_TRPE);
+	ss_sg.req = req;
+
+	return 0;
+
+fail:
+	free(piece);
+	free(ss_sg.buf);
+	ss_sg.buf = NULL;
+	return ret;
+}
+
+int hash_sg_hw_poll(struct hash_sg_req *req)
+{
+	u32 err;
+
+	if (ss_sg.req != req)
+		return -EINVAL;
+	if (!ss_check_finish(CHANNEL_0))
+		return -EBUSY;
+
+	ss_pending_clear(CHANNEL_0);
+	ss_ctrl_stop();
+	ss_irq_disable(CHANNEL_0);
+	err = ss_check_err(CHANNEL_0);
+
+	invalidate_dcache_range((ulong)ss_sg.digest,
+				(ulong)ss_sg.digest + CACHE_LINE_SIZE);
+	/* a failed job leaves the state to go on from for software */
+	if (!err)
+		memcpy(req->digest, ss_sg.digest, 32);
+	free(ss_sg.buf);
+	memset(&ss_sg, 0, sizeof(ss_sg));
+	/* the job is gone, ss_set_drq() won't wait for it */
+	ss_set_drq(0);
+
+	if (err) {
+		printf("SS %s fail 0x%x\n", __func__, err);
+		return -EIO;
+	}
+
+	return 0;
+}
+#else
+void ss_sg_wait_idle(void)
+{
+}
+#endif
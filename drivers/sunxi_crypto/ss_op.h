@@ -15,17 +15,21 @@ void ss_set_drq(u32 addr);
 void ss_ctrl_start(u8 alg_type);
 void ss_ctrl_stop(void);
 void ss_wait_finish(u32 task_id);
-void ss_pending_clear(u32 task_id);
+int ss_check_finish(u32 task_id);
 void ss_irq_enable(u32 task_id);
 void ss_irq_disable(u32 task_id);
 #if defined(CONFIG_SUNXI_CE_21) || defined(CONFIG_SUNXI_CE_23)
+u32 ss_pending_clear(u32 task_id);
 u32 ss_check_err(u32 task_id);
 #else
+void ss_pending_clear(u32 task_id);
 u32 ss_check_err(void);
 #endif
 void ss_open(void);
 void ss_close(void);
 u32 ss_get_addr_align(void);
+/* waits for a hash_sg job still holding the CE, see ss_hash_sg.c */
+void ss_sg_wait_idle(void);
 
 #endif
 
@@ -9,6 +9,7 @@
 #include <asm/io.h>
 #include <asm/arch/clock.h>
 #include <asm/arch/ce.h>
+#include "ss_op.h"
 #include <asm/arch/efuse.h>
 
 static int ss_base_mode;
@@ -35,6 +36,8 @@ __weak int ss_get_ver(void)
 
 __weak void ss_set_drq(u32 addr)
 {
+	/* a running hash_sg job keeps the CE until it is done */
+	ss_sg_wait_idle();
 	writel(addr, SS_TDQ);
 }
 
@@ -70,6 +73,12 @@ __weak void ss_wait_finish(u32 task_id)
 	}
 }
 
+__weak int ss_check_finish(u32 task_id)
+{
+	/* done or failed */
+	return (readl(SS_ISR) & (0x3 << task_id * 2)) ? 1 : 0;
+}
+
 __weak u32 ss_pending_clear(u32 task_id)
 {
 	u32 reg_val;
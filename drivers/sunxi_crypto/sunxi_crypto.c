@@ -6,6 +6,9 @@
  */
 
 #include <common.h>
+#include <errno.h>
+#include <hash_sg.h>
+#include <malloc.h>
 #include <asm/io.h>
 #include <asm/arch/ce.h>
 #include <memalign.h>
@@ -388,6 +391,170 @@ int sunxi_sha_calc(u8 *dst_addr, u32 dst_len, u8 *src_addr, u32 src_len)
 	return 0;
 }
 
+#ifdef CONFIG_HASH_SG
+/*
+ * A hash_sg job owns the CE until it is polled done. Its pieces are spread
+ * over chained task descriptors of up to SS_SG_SOURCES sources each; every
+ * task leaves the hash state in its destination, which the next task takes
+ * as IV. The first task takes the state of an earlier job as IV when the
+ * job goes on with a message. The last task raises the pending bit, and
+ * pads if the job ends the message.
+ */
+#define SS_SG_SOURCES	8
+/* the CE takes the total length in bits as one 32-bit word */
+#define SS_SG_MAX_BYTES	(0xffffffffU >> 3)
+
+static struct {
+	struct hash_sg_req *req;
+	void *buf;
+	u8 *state;	/* CACHE_LINE_SIZE per task, the last one the digest */
+	int nr_task;
+} ss_sg;
+
+void ss_sg_wait_idle(void)
+{
+	if (ss_sg.req)
+		hash_sg_wait(ss_sg.req);
+}
+
+static void ss_sg_flush(const void *addr, u32 len)
+{
+	ulong start = round_down((ulong)addr, CACHE_LINE_SIZE);
+
+	flush_cache(start, ALIGN((ulong)addr + len, CACHE_LINE_SIZE) - start);
+}
+
+int hash_sg_hw_submit(struct hash_sg_req *req)
+{
+	int max_piece = 2 * req->nr_sg + 1;
+	int max_task = DIV_ROUND_UP(max_piece, SS_SG_SOURCES);
+	u32 align_shift = ss_get_addr_align();
+	u32 *total_bits, bytes, size;
+	struct hash_sg *piece;
+	task_queue *task, *tq;
+	u8 *state, *iv, *bounce;
+	int nr_piece, i, s, last, pad, ret;
+
+	/* CE1.0 pads in the source buffer */
+	if (ss_get_ver() < 2)
+		return -ENOSYS;
+	if (ss_sg.req)
+		return -EBUSY;
+	if (!req->len || req->msg_len > SS_SG_MAX_BYTES)
+		return -EINVAL;
+
+	size = max_task * (sizeof(task_queue) + CACHE_LINE_SIZE) +
+	       2 * CACHE_LINE_SIZE +
+	       ALIGN((req->nr_sg + 1) * HASH_SG_BLOCK, CACHE_LINE_SIZE);
+	ss_sg.buf = memalign(CACHE_LINE_SIZE, size);
+	piece = malloc(max_piece * sizeof(*piece));
+	if (!ss_sg.buf || !piece) {
+		ret = -ENOMEM;
+		goto fail;
+	}
+	memset(ss_sg.buf, 0, size);
+	task = ss_sg.buf;
+	state = (u8 *)(task + max_task);
+	total_bits = (u32 *)(state + max_task * CACHE_LINE_SIZE);
+	iv = (u8 *)total_bits + CACHE_LINE_SIZE;
+	bounce = iv + CACHE_LINE_SIZE;
+	if (req->iv)
+		memcpy(iv, req->iv, 32);
+
+	nr_piece = hash_sg_plan(req->sg, req->nr_sg, piece, bounce);
+	if (nr_piece <= 0) {
+		ret = nr_piece ? nr_piece : -EINVAL;
+		goto fail;
+	}
+	total_bits[0] = req->msg_len << 3;
+	total_bits[1] = 0;
+
+	for (i = 0, tq = task; i < nr_piece; tq++) {
+		bytes = 0;
+		for (s = 0; s < SS_SG_SOURCES && i < nr_piece; s++, i++) {
+			tq->source[s].addr =
+				GET_LO32(piece[i].addr) >> align_shift;
+			tq->source[s].length = ALIGN(piece[i].len, 4) >> 2;
+			bytes += piece[i].len;
+			ss_sg_flush(piece[i].addr, ALIGN(piece[i].len, 4));
+		}
+		last = i == nr_piece;
+		pad = last && req->last;
+
+		tq->task_id = 0;
+		tq->common_ctl = (ALG_SHA256) | (pad << 15) |
+				 ((tq != task || req->iv) << 16) |
+				 ((u32)last << 31);
+		tq->key_descriptor = GET_LO32(total_bits) >> align_shift;
+		tq->data_len = bytes << 3;
+		if (tq != task)
+			tq->iv_descriptor =
+				GET_LO32(state + (tq - task - 1) *
+					 CACHE_LINE_SIZE) >> align_shift;
+		else if (req->iv)
+			tq->iv_descriptor = GET_LO32(iv) >> align_shift;
+		tq->destination[0].addr =
+			GET_LO32(state + (tq - task) * CACHE_LINE_SIZE) >>
+			align_shift;
+		tq->destination[0].length = 32 >> 2;
+		if (!last)
+			tq->next_descriptor = GET_LO32(tq + 1) >> align_shift;
+	}
+	free(piece);
+	ss_sg.state = state;
+	ss_sg.nr_task = tq - task;
+	flush_cache((ulong)ss_sg.buf, size);
+
+	ss_set_drq(GET_LO32(task) >> align_shift);
+	ss_irq_enable(0);
+	ss_ctrl_start(ALG_SHA256);
+	ss_sg.req = req;
+
+	return 0;
+
+fail:
+	free(piece);
+	free(ss_sg.buf);
+	ss_sg.buf = NULL;
+	return ret;
+}
+
+int hash_sg_hw_poll(struct hash_sg_req *req)
+{
+	u8 *digest;
+	u32 err;
+
+	if (ss_sg.req != req)
+		return -EINVAL;
+	if (!ss_check_finish(0))
+		return -EBUSY;
+
+	ss_pending_clear(0);
+	ss_ctrl_stop();
+	ss_irq_disable(0);
+	err = ss_check_err();
+
+	digest = ss_sg.state + (ss_sg.nr_task - 1) * CACHE_LINE_SIZE;
+	invalidate_dcache_range((ulong)digest, (ulong)digest + CACHE_LINE_SIZE);
+	/* a failed job leaves the state to go on from for software */
+	if (!err)
+		memcpy(req->digest, digest, 32);
+	free(ss_sg.buf);
+	memset(&ss_sg, 0, sizeof(ss_sg));
+
+	if (err) {
+		printf("SS %s fail 0x%x\n", __func__, err);
+		return -EIO;
+	}
+
+	return 0;
+}
+#else
+void ss_sg_wait_idle(void)
+{
+}
+#endif
+
 int sunxi_hash_test(u8 *dst_addr, u32 dst_len, u8 *src_addr, u32 src_len, u32 sha_type)
 {
 	u32 word_len = 0, src_align_len = 0;
@@ -1310,7 +1477,8 @@ int sunxi_create_rssk(u8 *rssk_buf, u32 rssk_byte)
 
 	return 0;
 }
-#if defined(SHA256_MULTISTEP_PACKAGE) || defined(SHA512_MULTISTEP_PACKAGE)
+#if defined(SHA256_MULTISTEP_PACKAGE) || defined(SHA512_MULTISTEP_PACKAGE) || \
+	defined(CONFIG_SUNXI_CE_SHA256_MULTISTEP)
 /**************************************************************************
 *function():
 *	sunxi_hash_init(): used for the first package data;
@@ -1379,7 +1547,7 @@ int sunxi_sha_process(u8 *dst_addr, u32 dst_len, u8 *src_addr, u32 src_len,
 	flush_cache((ulong)src_addr, src_align_len);
 	flush_cache((ulong)total_package_len, CACHE_LINE_SIZE);
 
-	ss_set_drq(GET_LO32(&task0);
+	ss_set_drq(GET_LO32(&task0));
 	ss_irq_enable(task0.task_id);
 	ss_ctrl_start(alg_hash);
 	ss_wait_finish(task0.task_id);
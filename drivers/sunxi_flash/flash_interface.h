@@ -10,6 +10,7 @@
 #ifndef _SUNXI_FLASH_INTERFACE_
 #define _SUNXI_FLASH_INTERFACE_
 
+struct sunxi_flash_req;
 
 typedef struct _sunxi_flash_desc {
 
@@ -20,6 +21,9 @@ typedef struct _sunxi_flash_desc {
 	int (*exit)(int force);
 	int	(*read)(uint start_block, uint nblock, void *buffer);
 	int	(*write)(uint start_block, uint nblock, void *buffer);
+	/* optional, start a read/write and check on it later */
+	int	(*submit)(struct sunxi_flash_req *req);
+	int	(*poll)(struct sunxi_flash_req *req);
 	int (*erase)(int erase, void *mbr_buffer);
 	int (*force_erase)(void);
 	int (*flush)(void);
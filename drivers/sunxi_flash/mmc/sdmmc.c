@@ -35,6 +35,7 @@ static int mmc_secure_storage_read_map(int item, unsigned char *buf,
 				       unsigned int len);
 
 static struct mmc *mmc_boot, *mmc_sprite;
+static struct mmc_req mmc_boot_req, mmc_sprite_req;
 static int mmc_no;
 static unsigned char _inner_buffer[4096 + 64]; /*align temp buffer*/
 
@@ -79,6 +80,42 @@ static int sunxi_flash_mmc_write(unsigned int start_block, unsigned int nblock,
 	    nblock, buffer);
 }
 
+static int sunxi_mmc_req_submit(struct mmc *mmc, struct mmc_req *mreq,
+				struct sunxi_flash_req *req)
+{
+	uint start = req->start_block;
+
+	if (!req->phys)
+		start += CONFIG_MMC_LOGICAL_OFFSET;
+	req->priv = mreq;
+
+	return mmc_req_submit(mmc, mreq, start, req->nblock, req->buffer,
+			      req->write);
+}
+
+static int sunxi_mmc_req_poll(struct sunxi_flash_req *req)
+{
+	struct mmc_req *mreq = req->priv;
+	int ret;
+
+	ret = mmc_req_poll(mreq);
+	if (ret == -EBUSY)
+		return ret;
+
+	req->done = 1;
+	req->ret  = ret ? 0 : mreq->ret;
+
+	return 0;
+}
+
+static int sunxi_flash_mmc_submit(struct sunxi_flash_req *req)
+{
+	debug("mmcboot submit: start 0x%x, sector 0x%x\n", req->start_block,
+	      req->nblock);
+
+	return sunxi_mmc_req_submit(mmc_boot, &mmc_boot_req, req);
+}
+
 int card_verify_boot0(uint start_block, uint length);
 static int sunxi_flash_mmc_download_spl(unsigned char *buf, int len,
 					unsigned int ext)
@@ -227,6 +264,14 @@ static int sunxi_sprite_mmc_write(unsigned int start_block, unsigned int nblock,
 	    nblock, buffer);
 }
 
+static int sunxi_sprite_mmc_submit(struct sunxi_flash_req *req)
+{
+	debug("mmcsprite submit: start 0x%x, sector 0x%x\n", req->start_block,
+	      req->nblock);
+
+	return sunxi_mmc_req_submit(mmc_sprite, &mmc_sprite_req, req);
+}
+
 static int sunxi_sprite_mmc_erase(int erase, void *mbr_buffer)
 {
 	return card_erase(erase, mbr_buffer);
@@ -735,6 +780,8 @@ sunxi_flash_desc sunxi_sdmmc_desc = {
     .exit = sunxi_flash_mmc_exit,
     .read = sunxi_flash_mmc_read,
     .write = sunxi_flash_mmc_write,
+    .submit = sunxi_flash_mmc_submit,
+    .poll = sunxi_mmc_req_poll,
     .erase = sunxi_sprite_mmc_erase,
     .flush = sunxi_flash_mmc_flush,
     .size = sunxi_flash_mmc_size,
@@ -756,6 +803,8 @@ sunxi_flash_desc sunxi_sdmmcs_desc = {
     .exit = sunxi_sprite_mmc_exit,
     .read = sunxi_sprite_mmc_read,
     .write = sunxi_sprite_mmc_write,
+    .submit = sunxi_sprite_mmc_submit,
+    .poll = sunxi_mmc_req_poll,
     .erase = sunxi_sprite_mmc_erase,
     .force_erase = sunxi_sprite_mmc_force_erase,
     .flush = sunxi_sprite_mmc_flush,
@@ -28,6 +28,8 @@
 #include "../../spi/spi-sunxi.h"
 
 static struct spi_flash *flash;
+/* what the updates did since the last flush */
+static struct spi_flash_update_stats update_total;
 
 #define SPINOR_DEBUG 0
 
@@ -61,64 +63,6 @@ void dump_spinor_info(boot_spinor_info_t *spinor_info)
 }
 
 
-/**
- * Write a block of data to SPI flash, first checking if it is different from
- * what is already there.
- *
- * If the data being written is the same, then *skipped is incremented by len.
- *
- * @param flash		flash context pointer
- * @param offset	flash offset to write
- * @param len		number of bytes to write
- * @param buf		buffer to write from
- * @param cmp_buf	read buffer to use to compare data
- * @param skipped	Count of skipped data (incremented by this function)
- * @return NULL if OK, else a string containing the stage which failed
- */
-static const char *_spi_flash_update_block(struct spi_flash *flash, u32 offset,
-		size_t len, const char *buf, char *cmp_buf, size_t *skipped)
-{
-	char *ptr = (char *)buf;
-	uint i = 0;
-
-	spinor_debug("offset=%x sector, nor_sector_size=%d bytes, len=%d bytes\n",
-	      offset/flash->sector_size, flash->sector_size, len);
-	/* Read the entire sector so to allow for rewriting */
-	if (spi_flash_read(flash, offset, flash->sector_size, cmp_buf))
-		return "read";
-
-	while (*(cmp_buf + i) == 0xff) {
-		i++;
-		if (i == flash->sector_size)
-			goto already_erase;
-	}
-
-	/* Compare only what is meaningful (len) */
-	if (memcmp(cmp_buf, buf, len) == 0) {
-		spinor_debug("Skip region %x size %zx: no change\n",
-		      offset, len);
-		*skipped += len;
-		return NULL;
-	}
-
-	/* Erase the entire sector */
-	if (spi_flash_erase(flash, offset, flash->sector_size))
-		return "erase";
-
-already_erase:
-	/* If it's a partial sector, copy the data into the temp-buffer */
-	if (len != flash->sector_size) {
-		memcpy(cmp_buf, buf, len);
-		ptr = cmp_buf;
-	}
-	/* Write one complete sector */
-	if (spi_flash_write(flash, offset, flash->sector_size, ptr))
-		return "write";
-
-	return NULL;
-}
-
-
 /**
  * Update an area of SPI flash by erasing and writing any blocks which need
  * to change. Existing blocks with the correct data are left unchanged.
@@ -132,28 +76,20 @@ already_erase:
 static int _spi_flash_update(struct spi_flash *flash, u32 offset,
 		size_t len, const char *buf)
 {
-	const char *err_oper = NULL;
-	char *cmp_buf;
-	const char *end = buf + len;
-	size_t todo;		/* number of bytes to do in this pass */
-	size_t skipped = 0;	/* statistics */
-
-	cmp_buf = memalign(ARCH_DMA_MINALIGN, flash->sector_size);
-	if (cmp_buf) {
-		for (; buf < end && !err_oper; buf += todo, offset += todo) {
-			todo = min_t(size_t, end - buf, flash->sector_size);
-			err_oper = _spi_flash_update_block(flash, offset, todo,
-					buf, cmp_buf, &skipped);
-		}
-	} else {
-		err_oper = "malloc";
-	}
-	free(cmp_buf);
+	struct spi_flash_update_stats stats;
+	int ret;
 
-	if (err_oper) {
-		printf("SPI flash failed in %s step\n", err_oper);
+	ret = spi_flash_update_range(flash, offset, len, buf, &stats);
+	if (ret) {
+		printf("SPI flash update at 0x%x failed: %d\n", offset, ret);
 		return 1;
 	}
+
+	spinor_debug("0x%x: %zu bytes skipped, %zu erased, %zu programmed\n",
+		     offset, stats.skipped, stats.erased, stats.programmed);
+	update_total.skipped += stats.skipped;
+	update_total.erased += stats.erased;
+	update_total.programmed += stats.programmed;
 	return 0;
 }
 
@@ -437,6 +373,13 @@ sunxi_flash_spinor_exit(int force)
 static int
 sunxi_flash_spinor_flush(void)
 {
+	if (update_total.skipped || update_total.erased ||
+	    update_total.programmed) {
+		printf("spinor: %zu bytes skipped, %zu erased, %zu programmed\n",
+		       update_total.skipped, update_total.erased,
+		       update_total.programmed);
+		memset(&update_total, 0, sizeof(update_total));
+	}
 	return 0;
 }
 
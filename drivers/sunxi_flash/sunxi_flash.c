@@ -38,6 +38,62 @@ int sunxi_flash_write(uint start_block, uint nblock, void *buffer)
 	return current_flash->write(start_block, nblock, buffer);
 }
 
+/* drivers without requests do the whole transfer at submit */
+static int sunxi_flash_req_submit(sunxi_flash_desc *flash,
+				  struct sunxi_flash_req *req, uint start_block,
+				  uint nblock, void *buffer, int write, int phys)
+{
+	req->start_block = start_block;
+	req->nblock	 = nblock;
+	req->buffer	 = buffer;
+	req->write	 = write;
+	req->phys	 = phys;
+	req->done	 = 0;
+	req->ret	 = 0;
+	req->desc	 = flash;
+	req->priv	 = NULL;
+
+	if (flash->submit)
+		return flash->submit(req);
+
+	if (phys && write)
+		req->ret = flash->phywrite(start_block, nblock, buffer);
+	else if (phys)
+		req->ret = flash->phyread(start_block, nblock, buffer);
+	else if (write)
+		req->ret = flash->write(start_block, nblock, buffer);
+	else
+		req->ret = flash->read(start_block, nblock, buffer);
+	req->done = 1;
+
+	return 0;
+}
+
+int sunxi_flash_submit(struct sunxi_flash_req *req, uint start_block,
+		       uint nblock, void *buffer, int write)
+{
+	return sunxi_flash_req_submit(current_flash, req, start_block, nblock,
+				      buffer, write, 0);
+}
+
+int sunxi_flash_poll(struct sunxi_flash_req *req)
+{
+	sunxi_flash_desc *flash = req->desc;
+
+	if (req->done)
+		return 0;
+
+	return flash->poll(req);
+}
+
+int sunxi_flash_complete(struct sunxi_flash_req *req)
+{
+	while (sunxi_flash_poll(req) == -EBUSY)
+		;
+
+	return req->ret;
+}
+
 int sunxi_flash_flush(void)
 {
 	return current_flash->flush();
@@ -154,6 +210,13 @@ int sunxi_sprite_write(uint start_block, uint nblock, void *buffer)
 	return sprite_flash->write(start_block, nblock, buffer);
 }
 
+int sunxi_sprite_submit(struct sunxi_flash_req *req, uint start_block,
+			uint nblock, void *buffer, int write)
+{
+	return sunxi_flash_req_submit(sprite_flash, req, start_block, nblock,
+				      buffer, write, 0);
+}
+
 int sunxi_sprite_flush(void)
 {
 	return sprite_flash->flush();
@@ -709,6 +772,19 @@ static unsigned long sunxi_block_read(struct blk_desc *block_dev,
 		return sunxi_flash_read((uint)start, (uint)blkcnt, (void *)buffer);
 }
 
+/* same addressing as sunxi_block_read() */
+int sunxi_flash_blk_submit(struct sunxi_flash_req *req, uint start_block,
+			   uint nblock, void *buffer)
+{
+	int storage_type = get_boot_storage_type();
+	int phys = get_boot_work_mode() == WORK_MODE_CARD_PRODUCT ||
+		   storage_type == STORAGE_SD || storage_type == STORAGE_EMMC ||
+		   storage_type == STORAGE_EMMC0;
+
+	return sunxi_flash_req_submit(current_flash, req, start_block, nblock,
+				      buffer, 0, phys);
+}
+
 static unsigned long sunxi_block_write(struct blk_desc *block_dev,
 				       lbaint_t start, lbaint_t blkcnt,
 				       const void *buffer)
@@ -231,3 +231,47 @@ int buf_dequeue(buf_element_t* pelement)
     //printf("efex dequeue ok: addr0x%x, sector 0x%x \n",pelement->addr,pelement->sector_num);
     return 0;
 }
+
+//get the pages at the head of the queue that follow each other both on flash
+//and in the queue buffer, they can go to flash with one write and no copy.
+//return the number of pages in the run, 0 if the queue is empty
+int buf_queue_peek_run(buf_element_t* run, uint max_sectors)
+{
+    buf_node_t *node = buf_queue_head;
+    buf_element_t *next = NULL;
+    int count = 0;
+
+    if(buf_queue_empty()) return 0;
+
+    *run = node->element;
+    count = 1;
+    while(count < buf_queue_current_len)
+    {
+        next = &node->next->element;
+        if(next->addr != run->addr + run->sector_num
+           || next->buff != run->buff + run->sector_num*512
+           || run->sector_num + next->sector_num > max_sectors)
+        {
+            break;
+        }
+        run->sector_num += next->sector_num;
+        node = node->next;
+        count++;
+    }
+
+    return count;
+}
+
+//release pages taken from the head after buf_queue_peek_run()
+int buf_queue_drop(int count)
+{
+    if(count > buf_queue_current_len) return -1;
+
+    while(count--)
+    {
+        buf_queue_head = buf_queue_head->next;
+        buf_queue_current_len--;
+    }
+
+    return 0;
+}
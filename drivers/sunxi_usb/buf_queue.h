@@ -27,5 +27,7 @@ int buf_queue_empty(void);
 int buf_queue_full(void);
 int buf_queue_free_size(void);
 int buf_queue_get_page_size(void);
+int buf_queue_peek_run(buf_element_t* run, uint max_sectors);
+int buf_queue_drop(int count);
 
 #endif
@@ -28,82 +28,64 @@
 #include <sunxi_flash.h>
 #include <memalign.h>
 
-buf_element_t      buf_queue_element;
+//largest flash write made from the queue, bounds the time the state loop
+//spends in one drain while the host waits for the next transfer
+#define EFEX_QUEUE_RUN_SECTORS   ((1024*1024)>>9)
 
 int efex_queue_init(void)
 {
-    int page_size = 0;
     if(buf_queue_init())
     {
         return -1;
     }
-    
-   
+
     //buf_queue_get_page_size() function should be call   after buf_queue_init function
-    page_size = buf_queue_get_page_size();
-    if( page_size == 0)
+    if(buf_queue_get_page_size() == 0)
     {
         printf("efex queue init fail:make sure buf_queue_init function has be called\n");
         return -1;
     }
 
-    //alloc mem for gloab element,    this memory for efex page write
-    memset(&buf_queue_element, 0 , sizeof(buf_element_t));
-    buf_queue_element.buff = malloc_cache_aligned(page_size);
-    if(buf_queue_element.buff == NULL) 
-    {
-        printf("efex_queue_init error: malloc memory size=0x%x fail\n",page_size);
-        return -1;
-    }
-
     return 0;
 
 }
 
 int efex_queue_exit(void)
 {
-    
-    //free global element buff
-    if(buf_queue_element.buff) 
-    {
-        free(buf_queue_element.buff);
-    }
     return buf_queue_exit();
 }
 
-int efex_queue_write_one_page( void )
+//write the pages at the head of the queue which are contiguous on flash with
+//one flash write straight from the queue buffer
+int efex_queue_drain(void)
 {
-    if(buf_queue_empty())
+    buf_element_t run;
+    int pages;
+
+    pages = buf_queue_peek_run(&run, EFEX_QUEUE_RUN_SECTORS);
+    if(!pages)
     {
-        //printf("efex enqueue empty\n");
         return 0;
     }
-    buf_dequeue(&buf_queue_element);
-    
-    if(!sunxi_flash_write(buf_queue_element.addr, buf_queue_element.sector_num,
-        (void *)buf_queue_element.buff))
+
+    if(!sunxi_flash_write(run.addr, run.sector_num, (void *)run.buff))
     {
-       printf("efex_queue_write_one_page error: write flash from 0x%x, sectors 0x%x failed\n", 
-        buf_queue_element.addr,buf_queue_element.sector_num);
-       return -1;
+        printf("efex_queue_drain error: write flash from 0x%x, sectors 0x%x failed\n",
+            run.addr, run.sector_num);
+        buf_queue_drop(pages);
+        return -1;
     }
+    buf_queue_drop(pages);
+
     return 0;
 }
 
 int efex_queue_write_all_page( void )
 {
-    if(buf_queue_empty())
+    while(!buf_queue_empty())
     {
-        //printf("efex queue empty\n");
-        return 0;
-    }
-    while(buf_dequeue(&buf_queue_element) == 0)
-    {
-        if(!sunxi_flash_write(buf_queue_element.addr, buf_queue_element.sector_num,
-            (void *)buf_queue_element.buff))
+        if(efex_queue_drain())
         {
-            printf("efex_queue_write_one_page error: write flash from 0x%x, sectors 0x%x failed\n", 
-                buf_queue_element.addr,buf_queue_element.sector_num);
             return -1;
         }
     }
@@ -125,17 +107,15 @@ int efex_save_buff_to_queue(uint flash_start, uint flash_sectors, void* buff)
     sec_per_page     = buf_queue_get_page_size()>>9;
     require_page = (flash_sectors+sec_per_page-1)/sec_per_page;
     
+    //only a full queue holds the host back, until enough pages are written
     queue_free_page   = buf_queue_free_size();
-    if(require_page > queue_free_page) 
+    while(queue_free_page < require_page && !buf_queue_empty())
     {
-        int i = 0;
-        for(i = 0; i < require_page - queue_free_page; i++)
+        if(efex_queue_drain())
         {
-            if(efex_queue_write_one_page())
-            {
-                return -1;
-            }
+            return -1;
         }
+        queue_free_page = buf_queue_free_size();
     }
 
     if(buf_queue_free_size() < require_page)
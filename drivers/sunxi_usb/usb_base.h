@@ -127,6 +127,12 @@ typedef struct sunxi_ubuf_s
 	uint   rx_ready_for_data;		//表示数据接收已经完成标志
 
 	uint   request_size;			//需要发送的数据长度
+
+	uchar *rx_ring_base;			//fastboot流式下载的环形buffer，为空时线性接收
+	uint   rx_ring_size;
+	volatile uint rx_ring_head;		//已经接收的字节数
+	volatile uint rx_ring_tail;		//已经释放的字节数
+	volatile uint rx_ring_stall;		//环形buffer已满，数据包留在fifo中
 }
 sunxi_ubuf_t;
 
@@ -134,6 +140,7 @@ sunxi_ubuf_t;
 extern  void sunxi_udc_ep_reset(void);
 
 extern  int sunxi_udc_start_recv_by_dma(void* mem_buf, uint length);
+extern  void sunxi_udc_rx_resume(void);
 
 extern  void sunxi_udc_send_setup(uint bLength, void *buffer);
 extern  int  sunxi_udc_send_data(void *buffer, unsigned int buffer_size);
@@ -157,6 +157,9 @@ void sunxi_usb_irq(void *data)
 		usb_dma_set_pktlen(sunxi_udc_source.dma_recv_channal, HIGH_SPEED_EP_MAX_PACKET_SIZE);
 
 		sunxi_ubuf.rx_ready_for_data = 0;
+		sunxi_ubuf.rx_ring_base = NULL;
+		sunxi_ubuf.rx_ring_size = 0;
+		sunxi_ubuf.rx_ring_stall = 0;
 		sunxi_udev_active->state_reset();
 
 		return ;
@@ -1387,12 +1390,27 @@ static int eprx_recv_op(void)
     	if(USBC_Dev_IsReadDataReady(sunxi_udc_source.usbc_hd, USBC_EP_TYPE_RX))
 		{
 			this_len = USBC_ReadLenFromFifo(sunxi_udc_source.usbc_hd, USBC_EP_TYPE_RX);
-			if(get_fastboot_data_flag() == 1)
+			if((get_fastboot_data_flag() == 1) && sunxi_ubuf.rx_ring_base &&
+			   (sunxi_ubuf.rx_ring_head + this_len > sunxi_ubuf.rx_ring_tail + sunxi_ubuf.rx_ring_size))
+			{
+				//环形buffer已满，数据包留在fifo中，主机会一直NAK，直到sunxi_udc_rx_resume
+				sunxi_ubuf.rx_ring_stall = 1;
+				sunxi_usb_dbg("rx ring full, hold the packet\n");
+			}
+			else if(get_fastboot_data_flag() == 1)
 			{
 				fifo = USBC_SelectFIFO(sunxi_udc_source.usbc_hd, SUNXI_USB_BULK_OUT_EP_INDEX);
 
 				sunxi_ubuf.rx_req_length = USBC_ReadPacket(sunxi_udc_source.usbc_hd, fifo, this_len, sunxi_ubuf.rx_req_buffer);
 				sunxi_ubuf.rx_req_buffer += this_len;
+				if(sunxi_ubuf.rx_ring_base)
+				{
+					sunxi_ubuf.rx_ring_head += this_len;
+					if(sunxi_ubuf.rx_req_buffer >= sunxi_ubuf.rx_ring_base + sunxi_ubuf.rx_ring_size)
+					{
+						sunxi_ubuf.rx_req_buffer = sunxi_ubuf.rx_ring_base;
+					}
+				}
 
 				sunxi_usb_dbg("special read ep bytes 0x%x\n", sunxi_ubuf.rx_req_length);
 				__usb_readcomplete(sunxi_udc_source.usbc_hd, USBC_EP_TYPE_RX, 1);		//返回状态
@@ -1428,6 +1446,34 @@ static int eprx_recv_op(void)
 *
 *                                             function
 *
+*    name          :  sunxi_udc_rx_resume
+*
+*    parmeters     :
+*
+*    return        :
+*
+*    note          :  环形buffer有空间后，取出因buffer满而留在fifo中的数据包
+*
+*
+************************************************************************************************************
+*/
+void sunxi_udc_rx_resume(void)
+{
+	if(!sunxi_ubuf.rx_ring_stall)
+	{
+		return ;
+	}
+	sunxi_ubuf.rx_ring_stall = 0;
+
+	disable_interrupts();
+	eprx_recv_op();
+	enable_interrupts();
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
 *    name          :
 *
 *    parmeters     :
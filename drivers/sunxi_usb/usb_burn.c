@@ -520,6 +520,9 @@ int __sunxi_burn_key(u8 *buff, uint buff_len)
 
 		return -1;
 	}
+	/* every key goes to the flash at once with the map, on exit */
+	if (sunxi_secure_storage_begin())
+		return -1;
 #endif
 	for(;key_count>0;key_count--, key_list++)
 	{
@@ -554,14 +557,14 @@ int __sunxi_burn_key(u8 *buff, uint buff_len)
 				#ifdef CONFIG_SUNXI_KEY_LADDER
 				if (sunxi_key_ladder_verify_rotpk_hash(key_list->key_data, key_list->len)) {
 					printf("verity the rootkey failed, stop burn it\n");
-					return -1;
+					goto fail;
 				}
 				#else
 				if(sunxi_verify_rotpk_hash(key_list->key_data, key_list->len))
 				{
 					printf("verity the rootkey failed, stop burn it\n");
 
-					return -1;
+					goto fail;
 				}
 				#endif
 #ifdef CONFIG_SUNXI_CHECK_CUSTOMER_RESERVED_ID
@@ -585,13 +588,13 @@ int __sunxi_burn_key(u8 *buff, uint buff_len)
 				if (ret) {
 					printf("sunxi_efuse_write failed with:%d\n",
 					       ret);
-					return -1;
+					goto fail;
 				}
 			} else
 #endif
 			{
 				if (sunxi_efuse_write(&efuse_key_info)) {
-					return -1;
+					goto fail;
 				}
 			}
 		}
@@ -604,7 +607,7 @@ int __sunxi_burn_key(u8 *buff, uint buff_len)
 				if(ret)
 				{
 					printf("sunxi deal with hdcp key failed\n");
-					return -1;
+					goto fail;
 				}
 			}
 #ifdef CONFIG_SUNXI_KEYBOX
@@ -617,7 +620,7 @@ int __sunxi_burn_key(u8 *buff, uint buff_len)
 				printf("sunxi deal with %s key resutl:%d\n",
 				       key_list->name, ret);
 				if (ret) {
-					return -1;
+					goto fail;
 				}
 			}
 #endif
@@ -632,7 +635,7 @@ int __sunxi_burn_key(u8 *buff, uint buff_len)
 				if(ret)
 				{
 					printf("write key to secure storage failed\n");
-					return -1;
+					goto fail;
 				}
 
 			}
@@ -648,6 +651,12 @@ int __sunxi_burn_key(u8 *buff, uint buff_len)
 	}
 #endif
 	return 0;
+
+fail:
+#ifdef	CONFIG_SUNXI_SECURE_STORAGE
+	sunxi_secure_storage_abort();
+#endif
+	return -1;
 }
 
 /*
@@ -75,6 +75,8 @@ extern int sunxi_flash_get_boot0_size(void);
 extern int sunxi_flash_get_boot1_size(void);
 extern void sunxi_nand_boot1_dump_for_efex(void *mem, int len);
 static  int sunxi_usb_efex_write_enable = 0;
+//flash write from the efex queue failed, reported in every following csw
+static  int efex_write_error_flag = 0;
 static  int sunxi_usb_efex_status = SUNXI_USB_EFEX_IDLE;
 static  int sunxi_usb_efex_app_step = SUNXI_USB_EFEX_APPS_IDLE;
 static  efex_trans_set_t  trans_data;
@@ -484,6 +486,7 @@ static int sunxi_efex_init(void)
 	sunxi_usb_dbg("sunxi_efex_init\n");
 	memset(&trans_data, 0, sizeof(efex_trans_set_t));
 	sunxi_usb_efex_write_enable = 0;
+	efex_write_error_flag = 0;
     sunxi_usb_efex_status = SUNXI_USB_EFEX_IDLE;
     sunxi_usb_efex_app_step = SUNXI_USB_EFEX_APPS_IDLE;
 
@@ -1901,7 +1904,6 @@ static int sunxi_efex_state_loop(void  *buffer)
 	static struct sunxi_efex_cbw_t  *cbw;
 	static struct sunxi_efex_csw_t   csw;
 	sunxi_ubuf_t *sunxi_ubuf = (sunxi_ubuf_t *)buffer;
-    int  efex_write_error_flag = 0;
 
 	sunxi_print_efex_status(sunxi_usb_efex_status);
 	sunxi_print_efex_app_step(sunxi_usb_efex_app_step);
@@ -1912,6 +1914,13 @@ static int sunxi_efex_state_loop(void  *buffer)
 			{
 				sunxi_usb_efex_status = SUNXI_USB_EFEX_SETUP;
 			}
+#ifdef _EFEX_USE_BUF_QUEUE_
+			else if(efex_queue_drain())		//主机还没有发下一个命令，先写一段队列数据
+			{
+				printf("sunxi efex queue: efex_queue_drain() err\n");
+				efex_write_error_flag = 1;
+			}
+#endif
 			//when product finish and usb disconnect ,shutdown machine
 			if( sunxi_efex_next_action == SUNXI_UPDATE_NEXT_ACTION_NORMAL ||
 				sunxi_efex_next_action >  SUNXI_UPDATE_NEXT_ACTION_REUPDATE )
@@ -2252,9 +2261,9 @@ static int sunxi_efex_state_loop(void  *buffer)
                 if(!sunxi_usb_efex_write_enable)
                 {
 #ifdef _EFEX_USE_BUF_QUEUE_
-                    if(efex_queue_write_one_page())
+                    if(efex_queue_drain())
                     {
-                        printf("sunxi efex queue: buf_queue_write_one_page() err\n");
+                        printf("sunxi efex queue: efex_queue_drain() err\n");
                         efex_write_error_flag = 1;
                     }
 #endif
@@ -42,6 +42,30 @@ static uint all_download_bytes;
 
 int fastboot_data_flag;
 
+#ifdef CONFIG_SUNXI_FASTBOOT_STREAM
+/*
+ * streaming download: once "oem stream <part>" armed a partition, the next
+ * download is received into a ring and every completed segment is written
+ * to the partition while the rest of the data is still on the bus
+ */
+#define FASTBOOT_STREAM_HEAD_BUFF (32 * 1024)
+#define FASTBOOT_STREAM_SEGMENT (4 << 20)
+#define FASTBOOT_STREAM_RING_SIZE                                              \
+	(FASTBOOT_TRANSFER_BUFFER_SIZE - FASTBOOT_STREAM_SEGMENT)
+
+static struct {
+	int armed;
+	int active;
+	int done;
+	int error;
+	int format;
+	char name[32];
+	uint start;
+	uint part_sectors;
+	uint consumed;
+} fb_stream;
+#endif
+
 extern int sunxi_usb_exit(void);
 
 int get_fastboot_data_flag(void)
@@ -860,6 +884,168 @@ static void __flash_to_uboot(void)
 }
 #endif
 
+#ifdef CONFIG_SUNXI_FASTBOOT_STREAM
+static int __stream_arm(char *name, char *response)
+{
+	disk_partition_t info = { 0 };
+
+	memset(&fb_stream, 0, sizeof(fb_stream));
+	if (sunxi_partition_get_info((const char *)name, &info) < 0) {
+		sprintf(response, "FAILstream: partition %s does not exist",
+			name);
+		return -1;
+	}
+	strncpy(fb_stream.name, name, sizeof(fb_stream.name) - 1);
+	fb_stream.start	= info.start;
+	fb_stream.part_sectors = info.size;
+	fb_stream.armed	= 1;
+	printf("sunxi fastboot: stream next download to %s, start 0x%x, sectors 0x%x\n",
+	       name, fb_stream.start, fb_stream.part_sectors);
+	strcpy(response, "OKAY");
+
+	return 0;
+}
+
+/* forget the armed partition, the next download goes to the buffer again */
+static void __stream_disarm(void)
+{
+	if (fb_stream.armed)
+		printf("sunxi fastboot: stream to %s disarmed\n",
+		       fb_stream.name);
+	memset(&fb_stream, 0, sizeof(fb_stream));
+}
+
+/* largest download accepted while a partition is armed */
+static uint __stream_max_download(void)
+{
+	u64 bytes = (u64)fb_stream.part_sectors << 9;
+
+	return bytes > 0xfffff000ULL ? 0xfffff000 : (uint)bytes;
+}
+
+static void __stream_begin(sunxi_ubuf_t *sunxi_ubuf)
+{
+	fb_stream.active   = 1;
+	fb_stream.done	   = 0;
+	fb_stream.error	   = 0;
+	fb_stream.consumed = 0;
+	fb_stream.format   = ANDROID_FORMAT_UNKNOW;
+
+	sunxi_ubuf->rx_ring_base = (uchar *)trans_data.base_recv_buffer +
+				   FASTBOOT_STREAM_HEAD_BUFF;
+	sunxi_ubuf->rx_ring_size  = FASTBOOT_STREAM_RING_SIZE;
+	sunxi_ubuf->rx_ring_head  = 0;
+	sunxi_ubuf->rx_ring_tail  = 0;
+	sunxi_ubuf->rx_ring_stall = 0;
+	sunxi_ubuf->rx_req_buffer = sunxi_ubuf->rx_ring_base;
+}
+
+static int __stream_write_segment(uchar *pbuf, uint len)
+{
+	uint sectors;
+
+	if (!fb_stream.consumed) {
+		fb_stream.format = unsparse_probe((char *)pbuf, len,
+						  fb_stream.start);
+		if (fb_stream.format != ANDROID_FORMAT_DETECT &&
+		    ((all_download_bytes + 511) >> 9) > fb_stream.part_sectors) {
+			printf("sunxi fastboot stream FAIL: partition %s is smaller than data size 0x%x\n",
+			       fb_stream.name, all_download_bytes);
+			return -1;
+		}
+	}
+
+	if (fb_stream.format == ANDROID_FORMAT_DETECT)
+		return unsparse_direct_write(pbuf, len);
+
+	sectors = (len + 511) >> 9;
+	if (!sunxi_flash_write(fb_stream.start, sectors, pbuf))
+		return -1;
+	fb_stream.start += sectors;
+
+	return 0;
+}
+
+/*
+ * write every completed segment of the ring, the last one may be short.
+ * FASTBOOT_STREAM_HEAD_BUFF bytes behind the consumer are kept from the
+ * receiver, the sparse writer may still need them for an unfinished chunk
+ */
+static void __stream_drain(sunxi_ubuf_t *sunxi_ubuf)
+{
+	uint avail, len, off, rest;
+	uchar *pbuf;
+
+	avail = sunxi_ubuf->rx_ring_head - fb_stream.consumed;
+	while (avail >= FASTBOOT_STREAM_SEGMENT ||
+	       (avail && sunxi_ubuf->rx_ring_head == all_download_bytes)) {
+		len  = min_t(uint, avail, FASTBOOT_STREAM_SEGMENT);
+		off  = fb_stream.consumed % FASTBOOT_STREAM_RING_SIZE;
+		pbuf = sunxi_ubuf->rx_ring_base + off;
+
+		if (!fb_stream.error) {
+			/* an unfinished sparse chunk ends the ring, move it in front of its start */
+			rest = unsparse_pending_bytes();
+			if (!off && fb_stream.consumed &&
+			    fb_stream.format == ANDROID_FORMAT_DETECT && rest)
+				memcpy(pbuf - rest,
+				       sunxi_ubuf->rx_ring_base +
+					       FASTBOOT_STREAM_RING_SIZE - rest,
+				       rest);
+			if (__stream_write_segment(pbuf, len)) {
+				printf("sunxi fastboot stream FAIL: failed to write partition %s\n",
+				       fb_stream.name);
+				/* keep receiving so the host can finish the transfer */
+				fb_stream.error = 1;
+			}
+		}
+		fb_stream.consumed += len;
+		avail -= len;
+
+		sunxi_ubuf->rx_ring_tail =
+			fb_stream.consumed > FASTBOOT_STREAM_HEAD_BUFF ?
+				fb_stream.consumed - FASTBOOT_STREAM_HEAD_BUFF :
+				0;
+		sunxi_udc_rx_resume();
+	}
+	sunxi_udc_rx_resume();
+}
+
+static void __stream_end(sunxi_ubuf_t *sunxi_ubuf)
+{
+	fb_stream.active	  = 0;
+	fb_stream.done		  = 1;
+	sunxi_ubuf->rx_ring_base  = NULL;
+	sunxi_ubuf->rx_ring_size  = 0;
+	sunxi_ubuf->rx_ring_stall = 0;
+}
+
+static int __stream_flash_to_part(char *name)
+{
+	char response[68];
+
+	fb_stream.armed = 0;
+	if (strcmp(name, fb_stream.name)) {
+		printf("sunxi fastboot download FAIL: data was streamed to %s, not %s\n",
+		       fb_stream.name, name);
+		sprintf(response, "FAILdownload: data streamed to %s",
+			fb_stream.name);
+	} else if (!fb_stream.done || fb_stream.error) {
+		sprintf(response, "FAILdownload: write partition %s err",
+			name);
+	} else {
+		sunxi_flash_write_end();
+		sunxi_flash_flush();
+		printf("sunxi fastboot: successed in streaming partition '%s'\n",
+		       name);
+		sprintf(response, "OKAY");
+	}
+	__sunxi_fastboot_send_status(response, strlen(response));
+
+	return response[0] == 'O' ? 0 : -1;
+}
+#endif
+
 static int __flash_to_part(char *name)
 {
 	char *addr = trans_data.base_recv_buffer;
@@ -1007,7 +1193,15 @@ static int __try_to_download(char *download_size, char *response)
 	if (0 == trans_data.try_to_recv) {
 		/* bad user input */
 		sprintf(response, "FAILdownload: data size is 0");
+#ifdef CONFIG_SUNXI_FASTBOOT_STREAM
+	} else if (fb_stream.armed &&
+		   trans_data.try_to_recv > __stream_max_download()) {
+		sprintf(response, "FAILdownload: data > partition");
+	} else if (!fb_stream.armed &&
+		   trans_data.try_to_recv > SUNXI_USB_FASTBOOT_BUFFER_MAX) {
+#else
 	} else if (trans_data.try_to_recv > SUNXI_USB_FASTBOOT_BUFFER_MAX) {
+#endif
 		sprintf(response, "FAILdownload: data > buffer");
 	} else {
 		/* The default case, the transfer fits
@@ -1017,6 +1211,10 @@ static int __try_to_download(char *download_size, char *response)
 
 		ret = 0;
 	}
+#ifdef CONFIG_SUNXI_FASTBOOT_STREAM
+	if (ret < 0)
+		__stream_disarm();
+#endif
 
 	return ret;
 }
@@ -1134,7 +1332,14 @@ static void __get_var(char *ver_name)
 	} else if (!strcmp(ver_name, "secure")) {
 		strcpy(response + 4, "yes");
 	} else if (!strcmp(ver_name, "max-download-size")) {
-		sprintf(response + 4, "0x%08x", SUNXI_USB_FASTBOOT_BUFFER_MAX);
+#ifdef CONFIG_SUNXI_FASTBOOT_STREAM
+		if (fb_stream.armed)
+			sprintf(response + 4, "0x%08x",
+				__stream_max_download());
+		else
+#endif
+			sprintf(response + 4, "0x%08x",
+				SUNXI_USB_FASTBOOT_BUFFER_MAX);
 		printf("response: %s\n", response);
 	} else {
 		strcpy(response + 4, "not supported");
@@ -1405,6 +1610,15 @@ static void __oem_operation(char *operation)
 			printf("the system is normal\n");
 		}
 	} else {
+#ifdef CONFIG_SUNXI_FASTBOOT_STREAM
+		if (!strncmp(operation, "stream ", 7)) {
+			__stream_arm(operation + 7, response);
+			__sunxi_fastboot_send_status(response,
+						     strlen(response));
+
+			return;
+		}
+#endif
 		if (!strncmp(operation, "efex", 4)) {
 			strcpy(response, "OKAY");
 			__sunxi_fastboot_send_status(response,
@@ -1535,6 +1749,9 @@ static int sunxi_fastboot_init(void)
 
 	all_download_bytes = 0;
 	fastboot_data_flag = 0;
+#ifdef CONFIG_SUNXI_FASTBOOT_STREAM
+	memset(&fb_stream, 0, sizeof(fb_stream));
+#endif
 
 	trans_data.base_recv_buffer = (char *)FASTBOOT_TRANSFER_BUFFER;
 
@@ -1581,6 +1798,9 @@ static int sunxi_fastboot_exit(void)
 	sunxi_flash_write_end();
 	sunxi_flash_flush();
 	printf("sunxi_fastboot_exit\n");
+#ifdef CONFIG_SUNXI_FASTBOOT_STREAM
+	__stream_disarm();
+#endif
 	if (trans_data.base_send_buffer) {
 		free(trans_data.base_send_buffer);
 	}
@@ -1607,6 +1827,9 @@ static void sunxi_fastboot_reset(void)
 {
 	sunxi_usb_fastboot_write_enable = 0;
 	sunxi_usb_fastboot_status       = SUNXI_USB_FASTBOOT_IDLE;
+#ifdef CONFIG_SUNXI_FASTBOOT_STREAM
+	__stream_disarm();
+#endif
 }
 /*
 ************************************************************************************************************
@@ -1944,6 +2167,12 @@ static int sunxi_fastboot_state_loop(void *buffer)
 					    "mbr", 3)) {
 				__flash_to_mbr();
 			} else
+#endif
+#ifdef CONFIG_SUNXI_FASTBOOT_STREAM
+				if (fb_stream.armed) {
+				__stream_flash_to_part(
+					(char *)(sunxi_ubuf->rx_req_buffer + 6));
+			} else
 #endif
 				__flash_to_part((
 					char *)(sunxi_ubuf->rx_req_buffer + 6));
@@ -1954,6 +2183,11 @@ static int sunxi_fastboot_state_loop(void *buffer)
 				__limited_fastboot();
 				break;
 			}
+#ifdef CONFIG_SUNXI_FASTBOOT_STREAM
+			/* the last streamed download was never flashed */
+			if (fb_stream.done)
+				__stream_disarm();
+#endif
 			ret = __try_to_download(
 				(char *)(sunxi_ubuf->rx_req_buffer + 9),
 				response);
@@ -1961,6 +2195,10 @@ static int sunxi_fastboot_state_loop(void *buffer)
 				fastboot_data_flag = 1;
 				sunxi_ubuf->rx_req_buffer =
 					(uchar *)trans_data.base_recv_buffer;
+#ifdef CONFIG_SUNXI_FASTBOOT_STREAM
+				if (fb_stream.armed)
+					__stream_begin(sunxi_ubuf);
+#endif
 				sunxi_usb_fastboot_status =
 					SUNXI_USB_FASTBOOT_RECEIVE_DATA;
 			}
@@ -2006,6 +2244,24 @@ static int sunxi_fastboot_state_loop(void *buffer)
 	case SUNXI_USB_FASTBOOT_RECEIVE_DATA:
 
 		//printf("SUNXI_USB_FASTBOOT_RECEIVE_DATA\n");
+#ifdef CONFIG_SUNXI_FASTBOOT_STREAM
+		if (fb_stream.active) {
+			__stream_drain(sunxi_ubuf);
+			if (fb_stream.consumed == all_download_bytes) {
+				printf("fastboot stream transfer finish\n");
+				__stream_end(sunxi_ubuf);
+				fastboot_data_flag	= 0;
+				sunxi_usb_fastboot_status = SUNXI_USB_FASTBOOT_IDLE;
+
+				sunxi_ubuf->rx_req_buffer = sunxi_ubuf->rx_base_buffer;
+
+				sprintf(response, "OKAY");
+				__sunxi_fastboot_send_status(response,
+							     strlen(response));
+			}
+			break;
+		}
+#endif
 		if ((fastboot_data_flag == 1) &&
 		    ((char *)sunxi_ubuf->rx_req_buffer ==
 		     all_download_bytes +
@@ -282,6 +282,8 @@ int sunxi_bmp_display(char *name)
 	unsigned long file_size = 0;
 	char *bmp_head_addr;
 	struct bmp_image *bmp;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_SUNXI_LOGO, "sunxi_logo");
 	bmp = memalign(CONFIG_SYS_CACHELINE_SIZE,  ALIGN(sizeof(struct bmp_header), CONFIG_SYS_CACHELINE_SIZE));
 	if (bmp) {
 		sprintf(bmp_head, "%lx", (ulong)bmp);
@@ -348,6 +350,7 @@ free2:
 free1:
 	free(bmp);
 out:
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_SUNXI_LOGO);
 	return ret;
 }
 
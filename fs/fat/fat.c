@@ -1132,6 +1132,198 @@ int fat_read_file(const char *filename, void *buf, loff_t offset, loff_t len,
 	return ret;
 }
 
+/*
+ * Append 'nr_sect' sectors at 'sect' to the run list of 'file', merging
+ * them into the last run when they follow it on disk.
+ */
+static int fat_file_add_run(struct fat_file *file, loff_t pos, __u32 sect,
+			    __u32 nr_sect)
+{
+	struct fat_extent *ext;
+
+	if (file->nr_extents) {
+		ext = &file->extents[file->nr_extents - 1];
+		if (ext->sect + ext->nr_sect == sect) {
+			ext->nr_sect += nr_sect;
+			return 0;
+		}
+	}
+
+	if (file->nr_extents == file->max_extents) {
+		ext = realloc(file->extents, (file->max_extents * 2 + 8) *
+			      sizeof(*ext));
+		if (!ext)
+			return -ENOMEM;
+		file->extents = ext;
+		file->max_extents = file->max_extents * 2 + 8;
+	}
+
+	ext = &file->extents[file->nr_extents++];
+	ext->pos = pos;
+	ext->sect = sect;
+	ext->nr_sect = nr_sect;
+
+	return 0;
+}
+
+int fat_file_open(const char *filename, struct fat_file **filep)
+{
+	fsdata *mydata;	/* for silly macros */
+	fsdata fsdata;
+	struct fat_file *file = NULL;
+	unsigned int bytesperclust;
+	fat_itr *itr;
+	__u32 clust;
+	loff_t pos;
+	int ret;
+
+	itr = malloc_cache_aligned(sizeof(fat_itr));
+	if (!itr)
+		return -ENOMEM;
+	mydata = &fsdata;
+	ret = fat_itr_root(itr, mydata);
+	if (ret)
+		goto out_free_itr;
+
+	ret = fat_itr_resolve(itr, filename, TYPE_FILE);
+	if (ret)
+		goto out_free_both;
+
+	file = calloc(1, sizeof(*file));
+	if (!file) {
+		ret = -ENOMEM;
+		goto out_free_both;
+	}
+	file->dev = cur_dev;
+	file->part_start = cur_part_info.start;
+	file->sect_size = mydata->sect_size;
+	file->size = FAT2CPU32(itr->dent->size);
+
+	/* walk the cluster chain once, the reads only look at the runs */
+	bytesperclust = mydata->clust_size * mydata->sect_size;
+	clust = START(itr->dent);
+	for (pos = 0; pos < file->size; pos += bytesperclust) {
+		if (CHECK_CLUST(clust, mydata->fatsize)) {
+			printf("Invalid FAT entry 0x%x in %s\n", clust,
+			       filename);
+			ret = -EIO;
+			goto out_free_both;
+		}
+		ret = fat_file_add_run(file, pos, clust_to_sect(mydata, clust),
+				       mydata->clust_size);
+		if (ret)
+			goto out_free_both;
+		clust = get_fatent(mydata, clust);
+	}
+	debug("%s: %llu bytes in %d runs\n", filename, file->size,
+	      file->nr_extents);
+
+	*filep = file;
+	file = NULL;
+
+out_free_both:
+	fat_file_close(file);
+	free(fsdata.fatbuf);
+out_free_itr:
+	free(itr);
+	return ret;
+}
+
+/* bounce chunk for whole sectors read to a misaligned buffer */
+#define FAT_BOUNCE_SIZE	(64 * 1024)
+
+int fat_file_read(struct fat_file *file, loff_t pos, void *buffer,
+		  loff_t maxsize, loff_t *actread)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(__u8, tmpbuf, file->sect_size);
+	struct fat_extent *ext;
+	__u8 *buf = buffer, *bounce = NULL;
+	__u32 off, skip, sect, nr_sect;
+	loff_t len;
+	int lo, hi, mid, ret = 0;
+
+	*actread = 0;
+	if (pos >= file->size)
+		return 0;
+	len = file->size - pos;
+	if (maxsize > 0 && maxsize < len)
+		len = maxsize;
+
+	/* last run starting at or before pos */
+	lo = 0;
+	hi = file->nr_extents - 1;
+	while (lo < hi) {
+		mid = (lo + hi + 1) / 2;
+		if (file->extents[mid].pos <= pos)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	ext = &file->extents[lo];
+
+	while (len) {
+		/* a run never holds more than the 4 GiB a FAT file may have */
+		off = pos - ext->pos;
+		sect = ext->sect + off / file->sect_size;
+		skip = off % file->sect_size;
+		nr_sect = ext->nr_sect - off / file->sect_size;
+
+		if (skip || len < file->sect_size) {
+			/* partial head or tail sector */
+			if (blk_dread(file->dev, file->part_start + sect, 1,
+				      tmpbuf) != 1)
+				goto read_err;
+			off = min(len, (loff_t)(file->sect_size - skip));
+			memcpy(buf, tmpbuf + skip, off);
+		} else if ((unsigned long)buf & (ARCH_DMA_MINALIGN - 1)) {
+			/* whole sectors to a misaligned buffer, a chunk at a time */
+			if (!bounce) {
+				bounce = malloc_cache_aligned(FAT_BOUNCE_SIZE);
+				if (!bounce)
+					return -ENOMEM;
+			}
+			nr_sect = min3(nr_sect, (__u32)(len / file->sect_size),
+				       (__u32)(FAT_BOUNCE_SIZE / file->sect_size));
+			if (blk_dread(file->dev, file->part_start + sect,
+				      nr_sect, bounce) != nr_sect)
+				goto read_err;
+			off = nr_sect * file->sect_size;
+			memcpy(buf, bounce, off);
+		} else {
+			nr_sect = min(nr_sect, (__u32)(len / file->sect_size));
+			if (blk_dread(file->dev, file->part_start + sect,
+				      nr_sect, buf) != nr_sect)
+				goto read_err;
+			off = nr_sect * file->sect_size;
+		}
+
+		buf += off;
+		pos += off;
+		len -= off;
+		*actread += off;
+		if (ext + 1 < file->extents + file->nr_extents &&
+		    pos >= ext[1].pos)
+			ext++;
+	}
+
+out:
+	free(bounce);
+	return ret;
+
+read_err:
+	printf("Error reading sector 0x%x\n", sect);
+	ret = -EIO;
+	goto out;
+}
+
+void fat_file_close(struct fat_file *file)
+{
+	if (!file)
+		return;
+	free(file->extents);
+	free(file);
+}
+
 typedef struct {
 	struct fs_dir_stream parent;
 	struct fs_dirent dirent;
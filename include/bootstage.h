@@ -199,6 +199,19 @@ enum bootstage_id {
 	BOOTSTATE_ID_ACCUM_DM_SPL,
 	BOOTSTATE_ID_ACCUM_DM_F,
 	BOOTSTATE_ID_ACCUM_DM_R,
+	BOOTSTAGE_ID_ACCUM_MMC_TUNING,
+	BOOTSTAGE_ID_ACCUM_MMC_TUNING_CHECK,
+	BOOTSTAGE_ID_ACCUM_SUNXI_FLASH,
+	BOOTSTAGE_ID_ACCUM_SUNXI_EARLY_LOGO,
+	BOOTSTAGE_ID_ACCUM_SUNXI_GPT,
+	BOOTSTAGE_ID_ACCUM_SUNXI_PART_MAP,
+	BOOTSTAGE_ID_ACCUM_SUNXI_ROTPK,
+	BOOTSTAGE_ID_ACCUM_SUNXI_PARTINFO,
+	BOOTSTAGE_ID_ACCUM_SUNXI_FDT,
+	BOOTSTAGE_ID_ACCUM_SUNXI_LOGO,
+	BOOTSTAGE_ID_ACCUM_SUNXI_IMAGE_LOAD,
+	BOOTSTAGE_ID_ACCUM_SUNXI_VERIFY,
+	BOOTSTAGE_ID_ACCUM_SUNXI_PART_VERIFY,
 
 	/* a few spare for the user, from here */
 	BOOTSTAGE_ID_USER,
@@ -0,0 +1,101 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Faster variants of the LZ4 and inflate decoders, used for kernel and
+ * ramdisk images: copies in 16 byte chunks and, in inflate, a 64-bit bit
+ * buffer filled once per length/distance pair. The copies are in NEON on
+ * ARMv7/ARMv8 AArch32 (DECOMP_NEON), portable C elsewhere.
+ *
+ * The original decoders stay in and are used when this is off, either
+ * at build time or through decomp_fast_set_enabled() for benchmarks.
+ */
+
+#ifndef __DECOMP_FAST_H__
+#define __DECOMP_FAST_H__
+
+#include <linux/string.h>
+#include <linux/types.h>
+
+#if CONFIG_IS_ENABLED(DECOMP_FAST)
+/**
+ * decomp_fast_enabled() - Check whether the decoders take the fast path
+ *
+ * The CPU is probed on the first call.
+ *
+ * @return true if built in, usable on this CPU and not switched off
+ */
+bool decomp_fast_enabled(void);
+
+/**
+ * decomp_fast_set_enabled() - Switch the fast path on or off
+ *
+ * @enable:	false to run the original decoders, it is on by default
+ */
+void decomp_fast_set_enabled(bool enable);
+
+/* Architecture part, returns false if the copies below can't run */
+bool decomp_fast_probe(void);
+#else
+static inline bool decomp_fast_enabled(void)
+{
+	return false;
+}
+
+static inline void decomp_fast_set_enabled(bool enable)
+{
+}
+#endif
+
+#if CONFIG_IS_ENABLED(DECOMP_NEON)
+u8 *decomp_copy(u8 *dst, const u8 *src, size_t len);
+void decomp_wild_copy(u8 *dst, const u8 *src, u8 *end);
+#else
+/**
+ * decomp_copy() - Copy a match the way a byte by byte loop would
+ *
+ * A match may start less than its length back, then it repeats the bytes
+ * between its start and @dst. Those are copied in growing pieces.
+ *
+ * @dst:	Output
+ * @src:	Before @dst, or in another buffer
+ * @len:	Bytes to copy, nothing is written beyond them
+ * @return @dst + @len
+ */
+static inline u8 *decomp_copy(u8 *dst, const u8 *src, size_t len)
+{
+	size_t dist = dst - src;
+
+	while (dist && dist < len) {
+		memcpy(dst, src, dist);
+		dst += dist;
+		len -= dist;
+		dist <<= 1;
+	}
+	memcpy(dst, src, len);
+
+	return dst + len;
+}
+
+/**
+ * decomp_wild_copy() - Copy up to @end in chunks, like LZ4_wildCopy()
+ *
+ * Up to 7 bytes beyond @end are written.
+ *
+ * @dst:	Output
+ * @src:	At least 8 bytes before @dst, or in another buffer
+ * @end:	Where the copy ends
+ */
+static inline void decomp_wild_copy(u8 *dst, const u8 *src, u8 *end)
+{
+	if ((size_t)(dst - src) >= 16) {
+		for (; end - dst > 8; dst += 16, src += 16)
+			memcpy(dst, src, 16);
+	}
+	for (; dst < end; dst += 8, src += 8)
+		memcpy(dst, src, 8);
+}
+#endif
+
+#endif /* __DECOMP_FAST_H__ */
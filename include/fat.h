@@ -198,6 +198,58 @@ int file_fat_write(const char *filename, void *buf, loff_t offset, loff_t len,
 		   loff_t *actwrite);
 int fat_read_file(const char *filename, void *buf, loff_t offset, loff_t len,
 		  loff_t *actread);
+
+/* Run of sectors holding consecutive bytes of an open file */
+struct fat_extent {
+	loff_t	pos;		/* File offset of the first byte */
+	__u32	sect;		/* First sector, relative to the partition */
+	__u32	nr_sect;	/* Sectors in the run */
+};
+
+/*
+ * Open file handle: the cluster chain is resolved once by fat_file_open()
+ * into a list of contiguous runs, reads at any offset then go straight
+ * to the device of the partition the file was opened on.
+ */
+struct fat_file {
+	struct blk_desc	*dev;
+	lbaint_t	part_start;
+	__u16		sect_size;
+	loff_t		size;
+	int		nr_extents;
+	int		max_extents;
+	struct fat_extent *extents;
+};
+
+/**
+ * fat_file_open() - Open a file on the current FAT partition
+ *
+ * @filename:	Path of the file
+ * @filep:	Returns the handle, to be released with fat_file_close()
+ * @return 0 if OK, -ve on error
+ */
+int fat_file_open(const char *filename, struct fat_file **filep);
+
+/**
+ * fat_file_read() - Read from a file opened by fat_file_open()
+ *
+ * @file:	File handle
+ * @pos:	Offset in the file
+ * @buffer:	Destination, cache aligned for reads without a bounce buffer
+ * @maxsize:	Bytes to read, 0 to read up to the end of the file
+ * @actread:	Returns the number of bytes read
+ * @return 0 if OK, -ve on error
+ */
+int fat_file_read(struct fat_file *file, loff_t pos, void *buffer,
+		  loff_t maxsize, loff_t *actread);
+
+/**
+ * fat_file_close() - Release a file handle
+ *
+ * @file:	File handle, may be NULL
+ */
+void fat_file_close(struct fat_file *file);
+
 int fat_opendir(const char *filename, struct fs_dir_stream **dirsp);
 int fat_readdir(struct fs_dir_stream *dirs, struct fs_dirent **dentp);
 void fat_closedir(struct fs_dir_stream *dirs);
@@ -0,0 +1,87 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Lookup index over one flattened device tree: hashed phandle and path
+ * tables and the node offsets in tree order. libfdt answers each of
+ * these lookups with a walk of the whole tree; the index is built by one
+ * walk and reused until the tree changes.
+ *
+ * The index follows the last tree it was asked about. It is dropped when
+ * the struct or strings block of that tree changes size, which every node
+ * or property insertion, removal or resize does, and by
+ * fdt_index_invalidate() for writes done in place. A write in place
+ * nobody reported is caught when a node found no longer has the name or
+ * phandle it was indexed with; libfdt answers then and the index is
+ * built again.
+ */
+
+#ifndef __FDT_INDEX_H__
+#define __FDT_INDEX_H__
+
+#include <linux/libfdt.h>
+
+#if CONFIG_IS_ENABLED(FDT_INDEX)
+/**
+ * fdt_index_path_offset() - fdt_path_offset() through the index
+ *
+ * @fdt:	Device tree blob
+ * @path:	Full path of a node, or an alias followed by a path
+ * @return offset of the node, or a libfdt error as fdt_path_offset()
+ */
+int fdt_index_path_offset(const void *fdt, const char *path);
+
+/**
+ * fdt_index_node_offset_by_phandle() - fdt_node_offset_by_phandle()
+ *	through the index
+ *
+ * @fdt:	Device tree blob
+ * @phandle:	phandle of the node
+ * @return offset of the node, or a libfdt error as
+ *	fdt_node_offset_by_phandle()
+ */
+int fdt_index_node_offset_by_phandle(const void *fdt, uint32_t phandle);
+
+/**
+ * fdt_index_get_path() - fdt_get_path() through the index
+ *
+ * @fdt:	Device tree blob
+ * @nodeoffset:	Offset of the node
+ * @buf:	Buffer taking the full path of the node
+ * @buflen:	Size of @buf
+ * @return 0 if OK, or a libfdt error as fdt_get_path()
+ */
+int fdt_index_get_path(const void *fdt, int nodeoffset, char *buf, int buflen);
+
+/**
+ * fdt_index_invalidate() - Drop the index after a write to the tree
+ *
+ * Needed for writes that keep the size of the struct block, such as
+ * fdt_setprop_inplace() or a node renamed to a name of the same length.
+ */
+void fdt_index_invalidate(void);
+#else
+static inline int fdt_index_path_offset(const void *fdt, const char *path)
+{
+	return fdt_path_offset(fdt, path);
+}
+
+static inline int fdt_index_node_offset_by_phandle(const void *fdt,
+						   uint32_t phandle)
+{
+	return fdt_node_offset_by_phandle(fdt, phandle);
+}
+
+static inline int fdt_index_get_path(const void *fdt, int nodeoffset,
+				     char *buf, int buflen)
+{
+	return fdt_get_path(fdt, nodeoffset, buf, buflen);
+}
+
+static inline void fdt_index_invalidate(void)
+{
+}
+#endif
+
+#endif /* __FDT_INDEX_H__ */
@@ -0,0 +1,156 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Scatter-gather SHA256: one digest over a list of buffers that are not
+ * next to each other in memory, such as salt + image or boot image header
+ * + kernel + ramdisk, without copying them together first.
+ *
+ * A backend (the sunxi CE) takes the whole list as one job and the caller
+ * may work while it runs. Without one, or for a list it can't take, the
+ * digest is made in software when the request is submitted.
+ *
+ * A message too large to be in memory at once, such as a partition read
+ * window by window, is hashed by several requests on one hash_sg_ctx.
+ */
+
+#ifndef __HASH_SG_H__
+#define __HASH_SG_H__
+
+#include <linux/types.h>
+
+/* hash block size, every piece but the last one a backend sees is a multiple */
+#define HASH_SG_BLOCK		64
+
+struct hash_sg {
+	const void *addr;
+	u32 len;
+};
+
+enum hash_sg_state {
+	HASH_SG_IDLE,
+	HASH_SG_BUSY,
+	HASH_SG_DONE,
+};
+
+/*
+ * Hash going on over several requests. The state is kept as the digest
+ * bytes of the hash so far, which is how the CE takes and leaves it.
+ */
+struct hash_sg_ctx {
+	u8 state[32];
+	u64 done;	/* bytes hashed into @state */
+	u64 total;	/* bytes in the whole message */
+	u8 *digest;	/* returns the digest once @total bytes are in */
+};
+
+struct hash_sg_req {
+	enum hash_sg_state state;
+	int ret;
+	const struct hash_sg *sg;	/* must stay until the request is done */
+	int nr_sg;
+	u8 *digest;			/* the digest, or the state to go on */
+	void *priv;			/* backend data of a running request */
+	/* set at submit for the backend */
+	struct hash_sg_ctx *ctx;	/* NULL for a one-job hash */
+	const u8 *iv;			/* state to go on from, NULL to start */
+	u64 msg_len;			/* bytes in the whole message */
+	u32 len;			/* bytes in this job */
+	int last;			/* this job pads and finishes the hash */
+};
+
+/**
+ * hash_sg_submit() - Start hashing a list of buffers
+ *
+ * @req:	Request, tracks the job until it is done
+ * @sg:		Buffers in hash order, empty ones are allowed
+ * @nr_sg:	Number of buffers
+ * @digest:	Returns the 32 byte SHA256 digest
+ * @return 0 if OK, -EBUSY if @req is still running
+ */
+int hash_sg_submit(struct hash_sg_req *req, const struct hash_sg *sg,
+		   int nr_sg, u8 *digest);
+
+/**
+ * hash_sg_ctx_init() - Start a hash fed by several requests
+ *
+ * @ctx:	Context to set up
+ * @total:	Bytes in the whole message
+ * @digest:	Returns the 32 byte SHA256 digest
+ */
+void hash_sg_ctx_init(struct hash_sg_ctx *ctx, u64 total, u8 *digest);
+
+/**
+ * hash_sg_ctx_submit() - Start hashing the next part of a message
+ *
+ * The part goes on from where the last request on @ctx stopped, which
+ * must be done. Every part but the one reaching the end of the message
+ * must be a multiple of HASH_SG_BLOCK.
+ *
+ * @req:	Request, tracks the job until it is done
+ * @ctx:	Hash to go on with
+ * @sg:		Buffers in hash order
+ * @nr_sg:	Number of buffers
+ * @return 0 if OK, -EBUSY if @req is still running, -EINVAL if the part
+ *	does not fit the message
+ */
+int hash_sg_ctx_submit(struct hash_sg_req *req, struct hash_sg_ctx *ctx,
+		       const struct hash_sg *sg, int nr_sg);
+
+/**
+ * hash_sg_poll() - Check a request, finishing it if the backend is through
+ *
+ * @req:	Submitted request
+ * @return 0 once the digest is in place, -EBUSY while the job runs,
+ *	-EINVAL if @req was never submitted
+ */
+int hash_sg_poll(struct hash_sg_req *req);
+
+/**
+ * hash_sg_wait() - Wait for a request to finish
+ *
+ * @req:	Submitted request
+ * @return 0 if OK, -ve on error
+ */
+int hash_sg_wait(struct hash_sg_req *req);
+
+/**
+ * hash_sg_sha256() - SHA256 of a list of buffers, waiting for it
+ *
+ * @sg:		Buffers in hash order
+ * @nr_sg:	Number of buffers
+ * @digest:	Returns the 32 byte SHA256 digest
+ * @return 0 if OK, -ve on error
+ */
+int hash_sg_sha256(const struct hash_sg *sg, int nr_sg, u8 *digest);
+
+/**
+ * hash_sg_plan() - Cut a list of buffers into pieces a DMA engine takes
+ *
+ * Every piece but the last is a multiple of HASH_SG_BLOCK and word
+ * aligned. The bytes where one buffer ends and the next starts off a
+ * block boundary are gathered in @bounce, one block per join at most.
+ *
+ * @sg:		Buffers in hash order
+ * @nr_sg:	Number of buffers
+ * @piece:	Returns the pieces, room for 2 * @nr_sg + 1 of them
+ * @bounce:	Room for (@nr_sg + 1) * HASH_SG_BLOCK bytes
+ * @return number of pieces, -EINVAL if a buffer of more than one block
+ *	is not word aligned
+ */
+int hash_sg_plan(const struct hash_sg *sg, int nr_sg, struct hash_sg *piece,
+		 u8 *bounce);
+
+/*
+ * Backend, the defaults have none. hash_sg_hw_submit() starts @req or
+ * fails with -ve to have it hashed in software; hash_sg_hw_poll() returns
+ * -EBUSY while the job runs, 0 with the digest in place or -ve to have
+ * the request hashed again in software. A job goes on from @req->iv if
+ * set, and pads for @req->msg_len bytes only if @req->last; otherwise it
+ * leaves the state in @req->digest.
+ */
+int hash_sg_hw_submit(struct hash_sg_req *req);
+int hash_sg_hw_poll(struct hash_sg_req *req);
+
+#endif /* __HASH_SG_H__ */
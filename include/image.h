@@ -1277,6 +1277,7 @@ static inline int fit_image_check_target_arch(const void *fdt, int node)
 #if defined(CONFIG_ANDROID_BOOT_IMAGE)
 struct andr_img_hdr;
 struct vendor_boot_img_hdr *get_vendor_hdr_addr(void);
+int android_image_get_vendor_get_end(const struct vendor_boot_img_hdr *vendor_hdr);
 int android_image_check_header(const struct andr_img_hdr *hdr);
 int android_image_get_kernel(const struct andr_img_hdr *hdr, int verify,
 			     ulong *os_data, ulong *os_len);
@@ -1294,6 +1295,21 @@ ulong android_image_get_end(const struct andr_img_hdr *hdr);
 ulong android_image_get_kload(const struct andr_img_hdr *hdr);
 void android_print_contents(const struct andr_img_hdr *hdr);
 
+/**
+ * android_image_set_preload() - Record where a loader put the boot image
+ *
+ * A loader that reads the kernel and ramdisk straight to their final
+ * addresses leaves those parts out of the image buffer. The getters above
+ * then return the recorded addresses, so bootm finds the data in place
+ * and does not copy it.
+ *
+ * @hdr:	Image header, NULL to drop the record
+ * @kernel:	Address the kernel was read to, 0 if inside the image
+ * @ramdisk:	Address the ramdisk was read to, 0 if inside the image
+ */
+void android_image_set_preload(const struct andr_img_hdr *hdr, ulong kernel,
+			       ulong ramdisk);
+
 #endif /* CONFIG_ANDROID_BOOT_IMAGE */
 
 /**
@@ -10,6 +10,7 @@
 #define __AW_RAWNAND_H__
 
 #include <linux/mtd/mtd.h>
+#include <linux/mtd/mtdbbt.h>
 #include <linux/mtd/aw-ubi.h>
 #include <dm/device.h>
 
@@ -95,6 +96,12 @@
 #define UBOOT_START_BLOCK_SMALLNAND 8
 #define UBOOT_START_BLOCK_BIGNAND 4
 #define AW_RAWNAND_RESERVED_PHY_BLK_FOR_SECURE_STORAGE 8
+/*the on-flash bbt copies live in the blocks right after secure storage*/
+#if IS_ENABLED(CONFIG_AW_RAWNAND_BBT)
+#define AW_RAWNAND_RESERVED_PHY_BLK_FOR_BBT 4
+#else
+#define AW_RAWNAND_RESERVED_PHY_BLK_FOR_BBT 0
+#endif
 
 /*
  * Standard NAND flash commands
@@ -123,6 +130,8 @@
 #define RAWNAND_CMD_MULTIPROG		0x11
 #define RAWNAND_CMD_MULTIPREADSTART	0x32
 #define RAWNAND_CMD_MULTIERASE		0xd1
+#define RAWNAND_CMD_READCACHESEQ	0x31
+#define RAWNAND_CMD_READCACHEEND	0x3f
 
 #define TOGGLE_INTERFACE_CHANGE_ADDR	(0x80)
 
@@ -179,6 +188,10 @@
 /* 80h -- 11h ~ 81h -- 10h*/
 #define RAWNAND_JEDEC_MULTI_WRITE	BIT(14)
 
+/* Chip has cache read */
+/* 00h -- 30h ~ 00h -- 31h ~ 3Fh*/
+#define RAWNAND_CACHE_READ	BIT(15)
+
 /* Device needs 2rd row address cycle */
 #define RAWNAND_ROW_ADDR_2	BIT(16)
 
@@ -200,6 +213,7 @@
 #define RAWNAND_HAS_MULTI_WRITE(chip) ((chip)->options & RAWNAND_MULTI_WRITE)
 #define RAWNAND_HAS_JEDEC_MULTI_WRITE(chip) ((chip)->options & RAWNAND_JEDEC_MULTI_WRITE)
 #define RAWNAND_HAS_MULTI_READ(chip) ((chip->options & RAWNAND_MULTI_READ))
+#define RAWNAND_HAS_CACHE_READ(chip) ((chip->options & RAWNAND_CACHE_READ))
 #define RAWNAND_HAS_MULTI_ERASE(chip) ((chip->options & RAWNAND_MULTI_ERASE))
 #define RAWNAND_HAS_MULTI_ONFI_ERASE(chip) ((chip->options & RAWNAND_MULTI_ONFI_ERASE))
 #define RAWNAND_HAS_ONLY_TOGGLE(chip) ((chip->options & RAWNAND_TOGGLE_SUPPORT_ONLY))
@@ -696,11 +710,21 @@ struct aw_nfc_batch_req {
 			uint8_t RNOUTSTART;
 		} mr;
 
+		struct {
+			/*page cache read, CACHEREAD is 31h or 3Fh*/
+			uint8_t READ0;
+			uint8_t CACHEREAD;
+			uint8_t RNOUT;
+			uint8_t RNOUTSTART;
+		} cr;
+
 	} cmd;
 
 	struct {
 		uint32_t page;
 		uint8_t row_cycles;
+		/*cache read: page sent with 31h, the data out is from page*/
+		uint32_t next_page;
 	} addr;
 
 	struct {
@@ -784,6 +808,30 @@ struct aw_nfc_batch_req {
 	}
 
 
+#define BATCH_REQ_CACHE_READ(_req, _page, _next_page, _row_cycles, _mdata, _mlen)	\
+	struct aw_nfc_batch_req _req = {						\
+		.type = CACHE_READ,						\
+		.layout = INTERLEAVE,						\
+		.cmd.cr = {							\
+			.READ0 = RAWNAND_CMD_READ0,				\
+			.CACHEREAD = ((_next_page) < 0) ?			\
+				RAWNAND_CMD_READCACHEEND :			\
+				RAWNAND_CMD_READCACHESEQ,			\
+			.RNOUT = RAWNAND_CMD_RNDOUT,				\
+			.RNOUTSTART = RAWNAND_CMD_RNDOUTSTART,			\
+		},								\
+		.addr = {							\
+			.page = _page,						\
+			.row_cycles = _row_cycles,				\
+			.next_page = _next_page,				\
+		},								\
+		.data = {							\
+			.type = MAINSPARE,					\
+			.main_len = _mlen,					\
+			.main = _mdata,					\
+		},								\
+	}
+
 #define BATCH_REQ_READ_ONLY_SPARE(_req, _page, _row_cycles, _sdata, _slen)	\
 	struct aw_nfc_batch_req _req = {						\
 		.type = READ,							\
@@ -1142,6 +1190,8 @@ struct aw_nand_chip {
 	uint8_t *bbt;
 	/*mark whether the corresponding bbt bit is updated*/
 	uint8_t *bbtd;
+	/*copies of bbt on flash, CONFIG_AW_RAWNAND_BBT*/
+	struct mtd_bbt flash_bbt;
 
 	uint8_t bitflips;
 
@@ -1172,6 +1222,9 @@ struct aw_nand_chip {
 		uint8_t *mdata, int mlen, uint8_t *sdata, int slen, int page);
 	int (*read_page_spare)(struct mtd_info *mtd, struct aw_nand_chip *chip,
 		uint8_t *sdata, int slen, int page);
+	/*whole simu pages of one simu block, straight to a dma aligned mdata*/
+	int (*read_pages)(struct mtd_info *mtd, struct aw_nand_chip *chip,
+		uint8_t *mdata, int page, int npages);
 
 	int (*write_boot0_page)(struct mtd_info *mtd, struct aw_nand_chip *chip,
 		uint8_t *mdata, int mlen, uint8_t *sdata, int slen, int page);
@@ -1336,6 +1389,8 @@ int aw_rawnand_chip_simu_block_bad(struct mtd_info *mtd, int block);
 extern int aw_rawnand_chip_block_markbad(struct mtd_info *mtd, int block);
 extern int aw_rawnand_chip_simu_block_markbad(struct mtd_info *mtd, int block);
 extern int aw_rawnand_chip_scan_bbt(struct mtd_info *mtd);
+extern int aw_rawnand_chip_load_bbt(struct mtd_info *mtd);
+extern int aw_rawnand_chip_store_bbt(struct mtd_info *mtd);
 
 extern int aw_host_init(struct udevice *dev);
 extern void aw_host_exit(struct aw_nand_host *host);
@@ -0,0 +1,85 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Bad block table kept on flash: a bitmap, one bit per block of the
+ * device, written with a version number to two eraseblocks of a small
+ * area the file systems never use. Loading it takes a page read per
+ * block of the area instead of reading the markers of every block.
+ *
+ * Every update goes to both copies one after the other with the next
+ * version, so a power cut leaves at least one complete copy and the
+ * newest complete copy wins.
+ */
+
+#ifndef __MTD_BBT_H__
+#define __MTD_BBT_H__
+
+#include <linux/types.h>
+
+#define MTD_BBT_MAGIC		0x30544242	/* "BBT0" */
+#define MTD_BBT_COPIES		2
+
+struct mtd_info;
+
+/* At the start of each copy, followed by the bitmap */
+struct mtd_bbt_hdr {
+	__le32 magic;
+	__le32 version;
+	__le32 nr_bits;
+	/* crc32 of version, nr_bits and the bitmap */
+	__le32 crc;
+} __packed;
+
+struct mtd_bbt {
+	struct mtd_info *mtd;
+	/* area holding the copies, eraseblock aligned */
+	loff_t offs;
+	int nr_blocks;
+	/* the table, one bit per block, set for a bad block */
+	u8 *bitmap;
+	int nr_bits;
+	/* of the copies on flash, 0 before the first one */
+	u32 version;
+	/* eraseblock in the area of each copy, -1 for none */
+	int copy[MTD_BBT_COPIES];
+};
+
+/**
+ * mtd_bbt_init() - Describe a table and the area for its copies
+ *
+ * @bbt:	Table to set up
+ * @mtd:	Device holding the copies
+ * @offs:	Start of the area, eraseblock aligned
+ * @nr_blocks:	Eraseblocks in the area, at least MTD_BBT_COPIES
+ * @bitmap:	The table, owned by the caller
+ * @nr_bits:	Blocks covered by @bitmap
+ * @return 0 if OK, -EINVAL if the area does not fit the device
+ */
+int mtd_bbt_init(struct mtd_bbt *bbt, struct mtd_info *mtd, loff_t offs,
+		 int nr_blocks, u8 *bitmap, int nr_bits);
+
+/**
+ * mtd_bbt_load() - Read the newest valid copy into the bitmap
+ *
+ * A copy that is missing or older than the newest one is rewritten.
+ *
+ * @bbt:	Table set up with mtd_bbt_init()
+ * @return 0 if OK, -ENOENT if no valid copy is found, the bitmap is
+ *	left alone then
+ */
+int mtd_bbt_load(struct mtd_bbt *bbt);
+
+/**
+ * mtd_bbt_store() - Write the bitmap to both copies as a new version
+ *
+ * Each copy is erased and written in turn. A block of the area that
+ * fails is left out and the copy goes to another good block.
+ *
+ * @bbt:	Table set up with mtd_bbt_init()
+ * @return 0 if at least one copy was written, -EIO if none could be
+ */
+int mtd_bbt_store(struct mtd_bbt *bbt);
+
+#endif /* __MTD_BBT_H__ */
@@ -509,6 +509,30 @@ struct dm_mmc_ops {
 	 */
 	int (*wait_dat0)(struct udevice *dev, int state, int timeout);
 #endif
+
+	/**
+	 * submit_cmd() - Start a data command without waiting for it
+	 *
+	 * Only one command can be in flight, it is finished by poll_cmd().
+	 *
+	 * @dev:	Device to receive the command
+	 * @cmd:	Command to send, must stay valid until it is finished
+	 * @data:	Data to send/receive, must stay valid as well
+	 * @return 0 if started, -ve on error
+	 */
+	int (*submit_cmd)(struct udevice *dev, struct mmc_cmd *cmd,
+			  struct mmc_data *data);
+
+	/**
+	 * poll_cmd() - Check a command started by submit_cmd()
+	 *
+	 * @dev:	Device the command was sent to
+	 * @cmd:	Command passed to submit_cmd()
+	 * @data:	Data passed to submit_cmd()
+	 * @return 0 if finished, -EBUSY if still running, other -ve on error
+	 */
+	int (*poll_cmd)(struct udevice *dev, struct mmc_cmd *cmd,
+			struct mmc_data *data);
 };
 
 #define mmc_get_ops(dev)        ((struct dm_mmc_ops *)(dev)->driver->ops)
@@ -521,6 +545,10 @@ int dm_mmc_get_cd(struct udevice *dev);
 int dm_mmc_get_wp(struct udevice *dev);
 int dm_mmc_execute_tuning(struct udevice *dev, uint opcode);
 int dm_mmc_wait_dat0(struct udevice *dev, int state, int timeout);
+int dm_mmc_submit_cmd(struct udevice *dev, struct mmc_cmd *cmd,
+		      struct mmc_data *data);
+int dm_mmc_poll_cmd(struct udevice *dev, struct mmc_cmd *cmd,
+		    struct mmc_data *data);
 
 /* Transition functions for compatibility */
 int mmc_set_ios(struct mmc *mmc);
@@ -546,6 +574,12 @@ struct mmc_ops {
 	int (*get_detail_errno)(struct mmc *mmc);
 
 	int (*update_phase)(struct mmc *mmc);
+
+	/* start a data command and check it later, see struct dm_mmc_ops */
+	int (*submit_cmd)(struct mmc *mmc,
+			  struct mmc_cmd *cmd, struct mmc_data *data);
+	int (*poll_cmd)(struct mmc *mmc,
+			struct mmc_cmd *cmd, struct mmc_data *data);
 };
 #endif
 struct tune_sdly {
@@ -838,6 +872,7 @@ struct mmc {
 	//u64 csd_perm_wp;
 	//u64 csd_wp_grp_size;
 	uchar secure_feature; // extcsd[231]
+	struct mmc_req *req;	/* request in flight, see mmc_req_submit() */
 };
 #pragma pack()
 
@@ -974,6 +1009,65 @@ int mmc_of_parse(struct udevice *dev, struct mmc_config *cfg);
 
 int mmc_read(struct mmc *mmc, u64 src, uchar *dst, int size);
 
+/* State of a struct mmc_req */
+enum mmc_req_state {
+	MMC_REQ_IDLE,
+	MMC_REQ_BUSY,		/* command in flight on the host */
+	MMC_REQ_DONE,
+};
+
+/*
+ * Block transfer that runs while the caller does something else. Hosts
+ * without submit_cmd/poll_cmd, and transfers the host cannot take in one
+ * command, are done at submit time through the block read/write path.
+ */
+struct mmc_req {
+	struct mmc	*mmc;
+	struct mmc_cmd	cmd;
+	struct mmc_data	data;
+	lbaint_t	start;
+	lbaint_t	blkcnt;
+	void		*buf;
+	bool		write;
+	enum mmc_req_state state;
+	int		ret;	/* blocks transferred or -ve error once done */
+};
+
+/**
+ * mmc_req_submit() - Start a block read or write
+ *
+ * A command sent to the card while the request is in flight waits for it
+ * to finish first.
+ *
+ * @mmc:	MMC device, with only one request in flight at a time
+ * @req:	Request to fill in, must stay valid until it is done
+ * @start:	First block, relative to the selected hardware partition
+ * @blkcnt:	Number of blocks
+ * @buf:	Buffer, cache aligned so the host can DMA into it
+ * @write:	true to write @buf to the card
+ * @return 0 if the request was taken, its result then comes from
+ *	mmc_req_poll()/mmc_req_wait(); -EBUSY if another request is in
+ *	flight, -EINVAL if the range is empty or past the end
+ */
+int mmc_req_submit(struct mmc *mmc, struct mmc_req *req, lbaint_t start,
+		   lbaint_t blkcnt, void *buf, bool write);
+
+/**
+ * mmc_req_poll() - Check a request started by mmc_req_submit()
+ *
+ * @req:	Request
+ * @return 0 if done, -EBUSY if still running, other -ve on error
+ */
+int mmc_req_poll(struct mmc_req *req);
+
+/**
+ * mmc_req_wait() - Wait for a request started by mmc_req_submit()
+ *
+ * @req:	Request
+ * @return number of blocks transferred, or -ve on error
+ */
+int mmc_req_wait(struct mmc_req *req);
+
 /**
  * mmc_voltage_to_mv() - Convert a mmc_voltage in mV
  *
@@ -1093,6 +1187,8 @@ int sunxi_write_tuning(struct mmc *mmc);
 int sunxi_bus_tuning(struct mmc *mmc);
 int sunxi_mmc_tuning_exit(void);
 int sunxi_switch_to_best_bus(struct mmc *mmc);
+int sunxi_mmc_tuning_cache_load(struct mmc *mmc);
+int sunxi_mmc_tuning_cache_check(struct mmc *mmc);
 
 int mmc_exit(void);
 void mmc_update_config_for_dragonboard(int card_no);
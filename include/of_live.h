@@ -20,4 +20,20 @@ struct device_node;
  */
 int of_live_build(const void *fdt_blob, struct device_node **rootp);
 
+/**
+ * of_live_unflatten() - build a live tree from a flat DT, for itself only
+ *
+ * Unlike of_live_build() the tree is not scanned for aliases, so it does
+ * not become the tree of driver model, and nodes get no made-up "name"
+ * property: the name of a node is its name in the blob, unit address
+ * included. Names and values of the properties point into @fdt_blob,
+ * which must stay in place. The whole tree is one allocation, freed by
+ * free(*rootp).
+ *
+ * @fdt_blob: Input tree to convert
+ * @rootp: Returns live tree that was created
+ * @return 0 if OK, -ve on error
+ */
+int of_live_unflatten(const void *fdt_blob, struct device_node **rootp);
+
 #endif
@@ -0,0 +1,121 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Batched fixups of a flattened device tree on a live tree: the blob is
+ * unflattened once, the fixups edit nodes and properties in memory, and
+ * the blob is written again in one pass when the batch is closed,
+ * instead of every fdt_setprop()/fdt_add_mem_rsv() moving the tail of
+ * the blob.
+ *
+ * The blob written is the one the same calls to libfdt give: same
+ * layout, property order, string table and reserve map. Only the padding
+ * after property values is zeroed, and NOPs of the input are dropped.
+ * The blob must not be written by other means while a batch is open.
+ */
+
+#ifndef __OF_LIVE_FIXUP_H__
+#define __OF_LIVE_FIXUP_H__
+
+#include <linux/libfdt.h>
+
+struct device_node;
+struct of_live_fixup_mem;
+
+struct of_live_fixup {
+	void *fdt;
+	struct device_node *root;
+	bool changed;
+	/* names of new properties, appended to the strings of the blob */
+	char *strings;
+	int strings_len;
+	int strings_max;
+	/* reserve map entries appended to the ones of the blob */
+	struct fdt_reserve_entry *rsv;
+	int nr_rsv;
+	int max_rsv;
+	/* property values and names allocated by the fixups */
+	struct of_live_fixup_mem *mem;
+};
+
+/**
+ * of_live_fixup_open() - Start a batch of fixups of a blob
+ *
+ * @lf:		Batch to start
+ * @fdt:	Blob to fix up, its totalsize bounds the result
+ * @return 0 if OK, or a libfdt error
+ */
+int of_live_fixup_open(struct of_live_fixup *lf, void *fdt);
+
+/**
+ * of_live_fixup_find_node() - Find a node as fdt_path_offset() does
+ *
+ * @lf:		Open batch
+ * @path:	Full path of a node, or an alias followed by a path
+ * @return node, or NULL if there is none
+ */
+struct device_node *of_live_fixup_find_node(struct of_live_fixup *lf,
+					    const char *path);
+
+/**
+ * of_live_fixup_setprop() - Set a property as fdt_setprop() does
+ *
+ * A new property comes first in the node, an existing one keeps its place.
+ *
+ * @lf:		Open batch
+ * @np:		Node of the property
+ * @name:	Property name
+ * @val:	Value, copied
+ * @len:	Length of @val in bytes, 0 for an empty property
+ * @return 0 if OK, or a libfdt error
+ */
+int of_live_fixup_setprop(struct of_live_fixup *lf, struct device_node *np,
+			  const char *name, const void *val, int len);
+
+static inline int of_live_fixup_setprop_u32(struct of_live_fixup *lf,
+					    struct device_node *np,
+					    const char *name, u32 val)
+{
+	fdt32_t tmp = cpu_to_fdt32(val);
+
+	return of_live_fixup_setprop(lf, np, name, &tmp, sizeof(tmp));
+}
+
+static inline int of_live_fixup_setprop_string(struct of_live_fixup *lf,
+					       struct device_node *np,
+					       const char *name,
+					       const char *str)
+{
+	return of_live_fixup_setprop(lf, np, name, str, strlen(str) + 1);
+}
+
+/**
+ * of_live_fixup_add_mem_rsv() - Add a reserve map entry as fdt_add_mem_rsv()
+ *
+ * @lf:		Open batch
+ * @address:	Start of the region
+ * @size:	Size of the region
+ * @return 0 if OK, or a libfdt error
+ */
+int of_live_fixup_add_mem_rsv(struct of_live_fixup *lf, u64 address,
+			      u64 size);
+
+/**
+ * of_live_fixup_close() - Write the fixed up blob and end the batch
+ *
+ * @lf:		Open batch
+ * @return 0 if OK, or a libfdt error, -FDT_ERR_NOSPACE when the result
+ *	does not fit the totalsize of the blob. The blob is left as it was
+ *	on error.
+ */
+int of_live_fixup_close(struct of_live_fixup *lf);
+
+/**
+ * of_live_fixup_abort() - End a batch leaving the blob as it was
+ *
+ * @lf:		Open batch
+ */
+void of_live_fixup_abort(struct of_live_fixup *lf);
+
+#endif /* __OF_LIVE_FIXUP_H__ */
@@ -330,4 +330,27 @@ int os_spl_to_uboot(const char *fname);
  */
 void os_localtime(struct rtc_time *rt);
 
+/**
+ * os_thread_start() - Run a function in a new host thread
+ *
+ * The thread is detached, it ends when @fn returns.
+ *
+ * @fn:		Function to run
+ * @arg:	Passed to @fn
+ * @return 0 if OK, -ve on error
+ */
+int os_thread_start(void *(*fn)(void *), void *arg);
+
+/**
+ * os_thread_yield() - Let other host threads run
+ */
+void os_thread_yield(void);
+
+/**
+ * os_cpu_count() - Number of host CPUs online
+ *
+ * @return number of CPUs, at least 1
+ */
+int os_cpu_count(void);
+
 #endif
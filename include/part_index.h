@@ -0,0 +1,88 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Partition lookup index: a table of partitions sorted by start sector
+ * for address lookups by binary search, and a hashed name table. The
+ * index is filled once when the partition map is loaded and queried on
+ * every read/write instead of walking the map.
+ */
+
+#ifndef __PART_INDEX_H__
+#define __PART_INDEX_H__
+
+#include <linux/types.h>
+
+#define PART_INDEX_MAX		128
+#define PART_INDEX_NAME_LEN	16
+/* power of two, at least twice PART_INDEX_MAX so probing stays short */
+#define PART_INDEX_HASH_SIZE	256
+
+struct part_index_ent {
+	char name[PART_INDEX_NAME_LEN + 1];
+	u32 start;
+	u32 sects;
+	int id;
+};
+
+struct part_index {
+	int valid;
+	int count;
+	/* sorted by start once the index is built */
+	struct part_index_ent ent[PART_INDEX_MAX];
+	/* slot in ent[] plus one, 0 for an empty bucket */
+	u8 hash[PART_INDEX_HASH_SIZE];
+};
+
+/**
+ * part_index_reset() - Empty and invalidate an index
+ *
+ * @idx:	Index to reset
+ */
+void part_index_reset(struct part_index *idx);
+
+/**
+ * part_index_add() - Add one partition to an index being filled
+ *
+ * @idx:	Index to fill
+ * @name:	Partition name, at most PART_INDEX_NAME_LEN characters count
+ * @start:	First sector of the partition
+ * @sects:	Sectors in the partition, 0 for a partition without space
+ * @id:		Value returned by lookups, the caller's partition number
+ * @return 0 if OK, -ENOSPC if the index is full
+ */
+int part_index_add(struct part_index *idx, const char *name, u32 start,
+		   u32 sects, int id);
+
+/**
+ * part_index_build() - Sort the partitions and hash the names
+ *
+ * The index is only valid after this. Partitions must not overlap.
+ *
+ * @idx:	Index filled with part_index_add()
+ * @return 0 if OK, -EINVAL if two partitions overlap
+ */
+int part_index_build(struct part_index *idx);
+
+/**
+ * part_index_find_addr() - Find the partition holding a sector range
+ *
+ * @idx:	Built index
+ * @start:	First sector of the range
+ * @sects:	Sectors in the range
+ * @return id of the partition, -ENOENT if @start is in no partition,
+ *	-ERANGE if the range runs past the end of the partition
+ */
+int part_index_find_addr(const struct part_index *idx, u32 start, u32 sects);
+
+/**
+ * part_index_find_name() - Find a partition by name
+ *
+ * @idx:	Built index
+ * @name:	Partition name
+ * @return id of the partition, -ENOENT if there is none
+ */
+int part_index_find_name(const struct part_index *idx, const char *name);
+
+#endif /* __PART_INDEX_H__ */
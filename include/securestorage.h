@@ -9,6 +9,9 @@
 
 extern int sunxi_secure_storage_init(void);
 extern int sunxi_secure_storage_exit(void);
+extern int sunxi_secure_storage_begin(void);
+extern int sunxi_secure_storage_commit(void);
+extern void sunxi_secure_storage_abort(void);
 
 extern int sunxi_secure_storage_list(void);
 extern int sunxi_secure_storage_probe(const char *item_name);
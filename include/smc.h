@@ -53,6 +53,7 @@ int smc_tee_inform_fdt(uint64_t base, uint32_t size);
 
 int arm_svc_set_cpu_on(int cpu, uint entry);
 int arm_svc_set_cpu_off(int cpu);
+int arm_svc_cpu_affinity(int cpu);
 int arm_svc_set_cpu_wfi(void);
 
 /*for multi cluster*/
@@ -193,4 +193,30 @@ static inline int spi_flash_protect(struct spi_flash *flash, u32 ofs, u32 len,
 		return flash->flash_unlock(flash, ofs, len);
 }
 
+/* What an update did to the flash, in bytes */
+struct spi_flash_update_stats {
+	size_t skipped;		/* already holding the new data */
+	size_t erased;
+	size_t programmed;
+};
+
+/**
+ * spi_flash_update_range() - Write data to SPI flash, leaving unchanged
+ *	sectors alone
+ *
+ * The whole range is read back and compared first. Runs of sectors that
+ * need erasing are erased with one request each, so the driver can use
+ * block or chip erase, and only sectors whose contents change are
+ * programmed. A partial last sector keeps the data following @len.
+ *
+ * @flash:	SPI flash
+ * @offset:	Offset into the flash, a multiple of the erase size
+ * @len:	Number of bytes to write
+ * @buf:	Buffer containing bytes to write
+ * @stats:	Returns what was skipped, erased and programmed
+ * @return 0 if OK, -ve on error
+ */
+int spi_flash_update_range(struct spi_flash *flash, u32 offset, size_t len,
+			   const void *buf, struct spi_flash_update_stats *stats);
+
 #endif /* _SPI_FLASH_H_ */
@@ -26,6 +26,22 @@
 #include <common.h>
 #include <sunxi_nand.h>
 
+/*
+ * read/write that runs while the caller works, see sunxi_flash_submit().
+ * Once done, @ret holds what sunxi_flash_read/write would have returned.
+ */
+struct sunxi_flash_req {
+	uint start_block;
+	uint nblock;
+	void *buffer;
+	int write;
+	int phys;	/* @start_block is a physical address, see phyread */
+	int done;
+	int ret;
+	void *desc;	/* flash the request went to */
+	void *priv;	/* driver request */
+};
+
 /*normal*/
 int sunxi_flash_init(void);
 uint sunxi_flash_size(void);
@@ -35,6 +51,21 @@ int sunxi_flash_read(unsigned int start_block, unsigned int nblock,
 int sunxi_flash_write(unsigned int start_block, unsigned int nblock,
 		      void *buffer);
 int sunxi_flash_flush(void);
+/*
+ * start a read/write, @buffer must stay untouched until sunxi_flash_poll()
+ * returns 0 or sunxi_flash_complete() returns. Flashes without request
+ * support do the transfer at submit. Returns -EBUSY if a request is
+ * already in flight on the device.
+ */
+int sunxi_flash_submit(struct sunxi_flash_req *req, uint start_block,
+		       uint nblock, void *buffer, int write);
+/* 0 once the request is done, -EBUSY while it runs */
+int sunxi_flash_poll(struct sunxi_flash_req *req);
+/* wait for the request, returns req->ret */
+int sunxi_flash_complete(struct sunxi_flash_req *req);
+/* sunxi_flash_submit() for the "sunxi_flash" block device addresses */
+int sunxi_flash_blk_submit(struct sunxi_flash_req *req, uint start_block,
+			   uint nblock, void *buffer);
 int sunxi_flash_erase(int erase, void *mbr_buffer);
 int sunxi_flash_erase_area(uint start_block, uint nblock);
 int sunxi_flash_force_erase(void);
@@ -57,6 +88,8 @@ int sunxi_sprite_read(unsigned int start_block, unsigned int nblock,
 		      void *buffer);
 int sunxi_sprite_write(unsigned int start_block, unsigned int nblock,
 		       void *buffer);
+int sunxi_sprite_submit(struct sunxi_flash_req *req, uint start_block,
+			uint nblock, void *buffer, int write);
 int sunxi_sprite_flush(void);
 int sunxi_sprite_erase(int erase, void *mbr_buffer);
 int sunxi_sprite_force_erase(void);
@@ -14,6 +14,13 @@ struct sunxi_image_verify_pattern_st {
 
 extern int sunxi_verify_rotpk_hash(void *input_hash_buf, int len);
 extern int sunxi_verify_os(ulong os_load_addr, const char *cert_name);
+/*
+ * Hash the boot image for sunxi_verify_os() while it is loaded: @len bytes
+ * of the image at @os_load_addr, fed in image order from wherever each
+ * part lands. Every piece but the last is a multiple of 64 bytes.
+ */
+extern int sunxi_verify_os_hash_start(ulong os_load_addr, uint32_t len);
+extern int sunxi_verify_os_hash_update(void *buf, uint32_t len);
 extern int sunxi_verify_partion(struct sunxi_image_verify_pattern_st *pattern, const char *part_name, const char *cert_name, int full);
 extern int sunxi_verify_preserve_toc1(void *toc1_head_buf);
 extern int sunxi_verify_get_rotpk_hash(void *hash_buf);
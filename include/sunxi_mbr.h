@@ -36,6 +36,10 @@
 #define     SUNXI_MBR_RESERVED          (SUNXI_MBR_SIZE - 32 - 4 - (SUNXI_MBR_MAX_PART_COUNT * sizeof(sunxi_partition)))   //mbr保留的空间
 #define     SUNXI_DL_RESERVED           (SUNXI_DL_SIZE - 32 - (SUNXI_MBR_MAX_PART_COUNT * sizeof(dl_one_part_info)))
 
+#define     SUNXI_VERIFY_NONE           0    //dl_one_part_info.verify: 不校验
+#define     SUNXI_VERIFY_ADD_SUM        1    //32位累加和, 校验文件前4字节
+#define     SUNXI_VERIFY_SHA256         2    //sha256, 校验文件前32字节
+
 #define     SUNXI_LOCKED               (0xAA)
 #define     SUNXI_UNLOCKED                (0xA5)
 /* partition information */
@@ -83,7 +87,7 @@ typedef struct tag_one_part_info
 	unsigned  char      dl_filename[16];    //所烧写分区的文件名称，长度固定16字节
 	unsigned  char      vf_filename[16];    //所烧写分区的校验文件名称，长度固定16字节
 	unsigned  int       encrypt;            //所烧写分区的数据是否进行加密 0:加密   1：不加密
-	unsigned  int       verify;             //所烧写分区的数据是否进行校验 0:不校验 1：校验
+	unsigned  int       verify;             //所烧写分区的数据是否进行校验 0:不校验 1：累加和校验 2：sha256校验
 }__attribute__ ((packed)) dl_one_part_info;
 
 //分区烧写信息
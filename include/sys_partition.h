@@ -16,6 +16,7 @@
 #include <sunxi_board.h>
 
 int sunxi_probe_partition_map(void);
+void sunxi_partition_index_invalidate(void);
 int sunxi_partition_get_partno_byname(const char *part_name);
 int sunxi_partition_get_info(const char *part_name, disk_partition_t *info);
 uint sunxi_partition_get_offset_byname(const char *part_name);
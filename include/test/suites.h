@@ -25,8 +25,20 @@ int cmd_ut_category(const char *name, struct unit_test *tests, int n_ents,
 
 int do_ut_dm(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 int do_ut_env(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
+int do_ut_fdt_index(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[]);
+int do_ut_hash_sg(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[]);
+int do_ut_imgdecode(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[]);
+int do_ut_mtd_bbt(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[]);
+int do_ut_of_live_fixup(cmd_tbl_t *cmdtp, int flag, int argc,
+			char *const argv[]);
 int do_ut_overlay(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
+int do_ut_part_index(cmd_tbl_t *cmdtp, int flag, int argc,
+		     char *const argv[]);
+int do_ut_sha(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[]);
 int do_ut_time(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
+int do_ut_ubi_kapi(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[]);
+int do_ut_worker_pool(cmd_tbl_t *cmdtp, int flag, int argc,
+		      char *const argv[]);
 int do_ut_compression(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[]);
 
 #endif /* __TEST_SUITES_H__ */
@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * CPU instruction backend for lib/sha1.c and lib/sha256.c. Whole blocks
+ * go to the architecture's block functions when the CPU has the SHA
+ * instructions, the portable C code does the rest.
+ */
+
+#ifndef _SHA_ARCH_H
+#define _SHA_ARCH_H
+
+#ifdef USE_HOSTCC
+#include <stdbool.h>
+#endif
+
+enum sha_arch_alg {
+	SHA_ARCH_SHA1,
+	SHA_ARCH_SHA256,
+};
+
+#if defined(USE_HOSTCC)
+#define SHA_ARCH_BUILD	0
+#elif CONFIG_IS_ENABLED(SHA_ARCH)
+#define SHA_ARCH_BUILD	1
+#else
+#define SHA_ARCH_BUILD	0
+#endif
+
+#if SHA_ARCH_BUILD
+/**
+ * sha_arch_usable() - Check whether whole blocks go to the backend
+ *
+ * The CPU is probed on the first call.
+ *
+ * @alg:	Algorithm to check
+ * @return true if the CPU has the instructions and the backend is enabled
+ */
+bool sha_arch_usable(enum sha_arch_alg alg);
+
+/**
+ * sha_arch_set_enabled() - Switch the backend on or off
+ *
+ * Off, everything is hashed by the portable code, for tests and
+ * benchmarks. The backend is on by default.
+ *
+ * @enable:	true to use the backend where the CPU allows
+ */
+void sha_arch_set_enabled(bool enable);
+
+/*
+ * Architecture part: sha_arch_probe() returns a mask of BIT(alg) the CPU
+ * can do, ready for use once it has returned, none by default.
+ * sha_arch_name() names the backend. The block functions take @blocks
+ * (not 0) 64 byte blocks at any alignment.
+ */
+unsigned int sha_arch_probe(void);
+const char *sha_arch_name(void);
+void sha1_arch_blocks(uint32_t *state, const uint8_t *data, uint32_t blocks);
+void sha256_arch_blocks(uint32_t *state, const uint8_t *data,
+			uint32_t blocks);
+#else
+static inline bool sha_arch_usable(enum sha_arch_alg alg)
+{
+	return false;
+}
+
+static inline void sha_arch_set_enabled(bool enable)
+{
+}
+
+static inline const char *sha_arch_name(void)
+{
+	return "none";
+}
+
+static inline void sha1_arch_blocks(uint32_t *state, const uint8_t *data,
+				    uint32_t blocks)
+{
+}
+
+static inline void sha256_arch_blocks(uint32_t *state, const uint8_t *data,
+				      uint32_t blocks)
+{
+}
+#endif
+
+#endif /* _SHA_ARCH_H */
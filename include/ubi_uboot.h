@@ -73,6 +73,8 @@ extern void ubi_exit(void);
 extern int ubi_part(char *part_name, const char *vid_header_offset);
 extern int ubi_volume_write(char *volume, void *buf, size_t size);
 extern int ubi_volume_read(char *volume, char *buf, size_t size);
+/* called before UBI device @ubi_num goes, its volumes must be closed */
+extern void ubi_detach_notify(int ubi_num);
 
 /* sunxi ubifs fuctions */
 int sunxi_do_ubi(int flags, int argc, char *const argv[]);
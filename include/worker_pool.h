@@ -0,0 +1,108 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Worker pool: the secondary cores, idle while U-Boot runs, take jobs
+ * of a batch next to the boot core. A batch is a number of independent
+ * jobs, such as the checksum of one chunk or the decompression of one
+ * block, and worker_pool_run() returns once all of them are done.
+ *
+ * Jobs run concurrently and must only touch their own data: no console
+ * output, no malloc() and no drivers.
+ */
+
+#ifndef __WORKER_POOL_H__
+#define __WORKER_POOL_H__
+
+/**
+ * typedef worker_job_fn - One job of a batch
+ *
+ * @priv:	Data shared by the batch
+ * @job:	Number of the job, 0 to the number of jobs - 1
+ */
+typedef void (*worker_job_fn)(void *priv, int job);
+
+#ifdef CONFIG_WORKER_POOL
+/**
+ * worker_pool_start() - Bring up the secondary cores
+ *
+ * Called on the first batch or worker_pool_size(), a started pool is
+ * left as it is.
+ *
+ * @return number of cores running jobs, the boot core included
+ */
+int worker_pool_start(void);
+
+/**
+ * worker_pool_stop() - Hand the secondary cores back to the firmware
+ *
+ * Must be done before the OS is started, it brings the cores up itself.
+ * The next batch or worker_pool_size() starts the pool again, unless a
+ * core did not leave it.
+ */
+void worker_pool_stop(void);
+
+/**
+ * worker_pool_size() - Number of cores running jobs of a batch
+ *
+ * Starts the pool if that was not done yet, so a batch can be sized on
+ * it before the first worker_pool_run().
+ *
+ * @return the started workers plus the boot core
+ */
+int worker_pool_size(void);
+
+/**
+ * worker_pool_run() - Run a batch of jobs and wait for all of them
+ *
+ * The boot core takes jobs too, without workers the batch simply runs
+ * on it in order.
+ *
+ * @fn:		Job function
+ * @priv:	Passed to every job
+ * @nr_jobs:	Number of jobs
+ */
+void worker_pool_run(worker_job_fn fn, void *priv, int nr_jobs);
+
+/* Entry of a worker, called by the arch code on the secondary core */
+void worker_pool_main(int id);
+
+/*
+ * Arch hooks, the defaults leave the pool without workers.
+ * arch_worker_start() starts worker @id (1 to CONFIG_WORKER_POOL_CPUS - 1)
+ * in worker_pool_main(@id); arch_worker_exit() is called on a worker
+ * that leaves the pool and arch_worker_stopped() on the boot core once
+ * it left; arch_worker_wait() idles a core until arch_worker_wake() is
+ * called on another one.
+ */
+int arch_worker_start(int id);
+void arch_worker_exit(int id);
+void arch_worker_stopped(int id);
+void arch_worker_wait(void);
+void arch_worker_wake(void);
+#else
+static inline int worker_pool_start(void)
+{
+	return 1;
+}
+
+static inline void worker_pool_stop(void)
+{
+}
+
+static inline int worker_pool_size(void)
+{
+	return 1;
+}
+
+static inline void worker_pool_run(worker_job_fn fn, void *priv, int nr_jobs)
+{
+	int i;
+
+	for (i = 0; i < nr_jobs; i++)
+		fn(priv, i);
+}
+#endif
+
+#endif /* __WORKER_POOL_H__ */
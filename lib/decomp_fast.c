@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Run time switch of the faster decoders, see include/decomp_fast.h
+ */
+
+#include <common.h>
+#include <decomp_fast.h>
+
+enum {
+	DECOMP_FAST_UNPROBED,
+	DECOMP_FAST_USABLE,
+	DECOMP_FAST_UNUSABLE,
+};
+
+/* images may be decompressed before relocation, keep it out of BSS */
+static int decomp_fast_state __attribute__((section(".data"))) =
+	DECOMP_FAST_UNPROBED;
+static bool decomp_fast_disabled __attribute__((section(".data")));
+
+bool __weak decomp_fast_probe(void)
+{
+	return true;
+}
+
+bool decomp_fast_enabled(void)
+{
+	if (decomp_fast_disabled)
+		return false;
+	if (decomp_fast_state == DECOMP_FAST_UNPROBED)
+		decomp_fast_state = decomp_fast_probe() ? DECOMP_FAST_USABLE :
+							  DECOMP_FAST_UNUSABLE;
+
+	return decomp_fast_state == DECOMP_FAST_USABLE;
+}
+
+void decomp_fast_set_enabled(bool enable)
+{
+	decomp_fast_disabled = !enable;
+}
@@ -0,0 +1,376 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Device tree lookup index, see include/fdt_index.h
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <fdt_index.h>
+
+#define FDT_INDEX_PATH_MAX	256
+#define FDT_INDEX_MAX_DEPTH	32
+/*
+ * Lookups answered by libfdt after a change before the index is built
+ * again, so that a tree written between every lookup is not rebuilt each
+ * time.
+ */
+#define FDT_INDEX_REBUILD_LOOKUPS	4
+
+struct fdt_index_node {
+	int offset;
+	u32 phandle;
+	/* offset of the full path in paths[] */
+	u32 path;
+};
+
+static struct {
+	/* tree the index is about and the sizes of its blocks */
+	const void *fdt;
+	u32 size_struct;
+	u32 size_strings;
+	bool valid;
+	bool failed;
+	int stale_lookups;
+
+	/* in tree order, so sorted by offset */
+	struct fdt_index_node *node;
+	int count;
+	int max;
+	char *paths;
+	u32 paths_len;
+	u32 paths_max;
+	/* node plus one, 0 for an empty bucket; hash_size is a power of two */
+	int *path_hash;
+	int *phandle_hash;
+	u32 hash_size;
+} idx;
+
+static u32 fdt_index_hash_path(const char *path, int len)
+{
+	u32 hash = 2166136261u;
+	int i;
+
+	/* FNV-1a */
+	for (i = 0; i < len; i++) {
+		hash ^= (u8)path[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static u32 fdt_index_hash_phandle(u32 phandle)
+{
+	return phandle * 2654435761u;
+}
+
+static int fdt_index_add(int offset, u32 phandle, const char *path, int len)
+{
+	struct fdt_index_node *node;
+
+	if (idx.count == idx.max) {
+		int max = idx.max ? idx.max * 2 : 256;
+
+		node = realloc(idx.node, max * sizeof(*node));
+		if (!node)
+			return -FDT_ERR_NOSPACE;
+		idx.node = node;
+		idx.max = max;
+	}
+	if (idx.paths_len + len + 1 > idx.paths_max) {
+		u32 max = idx.paths_max ? idx.paths_max : 16384;
+		char *paths;
+
+		while (idx.paths_len + len + 1 > max)
+			max *= 2;
+		paths = realloc(idx.paths, max);
+		if (!paths)
+			return -FDT_ERR_NOSPACE;
+		idx.paths = paths;
+		idx.paths_max = max;
+	}
+
+	node = &idx.node[idx.count++];
+	node->offset = offset;
+	node->phandle = phandle;
+	node->path = idx.paths_len;
+	memcpy(idx.paths + idx.paths_len, path, len);
+	idx.paths[idx.paths_len + len] = '\0';
+	idx.paths_len += len + 1;
+
+	return 0;
+}
+
+static int fdt_index_hash_nodes(void)
+{
+	u32 size = 64, mask, bucket;
+	int i;
+
+	while (size < 2 * idx.count)
+		size *= 2;
+	if (size > idx.hash_size) {
+		free(idx.path_hash);
+		free(idx.phandle_hash);
+		idx.path_hash = calloc(size, sizeof(int));
+		idx.phandle_hash = calloc(size, sizeof(int));
+		if (!idx.path_hash || !idx.phandle_hash) {
+			free(idx.path_hash);
+			free(idx.phandle_hash);
+			idx.path_hash = NULL;
+			idx.phandle_hash = NULL;
+			idx.hash_size = 0;
+			return -FDT_ERR_NOSPACE;
+		}
+		idx.hash_size = size;
+	} else {
+		memset(idx.path_hash, 0, idx.hash_size * sizeof(int));
+		memset(idx.phandle_hash, 0, idx.hash_size * sizeof(int));
+	}
+	mask = idx.hash_size - 1;
+
+	for (i = 0; i < idx.count; i++) {
+		const char *path = idx.paths + idx.node[i].path;
+		u32 phandle = idx.node[i].phandle;
+
+		/* paths are unique */
+		bucket = fdt_index_hash_path(path, strlen(path)) & mask;
+		while (idx.path_hash[bucket])
+			bucket = (bucket + 1) & mask;
+		idx.path_hash[bucket] = i + 1;
+
+		/* the first node of a phandle wins, as in libfdt */
+		if (!phandle || phandle == (u32)-1)
+			continue;
+		bucket = fdt_index_hash_phandle(phandle) & mask;
+		while (idx.phandle_hash[bucket] &&
+		       idx.node[idx.phandle_hash[bucket] - 1].phandle != phandle)
+			bucket = (bucket + 1) & mask;
+		if (!idx.phandle_hash[bucket])
+			idx.phandle_hash[bucket] = i + 1;
+	}
+
+	return 0;
+}
+
+static int fdt_index_build(const void *fdt)
+{
+	char path[FDT_INDEX_PATH_MAX];
+	int len[FDT_INDEX_MAX_DEPTH];
+	int offset, depth = 0, namelen, ret;
+	const char *name;
+
+	idx.count = 0;
+	idx.paths_len = 0;
+	for (offset = 0; offset >= 0 && depth >= 0;
+	     offset = fdt_next_node(fdt, offset, &depth)) {
+		if (depth >= FDT_INDEX_MAX_DEPTH)
+			return -FDT_ERR_BADSTRUCTURE;
+
+		if (!depth) {
+			len[0] = 0;
+			ret = fdt_index_add(offset, fdt_get_phandle(fdt, offset),
+					    "/", 1);
+		} else {
+			name = fdt_get_name(fdt, offset, &namelen);
+			if (!name)
+				return namelen;
+			len[depth] = len[depth - 1] + 1 + namelen;
+			if (len[depth] >= FDT_INDEX_PATH_MAX)
+				return -FDT_ERR_NOSPACE;
+			path[len[depth - 1]] = '/';
+			memcpy(path + len[depth - 1] + 1, name, namelen);
+			ret = fdt_index_add(offset, fdt_get_phandle(fdt, offset),
+					    path, len[depth]);
+		}
+		if (ret)
+			return ret;
+	}
+	if (offset < 0 && offset != -FDT_ERR_NOTFOUND)
+		return offset;
+
+	return fdt_index_hash_nodes();
+}
+
+/* Whether the index is up to date with @fdt, building it when worth it */
+static bool fdt_index_ready(const void *fdt)
+{
+	if (fdt_check_header(fdt))
+		return false;
+
+	if (idx.fdt != fdt || idx.size_struct != fdt_size_dt_struct(fdt) ||
+	    idx.size_strings != fdt_size_dt_strings(fdt)) {
+		fdt_index_invalidate();
+		idx.fdt = fdt;
+		idx.size_struct = fdt_size_dt_struct(fdt);
+		idx.size_strings = fdt_size_dt_strings(fdt);
+	}
+	if (idx.valid)
+		return true;
+	if (idx.failed || ++idx.stale_lookups < FDT_INDEX_REBUILD_LOOKUPS)
+		return false;
+
+	if (fdt_index_build(fdt)) {
+		debug("fdt index: build failed, using libfdt\n");
+		idx.failed = true;
+		return false;
+	}
+	debug("fdt index: %d nodes\n", idx.count);
+	idx.valid = true;
+
+	return true;
+}
+
+void fdt_index_invalidate(void)
+{
+	idx.valid = false;
+	idx.failed = false;
+	idx.stale_lookups = 0;
+}
+
+/*
+ * Offset of node @i, checked against the tree first: a write in place
+ * nobody told the index about leaves another node, or none, there. Then
+ * the index is built again on the next lookup and libfdt answers this one.
+ */
+static int fdt_index_hit(const void *fdt, int i)
+{
+	const struct fdt_index_node *node = &idx.node[i];
+	const char *path = idx.paths + node->path;
+	const char *base = strrchr(path, '/') + 1;
+	const char *name;
+	int len;
+
+	name = fdt_get_name(fdt, node->offset, &len);
+	if (name && len == strlen(base) && !memcmp(name, base, len) &&
+	    fdt_get_phandle(fdt, node->offset) == node->phandle)
+		return node->offset;
+
+	debug("fdt index: stale node@%d, rebuilding\n", node->offset);
+	fdt_index_invalidate();
+	idx.stale_lookups = FDT_INDEX_REBUILD_LOOKUPS;
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+static int fdt_index_find_path(const void *fdt, const char *path, int len)
+{
+	u32 mask = idx.hash_size - 1;
+	u32 bucket = fdt_index_hash_path(path, len) & mask;
+	const char *p;
+	int i;
+
+	while (idx.path_hash[bucket]) {
+		i = idx.path_hash[bucket] - 1;
+		p = idx.paths + idx.node[i].path;
+		if (!strncmp(p, path, len) && !p[len])
+			return fdt_index_hit(fdt, i);
+		bucket = (bucket + 1) & mask;
+	}
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+int fdt_index_path_offset(const void *fdt, const char *path)
+{
+	char full[FDT_INDEX_PATH_MAX];
+	const char *alias, *rest;
+	int offset, len, restlen;
+
+	if (!fdt_index_ready(fdt))
+		return fdt_path_offset(fdt, path);
+
+	if (*path == '/') {
+		offset = fdt_index_find_path(fdt, path, strlen(path));
+	} else {
+		/* alias, possibly followed by a path below it */
+		rest = strchr(path, '/');
+		if (!rest)
+			rest = path + strlen(path);
+		offset = fdt_index_find_path(fdt, "/aliases",
+					     strlen("/aliases"));
+		if (offset >= 0) {
+			alias = fdt_getprop_namelen(fdt, offset, path,
+						    rest - path, &len);
+			restlen = strlen(rest);
+			offset = -FDT_ERR_NOTFOUND;
+			if (alias && len > 0 && !alias[len - 1] &&
+			    len + restlen <= sizeof(full)) {
+				memcpy(full, alias, len - 1);
+				memcpy(full + len - 1, rest, restlen + 1);
+				offset = fdt_index_find_path(fdt, full,
+							     len - 1 + restlen);
+			}
+		}
+	}
+
+	/*
+	 * Not a full path of the index: a node name without its unit
+	 * address, a trailing '/', a missing or a stale node, left to libfdt.
+	 */
+	if (offset < 0)
+		return fdt_path_offset(fdt, path);
+
+	return offset;
+}
+
+int fdt_index_node_offset_by_phandle(const void *fdt, uint32_t phandle)
+{
+	u32 mask, bucket;
+	int offset, i;
+
+	if (!phandle || phandle == (uint32_t)-1)
+		return -FDT_ERR_BADPHANDLE;
+
+	if (!fdt_index_ready(fdt))
+		return fdt_node_offset_by_phandle(fdt, phandle);
+
+	mask = idx.hash_size - 1;
+	bucket = fdt_index_hash_phandle(phandle) & mask;
+	while (idx.phandle_hash[bucket]) {
+		i = idx.phandle_hash[bucket] - 1;
+		if (idx.node[i].phandle == phandle) {
+			offset = fdt_index_hit(fdt, i);
+			if (offset >= 0)
+				return offset;
+			break;
+		}
+		bucket = (bucket + 1) & mask;
+	}
+
+	/* a phandle set in place may be missing, libfdt has the last word */
+	return fdt_node_offset_by_phandle(fdt, phandle);
+}
+
+int fdt_index_get_path(const void *fdt, int nodeoffset, char *buf, int buflen)
+{
+	int lo = 0, hi, mid, len;
+	const char *path;
+
+	if (!fdt_index_ready(fdt))
+		return fdt_get_path(fdt, nodeoffset, buf, buflen);
+
+	hi = idx.count - 1;
+	while (lo <= hi) {
+		mid = (lo + hi) / 2;
+		if (idx.node[mid].offset == nodeoffset) {
+			if (fdt_index_hit(fdt, mid) < 0)
+				break;
+			path = idx.paths + idx.node[mid].path;
+			len = strlen(path);
+			if (len >= buflen)
+				return -FDT_ERR_NOSPACE;
+			memcpy(buf, path, len + 1);
+			return 0;
+		}
+		if (idx.node[mid].offset < nodeoffset)
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
+
+	/* not the offset of a node or a stale one, libfdt tells why */
+	return fdt_get_path(fdt, nodeoffset, buf, buflen);
+}
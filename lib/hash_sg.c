@@ -0,0 +1,223 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Scatter-gather SHA256, see include/hash_sg.h
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <hash_sg.h>
+#include <watchdog.h>
+#include <asm/unaligned.h>
+#include <u-boot/sha256.h>
+
+int __weak hash_sg_hw_submit(struct hash_sg_req *req)
+{
+	return -ENOSYS;
+}
+
+int __weak hash_sg_hw_poll(struct hash_sg_req *req)
+{
+	return -ENOSYS;
+}
+
+static void hash_sg_soft(struct hash_sg_req *req)
+{
+	const struct hash_sg *sg;
+	sha256_context ctx;
+	const u8 *p;
+	u32 left, chunk;
+	int i;
+
+	sha256_starts(&ctx);
+	if (req->iv) {
+		for (i = 0; i < ARRAY_SIZE(ctx.state); i++)
+			ctx.state[i] = get_unaligned_be32(req->iv + 4 * i);
+		ctx.total[0] = lower_32_bits(req->ctx->done);
+		ctx.total[1] = upper_32_bits(req->ctx->done);
+	}
+	for (sg = req->sg; sg < req->sg + req->nr_sg; sg++) {
+		for (p = sg->addr, left = sg->len; left; p += chunk, left -= chunk) {
+			chunk = min_t(u32, left, CHUNKSZ_SHA256);
+			sha256_update(&ctx, p, chunk);
+			WATCHDOG_RESET();
+		}
+	}
+	if (req->last) {
+		sha256_finish(&ctx, req->digest);
+		return;
+	}
+	/* whole blocks only, nothing is left in ctx.buffer */
+	for (i = 0; i < ARRAY_SIZE(ctx.state); i++)
+		put_unaligned_be32(ctx.state[i], req->digest + 4 * i);
+}
+
+static void hash_sg_finish(struct hash_sg_req *req, int ret)
+{
+	req->priv = NULL;
+	req->state = HASH_SG_DONE;
+	req->ret = ret;
+	if (!ret && req->ctx)
+		req->ctx->done += req->len;
+}
+
+static int __hash_sg_submit(struct hash_sg_req *req, struct hash_sg_ctx *ctx,
+			    const struct hash_sg *sg, int nr_sg, u8 *digest)
+{
+	u64 len = 0;
+	int i, ret;
+
+	if (req->state == HASH_SG_BUSY)
+		return -EBUSY;
+
+	for (i = 0; i < nr_sg; i++)
+		len += sg[i].len;
+	if (len > U32_MAX)
+		return -EINVAL;
+	/* only the part ending the message may end off a block */
+	if (ctx && (len > ctx->total - ctx->done ||
+		    (ctx->done + len != ctx->total && len % HASH_SG_BLOCK)))
+		return -EINVAL;
+
+	memset(req, 0, sizeof(*req));
+	req->sg = sg;
+	req->nr_sg = nr_sg;
+	req->len = len;
+	req->msg_len = len;
+	req->last = 1;
+	req->digest = digest;
+	if (ctx) {
+		req->ctx = ctx;
+		req->iv = ctx->done ? ctx->state : NULL;
+		req->msg_len = ctx->total;
+		req->last = ctx->done + len == ctx->total;
+		req->digest = req->last ? ctx->digest : ctx->state;
+	}
+	req->state = HASH_SG_BUSY;
+
+	ret = hash_sg_hw_submit(req);
+	if (ret) {
+		/* -EINVAL is a list the backend can't take */
+		if (ret != -ENOSYS && ret != -EINVAL)
+			printf("hash sg: hardware refused %d, hash in software\n",
+			       ret);
+		hash_sg_soft(req);
+		hash_sg_finish(req, 0);
+	}
+
+	return 0;
+}
+
+int hash_sg_submit(struct hash_sg_req *req, const struct hash_sg *sg,
+		   int nr_sg, u8 *digest)
+{
+	return __hash_sg_submit(req, NULL, sg, nr_sg, digest);
+}
+
+void hash_sg_ctx_init(struct hash_sg_ctx *ctx, u64 total, u8 *digest)
+{
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->total = total;
+	ctx->digest = digest;
+}
+
+int hash_sg_ctx_submit(struct hash_sg_req *req, struct hash_sg_ctx *ctx,
+		       const struct hash_sg *sg, int nr_sg)
+{
+	return __hash_sg_submit(req, ctx, sg, nr_sg, NULL);
+}
+
+int hash_sg_poll(struct hash_sg_req *req)
+{
+	int ret;
+
+	if (req->state == HASH_SG_IDLE)
+		return -EINVAL;
+	if (req->state == HASH_SG_DONE)
+		return req->ret;
+
+	ret = hash_sg_hw_poll(req);
+	if (ret == -EBUSY)
+		return ret;
+	if (ret) {
+		printf("hash sg: hardware failed %d, hash in software\n", ret);
+		hash_sg_soft(req);
+	}
+	hash_sg_finish(req, 0);
+
+	return 0;
+}
+
+int hash_sg_wait(struct hash_sg_req *req)
+{
+	int ret;
+
+	do {
+		ret = hash_sg_poll(req);
+	} while (ret == -EBUSY);
+
+	return ret;
+}
+
+int hash_sg_sha256(const struct hash_sg *sg, int nr_sg, u8 *digest)
+{
+	struct hash_sg_req req = { 0 };
+	int ret;
+
+	ret = hash_sg_submit(&req, sg, nr_sg, digest);
+	if (ret)
+		return ret;
+
+	return hash_sg_wait(&req);
+}
+
+int hash_sg_plan(const struct hash_sg *sg, int nr_sg, struct hash_sg *piece,
+		 u8 *bounce)
+{
+	const struct hash_sg *end = sg + nr_sg;
+	int nr_piece = 0;
+	u32 fill = 0, len, n;
+	const u8 *p;
+
+	for (; sg < end; sg++) {
+		p = sg->addr;
+		len = sg->len;
+
+		/* complete the block started by the buffers before */
+		if (fill) {
+			n = min_t(u32, HASH_SG_BLOCK - fill, len);
+			memcpy(bounce + fill, p, n);
+			fill += n;
+			p += n;
+			len -= n;
+			if (fill < HASH_SG_BLOCK)
+				continue;
+			piece[nr_piece].addr = bounce;
+			piece[nr_piece++].len = HASH_SG_BLOCK;
+			bounce += HASH_SG_BLOCK;
+			fill = 0;
+		}
+
+		n = round_down(len, HASH_SG_BLOCK);
+		if (n) {
+			if ((ulong)p & 3)
+				return -EINVAL;
+			piece[nr_piece].addr = p;
+			piece[nr_piece++].len = n;
+			p += n;
+			len -= n;
+		}
+
+		memcpy(bounce, p, len);
+		fill = len;
+	}
+
+	if (fill) {
+		piece[nr_piece].addr = bounce;
+		piece[nr_piece++].len = fill;
+	}
+
+	return nr_piece;
+}
@@ -53,6 +53,7 @@ static const int LZ4_minLength = (MFLIMIT+1);
 typedef enum { noDict = 0, withPrefix64k, usingExtDict } dict_directive;
 typedef enum { endOnOutputSize = 0, endOnInputSize = 1 } endCondition_directive;
 typedef enum { full = 0, partial = 1 } earlyEnd_directive;
+typedef enum { narrowCopy = 0, wideCopy = 1 } copy_directive;
 
 
 
@@ -77,7 +78,8 @@ FORCE_INLINE int LZ4_decompress_generic(
                  int dict,               /* noDict, withPrefix64k, usingExtDict */
                  const BYTE* const lowPrefix,  /* == dest if dict == noDict */
                  const BYTE* const dictStart,  /* only if dict==usingExtDict */
-                 const size_t dictSize         /* note : = 0 if noDict */
+                 const size_t dictSize,        /* note : = 0 if noDict */
+                 int copy                      /* narrowCopy, wideCopy (LZ4_wildCopyWide) */
                  )
 {
     /* Local Variables */
@@ -146,7 +148,8 @@ FORCE_INLINE int LZ4_decompress_generic(
             op += length;
             break;     /* Necessarily EOF, due to parsing restrictions */
         }
-        LZ4_wildCopy(op, ip, cpy);
+        if (copy==wideCopy) LZ4_wildCopyWide(op, ip, cpy);
+        else LZ4_wildCopy(op, ip, cpy);
         ip += length; op = cpy;
 
         /* get offset */
@@ -220,12 +223,15 @@ FORCE_INLINE int LZ4_decompress_generic(
             if (cpy > oend-LASTLITERALS) goto _output_error;    /* Error : last LASTLITERALS bytes must be literals */
             if (op < oend-8)
             {
-                LZ4_wildCopy(op, match, oend-8);
+                if (copy==wideCopy) LZ4_wildCopyWide(op, match, oend-8);
+                else LZ4_wildCopy(op, match, oend-8);
                 match += (oend-8) - op;
                 op = oend-8;
             }
             while (op<cpy) *op++ = *match++;
         }
+        else if (copy==wideCopy)
+            LZ4_wildCopyWide(op, match, cpy);
         else
             LZ4_wildCopy(op, match, cpy);
         op=cpy;   /* correction */
@@ -5,12 +5,19 @@
 
 #include <common.h>
 #include <compiler.h>
+#include <decomp_fast.h>
+#include <malloc.h>
+#include <worker_pool.h>
 #include <linux/kernel.h>
 #include <linux/types.h>
 
 static u16 LZ4_readLE16(const void *src) { return le16_to_cpu(*(u16 *)src); }
 static void LZ4_copy4(void *dst, const void *src) { *(u32 *)dst = *(u32 *)src; }
 static void LZ4_copy8(void *dst, const void *src) { *(u64 *)dst = *(u64 *)src; }
+static void LZ4_wildCopyWide(void *dst, const void *src, void *end)
+{
+	decomp_wild_copy(dst, src, end);
+}
 
 typedef  uint8_t BYTE;
 typedef uint16_t U16;
@@ -20,7 +27,10 @@ typedef uint64_t U64;
 
 #define FORCE_INLINE static inline __attribute__((always_inline))
 
-/* Unaltered (except removing unrelated code) from github.com/Cyan4973/lz4. */
+/*
+ * Unaltered (except removing unrelated code and adding the copy directive)
+ * from github.com/Cyan4973/lz4.
+ */
 #include "lz4.c"	/* #include for inlining, do not link! */
 
 #define LZ4F_MAGIC 0x184D2204
@@ -62,12 +72,132 @@ struct lz4_block_header {
 	/* + u32 block_checksum iff has_block_checksum is set */
 } __packed;
 
+#ifdef CONFIG_WORKER_POOL
+/*
+ * Independent blocks can be decompressed side by side: every block but
+ * the last one fills a whole block of output, so where each one goes is
+ * known up front. Anything unexpected, including errors, is left to the
+ * plain loop below, which has the final word.
+ */
+struct ulz4_block {
+	const void *in;
+	u32 size;
+	u32 not_compressed;
+	int ret;
+};
+
+struct ulz4_batch {
+	struct ulz4_block *blk;
+	void *dst;
+	const void *end;
+	size_t block_bytes;
+};
+
+static void ulz4_block_job(void *priv, int i)
+{
+	struct ulz4_batch *batch = priv;
+	struct ulz4_block *b = &batch->blk[i];
+	void *out = batch->dst + i * batch->block_bytes;
+	size_t room;
+
+	if (out >= batch->end) {
+		b->ret = -ENOBUFS;
+		return;
+	}
+	room = min((size_t)(batch->end - out), batch->block_bytes);
+
+	if (b->not_compressed) {
+		if (b->size > room) {
+			b->ret = -ENOBUFS;
+			return;
+		}
+		memcpy(out, b->in, b->size);
+		b->ret = b->size;
+	} else {
+		if (decomp_fast_enabled())
+			b->ret = LZ4_decompress_generic(b->in, out, b->size,
+					room, endOnInputSize, full, 0, noDict,
+					out, NULL, 0, wideCopy);
+		else
+			b->ret = LZ4_decompress_generic(b->in, out, b->size,
+					room, endOnInputSize, full, 0, noDict,
+					out, NULL, 0, narrowCopy);
+		if (b->ret < 0)
+			b->ret = -EPROTO;
+	}
+}
+
+static int ulz4fn_parallel(const void *src, size_t srcn, const void *in,
+			   void *dst, const void *end, int has_block_checksum,
+			   size_t block_bytes, size_t *dstn)
+{
+	struct ulz4_batch batch;
+	struct lz4_block_header b;
+	const void *p;
+	size_t out = 0;
+	int nr = 0, i, ret = -EAGAIN;
+
+	/* in-place decompression overwrites blocks not yet read */
+	if (worker_pool_size() < 2 ||
+	    (src < end && src + srcn > (const void *)dst))
+		return -EAGAIN;
+
+	for (p = in; ; nr++) {
+		b.raw = le32_to_cpu(*(u32 *)p);
+		p += sizeof(struct lz4_block_header);
+		if (p - src + b.size > srcn)
+			return -EAGAIN;
+		if (!b.size)
+			break;
+		p += b.size;
+		if (has_block_checksum)
+			p += sizeof(u32);
+	}
+	if (nr < 2)
+		return -EAGAIN;
+
+	batch.blk = malloc(nr * sizeof(*batch.blk));
+	if (!batch.blk)
+		return -EAGAIN;
+	batch.dst = dst;
+	batch.end = end;
+	batch.block_bytes = block_bytes;
+
+	for (p = in, i = 0; i < nr; i++) {
+		b.raw = le32_to_cpu(*(u32 *)p);
+		p += sizeof(struct lz4_block_header);
+		batch.blk[i].in = p;
+		batch.blk[i].size = b.size;
+		batch.blk[i].not_compressed = b.not_compressed;
+		p += b.size;
+		if (has_block_checksum)
+			p += sizeof(u32);
+	}
+
+	worker_pool_run(ulz4_block_job, &batch, nr);
+
+	for (i = 0; i < nr; i++) {
+		if (batch.blk[i].ret < 0 ||
+		    (i < nr - 1 && (size_t)batch.blk[i].ret != block_bytes))
+			goto out;
+		out += batch.blk[i].ret;
+	}
+	*dstn = out;
+	ret = 0;
+out:
+	free(batch.blk);
+
+	return ret;
+}
+#endif
+
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 {
 	const void *end = dst + *dstn;
 	const void *in = src;
 	void *out = dst;
 	int has_block_checksum;
+	__maybe_unused size_t block_bytes;
 	int ret;
 	*dstn = 0;
 
@@ -85,6 +215,7 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 		if (!h->independent_blocks)
 			return -EPROTONOSUPPORT; /* we can't support this yet */
 		has_block_checksum = h->has_block_checksum;
+		block_bytes = 1 << (2 * h->max_block_size + 8);
 
 		in += sizeof(*h);
 		if (h->has_content_size)
@@ -92,6 +223,12 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 		in += sizeof(u8);
 	}
 
+#ifdef CONFIG_WORKER_POOL
+	if (!ulz4fn_parallel(src, srcn, in, dst, end, has_block_checksum,
+			     block_bytes, dstn))
+		return 0;
+#endif
+
 	while (1) {
 		struct lz4_block_header b;
 
@@ -118,9 +255,16 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 			}
 		} else {
 			/* constant folding essential, do not touch params! */
-			ret = LZ4_decompress_generic(in, out, b.size,
-					end - out, endOnInputSize,
-					full, 0, noDict, out, NULL, 0);
+			if (decomp_fast_enabled())
+				ret = LZ4_decompress_generic(in, out, b.size,
+						end - out, endOnInputSize,
+						full, 0, noDict, out, NULL, 0,
+						wideCopy);
+			else
+				ret = LZ4_decompress_generic(in, out, b.size,
+						end - out, endOnInputSize,
+						full, 0, noDict, out, NULL, 0,
+						narrowCopy);
 			if (ret < 0) {
 				ret = -EPROTO;	/* decompression error */
 				break;
@@ -27,6 +27,173 @@ static void *unflatten_dt_alloc(void **mem, unsigned long size,
 	return res;
 }
 
+#define UNFLATTEN_MAX_DEPTH	32
+
+/**
+ * unflatten_dt_walk() - Alloc and populate the device_nodes of a flat tree
+ *
+ * Reads the tags of the struct block directly, in one walk, where
+ * unflatten_dt_node() goes through libfdt, which reads every node name a
+ * byte at a time. No "name" property is made up for nodes without one.
+ *
+ * @blob: The device tree blob, checked by fdt_check_header()
+ * @mem: Memory chunk to use for allocating device nodes and properties,
+ * returns its end
+ * @dryrun: If true, do not allocate device nodes but still calculate needed
+ * memory size
+ * @return root node (NULL on a dry run), or ERR_PTR on a bad struct block
+ */
+static struct device_node *unflatten_dt_walk(const void *blob, void **mem,
+					     bool dryrun)
+{
+	const char *base = blob + fdt_off_dt_struct(blob);
+	const char *strings = blob + fdt_off_dt_strings(blob);
+	u32 size = fdt_size_dt_struct(blob);
+	u32 size_strings = fdt_size_dt_strings(blob);
+	struct device_node *parent[UNFLATTEN_MAX_DEPTH];
+	struct device_node *last[UNFLATTEN_MAX_DEPTH];
+	int fpsize[UNFLATTEN_MAX_DEPTH];
+	struct device_node *np = NULL, *root = NULL;
+	struct property *pp, **prev_pp = NULL;
+	const struct fdt_property *prop;
+	int depth = -1, l, len;
+	bool props = false, done = false;
+	const char *pathp;
+	char *fn;
+	u32 offset = 0, tag, nameoff;
+
+	while (offset + FDT_TAGSIZE <= size) {
+		tag = fdt32_to_cpu(*(const fdt32_t *)(base + offset));
+		switch (tag) {
+		case FDT_BEGIN_NODE:
+			pathp = base + offset + FDT_TAGSIZE;
+			l = strnlen(pathp, size - offset - FDT_TAGSIZE);
+			if (offset + FDT_TAGSIZE + l == size || done ||
+			    depth + 1 == UNFLATTEN_MAX_DEPTH)
+				return ERR_PTR(-EINVAL);
+			offset += FDT_TAGSIZE + ALIGN(l + 1, FDT_TAGSIZE);
+
+			/* the root is "/", other nodes "/" after their parent */
+			len = depth < 0 ? 1 : fpsize[depth] + 1 + l;
+			np = unflatten_dt_alloc(mem, sizeof(*np) + len + 1,
+						__alignof__(struct device_node));
+			depth++;
+			fpsize[depth] = depth ? len : 0;
+			last[depth] = NULL;
+			props = true;
+			if (dryrun)
+				break;
+
+			fn = (char *)np + sizeof(*np);
+			np->full_name = fn;
+			if (depth) {
+				memcpy(fn, parent[depth - 1]->full_name,
+				       fpsize[depth - 1]);
+				fn += fpsize[depth - 1];
+				*(fn++) = '/';
+				memcpy(fn, pathp, l + 1);
+				np->name = fn;
+			} else {
+				strcpy(fn, "/");
+				np->name = "";
+				root = np;
+			}
+			np->type = "<NULL>";
+			if (depth) {
+				np->parent = parent[depth - 1];
+				if (last[depth - 1])
+					last[depth - 1]->sibling = np;
+				else
+					np->parent->child = np;
+				last[depth - 1] = np;
+			}
+			parent[depth] = np;
+			prev_pp = &np->properties;
+			break;
+		case FDT_PROP:
+			prop = (const void *)(base + offset);
+			if (offset + sizeof(*prop) > size || !props)
+				return ERR_PTR(-EINVAL);
+			len = fdt32_to_cpu(prop->len);
+			nameoff = fdt32_to_cpu(prop->nameoff);
+			if (len < 0 || len > size - offset - sizeof(*prop) ||
+			    nameoff >= size_strings)
+				return ERR_PTR(-EINVAL);
+			offset += sizeof(*prop) + ALIGN(len, FDT_TAGSIZE);
+
+			pp = unflatten_dt_alloc(mem, sizeof(struct property),
+						__alignof__(struct property));
+			if (dryrun)
+				break;
+
+			pp->name = (char *)strings + nameoff;
+			pp->length = len;
+			pp->value = (void *)prop->data;
+			*prev_pp = pp;
+			prev_pp = &pp->next;
+			if ((!strcmp(pp->name, "phandle") ||
+			     !strcmp(pp->name, "linux,phandle")) &&
+			    !np->phandle && len == sizeof(fdt32_t))
+				np->phandle = be32_to_cpup(pp->value);
+			else if (!strcmp(pp->name, "device_type"))
+				np->type = pp->value;
+			break;
+		case FDT_END_NODE:
+			if (depth < 0)
+				return ERR_PTR(-EINVAL);
+			offset += FDT_TAGSIZE;
+			/* properties come before the subnodes */
+			props = false;
+			done = --depth < 0;
+			break;
+		case FDT_NOP:
+			offset += FDT_TAGSIZE;
+			break;
+		case FDT_END:
+			if (!done)
+				return ERR_PTR(-EINVAL);
+			return root;
+		default:
+			return ERR_PTR(-EINVAL);
+		}
+	}
+
+	return ERR_PTR(-EINVAL);
+}
+
+int of_live_unflatten(const void *fdt_blob, struct device_node **rootp)
+{
+	struct device_node *root;
+	void *start, *mem = NULL;
+	unsigned long size;
+
+	if (fdt_check_header(fdt_blob))
+		return -EINVAL;
+
+	/* First pass, scan for size */
+	root = unflatten_dt_walk(fdt_blob, &mem, true);
+	if (IS_ERR(root))
+		return PTR_ERR(root);
+	size = (unsigned long)mem;
+
+	start = malloc(size);
+	if (!start)
+		return -ENOMEM;
+	memset(start, '\0', size);
+
+	/* Second pass, do actual unflattening */
+	mem = start;
+	root = unflatten_dt_walk(fdt_blob, &mem, false);
+	if (IS_ERR(root)) {
+		free(start);
+		return PTR_ERR(root);
+	}
+	*rootp = root;
+
+	return 0;
+}
+
+#if CONFIG_IS_ENABLED(OF_LIVE)
 /**
  * unflatten_dt_node() - Alloc and populate a device_node from the flat tree
  * @blob: The parent device tree blob
@@ -333,3 +500,4 @@ int of_live_build(const void *fdt_blob, struct device_node **rootp)
 
 	return ret;
 }
+#endif
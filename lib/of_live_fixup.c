@@ -0,0 +1,421 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Device tree fixups on a live tree, see include/of_live_fixup.h
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <fdt_index.h>
+#include <of_live.h>
+#include <of_live_fixup.h>
+#include <dm/of.h>
+
+struct of_live_fixup_mem {
+	struct of_live_fixup_mem *next;
+	/* property name or value */
+	u8 data[] __aligned(8);
+};
+
+/* name of a new property, after its offset in the strings of the result */
+struct of_live_fixup_name {
+	u32 off;
+	char name[];
+};
+
+static void *of_live_fixup_alloc(struct of_live_fixup *lf, int size)
+{
+	struct of_live_fixup_mem *mem;
+
+	mem = malloc(sizeof(*mem) + size);
+	if (!mem)
+		return NULL;
+	mem->next = lf->mem;
+	lf->mem = mem;
+
+	return mem->data;
+}
+
+static const char *of_live_fixup_strtab(const struct of_live_fixup *lf)
+{
+	return lf->fdt + fdt_off_dt_strings(lf->fdt);
+}
+
+/* Whether @name is in the strings of the blob, as unflattened */
+static bool of_live_fixup_flat_name(const struct of_live_fixup *lf,
+				    const char *name)
+{
+	const char *strtab = of_live_fixup_strtab(lf);
+
+	return name >= strtab && name < strtab + fdt_size_dt_strings(lf->fdt);
+}
+
+/* Next node of the tree in the order of the blob */
+static struct device_node *of_live_fixup_next(struct device_node *np)
+{
+	if (np->child)
+		return np->child;
+	while (np && !np->sibling)
+		np = np->parent;
+
+	return np ? np->sibling : NULL;
+}
+
+/* The search of libfdt for a string, suffixes of longer strings included */
+static const char *of_live_fixup_find_string(const char *strtab, int size,
+					     const char *s, int len)
+{
+	int i;
+
+	for (i = 0; i <= size - len; i++) {
+		if (!memcmp(strtab + i, s, len))
+			return strtab + i;
+	}
+
+	return NULL;
+}
+
+/* Offset of @name in the strings of the result, added if it is new */
+static int of_live_fixup_string(struct of_live_fixup *lf, const char *name)
+{
+	int size = fdt_size_dt_strings(lf->fdt);
+	int len = strlen(name) + 1;
+	const char *p;
+	char *strings;
+
+	p = of_live_fixup_find_string(of_live_fixup_strtab(lf), size, name,
+				      len);
+	if (p)
+		return p - of_live_fixup_strtab(lf);
+	p = of_live_fixup_find_string(lf->strings, lf->strings_len, name, len);
+	if (p)
+		return size + (p - lf->strings);
+
+	if (lf->strings_len + len > lf->strings_max) {
+		int max = max(lf->strings_max * 2, lf->strings_len + len + 256);
+
+		strings = realloc(lf->strings, max);
+		if (!strings)
+			return -FDT_ERR_NOSPACE;
+		lf->strings = strings;
+		lf->strings_max = max;
+	}
+	memcpy(lf->strings + lf->strings_len, name, len);
+	lf->strings_len += len;
+
+	return size + lf->strings_len - len;
+}
+
+int of_live_fixup_open(struct of_live_fixup *lf, void *fdt)
+{
+	int ret;
+
+	memset(lf, 0, sizeof(*lf));
+	ret = fdt_check_header(fdt);
+	if (ret)
+		return ret;
+	/* what libfdt takes for writing */
+	if (fdt_version(fdt) < 17)
+		return -FDT_ERR_BADVERSION;
+	if (fdt_off_mem_rsvmap(fdt) < ALIGN(sizeof(struct fdt_header), 8) ||
+	    fdt_off_dt_struct(fdt) < fdt_off_mem_rsvmap(fdt) +
+	    (fdt_num_mem_rsv(fdt) + 1) * sizeof(struct fdt_reserve_entry) ||
+	    fdt_off_dt_strings(fdt) <
+	    fdt_off_dt_struct(fdt) + fdt_size_dt_struct(fdt) ||
+	    fdt_totalsize(fdt) <
+	    fdt_off_dt_strings(fdt) + fdt_size_dt_strings(fdt))
+		return -FDT_ERR_BADLAYOUT;
+
+	ret = of_live_unflatten(fdt, &lf->root);
+	if (ret)
+		return -FDT_ERR_INTERNAL;
+	lf->fdt = fdt;
+
+	return 0;
+}
+
+/* fdt_subnode_offset_namelen() */
+static struct device_node *of_live_fixup_subnode(struct device_node *parent,
+						 const char *name, int len)
+{
+	struct device_node *np;
+	const char *p;
+
+	for (np = parent->child; np; np = np->sibling) {
+		p = np->name;
+		if (strncmp(p, name, len))
+			continue;
+		/* the unit address may be left out */
+		if (!p[len] || (p[len] == '@' && !memchr(name, '@', len)))
+			return np;
+	}
+
+	return NULL;
+}
+
+static struct device_node *of_live_fixup_walk(struct device_node *np,
+					      const char *p)
+{
+	const char *q;
+
+	while (np && *p) {
+		while (*p == '/')
+			p++;
+		if (!*p)
+			break;
+		q = strchrnul(p, '/');
+		np = of_live_fixup_subnode(np, p, q - p);
+		p = q;
+	}
+
+	return np;
+}
+
+struct device_node *of_live_fixup_find_node(struct of_live_fixup *lf,
+					    const char *path)
+{
+	struct device_node *aliases;
+	struct property *pp;
+	const char *q;
+
+	if (*path == '/')
+		return of_live_fixup_walk(lf->root, path);
+
+	q = strchrnul(path, '/');
+	aliases = of_live_fixup_subnode(lf->root, "aliases", strlen("aliases"));
+	if (!aliases)
+		return NULL;
+	for (pp = aliases->properties; pp; pp = pp->next) {
+		if (!strncmp(pp->name, path, q - path) && !pp->name[q - path])
+			break;
+	}
+	if (!pp || !pp->length || ((char *)pp->value)[pp->length - 1])
+		return NULL;
+
+	return of_live_fixup_walk(of_live_fixup_walk(lf->root, pp->value), q);
+}
+
+int of_live_fixup_setprop(struct of_live_fixup *lf, struct device_node *np,
+			  const char *name, const void *val, int len)
+{
+	struct of_live_fixup_name *fn;
+	struct property *pp;
+	void *value = NULL;
+	int off;
+
+	if (len < 0)
+		return -FDT_ERR_BADVALUE;
+	if (len) {
+		value = of_live_fixup_alloc(lf, len);
+		if (!value)
+			return -FDT_ERR_NOSPACE;
+		memcpy(value, val, len);
+	}
+
+	for (pp = np->properties; pp; pp = pp->next) {
+		if (!strcmp(pp->name, name))
+			break;
+	}
+	if (!pp) {
+		off = of_live_fixup_string(lf, name);
+		if (off < 0)
+			return off;
+		pp = of_live_fixup_alloc(lf, sizeof(*pp));
+		fn = of_live_fixup_alloc(lf, sizeof(*fn) + strlen(name) + 1);
+		if (!pp || !fn)
+			return -FDT_ERR_NOSPACE;
+		fn->off = off;
+		strcpy(fn->name, name);
+		pp->name = fn->name;
+		pp->next = np->properties;
+		np->properties = pp;
+	}
+	pp->value = value;
+	pp->length = len;
+	lf->changed = true;
+
+	return 0;
+}
+
+int of_live_fixup_add_mem_rsv(struct of_live_fixup *lf, u64 address,
+			      u64 size)
+{
+	struct fdt_reserve_entry *rsv;
+
+	if (lf->nr_rsv == lf->max_rsv) {
+		int max = lf->max_rsv ? lf->max_rsv * 2 : 8;
+
+		rsv = realloc(lf->rsv, max * sizeof(*rsv));
+		if (!rsv)
+			return -FDT_ERR_NOSPACE;
+		lf->rsv = rsv;
+		lf->max_rsv = max;
+	}
+	rsv = &lf->rsv[lf->nr_rsv++];
+	rsv->address = cpu_to_fdt64(address);
+	rsv->size = cpu_to_fdt64(size);
+	lf->changed = true;
+
+	return 0;
+}
+
+static int of_live_fixup_struct_size(struct of_live_fixup *lf)
+{
+	struct device_node *np;
+	struct property *pp;
+	int size = FDT_TAGSIZE;
+	int len;
+
+	for (np = lf->root; np; np = of_live_fixup_next(np)) {
+		len = strlen(np->name) + 1;
+		size += 2 * FDT_TAGSIZE + ALIGN(len, FDT_TAGSIZE);
+		for (pp = np->properties; pp; pp = pp->next)
+			size += sizeof(struct fdt_property) +
+				ALIGN(pp->length, FDT_TAGSIZE);
+	}
+
+	return size;
+}
+
+static char *of_live_fixup_put32(char *p, u32 val)
+{
+	*(fdt32_t *)p = cpu_to_fdt32(val);
+
+	return p + FDT_TAGSIZE;
+}
+
+/* Copy @len bytes and pad them to a tag */
+static char *of_live_fixup_put(char *p, const void *data, int len)
+{
+	memcpy(p, data, len);
+	memset(p + len, 0, ALIGN(len, FDT_TAGSIZE) - len);
+
+	return p + ALIGN(len, FDT_TAGSIZE);
+}
+
+static char *of_live_fixup_put_node(struct of_live_fixup *lf,
+				    struct device_node *np, char *p)
+{
+	const char *structs = lf->fdt + fdt_off_dt_struct(lf->fdt);
+	const char *name = np->name;
+	struct device_node *child;
+	struct property *pp;
+	int off;
+
+	p = of_live_fixup_put32(p, FDT_BEGIN_NODE);
+	p = of_live_fixup_put(p, name, strlen(name) + 1);
+
+	for (pp = np->properties; pp; pp = pp->next) {
+		if (of_live_fixup_flat_name(lf, pp->name))
+			off = pp->name - of_live_fixup_strtab(lf);
+		else
+			off = container_of(pp->name, struct of_live_fixup_name,
+					   name[0])->off;
+		p = of_live_fixup_put32(p, FDT_PROP);
+		p = of_live_fixup_put32(p, pp->length);
+		p = of_live_fixup_put32(p, off);
+		/* values left alone keep their padding */
+		if ((char *)pp->value >= structs &&
+		    (char *)pp->value < structs + fdt_size_dt_struct(lf->fdt)) {
+			memcpy(p, pp->value, ALIGN(pp->length, FDT_TAGSIZE));
+			p += ALIGN(pp->length, FDT_TAGSIZE);
+		} else {
+			p = of_live_fixup_put(p, pp->value, pp->length);
+		}
+	}
+
+	for (child = np->child; child; child = child->sibling)
+		p = of_live_fixup_put_node(lf, child, p);
+
+	return of_live_fixup_put32(p, FDT_END_NODE);
+}
+
+int of_live_fixup_close(struct of_live_fixup *lf)
+{
+	const struct fdt_reserve_entry *rsv_end;
+	void *fdt = lf->fdt;
+	int rsv_size, gap_rsv, gap_struct, struct_size, size;
+	struct fdt_header *hdr;
+	char *out, *p;
+
+	if (!lf->changed) {
+		of_live_fixup_abort(lf);
+		return 0;
+	}
+
+	/* the blocks move as libfdt would move them, gaps included */
+	rsv_size = (fdt_num_mem_rsv(fdt) + lf->nr_rsv + 1) *
+		   sizeof(struct fdt_reserve_entry);
+	rsv_end = (struct fdt_reserve_entry *)(fdt + fdt_off_mem_rsvmap(fdt)) +
+		  fdt_num_mem_rsv(fdt);
+	gap_rsv = fdt_off_dt_struct(fdt) -
+		  ((char *)(rsv_end + 1) - (char *)fdt);
+	gap_struct = fdt_off_dt_strings(fdt) -
+		     (fdt_off_dt_struct(fdt) + fdt_size_dt_struct(fdt));
+	struct_size = of_live_fixup_struct_size(lf);
+	size = fdt_off_mem_rsvmap(fdt) + rsv_size + gap_rsv + struct_size +
+	       gap_struct + fdt_size_dt_strings(fdt) + lf->strings_len;
+	if (size > fdt_totalsize(fdt)) {
+		of_live_fixup_abort(lf);
+		return -FDT_ERR_NOSPACE;
+	}
+
+	out = malloc(size);
+	if (!out) {
+		of_live_fixup_abort(lf);
+		return -FDT_ERR_NOSPACE;
+	}
+
+	memcpy(out, fdt, fdt_off_mem_rsvmap(fdt));
+	p = out + fdt_off_mem_rsvmap(fdt);
+	memcpy(p, fdt + fdt_off_mem_rsvmap(fdt),
+	       (char *)rsv_end - (char *)fdt - fdt_off_mem_rsvmap(fdt));
+	p += (char *)rsv_end - (char *)fdt - fdt_off_mem_rsvmap(fdt);
+	memcpy(p, lf->rsv, lf->nr_rsv * sizeof(*lf->rsv));
+	p += lf->nr_rsv * sizeof(*lf->rsv);
+	memcpy(p, rsv_end, sizeof(*rsv_end) + gap_rsv);
+	p += sizeof(*rsv_end) + gap_rsv;
+
+	hdr = (struct fdt_header *)out;
+	hdr->off_dt_struct = cpu_to_fdt32(p - out);
+	hdr->size_dt_struct = cpu_to_fdt32(struct_size);
+	p = of_live_fixup_put_node(lf, lf->root, p);
+	p = of_live_fixup_put32(p, FDT_END);
+
+	memcpy(p, fdt + fdt_off_dt_struct(fdt) + fdt_size_dt_struct(fdt),
+	       gap_struct);
+	p += gap_struct;
+	hdr->off_dt_strings = cpu_to_fdt32(p - out);
+	hdr->size_dt_strings = cpu_to_fdt32(fdt_size_dt_strings(fdt) +
+					    lf->strings_len);
+	memcpy(p, of_live_fixup_strtab(lf), fdt_size_dt_strings(fdt));
+	p += fdt_size_dt_strings(fdt);
+	memcpy(p, lf->strings, lf->strings_len);
+	if (fdt_version(fdt) > 17)
+		hdr->version = cpu_to_fdt32(17);
+
+	/* the live tree points into the blob until here */
+	of_live_fixup_abort(lf);
+	memcpy(fdt, out, size);
+	free(out);
+	fdt_index_invalidate();
+
+	return 0;
+}
+
+void of_live_fixup_abort(struct of_live_fixup *lf)
+{
+	struct of_live_fixup_mem *mem;
+
+	while (lf->mem) {
+		mem = lf->mem;
+		lf->mem = mem->next;
+		free(mem);
+	}
+	free(lf->root);
+	free(lf->strings);
+	free(lf->rsv);
+	memset(lf, 0, sizeof(*lf));
+}
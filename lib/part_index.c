@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Partition lookup index, see include/part_index.h
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <part_index.h>
+
+static u32 part_index_hash(const char *name)
+{
+	u32 hash = 2166136261u;
+	int i;
+
+	/* FNV-1a over the significant part of the name */
+	for (i = 0; i < PART_INDEX_NAME_LEN && name[i]; i++) {
+		hash ^= (u8)name[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static inline u32 part_index_end(const struct part_index_ent *ent)
+{
+	return ent->start + ent->sects;
+}
+
+void part_index_reset(struct part_index *idx)
+{
+	memset(idx, 0, sizeof(*idx));
+}
+
+int part_index_add(struct part_index *idx, const char *name, u32 start,
+		   u32 sects, int id)
+{
+	struct part_index_ent *ent;
+
+	if (idx->count >= PART_INDEX_MAX)
+		return -ENOSPC;
+
+	ent = &idx->ent[idx->count++];
+	strncpy(ent->name, name, PART_INDEX_NAME_LEN);
+	ent->name[PART_INDEX_NAME_LEN] = '\0';
+	ent->start = start;
+	ent->sects = sects;
+	ent->id	   = id;
+	idx->valid = 0;
+
+	return 0;
+}
+
+int part_index_build(struct part_index *idx)
+{
+	struct part_index_ent tmp;
+	u32 bucket;
+	int i, j;
+
+	idx->valid = 0;
+
+	/* insertion sort by start, the maps come nearly sorted */
+	for (i = 1; i < idx->count; i++) {
+		tmp = idx->ent[i];
+		for (j = i; j > 0 && idx->ent[j - 1].start > tmp.start; j--)
+			idx->ent[j] = idx->ent[j - 1];
+		idx->ent[j] = tmp;
+	}
+
+	for (i = 1; i < idx->count; i++) {
+		if (part_index_end(&idx->ent[i - 1]) > idx->ent[i].start) {
+			printf("part index: %s [0x%x 0x%x) overlaps %s at 0x%x\n",
+			       idx->ent[i - 1].name, idx->ent[i - 1].start,
+			       part_index_end(&idx->ent[i - 1]),
+			       idx->ent[i].name, idx->ent[i].start);
+			return -EINVAL;
+		}
+	}
+
+	memset(idx->hash, 0, sizeof(idx->hash));
+	for (i = 0; i < idx->count; i++) {
+		bucket = part_index_hash(idx->ent[i].name);
+		while (idx->hash[bucket & (PART_INDEX_HASH_SIZE - 1)])
+			bucket++;
+		idx->hash[bucket & (PART_INDEX_HASH_SIZE - 1)] = i + 1;
+	}
+	idx->valid = 1;
+
+	return 0;
+}
+
+int part_index_find_addr(const struct part_index *idx, u32 start, u32 sects)
+{
+	const struct part_index_ent *ent;
+	int lo = 0, hi = idx->count;
+	int mid;
+
+	/* first partition ending after @start, ends grow with starts */
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (part_index_end(&idx->ent[mid]) > start)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	if (lo == idx->count)
+		return -ENOENT;
+
+	ent = &idx->ent[lo];
+	if (start < ent->start)
+		return -ENOENT;
+	if (sects > part_index_end(ent) - start)
+		return -ERANGE;
+
+	return ent->id;
+}
+
+int part_index_find_name(const struct part_index *idx, const char *name)
+{
+	const struct part_index_ent *ent;
+	u32 bucket;
+	int slot;
+
+	if (!name)
+		return -ENOENT;
+
+	bucket = part_index_hash(name);
+	while ((slot = idx->hash[bucket & (PART_INDEX_HASH_SIZE - 1)])) {
+		ent = &idx->ent[slot - 1];
+		if (!strncmp(ent->name, name, PART_INDEX_NAME_LEN))
+			return ent->id;
+		bucket++;
+	}
+
+	return -ENOENT;
+}
@@ -24,6 +24,7 @@
 #endif /* USE_HOSTCC */
 #include <watchdog.h>
 #include <u-boot/sha1.h>
+#include <u-boot/sha_arch.h>
 
 const uint8_t sha1_der_prefix[SHA1_DER_LEN] = {
 	0x30, 0x21, 0x30, 0x09, 0x06, 0x05, 0x2b, 0x0e,
@@ -219,6 +220,19 @@ static void sha1_process(sha1_context *ctx, const unsigned char data[64])
 	ctx->state[4] += E;
 }
 
+static void sha1_process_blocks(sha1_context *ctx, const unsigned char *data,
+				unsigned int blocks)
+{
+	if (sha_arch_usable(SHA_ARCH_SHA1)) {
+		/* unsigned long is 32 bits on the CPUs with a backend */
+		sha1_arch_blocks((uint32_t *)ctx->state, data, blocks);
+		return;
+	}
+
+	for (; blocks; blocks--, data += 64)
+		sha1_process(ctx, data);
+}
+
 /*
  * SHA-1 process buffer
  */
@@ -242,16 +256,16 @@ void sha1_update(sha1_context *ctx, const unsigned char *input,
 
 	if (left && ilen >= fill) {
 		memcpy ((void *) (ctx->buffer + left), (void *) input, fill);
-		sha1_process (ctx, ctx->buffer);
+		sha1_process_blocks(ctx, ctx->buffer, 1);
 		input += fill;
 		ilen -= fill;
 		left = 0;
 	}
 
-	while (ilen >= 64) {
-		sha1_process (ctx, input);
-		input += 64;
-		ilen -= 64;
+	if (ilen >= 64) {
+		sha1_process_blocks(ctx, input, ilen / 64);
+		input += ilen & ~0x3F;
+		ilen &= 0x3F;
 	}
 
 	if (ilen > 0) {
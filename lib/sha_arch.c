@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Runtime selection of the SHA instruction backend, see
+ * include/u-boot/sha_arch.h
+ */
+
+#include <common.h>
+#include <u-boot/sha_arch.h>
+
+#define SHA_ARCH_UNPROBED	(~0U)
+
+/* may be first used before relocation, keep it out of BSS */
+static unsigned int sha_arch_algs __attribute__((section(".data"))) =
+	SHA_ARCH_UNPROBED;
+static bool sha_arch_disabled __attribute__((section(".data")));
+
+unsigned int __weak sha_arch_probe(void)
+{
+	return 0;
+}
+
+const char * __weak sha_arch_name(void)
+{
+	return "none";
+}
+
+bool sha_arch_usable(enum sha_arch_alg alg)
+{
+	if (sha_arch_disabled)
+		return false;
+	if (sha_arch_algs == SHA_ARCH_UNPROBED)
+		sha_arch_algs = sha_arch_probe();
+
+	return sha_arch_algs & BIT(alg);
+}
+
+void sha_arch_set_enabled(bool enable)
+{
+	sha_arch_disabled = !enable;
+}
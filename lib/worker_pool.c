@@ -0,0 +1,205 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Worker pool, see include/worker_pool.h
+ *
+ * A batch is published by bumping the sequence number. Every core takes
+ * the next job with an atomic increment until none is left, then each
+ * worker acknowledges the batch. The boot core waits for all of them, so
+ * a slow worker never takes a job of the following batch by mistake.
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <worker_pool.h>
+
+/* ms a core gets to enter the pool after its start, and to leave it */
+#define WORKER_POOL_TIMEOUT	100
+
+#define pool_load(p)		__atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define pool_store(p, v)	__atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+static struct {
+	int started;
+	int stop;
+	int nr_workers;
+	uint mask;		/* ids of the workers in the pool */
+	int admit;		/* id being started, -id once it entered */
+	int alive;		/* workers in worker_pool_main() */
+	/* the batch, valid once seq is bumped */
+	worker_job_fn fn;
+	void *priv;
+	int nr_jobs;
+	int next;
+	uint seq;
+	uint ack[CONFIG_WORKER_POOL_CPUS];	/* last batch a worker left */
+} pool;
+
+int __weak arch_worker_start(int id)
+{
+	return -ENOSYS;
+}
+
+void __weak arch_worker_exit(int id)
+{
+}
+
+void __weak arch_worker_stopped(int id)
+{
+}
+
+void __weak arch_worker_wait(void)
+{
+}
+
+void __weak arch_worker_wake(void)
+{
+}
+
+static void worker_pool_drain(void)
+{
+	int job;
+
+	while ((job = __atomic_fetch_add(&pool.next, 1, __ATOMIC_ACQ_REL)) <
+	       pool.nr_jobs)
+		pool.fn(pool.priv, job);
+}
+
+void worker_pool_main(int id)
+{
+	int admit = id;
+	uint seq;
+
+	/* a core showing up after worker_pool_start() gave up leaves again */
+	if (!__atomic_compare_exchange_n(&pool.admit, &admit, -id, false,
+					 __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+		arch_worker_exit(id);
+		return;
+	}
+	__atomic_fetch_add(&pool.alive, 1, __ATOMIC_ACQ_REL);
+	pool_store(&pool.ack[id], pool_load(&pool.seq));
+	arch_worker_wake();
+
+	for (;;) {
+		while ((seq = pool_load(&pool.seq)) == pool.ack[id] &&
+		       !pool_load(&pool.stop))
+			arch_worker_wait();
+		if (pool_load(&pool.stop))
+			break;
+
+		worker_pool_drain();
+		pool_store(&pool.ack[id], seq);
+		arch_worker_wake();
+	}
+
+	__atomic_fetch_sub(&pool.alive, 1, __ATOMIC_ACQ_REL);
+	arch_worker_wake();
+	arch_worker_exit(id);
+}
+
+int worker_pool_start(void)
+{
+	ulong start;
+	int id, expect;
+
+	if (pool.started)
+		return pool.nr_workers + 1;
+	pool.started = 1;
+
+	for (id = 1; id < CONFIG_WORKER_POOL_CPUS; id++) {
+		pool_store(&pool.admit, id);
+		if (arch_worker_start(id))
+			continue;
+
+		start = get_timer(0);
+		while (pool_load(&pool.admit) == id &&
+		       get_timer(start) < WORKER_POOL_TIMEOUT)
+			;
+		expect = id;
+		if (__atomic_compare_exchange_n(&pool.admit, &expect, 0, false,
+						__ATOMIC_ACQ_REL,
+						__ATOMIC_ACQUIRE)) {
+			printf("worker pool: core %d did not start\n", id);
+			continue;
+		}
+		pool.mask |= 1 << id;
+		pool.nr_workers++;
+	}
+	pool_store(&pool.admit, 0);
+	debug("worker pool: %d workers\n", pool.nr_workers);
+
+	return pool.nr_workers + 1;
+}
+
+void worker_pool_stop(void)
+{
+	ulong start;
+	int id;
+
+	if (!pool.nr_workers) {
+		pool.started = 0;
+		return;
+	}
+
+	pool_store(&pool.stop, 1);
+	arch_worker_wake();
+	start = get_timer(0);
+	while (pool_load(&pool.alive) && get_timer(start) < WORKER_POOL_TIMEOUT)
+		;
+	if (pool_load(&pool.alive)) {
+		printf("worker pool: %d cores did not stop\n",
+		       pool_load(&pool.alive));
+	} else {
+		/* the next batch starts the pool again */
+		pool_store(&pool.stop, 0);
+		pool.started = 0;
+	}
+
+	for (id = 1; id < CONFIG_WORKER_POOL_CPUS; id++)
+		if (pool.mask & (1 << id))
+			arch_worker_stopped(id);
+	pool.nr_workers = 0;
+	pool.mask = 0;
+}
+
+int worker_pool_size(void)
+{
+	/* batches are sized on it, so the first caller brings the pool up */
+	if (!pool.started)
+		return worker_pool_start();
+
+	return pool.nr_workers + 1;
+}
+
+void worker_pool_run(worker_job_fn fn, void *priv, int nr_jobs)
+{
+	uint seq;
+	int id;
+
+	if (!pool.started)
+		worker_pool_start();
+
+	if (!pool.nr_workers || nr_jobs < 2) {
+		for (id = 0; id < nr_jobs; id++)
+			fn(priv, id);
+		return;
+	}
+
+	pool.fn = fn;
+	pool.priv = priv;
+	pool.nr_jobs = nr_jobs;
+	pool.next = 0;
+	seq = pool.seq + 1;
+	pool_store(&pool.seq, seq);
+	arch_worker_wake();
+
+	worker_pool_drain();
+	for (id = 1; id < CONFIG_WORKER_POOL_CPUS; id++) {
+		if (!(pool.mask & (1 << id)))
+			continue;
+		while (pool_load(&pool.ack[id]) != seq)
+			arch_worker_wait();
+	}
+}
@@ -65,8 +65,18 @@
       bytes, which is the maximum length that can be coded.  inflate_fast()
       requires strm->avail_out >= 258 for each loop to avoid checking for
       output space.
+
+    - U-Boot: built a second time as inflate_fast64() with INFLATE_FAST64.
+      That keeps a 64-bit bit buffer, filled to 48 or more bits once per
+      loop, which is all a length/distance pair takes, and copies matches
+      from the output with decomp_copy().  Still at most six bytes read per
+      loop, and every buffered byte was read during this call.
  */
+#ifdef INFLATE_FAST64
+void inflate_fast64(z_streamp strm, unsigned start)
+#else
 void inflate_fast(z_streamp strm, unsigned start)
+#endif
 /* start: inflate()'s starting value for strm->avail_out */
 {
     struct inflate_state FAR *state;
@@ -82,7 +92,11 @@ void inflate_fast(z_streamp strm, unsigned start)
     unsigned whave;             /* valid bytes in the window */
     unsigned write;             /* window write index */
     unsigned char FAR *window;  /* allocated sliding window, if wsize != 0 */
+#ifdef INFLATE_FAST64
+    u64 hold;                   /* local strm->hold, up to 55 bits */
+#else
     unsigned long hold;         /* local strm->hold */
+#endif
     unsigned bits;              /* local strm->bits */
     code const FAR *lcode;      /* local strm->lencode */
     code const FAR *dcode;      /* local strm->distcode */
@@ -127,12 +141,19 @@ void inflate_fast(z_streamp strm, unsigned start)
     /* decode literals and length/distances until end-of-block or not enough
        input data or output space */
     do {
+#ifdef INFLATE_FAST64
+        while (bits < 48) {
+            hold += (u64)(PUP(in)) << bits;
+            bits += 8;
+        }
+#else
         if (bits < 15) {
             hold += (unsigned long)(PUP(in)) << bits;
             bits += 8;
             hold += (unsigned long)(PUP(in)) << bits;
             bits += 8;
         }
+#endif
         this = lcode[hold & lmask];
       dolen:
         op = (unsigned)(this.bits);
@@ -149,21 +170,25 @@ void inflate_fast(z_streamp strm, unsigned start)
             len = (unsigned)(this.val);
             op &= 15;                           /* number of extra bits */
             if (op) {
+#ifndef INFLATE_FAST64
                 if (bits < op) {
                     hold += (unsigned long)(PUP(in)) << bits;
                     bits += 8;
                 }
+#endif
                 len += (unsigned)hold & ((1U << op) - 1);
                 hold >>= op;
                 bits -= op;
             }
             Tracevv((stderr, "inflate:         length %u\n", len));
+#ifndef INFLATE_FAST64
             if (bits < 15) {
                 hold += (unsigned long)(PUP(in)) << bits;
                 bits += 8;
                 hold += (unsigned long)(PUP(in)) << bits;
                 bits += 8;
             }
+#endif
             this = dcode[hold & dmask];
           dodist:
             op = (unsigned)(this.bits);
@@ -173,6 +198,7 @@ void inflate_fast(z_streamp strm, unsigned start)
             if (op & 16) {                      /* distance base */
                 dist = (unsigned)(this.val);
                 op &= 15;                       /* number of extra bits */
+#ifndef INFLATE_FAST64
                 if (bits < op) {
                     hold += (unsigned long)(PUP(in)) << bits;
                     bits += 8;
@@ -181,6 +207,7 @@ void inflate_fast(z_streamp strm, unsigned start)
                         bits += 8;
                     }
                 }
+#endif
                 dist += (unsigned)hold & ((1U << op) - 1);
 #ifdef INFLATE_STRICT
                 if (dist > dmax) {
@@ -252,6 +279,12 @@ void inflate_fast(z_streamp strm, unsigned start)
                             PUP(out) = PUP(from);
                     }
                 }
+#ifdef INFLATE_FAST64
+                else {
+                    from = out - dist;          /* copy direct from output */
+                    out = decomp_copy(out + OFF, from + OFF, len) - OFF;
+                }
+#else
                 else {
 		    unsigned short *sout;
 		    unsigned long loops;
@@ -295,6 +328,7 @@ void inflate_fast(z_streamp strm, unsigned start)
 		    if (len & 1)
 			PUP(out) = PUP(from);
                 }
+#endif
             }
             else if ((op & 64) == 0) {          /* 2nd level distance code */
                 this = dcode[this.val + (hold & ((1U << op) - 1))];
@@ -9,3 +9,4 @@
  */
 
 void inflate_fast OF((z_streamp strm, unsigned start));
+void inflate_fast64 OF((z_streamp strm, unsigned start));
@@ -724,7 +724,10 @@ int ZEXPORT inflate(z_streamp strm, int flush)
 	    WATCHDOG_RESET();
             if (have >= 6 && left >= 258) {
                 RESTORE();
-                inflate_fast(strm, out);
+                if (decomp_fast_enabled())
+                    inflate_fast64(strm, out);
+                else
+                    inflate_fast(strm, out);
                 LOAD();
                 break;
             }
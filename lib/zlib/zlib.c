@@ -10,9 +10,11 @@
  * - added minCompression parameter to deflateInit2
  * - added Z_PACKET_FLUSH (see zlib.h for details)
  * - added inflateIncomp
+ * - added inflate_fast64, the second build of inffast.c (DECOMP_FAST)
  */
 
 #include <common.h>
+#include <decomp_fast.h>
 
 #ifdef CONFIG_GZIP_COMPRESSED
 #define NO_DUMMY_DECL
@@ -26,6 +28,11 @@
 #include "inffast.h"
 #include "inffixed.h"
 #include "inffast.c"
+#if CONFIG_IS_ENABLED(DECOMP_FAST)
+#define INFLATE_FAST64
+#include "inffast.c"
+#undef INFLATE_FAST64
+#endif
 #include "inftrees.c"
 #include "inflate.c"
 #include "zutil.c"
@@ -19,7 +19,17 @@
 #define IF_CNT 3 //加密接口个数	现在只有头加密，表加密，数据加密3种
 #define MAX_KEY_SIZE 32 //密码长度
 
+#define INVALID_INDEX 0xFFFFFFFF
+
+#define IMG_ITEM_POOL_SIZE 8 //同时打开的item一般不超过两个
+
 #pragma pack(push, 1)
+typedef struct tag_ITEM_HANDLE {
+	uint index; //在ItemTable中的索引
+	uint reserved[3];
+	//	long long pos;
+} ITEM_HANDLE;
+
 typedef struct tag_IMAGE_HANDLE {
 	//	HANDLE  fp;			//
 
@@ -30,19 +40,104 @@ typedef struct tag_IMAGE_HANDLE {
 	//	RC_ENDECODE_IF_t rc_if_decode[IF_CNT];//解密接口
 
 	//	BOOL			bWithEncpy; // 是否加密
-} IMAGE_HANDLE;
 
-#define INVALID_INDEX 0xFFFFFFFF
+	uint *ItemHash; //按subType散列的索引表, 存放ItemTable索引加1, 0为空
+	uint HashMask; //散列表大小减1
 
-typedef struct tag_ITEM_HANDLE {
-	uint index; //在ItemTable中的索引
-	uint reserved[3];
-	//	long long pos;
-} ITEM_HANDLE;
+	ITEM_HANDLE ItemPool[IMG_ITEM_POOL_SIZE]; //item句柄池
+	uint ItemPoolUsed; //句柄池占用位图
+} IMAGE_HANDLE;
 
 #define ITEM_PHOENIX_TOOLS "PXTOOLS "
 
 uint img_file_start; //固件的起始位置
+
+static uint __Img_HashSubType(const u8 *subType)
+{
+	uint hash = 2166136261u;
+	int i;
+
+	//FNV-1a
+	for (i = 0; i < SUBTYPE_LEN; i++) {
+		hash ^= subType[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+//------------------------------------------------------------------------------------------------------------
+// 读出ItemTable后建立一次subType散列索引, 之后每次Img_OpenItem不再扫描整个表
+// 建立失败时Img_OpenItem退回到顺序查找
+//------------------------------------------------------------------------------------------------------------
+static void __Img_BuildIndex(IMAGE_HANDLE *pImage)
+{
+	uint size = 16;
+	uint i, bucket;
+
+	while (size < pImage->ImageHead.itemcount * 2)
+		size <<= 1;
+
+	pImage->ItemHash = (uint *)malloc(size * sizeof(uint));
+	if (NULL == pImage->ItemHash) {
+		printf("sunxi sprite: no memory for item index, use table scan\n");
+
+		return;
+	}
+	memset(pImage->ItemHash, 0, size * sizeof(uint));
+	pImage->HashMask = size - 1;
+
+	//按表中顺序插入, 同名的item查找时仍然先找到前面的一个
+	for (i = 0; i < pImage->ImageHead.itemcount; i++) {
+		bucket = __Img_HashSubType(pImage->ItemTable[i].subType);
+		while (pImage->ItemHash[bucket & pImage->HashMask])
+			bucket++;
+		pImage->ItemHash[bucket & pImage->HashMask] = i + 1;
+	}
+}
+
+static uint __Img_FindItem(IMAGE_HANDLE *pImage, char *subType)
+{
+	uint i, bucket;
+
+	if (NULL == pImage->ItemHash) {
+		for (i = 0; i < pImage->ImageHead.itemcount; i++) {
+			if (!memcmp(subType, pImage->ItemTable[i].subType,
+				    SUBTYPE_LEN))
+				return i;
+		}
+
+		return INVALID_INDEX;
+	}
+
+	bucket = __Img_HashSubType((u8 *)subType);
+	while ((i = pImage->ItemHash[bucket & pImage->HashMask])) {
+		if (!memcmp(subType, pImage->ItemTable[i - 1].subType,
+			    SUBTYPE_LEN))
+			return i - 1;
+		bucket++;
+	}
+
+	return INVALID_INDEX;
+}
+
+static ITEM_HANDLE *__Img_AllocItem(IMAGE_HANDLE *pImage)
+{
+	int i;
+
+	for (i = 0; i < IMG_ITEM_POOL_SIZE; i++) {
+		if (!(pImage->ItemPoolUsed & (1 << i))) {
+			pImage->ItemPoolUsed |= 1 << i;
+
+			return &pImage->ItemPool[i];
+		}
+	}
+
+	//句柄池用完时从堆上分配
+	return (ITEM_HANDLE *)memalign(CONFIG_SYS_CACHELINE_SIZE,
+				       ALIGN(sizeof(ITEM_HANDLE),
+					     CONFIG_SYS_CACHELINE_SIZE));
+}
 //------------------------------------------------------------------------------------------------------------
 //image解析插件的接口
 //------------------------------------------------------------------------------------------------------------
@@ -64,16 +159,29 @@ uint img_file_start; //固件的起始位置
 //------------------------------------------------------------------------------------------------------------
 HIMAGE Img_Open(char *ImageFile)
 {
-	IMAGE_HANDLE *pImage = NULL;
-	uint ItemTableSize; //固件索引表的大小
+	uint start;
+
 	debug("%d:sprite_card_firmware_start\n", __LINE__);
-	img_file_start = (uint)sprite_card_firmware_start();
-	if (!img_file_start) {
+	start = (uint)sprite_card_firmware_start();
+	if (!start) {
 		printf("sunxi sprite error: unable to get firmware start position\n");
 
 		return NULL;
 	}
-	printf("img start = 0x%x\n", img_file_start);
+	printf("img start = 0x%x\n", start);
+
+	return Img_Open_At(start);
+}
+
+//------------------------------------------------------------------------------------------------------------
+// 打开flash上从start扇区开始的固件
+//------------------------------------------------------------------------------------------------------------
+HIMAGE Img_Open_At(uint start)
+{
+	IMAGE_HANDLE *pImage = NULL;
+	uint ItemTableSize; //固件索引表的大小
+
+	img_file_start = start;
 	pImage = (IMAGE_HANDLE *)memalign(CONFIG_SYS_CACHELINE_SIZE,
 					  ALIGN(sizeof(IMAGE_HANDLE),
 						CONFIG_SYS_CACHELINE_SIZE));
@@ -123,6 +231,7 @@ HIMAGE Img_Open(char *ImageFile)
 
 		goto _img_open_fail_;
 	}
+	__Img_BuildIndex(pImage);
 
 	return pImage;
 
@@ -137,6 +246,49 @@ _img_open_fail_:
 	return NULL;
 }
 
+//------------------------------------------------------------------------------------------------------------
+// 打开已经读到内存中的固件, 只取出头和索引表
+// item数据在Image + Img_GetItemOffset()处, 不能用Img_ReadItem读取
+//------------------------------------------------------------------------------------------------------------
+HIMAGE Img_Mem_Open(void *Image)
+{
+	IMAGE_HANDLE *pImage = NULL;
+	uint ItemTableSize;
+
+	pImage = (IMAGE_HANDLE *)memalign(ARCH_DMA_MINALIGN, sizeof(IMAGE_HANDLE));
+	if (NULL == pImage) {
+		printf("sunxi sprite error: fail to malloc memory for img head\n");
+
+		return NULL;
+	}
+	memset(pImage, 0, sizeof(IMAGE_HANDLE));
+
+	memcpy(&pImage->ImageHead, Image, IMAGE_HEAD_SIZE);
+	if (memcmp(pImage->ImageHead.magic, IMAGE_MAGIC, 8) != 0) {
+		printf("sunxi sprite error: iamge magic is bad\n");
+
+		goto _img_mem_open_fail_;
+	}
+
+	ItemTableSize = pImage->ImageHead.itemcount * sizeof(ImageItem_t);
+	pImage->ItemTable =
+		(ImageItem_t *)memalign(ARCH_DMA_MINALIGN, ItemTableSize);
+	if (NULL == pImage->ItemTable) {
+		printf("sunxi sprite error: fail to malloc memory for item table\n");
+
+		goto _img_mem_open_fail_;
+	}
+	memcpy(pImage->ItemTable, Image + IMAGE_HEAD_SIZE, ItemTableSize);
+	__Img_BuildIndex(pImage);
+
+	return pImage;
+
+_img_mem_open_fail_:
+	free(pImage);
+
+	return NULL;
+}
+
 HIMAGE Img_Fat_Open(char *ImageFile)
 {
 	IMAGE_HANDLE *pImage = NULL;
@@ -181,6 +333,7 @@ HIMAGE Img_Fat_Open(char *ImageFile)
 
 		goto _img_fs_open_fail_;
 	}
+	__Img_BuildIndex(pImage);
 
 	return pImage;
 
@@ -246,64 +399,30 @@ HIMAGEITEM Img_OpenItem(HIMAGE hImage, char *MainType, char *subType)
 {
 	IMAGE_HANDLE *pImage = (IMAGE_HANDLE *)hImage;
 	ITEM_HANDLE *pItem   = NULL;
-	uint i;
+	uint index;
 
 	if (NULL == pImage || NULL == MainType || NULL == subType) {
 		return NULL;
 	}
 
-	pItem = (ITEM_HANDLE *)memalign(CONFIG_SYS_CACHELINE_SIZE,
-					ALIGN(sizeof(ITEM_HANDLE),
-					      CONFIG_SYS_CACHELINE_SIZE));
-	if (NULL == pItem) {
-		printf("sunxi sprite error : cannot malloc memory for item\n");
+	//只按subType查找, MainType不参与比较
+	index = __Img_FindItem(pImage, subType);
+	if (INVALID_INDEX == index) {
+		printf("sunxi sprite error : cannot find item %s %s\n", MainType,
+		       subType);
 
 		return NULL;
 	}
-	pItem->index = INVALID_INDEX;
 
-	for (i = 0; i < pImage->ImageHead.itemcount; i++) {
-		//		int nCmp = memcmp(ITEM_PHOENIX_TOOLS, MainType, MAINTYPE_LEN);
-		//
-		//		if (nCmp == 0)//
-		//		{
-		//			if (memcmp(MainType, pImage->ItemTable[i].mainType, MAINTYPE_LEN) == 0 )
-		//			{
-		//				pItem->index = i;
-		//
-		//				return pItem;
-		//			}
-		//		}
-		//		else
-		//		{
-		//			nCmp = memcmp(MainType, pImage->ItemTable[i].mainType, MAINTYPE_LEN);
-		//			if(nCmp == 0)
-		//			{
-		//				nCmp = memcmp(subType,  pImage->ItemTable[i].subType,  SUBTYPE_LEN);
-		//				if( nCmp == 0)
-		//				{
-		//					pItem->index = i;
-		//
-		//					return pItem;
-		//				}
-		//			}
-		//		}
-		if (!memcmp(subType, pImage->ItemTable[i].subType,
-			    SUBTYPE_LEN)) {
-			pItem->index = i;
-			//debug("try to malloc %x\n", (uint)pItem);
-
-			return pItem;
-		}
-	}
-
-	printf("sunxi sprite error : cannot find item %s %s\n", MainType,
-	       subType);
+	pItem = __Img_AllocItem(pImage);
+	if (NULL == pItem) {
+		printf("sunxi sprite error : cannot malloc memory for item\n");
 
-	free(pItem);
-	pItem = NULL;
+		return NULL;
+	}
+	pItem->index = index;
 
-	return NULL;
+	return pItem;
 }
 
 //------------------------------------------------------------------------------------------------------------
@@ -910,12 +1029,19 @@ uint Img_Fat_ReadItem(HIMAGE hImage, HIMAGEITEM hItem, char *ImageFile,
 //------------------------------------------------------------------------------------------------------------
 int Img_CloseItem(HIMAGE hImage, HIMAGEITEM hItem)
 {
-	ITEM_HANDLE *pItem = (ITEM_HANDLE *)hItem;
+	IMAGE_HANDLE *pImage = (IMAGE_HANDLE *)hImage;
+	ITEM_HANDLE *pItem   = (ITEM_HANDLE *)hItem;
 	if (NULL == pItem) {
 		printf("sunxi sprite error : item is null when close it\n");
 
 		return -1;
 	}
+	if (pImage && pItem >= pImage->ItemPool &&
+	    pItem < pImage->ItemPool + IMG_ITEM_POOL_SIZE) {
+		pImage->ItemPoolUsed &= ~(1 << (pItem - pImage->ItemPool));
+
+		return 0;
+	}
 	//debug("try to free %x\n", (uint)pItem);
 	free(pItem);
 	pItem = NULL;
@@ -952,6 +1078,10 @@ void Img_Close(HIMAGE hImage)
 		free(pImage->ItemTable);
 		pImage->ItemTable = NULL;
 	}
+	if (NULL != pImage->ItemHash) {
+		free(pImage->ItemHash);
+		pImage->ItemHash = NULL;
+	}
 
 	memset(pImage, 0, sizeof(IMAGE_HANDLE));
 	free(pImage);
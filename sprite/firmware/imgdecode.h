@@ -24,6 +24,8 @@ typedef void *HIMAGE;
 typedef void *HIMAGEITEM;
 
 extern HIMAGE Img_Open(char *ImageFile);
+extern HIMAGE Img_Open_At(uint start);
+extern HIMAGE Img_Mem_Open(void *Image);
 extern long long Img_GetSize(HIMAGE hImage);
 extern HIMAGEITEM Img_OpenItem(HIMAGE hImage, char *MainType, char *subType);
 extern long long Img_GetItemSize(HIMAGE hImage, HIMAGEITEM hItem);
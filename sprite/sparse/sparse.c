@@ -6,6 +6,7 @@
  *     */
 #include <config.h>
 #include <common.h>
+#include <malloc.h>
 #include <sparse_format.h>
 #include "sparse.h"
 #include "../sprite_verify.h"
@@ -17,6 +18,9 @@
 #define SPARSE_FORMAT_TYPE_CHUNK_DATA 0xff02
 #define SPARSE_FORMAT_TYPE_CHUNK_FILL_DATA 0xff03
 
+/* one fill command covers up to this many bytes */
+#define SPARSE_FILL_BUFF_SIZE (1024 * 1024)
+
 static uint android_format_checksum;
 static uint sparse_format_type;
 static uint chunk_count;
@@ -25,6 +29,65 @@ static int chunk_length;
 static uint flash_start;
 static sparse_header_t globl_header;
 static uint total_chunks;
+static uint last_percent;
+
+static u32 *fill_buf;
+static uint fill_buf_sectors;
+static u32 fill_buf_val;
+
+/*
+ * a fill chunk is written from a buffer replicated with the fill value,
+ * SPARSE_FILL_BUFF_SIZE bytes per command instead of 4k
+ */
+static int unsparse_fill_write(uint start, uint sectors, u32 val)
+{
+	u32 small_buf[1024];
+	u32 *buf = fill_buf;
+	uint buf_sectors = fill_buf_sectors;
+	uint this_sectors, i;
+
+	if (!fill_buf) {
+		fill_buf = memalign(CONFIG_SYS_CACHELINE_SIZE,
+				    SPARSE_FILL_BUFF_SIZE);
+		if (fill_buf) {
+			fill_buf_sectors = SPARSE_FILL_BUFF_SIZE >> 9;
+			for (i = 0; i < SPARSE_FILL_BUFF_SIZE / 4; i++)
+				fill_buf[i] = val;
+			fill_buf_val = val;
+		}
+		buf	    = fill_buf;
+		buf_sectors = fill_buf_sectors;
+	}
+	if (!buf) {
+		/* no memory for the big buffer, fall back to 4k at a time */
+		for (i = 0; i < ARRAY_SIZE(small_buf); i++)
+			small_buf[i] = val;
+		buf	    = small_buf;
+		buf_sectors = sizeof(small_buf) >> 9;
+	} else if (fill_buf_val != val) {
+		for (i = 0; i < SPARSE_FILL_BUFF_SIZE / 4; i++)
+			fill_buf[i] = val;
+		fill_buf_val = val;
+	}
+
+	while (sectors) {
+		this_sectors = min(sectors, buf_sectors);
+		if (!sunxi_sprite_write(start, this_sectors, buf))
+			return -1;
+		start += this_sectors;
+		sectors -= this_sectors;
+	}
+
+	return 0;
+}
+
+/* the fill buffer only lives for one image, it is 1M of the malloc pool */
+static void unsparse_fill_free(void)
+{
+	free(fill_buf);
+	fill_buf	 = NULL;
+	fill_buf_sectors = 0;
+}
 /*
 ************************************************************************************************************
 *
@@ -58,6 +121,8 @@ int unsparse_probe(char *source, uint length, uint android_format_flash_start)
 
 		return ANDROID_FORMAT_BAD;
 	}
+	/* a previous image may have been aborted half way */
+	unsparse_fill_free();
 	android_format_checksum = 0;
 	last_rest_size		= 0;
 	chunk_count		= 0;
@@ -65,6 +130,7 @@ int unsparse_probe(char *source, uint length, uint android_format_flash_start)
 	sparse_format_type      = SPARSE_FORMAT_TYPE_TOTAL_HEAD;
 	flash_start		= android_format_flash_start;
 	total_chunks		= header->total_chunks;
+	last_percent		= 0;
 
 	return ANDROID_FORMAT_DETECT;
 }
@@ -84,7 +150,7 @@ int unsparse_probe(char *source, uint length, uint android_format_flash_start)
 *
 ************************************************************************************************************
 */
-int unsparse_direct_write(void *pbuf, uint length)
+static int __unsparse_direct_write(void *pbuf, uint length)
 {
 	int unenough_length;
 	int this_rest_size;
@@ -128,10 +194,17 @@ int unsparse_direct_write(void *pbuf, uint length)
 				chunk->chunk_sz *
 				globl_header
 					.blk_sz; //当前数据块需要写入的数据长度
-			printf("chunk %d(%d)\n", chunk_count++, total_chunks);
+			chunk_count++;
+			/* report progress once per percent, not once per chunk */
+			if (total_chunks &&
+			    (100 * chunk_count) / total_chunks != last_percent) {
+				last_percent = (100 * chunk_count) / total_chunks;
+				printf("chunk %d(%d)\n", chunk_count, total_chunks);
 #ifdef CONFIG_SUNXI_SPRITE_CARTOON
-			sprite_cartoon_upgrade(10 + (70 * chunk_count)/total_chunks);
+				sprite_cartoon_upgrade(10 + (70 * chunk_count) /
+								    total_chunks);
 #endif
+			}
 			switch (chunk->chunk_type) {
 			case CHUNK_TYPE_RAW:
 
@@ -258,9 +331,7 @@ int unsparse_direct_write(void *pbuf, uint length)
 			break;
 		}
 		case SPARSE_FORMAT_TYPE_CHUNK_FILL_DATA: {
-			u32 fillbuf[1024];
 			u32 file_val = 0;
-			u32 ii       = 0;
 
 			if (this_rest_size >= 4) {
 				this_rest_size -= sizeof(u32);
@@ -269,17 +340,14 @@ int unsparse_direct_write(void *pbuf, uint length)
 					printf("fill data is not sector align 0\n");
 					return -1;
 				}
-				for (ii = 0; ii < sizeof(fillbuf)/sizeof(fillbuf[0]); ii++)
-					fillbuf[ii] = file_val;
-				for (ii = 0; ii < (chunk_length >> 12); ii++) {
-					if (!sunxi_sprite_write(flash_start, 8,
-								fillbuf)) {
-						printf("sparse: fill data write failed\n");
-
-						return -1;
-					}
-					flash_start += 8;
+				if (unsparse_fill_write(flash_start,
+							chunk_length >> 9,
+							file_val)) {
+					printf("sparse: fill data write failed\n");
+
+					return -1;
 				}
+				flash_start += chunk_length >> 9;
 				tmp_buf += sizeof(u32);
 				sparse_format_type =
 					SPARSE_FORMAT_TYPE_CHUNK_HEAD;
@@ -304,6 +372,18 @@ int unsparse_direct_write(void *pbuf, uint length)
 
 	return 0;
 }
+
+int unsparse_direct_write(void *pbuf, uint length)
+{
+	int ret = __unsparse_direct_write(pbuf, length);
+
+	/* the image is broken or its last chunk is written */
+	if (ret || (chunk_count == total_chunks &&
+		    sparse_format_type == SPARSE_FORMAT_TYPE_CHUNK_HEAD))
+		unsparse_fill_free();
+
+	return ret;
+}
 /*
 ************************************************************************************************************
 *
@@ -324,3 +404,11 @@ uint unsparse_checksum(void)
 {
 	return android_format_checksum;
 }
+/*
+ * bytes of an unfinished chunk kept in front of the last buffer handed to
+ * unsparse_direct_write, they are expected in front of the next one
+ */
+uint unsparse_pending_bytes(void)
+{
+	return last_rest_size;
+}
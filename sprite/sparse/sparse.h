@@ -10,5 +10,6 @@ extern int unsparse_probe(char *source, unsigned int length,
 			  unsigned int flash_start);
 extern int unsparse_direct_write(void *pbuf, unsigned int length);
 extern unsigned int unsparse_checksum(void);
+extern unsigned int unsparse_pending_bytes(void);
 
 #endif /* __SUNXI_SPRITE_SPARSE_H__ */
@@ -22,8 +22,10 @@
 #include "sprite_card.h"
 #include "sparse/sparse.h"
 #include "sprite_verify.h"
+#include "sprite_pipe.h"
 #include "firmware/imgdecode.h"
 #include <fs.h>
+#include <fat.h>
 #include "sys_config.h"
 #include "sprite_auto_update.h"
 #include <usb.h>
@@ -40,13 +42,11 @@ DECLARE_GLOBAL_DATA_PTR;
 #define IS_FILE_END(x) (SCRIPT_FILE_END == (x))
 #define IS_LINE_END(x) ('\r' == (x) || '\n' == (x))
 
-#define AU_HEAD_BUFF (32 * 1024)
 #if defined(CONFIG_SUNXI_SPINOR)
 #define AU_ONCE_DATA_DEAL (2 * 1024 * 1024)
 #else
 #define AU_ONCE_DATA_DEAL (3 * 1024 * 1024)
 #endif
-#define AU_ONCE_SECTOR_DEAL (AU_ONCE_DATA_DEAL / 512)
 #define IMG_NAME "update/FIRMWARE.bin"
 
 typedef struct _uboot_command {
@@ -57,6 +57,8 @@ static char *firmware_path = IMG_NAME;
 static void *imghd;
 static void *imgitemhd;
 static char *imgname;
+/* image opened once per update, item reads skip the directory and fat walk */
+static struct fat_file *imgfile;
 char interface[8] = "usb";
 
 extern int do_card0_probe(cmd_tbl_t *cmdtp, int flag, int argc,
@@ -78,8 +80,26 @@ int __attribute__((weak)) nand_get_mbr(char *buffer, uint len)
 	return -1;
 }
 
+static void auto_update_firmware_release(void)
+{
+	fat_file_close(imgfile);
+	imgfile = NULL;
+}
+
 static int auto_update_firmware_probe(char *name)
 {
+	struct blk_desc *desc;
+	disk_partition_t info;
+
+	auto_update_firmware_release();
+	/* same device and partition as "fatload <interface> 0" */
+	if (blk_get_device_part_str(interface, "0", &desc, &info, 1) < 0 ||
+	    fat_set_blk_dev(desc, &info) || fat_file_open(name, &imgfile)) {
+		printf("sunxi sprite: unable to open %s, read it by name\n",
+		       name);
+		imgfile = NULL;
+	}
+
 	imghd = Img_Fat_Open(name);
 
 	if (!imghd) {
@@ -90,13 +110,21 @@ static int auto_update_firmware_probe(char *name)
 }
 
 
-loff_t fat_fs_read(const char *filename, void *buf, int offset, int len)
+loff_t fat_fs_read(const char *filename, void *buf, loff_t offset, int len)
 {
 	char temp_str[256] = {0};
+	loff_t actread;
+
 	if ((buf == NULL) || (filename == NULL))
 		return -1;
 
-	sprintf(temp_str, "fatload %s 0 0x%lx %s 0x%x 0x%x", interface, (unsigned long)buf, filename, len, offset);
+	if (imgfile && imgname && !strcmp(filename, imgname)) {
+		if (fat_file_read(imgfile, offset, buf, len, &actread))
+			return -1;
+		return actread;
+	}
+
+	sprintf(temp_str, "fatload %s 0 0x%lx %s 0x%x 0x%llx", interface, (unsigned long)buf, filename, len, offset);
 	run_command(temp_str, 0);
 	return env_get_hex("filesize", 0);
 }
@@ -147,27 +175,60 @@ static int auto_update_fetch_mbr(void *img_mbr)
 	return sunxi_sprite_verify_mbr(img_mbr);
 }
 
+static int au_pipe_read(void *priv, u64 offset, void *buf, uint bytes)
+{
+	return fat_fs_read(imgname, buf, offset, bytes) == bytes ? 0 : -1;
+}
+
+/*
+ * fat_fs_read() ends up in blk_dread() and blocks, so there is no
+ * submit/wait here: every chunk is read in the foreground and overlaps only
+ * with the flash writes still in flight
+ */
+static struct sprite_pipe_src au_pipe_src = {
+	.read = au_pipe_read,
+};
+
+#ifdef CONFIG_SUNXI_SPRITE_DELTA
+/* delta update: the partition on flash already holds the image item */
+static int __normal_part_unchanged(dl_one_part_info *part_info,
+				   uint imgfile_start, s64 partdata_by_byte)
+{
+	HIMAGEITEM vf_item;
+	uchar vf_data[1024];
+	uchar head[512];
+	int ret = 0;
+
+	if (!part_info->vf_filename[0])
+		return 0;
+
+	vf_item = Img_OpenItem(imghd, "RFSFAT16", (char *)part_info->vf_filename);
+	if (!vf_item)
+		return 0;
+	if (Img_Fat_ReadItem(imghd, vf_item, imgname, vf_data, 1024) &&
+	    !au_pipe_read(NULL, imgfile_start, head, 512))
+		ret = sunxi_sprite_part_unchanged(part_info, part_info->addrlo,
+						  partdata_by_byte, head,
+						  vf_data,
+						  Img_GetItemSize(imghd, vf_item));
+	Img_CloseItem(imghd, vf_item);
+
+	return ret;
+}
+#endif
+
 static int __download_normal_part(dl_one_part_info *part_info,
-				  uchar *source_buff)
+				  struct sprite_pipe *pipe)
 {
 	int ret = -1;
 	uint partstart_by_sector;
-	uint tmp_partstart_by_sector;
 	s64 partsize_by_byte;
 	s64 partdata_by_byte;
-	s64 tmp_partdata_by_bytes;
-	uint onetime_read_sectors;
-	uint first_write_bytes;
 	uint imgfile_start;
-	uint tmp_imgfile_start;
 	int partdata_format;
-	uint active_verify;
-	uint origin_verify;
 	uchar verify_data[1024];
-	uint *tmp;
-	u8 *down_buffer = source_buff + AU_HEAD_BUFF;
 
-	tmp_partstart_by_sector = partstart_by_sector = part_info->addrlo;
+	partstart_by_sector = part_info->addrlo;
 	partsize_by_byte			      = part_info->lenlo;
 	partsize_by_byte <<= 9;
 
@@ -198,15 +259,6 @@ static int __download_normal_part(dl_one_part_info *part_info,
 		goto __download_normal_part_err1;
 	}
 
-	tmp_partdata_by_bytes = partdata_by_byte;
-	if (tmp_partdata_by_bytes >= AU_ONCE_DATA_DEAL) {
-		onetime_read_sectors = AU_ONCE_SECTOR_DEAL;
-		first_write_bytes    = AU_ONCE_DATA_DEAL;
-	} else {
-		onetime_read_sectors = (tmp_partdata_by_bytes + 511) >> 9;
-		first_write_bytes    = (uint)tmp_partdata_by_bytes;
-	}
-
 	imgfile_start = Img_GetItemOffset(imghd, imgitemhd);
 	if (!imgfile_start) {
 		printf("sunxi sprite err : cant get part data imgfile_start %s\n",
@@ -214,126 +266,25 @@ static int __download_normal_part(dl_one_part_info *part_info,
 
 		goto __download_normal_part_err1;
 	}
-	tmp_imgfile_start = imgfile_start;
-
-	if (fat_fs_read(imgname, down_buffer, imgfile_start,
-			onetime_read_sectors * 512) !=
-	    onetime_read_sectors * 512) {
-		printf("sunxi sprite error : read sdcard start %d, total %d failed\n",
-		       tmp_imgfile_start, onetime_read_sectors);
-
+#ifdef CONFIG_SUNXI_SPRITE_DELTA
+	if (__normal_part_unchanged(part_info, imgfile_start,
+				    partdata_by_byte)) {
+		tick_printf("part %s unchanged, skip it\n", part_info->name);
+		ret = 0;
 		goto __download_normal_part_err1;
 	}
-	/* position of next data to be read*/
-	tmp_imgfile_start += onetime_read_sectors * 512;
-
-	/* check sparse format or not */
-	partdata_format = unsparse_probe((char *)down_buffer, first_write_bytes,
-					 partstart_by_sector);
-	if (partdata_format != ANDROID_FORMAT_DETECT) {
-		if (sunxi_sprite_write(tmp_partstart_by_sector,
-				       onetime_read_sectors,
-				       down_buffer) != onetime_read_sectors) {
-			printf("sunxi sprite error: download rawdata error %s\n",
-			       part_info->dl_filename);
-
-			goto __download_normal_part_err1;
-		}
-		tmp_partdata_by_bytes -= first_write_bytes;
-		tmp_partstart_by_sector += onetime_read_sectors;
-
-		while (tmp_partdata_by_bytes >= AU_ONCE_DATA_DEAL) {
-			/* continue read partition data from img*/
-			if (fat_fs_read(imgname, down_buffer, tmp_imgfile_start,
-					AU_ONCE_DATA_DEAL) !=
-			    AU_ONCE_DATA_DEAL) {
-				printf("sunxi sprite error : read sdcard start %d, total %d failed\n",
-				       tmp_imgfile_start, AU_ONCE_DATA_DEAL);
-
-				goto __download_normal_part_err1;
-			}
-			if (sunxi_sprite_write(tmp_partstart_by_sector,
-					       AU_ONCE_SECTOR_DEAL,
-					       down_buffer) !=
-			    AU_ONCE_SECTOR_DEAL) {
-				printf("sunxi sprite error: download rawdata error %s, start 0x%x, sectors 0x%x\n",
-				       part_info->dl_filename,
-				       tmp_partstart_by_sector,
-				       AU_ONCE_SECTOR_DEAL);
-
-				goto __download_normal_part_err1;
-			}
-			tmp_imgfile_start += AU_ONCE_SECTOR_DEAL * 512;
-			tmp_partdata_by_bytes -= AU_ONCE_DATA_DEAL;
-			tmp_partstart_by_sector += AU_ONCE_SECTOR_DEAL;
-		}
-		if (tmp_partdata_by_bytes > 0) {
-			uint rest_sectors = (tmp_partdata_by_bytes + 511) >> 9;
-			if (fat_fs_read(imgname, down_buffer, tmp_imgfile_start,
-					rest_sectors * 512) !=
-			    rest_sectors * 512) {
-				printf("sunxi sprite error : read sdcard start %d, total %d failed\n",
-				       tmp_imgfile_start, rest_sectors * 512);
-
-				goto __download_normal_part_err1;
-			}
-			if (sunxi_sprite_write(tmp_partstart_by_sector,
-					       rest_sectors,
-					       down_buffer) != rest_sectors) {
-				printf("sunxi sprite error: download rawdata error %s, start 0x%x, sectors 0x%x\n",
-				       part_info->dl_filename,
-				       tmp_partstart_by_sector, rest_sectors);
-
-				goto __download_normal_part_err1;
-			}
-		}
-	} else {
-		if (unsparse_direct_write(down_buffer, first_write_bytes)) {
-			printf("sunxi sprite error: download sparse error %s\n",
-			       part_info->dl_filename);
-
-			goto __download_normal_part_err1;
-		}
-		tmp_partdata_by_bytes -= first_write_bytes;
-
-		while (tmp_partdata_by_bytes >= AU_ONCE_DATA_DEAL) {
-			if (fat_fs_read(imgname, down_buffer, tmp_imgfile_start,
-					AU_ONCE_DATA_DEAL) !=
-			    AU_ONCE_DATA_DEAL) {
-				printf("sunxi sprite error : read sdcard start 0x%x, total 0x%x failed\n",
-				       tmp_imgfile_start, AU_ONCE_DATA_DEAL);
-
-				goto __download_normal_part_err1;
-			}
-			if (unsparse_direct_write(down_buffer,
-						  AU_ONCE_DATA_DEAL)) {
-				printf("sunxi sprite error: download sparse error %s\n",
-				       part_info->dl_filename);
-
-				goto __download_normal_part_err1;
-			}
-			tmp_imgfile_start += AU_ONCE_SECTOR_DEAL * 512;
-			tmp_partdata_by_bytes -= AU_ONCE_DATA_DEAL;
-		}
-		if (tmp_partdata_by_bytes > 0) {
-			uint rest_sectors = (tmp_partdata_by_bytes + 511) >> 9;
-			if (fat_fs_read(imgname, down_buffer, tmp_imgfile_start,
-					rest_sectors * 512) !=
-			    rest_sectors * 512) {
-				printf("sunxi sprite error : read sdcard start 0x%x, total 0x%x failed\n",
-				       tmp_imgfile_start, rest_sectors * 512);
+#endif
 
-				goto __download_normal_part_err1;
-			}
-			if (unsparse_direct_write(down_buffer,
-						  tmp_partdata_by_bytes)) {
-				printf("sunxi sprite error: download sparse error %s\n",
-				       part_info->dl_filename);
+	/* read partition data from img and write it, sparse format is probed */
+	if (sprite_pipe_download(pipe, &au_pipe_src, imgfile_start,
+				 partdata_by_byte, partstart_by_sector, 1,
+				 &partdata_format)) {
+		printf("sunxi sprite error: download part %s failed\n",
+		       part_info->dl_filename);
 
-				goto __download_normal_part_err1;
-			}
-		}
+		goto __download_normal_part_err1;
 	}
+	sprite_pipe_report(pipe, (char *)part_info->name);
 
 	tick_printf("successed in writting part %s\n", part_info->name);
 	ret = 0;
@@ -361,22 +312,12 @@ static int __download_normal_part(dl_one_part_info *part_info,
 
 				goto __download_normal_part_err1;
 			}
-			if (partdata_format == ANDROID_FORMAT_DETECT) {
-				active_verify =
-					sunxi_sprite_part_sparsedata_verify();
-			} else {
-				active_verify =
-					sunxi_sprite_part_rawdata_verify(
-						partstart_by_sector,
-						partdata_by_byte);
-			}
-			tmp	   = (uint *)verify_data;
-			origin_verify = *tmp;
-			printf("origin_verify value = %x, active_verify value = %x\n",
-			       origin_verify, active_verify);
-			if (origin_verify != active_verify) {
-				printf("origin checksum=%x, active checksum=%x\n",
-				       origin_verify, active_verify);
+			if (sunxi_sprite_part_verify(
+				    part_info, partstart_by_sector,
+				    partdata_by_byte,
+				    partdata_format == ANDROID_FORMAT_DETECT,
+				    verify_data,
+				    Img_GetItemSize(imghd, imgitemhd))) {
 				printf("sunxi sprite: part %s verify error\n",
 				       part_info->dl_filename);
 
@@ -402,7 +343,8 @@ __download_normal_part_err1:
 	return ret;
 }
 
-static int __download_udisk(dl_one_part_info *part_info, uchar *source_buff)
+static int __download_udisk(dl_one_part_info *part_info,
+			    struct sprite_pipe *pipe)
 {
 	HIMAGEITEM imgitemhd = NULL;
 	u32 flash_sector;
@@ -444,7 +386,7 @@ static int __download_udisk(dl_one_part_info *part_info, uchar *source_buff)
 	printf("UDISK low is 0x%x Sectors\n", part_info->lenlo);
 	printf("UDISK high is 0x%x Sectors\n", part_info->lenhi);
 
-	ret = __download_normal_part(part_info, source_buff);
+	ret = __download_normal_part(part_info, pipe);
 __download_udisk_err1:
 	ret1 = Img_CloseItem(imghd, imgitemhd);
 	if (ret1 != 0) {
@@ -457,20 +399,15 @@ __download_udisk_err1:
 }
 
 static int __download_sysrecover_part(dl_one_part_info *part_info,
-				      uchar *source_buff)
+				      struct sprite_pipe *pipe)
 {
 	uint partstart_by_sector;
-	uint tmp_partstart_by_sector;
 	s64 partsize_by_byte;
 	s64 partdata_by_byte;
-	s64 tmp_partdata_by_bytes;
-	uint onetime_read_sectors;
-	uint tmp_imgfile_start = 0;
-	u8 *down_buffer	= source_buff + AU_HEAD_BUFF;
-	int ret		       = -1;
+	int ret = -1;
 
-	tmp_partstart_by_sector = partstart_by_sector = part_info->addrlo;
-	partsize_by_byte			      = part_info->lenlo;
+	partstart_by_sector = part_info->addrlo;
+	partsize_by_byte    = part_info->lenlo;
 	partsize_by_byte <<= 9;
 
 	partdata_by_byte = Img_GetSize(imghd);
@@ -489,53 +426,15 @@ static int __download_sysrecover_part(dl_one_part_info *part_info,
 		goto __download_sysrecover_part_err1;
 	}
 
-	tmp_partdata_by_bytes = partdata_by_byte;
-	if (tmp_partdata_by_bytes >= AU_ONCE_DATA_DEAL) {
-		onetime_read_sectors = AU_ONCE_SECTOR_DEAL;
-	} else {
-		onetime_read_sectors = (tmp_partdata_by_bytes + 511) >> 9;
-	}
-
-	while (tmp_partdata_by_bytes >= AU_ONCE_DATA_DEAL) {
-		if (fat_fs_read(imgname, down_buffer, 0,
-				onetime_read_sectors * 512) !=
-		    onetime_read_sectors * 512) {
-			printf("sunxi sprite error : read sdcard start %d, total %d failed\n",
-			       tmp_imgfile_start, onetime_read_sectors * 512);
-
-			goto __download_sysrecover_part_err1;
-		}
-		if (sunxi_sprite_write(tmp_partstart_by_sector,
-				       onetime_read_sectors,
-				       down_buffer) != onetime_read_sectors) {
-			printf("sunxi sprite error: download rawdata error %s, start 0x%x, sectors 0x%x\n",
-			       part_info->dl_filename, tmp_partstart_by_sector,
-			       onetime_read_sectors);
-
-			goto __download_sysrecover_part_err1;
-		}
-		tmp_imgfile_start += onetime_read_sectors * 512;
-		tmp_partdata_by_bytes -= onetime_read_sectors * 512;
-		tmp_partstart_by_sector += onetime_read_sectors;
-	}
-	if (tmp_partdata_by_bytes > 0) {
-		uint rest_sectors = (tmp_partdata_by_bytes + 511) / 512;
-		if (fat_fs_read(imgname, down_buffer, tmp_imgfile_start,
-				rest_sectors * 512) != rest_sectors * 512) {
-			printf("sunxi sprite error : read sdcard start %d, total %d failed\n",
-			       tmp_imgfile_start, rest_sectors * 512);
-
-			goto __download_sysrecover_part_err1;
-		}
-		if (sunxi_sprite_write(tmp_partstart_by_sector, rest_sectors,
-				       down_buffer) != rest_sectors) {
-			printf("sunxi sprite error: download rawdata error %s, start 0x%x, sectors 0x%x\n",
-			       part_info->dl_filename, tmp_partstart_by_sector,
-			       rest_sectors);
+	/* the whole img goes to the partition as it is */
+	if (sprite_pipe_download(pipe, &au_pipe_src, 0, partdata_by_byte,
+				 partstart_by_sector, 0, NULL)) {
+		printf("sunxi sprite error: download rawdata error %s\n",
+		       part_info->dl_filename);
 
-			goto __download_sysrecover_part_err1;
-		}
+		goto __download_sysrecover_part_err1;
 	}
+	sprite_pipe_report(pipe, (char *)part_info->name);
 	ret = 0;
 
 __download_sysrecover_part_err1:
@@ -553,7 +452,7 @@ static int auto_update_deal_part(sunxi_download_info *dl_map)
 	int ret = -1;
 	int ret1;
 	int i		 = 0;
-	uchar *down_buff = NULL;
+	struct sprite_pipe pipe;
 	__maybe_unused int rate;
 
 	if (!dl_map->download_count) {
@@ -563,18 +462,21 @@ static int auto_update_deal_part(sunxi_download_info *dl_map)
 
 	rate = (70 - 10) / dl_map->download_count;
 
-	down_buff = (uchar *)memalign(CONFIG_SYS_CACHELINE_SIZE, AU_ONCE_DATA_DEAL + AU_HEAD_BUFF);
-	if (!down_buff) {
+	if (sprite_pipe_init(&pipe, AU_ONCE_DATA_DEAL)) {
 		printf("sunxi sprite err: unable to malloc memory for sunxi_sprite_deal_part\n");
 		goto __auto_update_deal_part_err1;
 	}
+#ifdef CONFIG_SUNXI_SPRITE_DELTA
+	/* without the compare buffer every part is simply written in full */
+	sprite_pipe_set_delta(&pipe, 1);
+#endif
 
 	for (part_info = dl_map->one_part_info, i = 0;
 	     i < dl_map->download_count; i++, part_info++) {
 		tick_printf("begin to download part %s\n", part_info->name);
 		if (!strncmp("UDISK", (char *)part_info->name,
 			     strlen("UDISK"))) {
-			ret1 = __download_udisk(part_info, down_buff);
+			ret1 = __download_udisk(part_info, &pipe);
 			if (ret1 < 0) {
 				printf("sunxi sprite err: sunxi_sprite_deal_part, download_udisk failed\n");
 
@@ -586,7 +488,7 @@ static int auto_update_deal_part(sunxi_download_info *dl_map)
 		/* sysrecovery partition: burn the whole img*/
 		else if (!strncmp("sysrecovery", (char *)part_info->name,
 				  strlen("sysrecovery"))) {
-			ret1 = __download_sysrecover_part(part_info, down_buff);
+			ret1 = __download_sysrecover_part(part_info, &pipe);
 			if (ret1 != 0) {
 				printf("sunxi sprite err: sunxi_sprite_deal_part, download sysrecovery failed\n");
 
@@ -600,7 +502,7 @@ static int auto_update_deal_part(sunxi_download_info *dl_map)
 				/*need to burn  private part*/
 				printf("NEED down private part\n");
 				ret1 = __download_normal_part(part_info,
-							      down_buff);
+							      &pipe);
 				if (ret1 != 0) {
 					printf("sunxi sprite err: sunxi_sprite_deal_part, download private failed\n");
 
@@ -610,7 +512,7 @@ static int auto_update_deal_part(sunxi_download_info *dl_map)
 				printf("IGNORE private part\n");
 			}
 		} else {
-			ret1 = __download_normal_part(part_info, down_buff);
+			ret1 = __download_normal_part(part_info, &pipe);
 			if (ret1 != 0) {
 				printf("sunxi sprite err: sunxi_sprite_deal_part, download normal failed\n");
 
@@ -628,9 +530,7 @@ __auto_update_deal_part_err1:
 
 __auto_update_deal_part_err2:
 
-	if (down_buff) {
-		free(down_buff);
-	}
+	sprite_pipe_exit(&pipe);
 
 	return ret;
 }
@@ -726,7 +626,7 @@ int auto_update_deal_uboot(int production_media)
 	return 0;
 }
 
-int sunxi_auto_update_main(void)
+static int __auto_update_main(void)
 {
 	int production_media;
 	/* uchar img_mbr[1024 * 1024]; */
@@ -835,6 +735,16 @@ int sunxi_auto_update_main(void)
 	return 0;
 }
 
+int sunxi_auto_update_main(void)
+{
+	int ret;
+
+	ret = __auto_update_main();
+	auto_update_firmware_release();
+
+	return ret;
+}
+
 
 static uboot_command *get_script_next_line(char *line_buf_ptr, int *arg_max)
 {
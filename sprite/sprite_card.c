@@ -18,6 +18,7 @@
 //#include "sprite_queue.h"
 #include "sprite_download.h"
 #include "sprite_verify.h"
+#include "sprite_pipe.h"
 #include "firmware/imgdecode.h"
 #include "dos_part.h"
 #include "private_uboot.h"
@@ -43,9 +44,72 @@ static void *imgitemhd;
 
 DECLARE_GLOBAL_DATA_PTR;
 
+static int card_pipe_read(void *priv, u64 offset, void *buf, uint bytes)
+{
+	uint start   = (uint)(offset >> 9);
+	uint sectors = bytes >> 9;
+
+	return sunxi_flash_read(start, sectors, buf) == sectors ? 0 : -1;
+}
+
+static struct sunxi_flash_req card_pipe_req;
+
+static int card_pipe_submit(void *priv, u64 offset, void *buf, uint bytes)
+{
+	return sunxi_flash_submit(&card_pipe_req, (uint)(offset >> 9),
+				  bytes >> 9, buf, 0);
+}
+
+static int card_pipe_wait(void *priv)
+{
+	return sunxi_flash_complete(&card_pipe_req) == card_pipe_req.nblock ?
+		       0 : -1;
+}
+
+static struct sprite_pipe_src card_pipe_src = {
+	.read	= card_pipe_read,
+	.submit = card_pipe_submit,
+	.wait	= card_pipe_wait,
+};
+
+#ifdef CONFIG_SUNXI_SPRITE_DELTA
+/* delta burn: the partition on flash already holds the image item */
+static int __normal_part_unchanged(dl_one_part_info *part_info,
+				   uint imgfile_start, s64 partdata_by_byte)
+{
+	HIMAGEITEM vf_item;
+	uchar *buf;
+	int ret = 0;
+
+	if (!part_info->vf_filename[0])
+		return 0;
+
+	/* verify file first, the head of the image behind it */
+	buf = memalign(CONFIG_SYS_CACHELINE_SIZE,
+		       ALIGN(1024 + 512, CONFIG_SYS_CACHELINE_SIZE));
+	if (!buf)
+		return 0;
+	vf_item = Img_OpenItem(imghd, "RFSFAT16", (char *)part_info->vf_filename);
+	if (!vf_item)
+		goto __normal_part_unchanged_out;
+	if (Img_ReadItem(imghd, vf_item, buf, 1024) &&
+	    !card_pipe_read(NULL, (u64)imgfile_start << 9, buf + 1024, 512))
+		ret = sunxi_sprite_part_unchanged(part_info, part_info->addrlo,
+						  partdata_by_byte, buf + 1024,
+						  buf,
+						  Img_GetItemSize(imghd, vf_item));
+	Img_CloseItem(imghd, vf_item);
+
+__normal_part_unchanged_out:
+	free(buf);
+
+	return ret;
+}
+#endif
+
 //extern int sunxi_flash_mmc_phywipe(unsigned long start_block, unsigned long nblock, unsigned long *skip);
 static int __download_normal_part(dl_one_part_info *part_info,
-				  uchar *source_buff);
+				  struct sprite_pipe *pipe);
 /*
 ************************************************************************************************************
 *
@@ -182,7 +246,8 @@ int sprite_card_fetch_mbr(void *img_mbr)
 *
 ************************************************************************************************************
 */
-static int __download_udisk(dl_one_part_info *part_info, uchar *source_buff)
+static int __download_udisk(dl_one_part_info *part_info,
+			    struct sprite_pipe *pipe)
 {
 	HIMAGEITEM imgitemhd = NULL;
 	u32 flash_sector;
@@ -226,7 +291,7 @@ static int __download_udisk(dl_one_part_info *part_info, uchar *source_buff)
 	printf("UDISK low is 0x%x Sectors\n", part_info->lenlo);
 	printf("UDISK high is 0x%x Sectors\n", part_info->lenhi);
 
-	ret = __download_normal_part(part_info, source_buff);
+	ret = __download_normal_part(part_info, pipe);
 __download_udisk_err1:
 	ret1 = Img_CloseItem(imghd, imgitemhd);
 	if (ret1 != 0) {
@@ -254,23 +319,15 @@ __download_udisk_err1:
 ************************************************************************************************************
 */
 static int __download_normal_part(dl_one_part_info *part_info,
-				  uchar *source_buff)
+				  struct sprite_pipe *pipe)
 {
 	uint partstart_by_sector; //分区起始扇区
-	uint tmp_partstart_by_sector;
 
 	s64 partsize_by_byte; //分区大小(字节单位)
 
 	s64 partdata_by_byte; //需要下载的分区数据(字节单位)
-	s64 tmp_partdata_by_bytes;
-
-	uint onetime_read_sectors; //一次读写的扇区数
-	uint first_write_bytes;
 
 	uint imgfile_start; //分区数据所在的扇区
-	uint tmp_imgfile_start;
-
-	u8 *down_buffer = source_buff + SPRITE_CARD_HEAD_BUFF;
 
 	int partdata_format;
 
@@ -278,9 +335,9 @@ static int __download_normal_part(dl_one_part_info *part_info,
 	//*******************************************************************
 	//获取分区起始扇区
 
-	tmp_partstart_by_sector = partstart_by_sector = part_info->addrlo;
-	debug("line:%d tmp_partstart_by_sector=0x%x\n", __LINE__,
-	      tmp_partstart_by_sector);
+	partstart_by_sector = part_info->addrlo;
+	debug("line:%d partstart_by_sector=0x%x\n", __LINE__,
+	      partstart_by_sector);
 	//获取分区大小，字节数
 	partsize_by_byte = part_info->lenlo;
 	partsize_by_byte <<= 9;
@@ -314,161 +371,33 @@ static int __download_normal_part(dl_one_part_info *part_info,
 
 		goto __download_normal_part_err1;
 	}
-	//准备读取分区镜像数据
-	tmp_partdata_by_bytes = partdata_by_byte;
-	if (tmp_partdata_by_bytes >= SPRITE_CARD_ONCE_DATA_DEAL) {
-		onetime_read_sectors = SPRITE_CARD_ONCE_SECTOR_DEAL;
-		first_write_bytes    = SPRITE_CARD_ONCE_DATA_DEAL;
-		debug("line:%d onetime_read_sectors=0x%x\n", __LINE__,
-		      onetime_read_sectors);
-		debug("line:%d first_write_bytes=0x%x\n", __LINE__,
-		      first_write_bytes);
-	} else {
-		onetime_read_sectors = (tmp_partdata_by_bytes + 511) >> 9;
-		first_write_bytes    = (uint)tmp_partdata_by_bytes;
-		debug("line:%d onetime_read_sectors=0x%x\n", __LINE__,
-		      onetime_read_sectors);
-		debug("line:%d first_write_bytes=0x%x\n", __LINE__,
-		      first_write_bytes);
-	}
 	//开始获取分区数据
 	imgfile_start = Img_GetItemStart(imghd, imgitemhd);
-	debug("line:%d imgfile_start=tmp_imgfile_start=0x%x\n", __LINE__,
-	      imgfile_start);
+	debug("line:%d imgfile_start=0x%x\n", __LINE__, imgfile_start);
 	if (!imgfile_start) {
 		printf("sunxi sprite err : cant get part data imgfile_start %s\n",
 		       part_info->dl_filename);
 
 		goto __download_normal_part_err1;
 	}
-	tmp_imgfile_start = imgfile_start;
-	//读出第一笔固件中的分区数据，大小为buffer字节数
-	if (sunxi_flash_read(tmp_imgfile_start, onetime_read_sectors,
-			     down_buffer) != onetime_read_sectors) {
-		printf("sunxi sprite error : read sdcard block %d, total %d failed\n",
-		       tmp_imgfile_start, onetime_read_sectors);
-
+#ifdef CONFIG_SUNXI_SPRITE_DELTA
+	if (__normal_part_unchanged(part_info, imgfile_start,
+				    partdata_by_byte)) {
+		tick_printf("part %s unchanged, skip it\n", part_info->name);
+		ret = 0;
 		goto __download_normal_part_err1;
 	}
-	//下一个要读出的数据
-	tmp_imgfile_start += onetime_read_sectors;
-	//尝试查看是否sparse格式
-	partdata_format = unsparse_probe((char *)down_buffer, first_write_bytes,
-					 partstart_by_sector); //判断数据格式
-	if (partdata_format != ANDROID_FORMAT_DETECT) {
-		//写入第一笔数据
-		if (sunxi_sprite_write(tmp_partstart_by_sector,
-				       onetime_read_sectors,
-				       down_buffer) != onetime_read_sectors) {
-			printf("sunxi sprite error: download rawdata error %s\n",
-			       part_info->dl_filename);
-
-			goto __download_normal_part_err1;
-		}
-		tmp_partdata_by_bytes -= first_write_bytes;
-		tmp_partstart_by_sector += onetime_read_sectors;
-
-		while (tmp_partdata_by_bytes >= SPRITE_CARD_ONCE_DATA_DEAL) {
-			//继续读出固件中的分区数据，大小为buffer字节数
-			if (sunxi_flash_read(tmp_imgfile_start,
-					     SPRITE_CARD_ONCE_SECTOR_DEAL,
-					     down_buffer) !=
-			    SPRITE_CARD_ONCE_SECTOR_DEAL) {
-				printf("sunxi sprite error : read sdcard block %d, total %d failed\n",
-				       tmp_imgfile_start,
-				       SPRITE_CARD_ONCE_SECTOR_DEAL);
-
-				goto __download_normal_part_err1;
-			}
-			//写入flash
-			if (sunxi_sprite_write(tmp_partstart_by_sector,
-					       SPRITE_CARD_ONCE_SECTOR_DEAL,
-					       down_buffer) !=
-			    SPRITE_CARD_ONCE_SECTOR_DEAL) {
-				printf("sunxi sprite error: download rawdata error %s, start 0x%x, sectors 0x%x\n",
-				       part_info->dl_filename,
-				       tmp_partstart_by_sector,
-				       SPRITE_CARD_ONCE_SECTOR_DEAL);
-
-				goto __download_normal_part_err1;
-			}
-			tmp_imgfile_start += SPRITE_CARD_ONCE_SECTOR_DEAL;
-			tmp_partdata_by_bytes -= SPRITE_CARD_ONCE_DATA_DEAL;
-			tmp_partstart_by_sector += SPRITE_CARD_ONCE_SECTOR_DEAL;
-		}
-		if (tmp_partdata_by_bytes > 0) {
-			uint rest_sectors = (tmp_partdata_by_bytes + 511) >> 9;
-			//继续读出固件中的分区数据，大小为buffer字节数
-			if (sunxi_flash_read(tmp_imgfile_start, rest_sectors,
-					     down_buffer) != rest_sectors) {
-				printf("sunxi sprite error : read sdcard block %d, total %d failed\n",
-				       tmp_imgfile_start, rest_sectors);
-
-				goto __download_normal_part_err1;
-			}
-			//写入flash
-			if (sunxi_sprite_write(tmp_partstart_by_sector,
-					       rest_sectors,
-					       down_buffer) != rest_sectors) {
-				printf("sunxi sprite error: download rawdata error %s, start 0x%x, sectors 0x%x\n",
-				       part_info->dl_filename,
-				       tmp_partstart_by_sector, rest_sectors);
-
-				goto __download_normal_part_err1;
-			}
-		}
-	} else {
-		if (unsparse_direct_write(down_buffer, first_write_bytes)) {
-			printf("sunxi sprite error: download sparse error %s\n",
-			       part_info->dl_filename);
-
-			goto __download_normal_part_err1;
-		}
-		tmp_partdata_by_bytes -= first_write_bytes;
-
-		while (tmp_partdata_by_bytes >= SPRITE_CARD_ONCE_DATA_DEAL) {
-			//继续读出固件中的分区数据，大小为buffer字节数
-			if (sunxi_flash_read(tmp_imgfile_start,
-					     SPRITE_CARD_ONCE_SECTOR_DEAL,
-					     down_buffer) !=
-			    SPRITE_CARD_ONCE_SECTOR_DEAL) {
-				printf("sunxi sprite error : read sdcard block 0x%x, total 0x%x failed\n",
-				       tmp_imgfile_start,
-				       SPRITE_CARD_ONCE_SECTOR_DEAL);
-
-				goto __download_normal_part_err1;
-			}
-			//写入flash
-			if (unsparse_direct_write(down_buffer,
-						  SPRITE_CARD_ONCE_DATA_DEAL)) {
-				printf("sunxi sprite error: download sparse error %s\n",
-				       part_info->dl_filename);
-
-				goto __download_normal_part_err1;
-			}
-			tmp_imgfile_start += SPRITE_CARD_ONCE_SECTOR_DEAL;
-			tmp_partdata_by_bytes -= SPRITE_CARD_ONCE_DATA_DEAL;
-		}
-		if (tmp_partdata_by_bytes > 0) {
-			uint rest_sectors = (tmp_partdata_by_bytes + 511) >> 9;
-			//继续读出固件中的分区数据，大小为buffer字节数
-			if (sunxi_flash_read(tmp_imgfile_start, rest_sectors,
-					     down_buffer) != rest_sectors) {
-				printf("sunxi sprite error : read sdcard block 0x%x, total 0x%x failed\n",
-				       tmp_imgfile_start, rest_sectors);
-
-				goto __download_normal_part_err1;
-			}
-			//写入flash
-			if (unsparse_direct_write(down_buffer,
-						  tmp_partdata_by_bytes)) {
-				printf("sunxi sprite error: download sparse error %s\n",
-				       part_info->dl_filename);
+#endif
+	//读出固件中的分区数据并写入flash，自动识别sparse格式
+	if (sprite_pipe_download(pipe, &card_pipe_src, (u64)imgfile_start << 9,
+				 partdata_by_byte, partstart_by_sector, 1,
+				 &partdata_format)) {
+		printf("sunxi sprite error: download part %s failed\n",
+		       part_info->dl_filename);
 
-				goto __download_normal_part_err1;
-			}
-		}
+		goto __download_normal_part_err1;
 	}
+	sprite_pipe_report(pipe, (char *)part_info->name);
 
 	tick_printf("successed in writting part %s\n", part_info->name);
 	ret = 0;
@@ -478,8 +407,6 @@ static int __download_normal_part(dl_one_part_info *part_info,
 	}
 	//判断是否需要进行校验
 	if (part_info->verify) {
-		uint active_verify;
-		uint origin_verify;
 		uchar *verify_data;
 		verify_data = (uchar *)memalign(CONFIG_SYS_CACHELINE_SIZE, ALIGN(1024, CONFIG_SYS_CACHELINE_SIZE));
 		memset(verify_data, 0, ALIGN(1024, CONFIG_SYS_CACHELINE_SIZE));
@@ -502,25 +429,12 @@ static int __download_normal_part(dl_one_part_info *part_info,
 
 				goto __download_normal_part_err1;
 			}
-			if (partdata_format == ANDROID_FORMAT_DETECT) {
-				active_verify =
-					sunxi_sprite_part_sparsedata_verify();
-			} else {
-				active_verify =
-					sunxi_sprite_part_rawdata_verify(
-						partstart_by_sector,
-						partdata_by_byte);
-			}
-			{
-				uint *tmp = (uint *)verify_data;
-
-				origin_verify = *tmp;
-			}
-			printf("origin_verify value = %x, active_verify value = %x\n",
-			       origin_verify, active_verify);
-			if (origin_verify != active_verify) {
-				printf("origin checksum=%x, active checksum=%x\n",
-				       origin_verify, active_verify);
+			if (sunxi_sprite_part_verify(
+				    part_info, partstart_by_sector,
+				    partdata_by_byte,
+				    partdata_format == ANDROID_FORMAT_DETECT,
+				    verify_data,
+				    Img_GetItemSize(imghd, imgitemhd))) {
 				printf("sunxi sprite: part %s verify error\n",
 				       part_info->dl_filename);
 
@@ -562,27 +476,20 @@ __download_normal_part_err1:
 ************************************************************************************************************
 */
 static int __download_sysrecover_part(dl_one_part_info *part_info,
-				      uchar *source_buff)
+				      struct sprite_pipe *pipe)
 {
 	uint partstart_by_sector; //分区起始扇区
-	uint tmp_partstart_by_sector;
 
 	s64 partsize_by_byte; //分区大小(字节单位)
 
 	s64 partdata_by_byte; //需要下载的分区数据(字节单位)
-	s64 tmp_partdata_by_bytes;
-
-	uint onetime_read_sectors; //一次读写的扇区数
 
 	uint imgfile_start; //分区数据所在的扇区
-	uint tmp_imgfile_start;
-
-	u8 *down_buffer = source_buff + SPRITE_CARD_HEAD_BUFF;
 
 	int ret = -1;
 	//*******************************************************************
 	//获取分区起始扇区
-	tmp_partstart_by_sector = partstart_by_sector = part_info->addrlo;
+	partstart_by_sector = part_info->addrlo;
 	//获取分区大小，字节数
 	partsize_by_byte = part_info->lenlo;
 	partsize_by_byte <<= 9;
@@ -604,13 +511,6 @@ static int __download_sysrecover_part(dl_one_part_info *part_info,
 
 		goto __download_sysrecover_part_err1;
 	}
-	//准备读取分区镜像数据
-	tmp_partdata_by_bytes = partdata_by_byte;
-	if (tmp_partdata_by_bytes >= SPRITE_CARD_ONCE_DATA_DEAL) {
-		onetime_read_sectors = SPRITE_CARD_ONCE_SECTOR_DEAL;
-	} else {
-		onetime_read_sectors = (tmp_partdata_by_bytes + 511) >> 9;
-	}
 	//开始获取分区数据
 	imgfile_start = sprite_card_firmware_start();
 	if (!imgfile_start) {
@@ -619,51 +519,16 @@ static int __download_sysrecover_part(dl_one_part_info *part_info,
 
 		goto __download_sysrecover_part_err1;
 	}
-	tmp_imgfile_start = imgfile_start;
-
-	while (tmp_partdata_by_bytes >= SPRITE_CARD_ONCE_DATA_DEAL) {
-		//继续读出固件中的分区数据，大小为buffer字节数
-		if (sunxi_flash_read(tmp_imgfile_start, onetime_read_sectors,
-				     down_buffer) != onetime_read_sectors) {
-			printf("sunxi sprite error : read sdcard block %d, total %d failed\n",
-			       tmp_imgfile_start, onetime_read_sectors);
-
-			goto __download_sysrecover_part_err1;
-		}
-		//写入flash
-		if (sunxi_sprite_write(tmp_partstart_by_sector,
-				       onetime_read_sectors,
-				       down_buffer) != onetime_read_sectors) {
-			printf("sunxi sprite error: download rawdata error %s, start 0x%x, sectors 0x%x\n",
-			       part_info->dl_filename, tmp_partstart_by_sector,
-			       onetime_read_sectors);
-
-			goto __download_sysrecover_part_err1;
-		}
-		tmp_imgfile_start += onetime_read_sectors;
-		tmp_partdata_by_bytes -= onetime_read_sectors * 512;
-		tmp_partstart_by_sector += onetime_read_sectors;
-	}
-	if (tmp_partdata_by_bytes > 0) {
-		uint rest_sectors = (tmp_partdata_by_bytes + 511) / 512;
-		//继续读出固件中的分区数据，大小为buffer字节数
-		if (sunxi_flash_read(tmp_imgfile_start, rest_sectors,
-				     down_buffer) != rest_sectors) {
-			printf("sunxi sprite error : read sdcard block %d, total %d failed\n",
-			       tmp_imgfile_start, rest_sectors);
+	//整个固件原样写入分区
+	if (sprite_pipe_download(pipe, &card_pipe_src, (u64)imgfile_start << 9,
+				 partdata_by_byte, partstart_by_sector, 0,
+				 NULL)) {
+		printf("sunxi sprite error: download rawdata error %s\n",
+		       part_info->dl_filename);
 
-			goto __download_sysrecover_part_err1;
-		}
-		//写入flash
-		if (sunxi_sprite_write(tmp_partstart_by_sector, rest_sectors,
-				       down_buffer) != rest_sectors) {
-			printf("sunxi sprite error: download rawdata error %s, start 0x%x, sectors 0x%x\n",
-			       part_info->dl_filename, tmp_partstart_by_sector,
-			       rest_sectors);
-
-			goto __download_sysrecover_part_err1;
-		}
+		goto __download_sysrecover_part_err1;
 	}
+	sprite_pipe_report(pipe, (char *)part_info->name);
 	ret = 0;
 
 __download_sysrecover_part_err1:
@@ -696,7 +561,7 @@ int sunxi_sprite_deal_part(sunxi_download_info *dl_map)
 	int ret = -1;
 	int ret1;
 	int i		 = 0;
-	uchar *down_buff = NULL;
+	struct sprite_pipe pipe;
 
 	if (!dl_map->download_count) {
 		printf("sunxi sprite: no part need to write\n");
@@ -711,20 +576,22 @@ int sunxi_sprite_deal_part(sunxi_download_info *dl_map)
 	//		return -1;
 	//	}
 	//申请内存
-	down_buff = (uchar *)memalign(CONFIG_SYS_CACHELINE_SIZE, ALIGN(SPRITE_CARD_ONCE_DATA_DEAL +
-				    SPRITE_CARD_HEAD_BUFF, CONFIG_SYS_CACHELINE_SIZE));
-	if (!down_buff) {
+	if (sprite_pipe_init(&pipe, SPRITE_CARD_ONCE_DATA_DEAL)) {
 		printf("sunxi sprite err: unable to malloc memory for sunxi_sprite_deal_part\n");
 
 		goto __sunxi_sprite_deal_part_err1;
 	}
+#ifdef CONFIG_SUNXI_SPRITE_DELTA
+	/* without the compare buffer every part is simply written in full */
+	sprite_pipe_set_delta(&pipe, 1);
+#endif
 	for (part_info = dl_map->one_part_info, i = 0;
 	     i < dl_map->download_count; i++, part_info++) {
 		tick_printf("begin to download part %s\n", part_info->name);
 
 		if (!strncmp("UDISK", (char *)part_info->name,
 			     strlen("UDISK"))) {
-			ret1 = __download_udisk(part_info, down_buff);
+			ret1 = __download_udisk(part_info, &pipe);
 			if (ret1 < 0) {
 				printf("sunxi sprite err: sunxi_sprite_deal_part, download_udisk failed\n");
 
@@ -735,7 +602,7 @@ int sunxi_sprite_deal_part(sunxi_download_info *dl_map)
 		} //如果是sysrecovery分区，烧录完整分区镜像
 		else if (!strncmp("sysrecovery", (char *)part_info->name,
 				  strlen("sysrecovery"))) {
-			ret1 = __download_sysrecover_part(part_info, down_buff);
+			ret1 = __download_sysrecover_part(part_info, &pipe);
 			if (ret1 != 0) {
 				printf("sunxi sprite err: sunxi_sprite_deal_part, download sysrecovery failed\n");
 
@@ -748,7 +615,7 @@ int sunxi_sprite_deal_part(sunxi_download_info *dl_map)
 				//需要烧录此分区
 				printf("NEED down private part\n");
 				ret1 = __download_normal_part(part_info,
-							      down_buff);
+							      &pipe);
 				if (ret1 != 0) {
 					printf("line:%d sunxi sprite err: sunxi_sprite_deal_part, download private failed\n",
 					       __LINE__);
@@ -759,7 +626,7 @@ int sunxi_sprite_deal_part(sunxi_download_info *dl_map)
 				printf("IGNORE private part\n");
 			}
 		} else {
-			ret1 = __download_normal_part(part_info, down_buff);
+			ret1 = __download_normal_part(part_info, &pipe);
 			if (ret1 != 0) {
 				printf("line:%d sunxi sprite err: sunxi_sprite_deal_part, download private failed\n",
 				       __LINE__);
@@ -777,9 +644,7 @@ __sunxi_sprite_deal_part_err1:
 
 __sunxi_sprite_deal_part_err2:
 
-	if (down_buff) {
-		free(down_buff);
-	}
+	sprite_pipe_exit(&pipe);
 
 	return ret;
 }
@@ -1641,7 +1506,7 @@ int sunxi_sprite_deal_part_from_sysrevoery(sunxi_download_info *dl_map)
 	int ret = -1;
 	int ret1;
 	int i		 = 0;
-	uchar *down_buff = NULL;
+	struct sprite_pipe pipe;
 	__maybe_unused int rate;
 
 	if (!dl_map->download_count) {
@@ -1649,11 +1514,9 @@ int sunxi_sprite_deal_part_from_sysrevoery(sunxi_download_info *dl_map)
 		return 0;
 	}
 	rate = (80) / (dl_map->download_count + 1);
-	down_buff = (uchar *)memalign(CONFIG_SYS_CACHELINE_SIZE, ALIGN(SPRITE_CARD_ONCE_DATA_DEAL +
-				    SPRITE_CARD_HEAD_BUFF, CONFIG_SYS_CACHELINE_SIZE));
-	if (!down_buff) {
+	if (sprite_pipe_init(&pipe, SPRITE_CARD_ONCE_DATA_DEAL)) {
 		printf("sunxi sprite err: unable to malloc memory for sunxi_sprite_deal_part\n");
-		goto __sunxi_sprite_deal_part_err;
+		return -1;
 	}
 
 	for (part_info = dl_map->one_part_info, i = 0;
@@ -1677,7 +1540,7 @@ int sunxi_sprite_deal_part_from_sysrevoery(sunxi_download_info *dl_map)
 			//			sprite_cartoon_upgrade(20 + rate * (i+1));
 			continue;
 		} else {
-			ret1 = __download_normal_part(part_info, down_buff);
+			ret1 = __download_normal_part(part_info, &pipe);
 			if (ret1 != 0) {
 				printf("sunxi sprite err: sunxi_sprite_deal_part, download normal failed\n");
 				goto __sunxi_sprite_deal_part_err;
@@ -1691,9 +1554,7 @@ int sunxi_sprite_deal_part_from_sysrevoery(sunxi_download_info *dl_map)
 
 __sunxi_sprite_deal_part_err:
 
-	if (down_buff) {
-		free(down_buff);
-	}
+	sprite_pipe_exit(&pipe);
 
 	return ret;
 }
@@ -145,6 +145,8 @@ int sunxi_sprite_download_mbr(void *buffer, uint buffer_size)
 	if ((storage_type == STORAGE_NAND) && (sunxi_sprite_init(0))) {
 		return -2;
 	}
+	/* the map is rewritten, drop the partition name index */
+	sunxi_partition_index_invalidate();
 	/*write GPT Table*/
 	ret = download_standard_gpt(buffer,buffer_size,storage_type);
 	if(ret) {
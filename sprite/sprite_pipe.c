@@ -0,0 +1,365 @@
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * SPDX-License-Identifier:     GPL-2.0+
+ *
+ * chunk pipeline shared by the card, auto update and sysrecovery burn
+ * paths: firmware chunks are read into a ring of buffers and written to
+ * the target flash from the oldest one, so a source able to run its
+ * transfer in the background keeps reading while the flash is written.
+ * In delta mode raw data is first compared with what the flash holds and
+ * only the ranges that differ are written.
+ */
+#include <common.h>
+#include <malloc.h>
+#include <div64.h>
+#include <sunxi_flash.h>
+#include "sparse/sparse.h"
+#include "sprite_pipe.h"
+
+struct sprite_pipe_state {
+	struct sprite_pipe *pipe;
+	struct sprite_pipe_src *src;
+	u64 src_offset;
+	s64 bytes;
+	s64 issued;
+	int head;
+	int ready;
+	int pending;
+	ulong submit_at;
+};
+
+int sprite_pipe_init(struct sprite_pipe *pipe, uint chunk_bytes)
+{
+	int i;
+
+	memset(pipe, 0, sizeof(*pipe));
+	pipe->depth	  = CONFIG_SUNXI_SPRITE_PIPE_DEPTH;
+	pipe->chunk_bytes = chunk_bytes;
+	for (i = 0; i < pipe->depth; i++) {
+		pipe->slot[i].base = memalign(CONFIG_SYS_CACHELINE_SIZE,
+					      ALIGN(SPRITE_PIPE_HEAD_BUFF + chunk_bytes,
+						    CONFIG_SYS_CACHELINE_SIZE));
+		if (!pipe->slot[i].base) {
+			printf("sprite pipe: unable to malloc chunk buffer %d\n",
+			       i);
+			sprite_pipe_exit(pipe);
+			return -1;
+		}
+		pipe->slot[i].data = pipe->slot[i].base + SPRITE_PIPE_HEAD_BUFF;
+	}
+
+	return 0;
+}
+
+void sprite_pipe_exit(struct sprite_pipe *pipe)
+{
+	int i;
+
+	for (i = 0; i < pipe->depth; i++) {
+		if (pipe->slot[i].base)
+			free(pipe->slot[i].base);
+		pipe->slot[i].base = NULL;
+		pipe->slot[i].data = NULL;
+	}
+	sprite_pipe_set_delta(pipe, 0);
+}
+
+/*
+ * in delta mode every raw chunk is read back from the flash before it is
+ * written, this costs a flash read but saves the write of unchanged data
+ */
+int sprite_pipe_set_delta(struct sprite_pipe *pipe, int enable)
+{
+	if (!enable) {
+		if (pipe->cmp)
+			free(pipe->cmp);
+		pipe->cmp = NULL;
+		return 0;
+	}
+	if (pipe->cmp)
+		return 0;
+
+	pipe->cmp = memalign(CONFIG_SYS_CACHELINE_SIZE,
+			     ALIGN(pipe->chunk_bytes, CONFIG_SYS_CACHELINE_SIZE));
+	if (!pipe->cmp) {
+		printf("sprite pipe: unable to malloc delta buffer\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static int __pipe_write(uint flash_start, uint sectors, u8 *data)
+{
+	if (sunxi_sprite_write(flash_start, sectors, data) != sectors) {
+		printf("sprite pipe: write start 0x%x, sectors 0x%x failed\n",
+		       flash_start, sectors);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* write the ranges of @data that differ from the flash, whole sectors */
+static int __pipe_write_delta(struct sprite_pipe *pipe, uint flash_start,
+			      u8 *data, uint sectors)
+{
+	uint range = SPRITE_PIPE_DELTA_RANGE >> 9;
+	uint from, to, cnt;
+
+	/* unreadable data is rewritten in full */
+	if (sunxi_sprite_read(flash_start, sectors, pipe->cmp) != sectors)
+		return __pipe_write(flash_start, sectors, data);
+
+	for (from = 0; from < sectors; from = to) {
+		cnt = min(range, sectors - from);
+		to  = from + cnt;
+		if (!memcmp(data + (from << 9), pipe->cmp + (from << 9),
+			    cnt << 9)) {
+			pipe->skip_bytes += cnt << 9;
+			continue;
+		}
+		/* neighbouring dirty ranges go out with one write */
+		for (; to < sectors; to += cnt) {
+			cnt = min(range, sectors - to);
+			if (!memcmp(data + (to << 9), pipe->cmp + (to << 9),
+				    cnt << 9))
+				break;
+		}
+		if (__pipe_write(flash_start + from, to - from,
+				 data + (from << 9)))
+			return -1;
+	}
+
+	return 0;
+}
+
+/* start reads into every free slot, at most one outstanding for async sources */
+static int __pipe_fill(struct sprite_pipe_state *st)
+{
+	struct sprite_pipe *pipe    = st->pipe;
+	struct sprite_pipe_src *src = st->src;
+	struct sprite_pipe_slot *slot;
+	ulong start;
+	uint len;
+
+	while (st->issued < st->bytes &&
+	       st->ready + st->pending < pipe->depth) {
+		if (src->submit && st->pending)
+			break;
+		slot = &pipe->slot[(st->head + st->ready + st->pending) %
+				   pipe->depth];
+		len = min_t(s64, pipe->chunk_bytes, st->bytes - st->issued);
+		slot->bytes = len;
+
+		start = get_timer(0);
+		if (src->submit) {
+			if (src->submit(src->priv, st->src_offset + st->issued,
+					slot->data, ALIGN(len, 512)))
+				goto __pipe_fill_err;
+			st->pending   = 1;
+			st->submit_at = start;
+		} else {
+			if (src->read(src->priv, st->src_offset + st->issued,
+				      slot->data, ALIGN(len, 512)))
+				goto __pipe_fill_err;
+			st->ready++;
+			pipe->read_ms += get_timer(start);
+			pipe->stall_ms += get_timer(start);
+		}
+		st->issued += len;
+	}
+
+	return 0;
+
+__pipe_fill_err:
+	printf("sprite pipe: read source offset 0x%llx, len 0x%x failed\n",
+	       st->src_offset + st->issued, len);
+	return -1;
+}
+
+static int __pipe_wait(struct sprite_pipe_state *st)
+{
+	ulong start;
+	int ret;
+
+	if (!st->pending)
+		return 0;
+
+	start = get_timer(0);
+	ret   = st->src->wait(st->src->priv);
+	/* the source was busy from submit on, the cpu only from here */
+	st->pipe->read_ms += get_timer(st->submit_at);
+	st->pipe->stall_ms += get_timer(start);
+	st->pending = 0;
+	if (ret) {
+		printf("sprite pipe: wait source data failed\n");
+		return -1;
+	}
+	st->ready++;
+
+	return 0;
+}
+
+/*
+ * copy @bytes of image data starting at @src_offset to the flash at sector
+ * @flash_start. With @probe_sparse the first chunk is checked for the
+ * android sparse format and the data goes through the sparse writer,
+ * the detected format is returned in @format.
+ */
+int sprite_pipe_download(struct sprite_pipe *pipe, struct sprite_pipe_src *src,
+			 u64 src_offset, s64 bytes, uint flash_start,
+			 int probe_sparse, int *format)
+{
+	struct sprite_pipe_state st;
+	struct sprite_pipe_slot *cur, *prev = NULL;
+	int data_format			    = ANDROID_FORMAT_UNKNOW;
+	uint rest, sectors;
+	s64 done = 0;
+	ulong start, wall;
+	int ret = -1, err;
+
+	memset(&st, 0, sizeof(st));
+	st.pipe	      = pipe;
+	st.src	      = src;
+	st.src_offset = src_offset;
+	st.bytes      = bytes;
+
+	pipe->read_ms	  = 0;
+	pipe->stall_ms	  = 0;
+	pipe->write_ms	  = 0;
+	pipe->total_bytes = bytes;
+	pipe->skip_bytes  = 0;
+	wall		  = get_timer(0);
+
+	while (done < bytes) {
+		if (__pipe_fill(&st))
+			goto __pipe_download_err;
+		if (!st.ready) {
+			if (__pipe_wait(&st) || __pipe_fill(&st))
+				goto __pipe_download_err;
+		}
+		cur = &pipe->slot[st.head];
+
+		if (!done && probe_sparse)
+			data_format = unsparse_probe((char *)cur->data,
+						     cur->bytes, flash_start);
+
+		start = get_timer(0);
+		if (data_format == ANDROID_FORMAT_DETECT) {
+			/* unfinished sparse data sits in front of the last buffer */
+			rest = unsparse_pending_bytes();
+			if (prev && prev != cur && rest)
+				memcpy(cur->data - rest, prev->data - rest,
+				       rest);
+			if (unsparse_direct_write(cur->data, cur->bytes)) {
+				printf("sprite pipe: sparse write failed\n");
+				goto __pipe_download_err;
+			}
+		} else {
+			sectors = (cur->bytes + 511) >> 9;
+			if (pipe->cmp)
+				err = __pipe_write_delta(pipe, flash_start,
+							 cur->data, sectors);
+			else
+				err = __pipe_write(flash_start, sectors,
+						   cur->data);
+			if (err)
+				goto __pipe_download_err;
+			flash_start += sectors;
+		}
+		pipe->write_ms += get_timer(start);
+
+		done += cur->bytes;
+		prev	= cur;
+		st.head = (st.head + 1) % pipe->depth;
+		st.ready--;
+	}
+	ret = 0;
+
+__pipe_download_err:
+	/* never leave a transfer running into a buffer that may be freed */
+	if (st.pending)
+		src->wait(src->priv);
+	pipe->wall_ms = get_timer(wall);
+	if (format)
+		*format = data_format;
+
+	return ret;
+}
+
+/*
+ * read @bytes starting at @src_offset through the ring and hand every chunk
+ * to @consume in order, for work on data already on flash such as verify.
+ * the write statistics account the time spent in @consume.
+ */
+int sprite_pipe_scan(struct sprite_pipe *pipe, struct sprite_pipe_src *src,
+		     u64 src_offset, s64 bytes,
+		     int (*consume)(void *priv, void *buf, uint bytes),
+		     void *priv)
+{
+	struct sprite_pipe_state st;
+	struct sprite_pipe_slot *cur;
+	s64 done = 0;
+	ulong start, wall;
+	int ret = -1;
+
+	memset(&st, 0, sizeof(st));
+	st.pipe	      = pipe;
+	st.src	      = src;
+	st.src_offset = src_offset;
+	st.bytes      = bytes;
+
+	pipe->read_ms	  = 0;
+	pipe->stall_ms	  = 0;
+	pipe->write_ms	  = 0;
+	pipe->total_bytes = bytes;
+	pipe->skip_bytes  = 0;
+	wall		  = get_timer(0);
+
+	while (done < bytes) {
+		if (__pipe_fill(&st))
+			goto __pipe_scan_err;
+		if (!st.ready) {
+			if (__pipe_wait(&st) || __pipe_fill(&st))
+				goto __pipe_scan_err;
+		}
+		cur = &pipe->slot[st.head];
+
+		start = get_timer(0);
+		if (consume(priv, cur->data, cur->bytes))
+			goto __pipe_scan_err;
+		pipe->write_ms += get_timer(start);
+
+		done += cur->bytes;
+		st.head = (st.head + 1) % pipe->depth;
+		st.ready--;
+	}
+	ret = 0;
+
+__pipe_scan_err:
+	if (st.pending)
+		src->wait(src->priv);
+	pipe->wall_ms = get_timer(wall);
+
+	return ret;
+}
+
+void sprite_pipe_report(struct sprite_pipe *pipe, const char *name)
+{
+	ulong busy    = pipe->read_ms + pipe->write_ms;
+	ulong overlap = busy > pipe->wall_ms ? busy - pipe->wall_ms : 0;
+	ulong kbps    = 0;
+
+	if (pipe->wall_ms)
+		kbps = (ulong)lldiv(pipe->total_bytes, pipe->wall_ms);
+
+	pr_msg("sprite pipe %s: 0x%llx bytes, depth %d, read %lu ms (stall %lu ms), write %lu ms, total %lu ms, overlap %lu ms, %lu KB/s\n",
+	       name, pipe->total_bytes, pipe->depth, pipe->read_ms,
+	       pipe->stall_ms, pipe->write_ms, pipe->wall_ms, overlap, kbps);
+	if (pipe->cmp)
+		pr_msg("sprite pipe %s: delta, 0x%llx bytes unchanged\n", name,
+		       pipe->skip_bytes);
+}
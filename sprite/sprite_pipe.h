@@ -0,0 +1,70 @@
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * SPDX-License-Identifier:     GPL-2.0+
+ */
+#ifndef __SUNXI_SPRITE_PIPE_H__
+#define __SUNXI_SPRITE_PIPE_H__
+
+#include <common.h>
+
+#ifndef CONFIG_SUNXI_SPRITE_PIPE_DEPTH
+#define CONFIG_SUNXI_SPRITE_PIPE_DEPTH 2
+#endif
+
+/*
+ * room kept in front of every chunk buffer, the sparse writer puts the
+ * tail of an unfinished chunk there before handling the next buffer
+ */
+#define SPRITE_PIPE_HEAD_BUFF (32 * 1024)
+
+/* delta burn compares raw data with the flash in ranges of this size */
+#define SPRITE_PIPE_DELTA_RANGE (64 * 1024)
+
+/*
+ * firmware source of a download, offsets are in bytes from the start of
+ * the image. read() is blocking; submit()/wait() are optional and let the
+ * source DMA of the next chunk run while the current chunk is written.
+ */
+struct sprite_pipe_src {
+	int (*read)(void *priv, u64 offset, void *buf, uint bytes);
+	int (*submit)(void *priv, u64 offset, void *buf, uint bytes);
+	int (*wait)(void *priv);
+	void *priv;
+};
+
+struct sprite_pipe_slot {
+	u8 *base;
+	u8 *data;
+	uint bytes;
+};
+
+struct sprite_pipe {
+	struct sprite_pipe_slot slot[CONFIG_SUNXI_SPRITE_PIPE_DEPTH];
+	int depth;
+	uint chunk_bytes;
+	/* delta burn: raw data is read back and only changed ranges written */
+	u8 *cmp;
+	/* statistics of the last download, in ms */
+	ulong read_ms;
+	ulong stall_ms;
+	ulong write_ms;
+	ulong wall_ms;
+	u64 total_bytes;
+	u64 skip_bytes;
+};
+
+int sprite_pipe_init(struct sprite_pipe *pipe, uint chunk_bytes);
+void sprite_pipe_exit(struct sprite_pipe *pipe);
+int sprite_pipe_set_delta(struct sprite_pipe *pipe, int enable);
+int sprite_pipe_download(struct sprite_pipe *pipe, struct sprite_pipe_src *src,
+			 u64 src_offset, s64 bytes, uint flash_start,
+			 int probe_sparse, int *format);
+int sprite_pipe_scan(struct sprite_pipe *pipe, struct sprite_pipe_src *src,
+		     u64 src_offset, s64 bytes,
+		     int (*consume)(void *priv, void *buf, uint bytes),
+		     void *priv);
+void sprite_pipe_report(struct sprite_pipe *pipe, const char *name);
+
+#endif /* __SUNXI_SPRITE_PIPE_H__ */
@@ -23,86 +23,16 @@
 #include "sprite_card.h"
 #include "sprite_download.h"
 #include "./firmware/imgdecode.h"
-#include "./firmware/imagefile_new.h"
 #include <sys_config.h>
 #include <fdt_support.h>
 #include "./cartoon/sprite_cartoon.h"
 #include <sys_partition.h>
 
-extern uint img_file_start;
 extern int sunxi_sprite_deal_part_from_sysrevoery(sunxi_download_info *dl_map);
 extern int __imagehd(HIMAGE tmp_himage);
 extern int char8_char16_compare(const char *char8, const efi_char16_t *char16,
 				size_t char16_len);
 
-typedef struct tag_IMAGE_HANDLE {
-	ImageHead_t ImageHead;
-	ImageItem_t *ItemTable;
-} IMAGE_HANDLE;
-
-static HIMAGE Img_Open_from_sysrecovery(__u32 start)
-{
-	IMAGE_HANDLE *pImage = NULL;
-	uint ItemTableSize;
-
-	img_file_start = start;
-	if (!img_file_start) {
-		pr_err("sunxi sprite error: unable to get firmware start position\n");
-
-		return NULL;
-	}
-	debug("img start = 0x%x\n", img_file_start);
-	pImage = (IMAGE_HANDLE *)malloc(sizeof(IMAGE_HANDLE));
-	if (NULL == pImage) {
-		pr_err("sunxi sprite error: fail to malloc memory for img head\n");
-
-		return NULL;
-	}
-	memset(pImage, 0, sizeof(IMAGE_HANDLE));
-
-	//debug("try to read mmc start %d\n", img_file_start);
-	if (!sunxi_flash_read(img_file_start, IMAGE_HEAD_SIZE / 512,
-			      &pImage->ImageHead)) {
-		pr_err("sunxi sprite error: read iamge head fail\n");
-
-		goto _img_open_fail_;
-	}
-	debug("read mmc ok\n");
-
-	if (memcmp(pImage->ImageHead.magic, IMAGE_MAGIC, 8) != 0) {
-		pr_err("sunxi sprite error: iamge magic is bad\n");
-
-		goto _img_open_fail_;
-	}
-
-	ItemTableSize     = pImage->ImageHead.itemcount * sizeof(ImageItem_t);
-	pImage->ItemTable = (ImageItem_t *)malloc(ItemTableSize);
-	if (NULL == pImage->ItemTable) {
-		pr_err("sunxi sprite error: fail to malloc memory for item table\n");
-
-		goto _img_open_fail_;
-	}
-
-	if (!sunxi_flash_read(img_file_start + (IMAGE_HEAD_SIZE / 512),
-			      ItemTableSize / 512, pImage->ItemTable)) {
-		pr_err("sunxi sprite error: read iamge item table fail\n");
-
-		goto _img_open_fail_;
-	}
-
-	return pImage;
-
-_img_open_fail_:
-	if (pImage->ItemTable) {
-		free(pImage->ItemTable);
-	}
-	if (pImage) {
-		free(pImage);
-	}
-
-	return NULL;
-}
-
 static int sprite_erase_partition_by_name(char *part_name)
 {
 	int ret = -1;
@@ -230,7 +160,7 @@ int sprite_form_sysrecovery(void)
 		goto _update_error_;
 	}
 	tick_printf("part start = %d\n", img_start);
-	imghd = Img_Open_from_sysrecovery(img_start);
+	imghd = Img_Open_At(img_start);
 	if (!imghd) {
 		pr_err("sprite update error: fail to open img\n");
 		goto _update_error_;
@@ -35,6 +35,48 @@ static inline int try_map_dirty(void)
 
 static struct map_info secure_storage_map = { { 0 } };
 
+/*
+ * Items written between sunxi_secure_storage_begin() and
+ * sunxi_secure_storage_commit() are staged here, one block per item index,
+ * and go to the flash once each with the map last. An item the map on flash
+ * already names is written to a free index instead, the map switches to it
+ * and the old slot is released after the map is on flash.
+ */
+#define SEC_STORE_MAX_ITEMS 32
+
+static unsigned int secure_storage_trans;
+static unsigned char *trans_item[SEC_STORE_MAX_ITEMS];
+/* the map when the transaction began, it names the items on flash */
+static struct map_info trans_base_map;
+
+static unsigned char *staged_item(int index)
+{
+	if (!secure_storage_trans || index <= 0 || index >= SEC_STORE_MAX_ITEMS)
+		return NULL;
+
+	return trans_item[index];
+}
+
+static unsigned char *stage_item(int index)
+{
+	if (!secure_storage_trans || index <= 0 || index >= SEC_STORE_MAX_ITEMS)
+		return NULL;
+	if (!trans_item[index])
+		trans_item[index] = malloc_cache_aligned(SEC_BLK_SIZE);
+
+	return trans_item[index];
+}
+
+static void drop_staged_items(void)
+{
+	int i;
+
+	for (i = 0; i < SEC_STORE_MAX_ITEMS; i++) {
+		free(trans_item[i]);
+		trans_item[i] = NULL;
+	}
+}
+
 /*
 ************************************************************************************************************
 *
@@ -266,6 +308,99 @@ static int __discard_name_in_map(unsigned char *buffer, const char *item_name)
 	return -1;
 }
 
+/*
+ * entry @index of the map, the free tail when @index is one past the last
+ * entry, NULL beyond that
+ */
+static unsigned char *__entry_in_map(unsigned char *buffer, int index)
+{
+	unsigned char *buf_start = buffer;
+	int i = 1;
+
+	while (*buf_start != '\0' && (buf_start - buffer) < SEC_BLK_SIZE) {
+		if (i == index)
+			return buf_start;
+		i++;
+		buf_start += strlen((const char *)buf_start) + 1;
+	}
+
+	return i == index ? buf_start : NULL;
+}
+
+static int __entry_is_dummy(const unsigned char *entry)
+{
+	char dummy[MAP_KEY_NAME_SIZE];
+
+	sprintf(dummy, "%s:%d", SECURE_STORAGE_DUMMY_KEY_NAME, 0);
+
+	return !strcmp((const char *)entry, dummy);
+}
+
+/* the entry names data, its slot on flash is in use */
+static int __entry_is_live(unsigned char *buffer, int index)
+{
+	unsigned char *entry = __entry_in_map(buffer, index);
+
+	return entry && *entry != '\0' && !__entry_is_dummy(entry);
+}
+
+/*
+ * hand the name of entry @from to entry @to, a dummy or the free tail, and
+ * leave a DUMMY_KEY at @from so no other key changes its index
+ */
+static int __move_name_in_map(unsigned char *buffer, int from, int to)
+{
+	uint8_t new_map[sizeof(((struct map_info *)0)->data)];
+	char dummy[MAP_KEY_NAME_SIZE];
+	unsigned char *entry;
+	int index, len, pos = 0;
+
+	sprintf(dummy, "%s:%d", SECURE_STORAGE_DUMMY_KEY_NAME, 0);
+	memset(new_map, 0, sizeof(new_map));
+	for (index = 1; (entry = __entry_in_map(buffer, index)) != NULL &&
+			(*entry != '\0' || index == to);
+	     index++) {
+		if (index == to)
+			entry = __entry_in_map(buffer, from);
+		else if (index == from)
+			entry = (unsigned char *)dummy;
+		len = strlen((const char *)entry) + 1;
+		if (pos + len >= sizeof(new_map))
+			return -1;
+		memcpy(new_map + pos, entry, len);
+		pos += len;
+	}
+	memcpy(buffer, new_map, sizeof(new_map));
+
+	return 0;
+}
+
+/*
+ * a free index for the new data of an item the map on flash names: not in
+ * use in either map and not staged
+ */
+static int __shadow_index(void)
+{
+	unsigned char *entry;
+	int index;
+
+	for (index = 1; index < SEC_STORE_MAX_ITEMS; index++) {
+		entry = __entry_in_map((unsigned char *)&secure_storage_map,
+				       index);
+		if (!entry)
+			break;
+		if (*entry != '\0' && !__entry_is_dummy(entry))
+			continue;
+		if (trans_item[index] ||
+		    __entry_is_live((unsigned char *)&trans_base_map, index))
+			continue;
+
+		return index;
+	}
+
+	return -1;
+}
+
 int check_secure_storage_map(void *buffer)
 {
 	struct map_info *map_buf = (struct map_info *)buffer;
@@ -345,6 +480,25 @@ int sunxi_secure_storage_init(void)
 *
 ************************************************************************************************************
 */
+static int sunxi_secure_storage_write_map(void)
+{
+	int ret;
+
+	secure_storage_map.magic = STORE_OBJECT_MAGIC;
+	secure_storage_map.crc   = crc32(0, (void *)&secure_storage_map,
+				       sizeof(struct map_info) - 4);
+	ret = sunxi_secstorage_write(0, (unsigned char *)&secure_storage_map,
+				     4096);
+	if (ret < 0) {
+		pr_err("write secure storage map\n");
+
+		return -1;
+	}
+	clear_map_dirty();
+
+	return 0;
+}
+
 int sunxi_secure_storage_exit(void)
 {
 	int ret;
@@ -355,23 +509,156 @@ int sunxi_secure_storage_exit(void)
 
 		return -1;
 	}
-	if (try_map_dirty()) {
-		secure_storage_map.magic = STORE_OBJECT_MAGIC;
-		secure_storage_map.crc   = crc32(0, (void *)&secure_storage_map,
-					       sizeof(struct map_info) - 4);
-		ret = sunxi_secstorage_write(
-			0, (unsigned char *)&secure_storage_map, 4096);
+	if (secure_storage_trans)
+		return sunxi_secure_storage_commit();
+	if (try_map_dirty() && sunxi_secure_storage_write_map() < 0)
+		return -1;
+	ret = sunxi_secstorage_flush();
+	secure_storage_inited = 0;
+
+	return ret;
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  sunxi_secure_storage_begin
+*
+*    parmeters     :
+*
+*    return        :
+*
+*    note          :  stage the following writes and erases in ram until
+*                     sunxi_secure_storage_commit or sunxi_secure_storage_abort
+*
+*
+************************************************************************************************************
+*/
+int sunxi_secure_storage_begin(void)
+{
+	if (!secure_storage_inited) {
+		pr_err("%s err: secure storage has not been inited\n",
+		       __func__);
+
+		return -1;
+	}
+	if (secure_storage_trans) {
+		pr_err("%s err: transaction already open\n", __func__);
+
+		return -1;
+	}
+	memcpy(&trans_base_map, &secure_storage_map, sizeof(trans_base_map));
+	secure_storage_trans = 1;
+
+	return 0;
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  sunxi_secure_storage_commit
+*
+*    parmeters     :
+*
+*    return        :
+*
+*    note          :  write every staged item once, then the map, then flush.
+*                     items the map on flash names go to free indexes, so
+*                     the map on flash keeps naming the old data until the
+*                     new map is written. the old slots are erased last
+*
+*
+************************************************************************************************************
+*/
+int sunxi_secure_storage_commit(void)
+{
+	unsigned char *base_map = (unsigned char *)&trans_base_map;
+	unsigned char *map = (unsigned char *)&secure_storage_map;
+	unsigned char release[SEC_STORE_MAX_ITEMS] = { 0 };
+	int ret, index, shadow;
+
+	if (!secure_storage_trans) {
+		pr_err("%s err: no transaction open\n", __func__);
+
+		return -1;
+	}
+
+	for (index = 1; index < SEC_STORE_MAX_ITEMS; index++) {
+		if (!trans_item[index])
+			continue;
+		shadow = index;
+		if (__entry_is_live(base_map, index)) {
+			/* the map on flash names this slot, keep it until the map */
+			release[index] = 1;
+			if (!__entry_is_live(map, index))
+				continue;
+			shadow = __shadow_index();
+			if (shadow < 0 ||
+			    __move_name_in_map(map, index, shadow) < 0) {
+				pr_err("no free secure storage block for %d\n",
+				       index);
+				sunxi_secure_storage_abort();
+
+				return -1;
+			}
+			pr_msg("secure storage block %d moves to %d\n", index,
+			       shadow);
+		}
+		ret = sunxi_secstorage_write(shadow, trans_item[index],
+					     SEC_BLK_SIZE);
 		if (ret < 0) {
-			pr_err("write secure storage map\n");
+			pr_err("write secure storage block %d err\n", shadow);
+			sunxi_secure_storage_abort();
 
 			return -1;
 		}
-		clear_map_dirty();
 	}
-	ret = sunxi_secstorage_flush();
-	secure_storage_inited = 0;
 
-	return ret;
+	if (sunxi_secure_storage_write_map() < 0 || sunxi_secstorage_flush()) {
+		sunxi_secure_storage_abort();
+
+		return -1;
+	}
+
+	/* the map no longer names the old slots, a failure here is harmless */
+	for (index = 1; index < SEC_STORE_MAX_ITEMS; index++) {
+		if (!release[index])
+			continue;
+		memset(trans_item[index], 0xff, SEC_BLK_SIZE);
+		if (sunxi_secstorage_write(index, trans_item[index],
+					   SEC_BLK_SIZE) < 0)
+			pr_err("release secure storage block %d err\n", index);
+	}
+	drop_staged_items();
+	secure_storage_trans = 0;
+
+	return sunxi_secure_storage_exit();
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  sunxi_secure_storage_abort
+*
+*    parmeters     :
+*
+*    return        :
+*
+*    note          :  drop the staged items and the map in ram, the next
+*                     sunxi_secure_storage_init reads the map back from flash
+*
+*
+************************************************************************************************************
+*/
+void sunxi_secure_storage_abort(void)
+{
+	drop_staged_items();
+	secure_storage_trans = 0;
+	clear_map_dirty();
+	secure_storage_inited = 0;
 }
 /*
 ************************************************************************************************************
@@ -526,7 +813,12 @@ int sunxi_secure_storage_read(const char *item_name, char *buffer,
 		return -2;
 	}
 	memset(buffer_to_sec, 0, 4096);
-	ret = sunxi_secstorage_read(index, buffer_to_sec, 4096);
+	if (staged_item(index)) {
+		memcpy(buffer_to_sec, staged_item(index), 4096);
+		ret = 0;
+	} else {
+		ret = sunxi_secstorage_read(index, buffer_to_sec, 4096);
+	}
 	if (ret < 0) {
 		pr_err("read secure storage block %d name %s err\n", index,
 		       item_name);
@@ -587,7 +879,7 @@ int sunxi_secure_storage_write(const char *item_name, char *buffer, int length)
 		if (len != length) {
 			pr_err("the length is not match with key has store in secure storage\n");
 			return -1;
-		} else {
+		} else if (!secure_storage_trans) {
 			if (sunxi_secure_storage_erase_data_only(item_name) <
 			    0) {
 				pr_err("Erase item %s fail\n", item_name);
@@ -595,6 +887,19 @@ int sunxi_secure_storage_write(const char *item_name, char *buffer, int length)
 			}
 		}
 	}
+	if (secure_storage_trans) {
+		if (!stage_item(index)) {
+			pr_err("stage secure storage block %d name %s err\n",
+			       index, item_name);
+			return -1;
+		}
+		memset(stage_item(index), 0x0, 4096);
+		memcpy(stage_item(index), buffer, length);
+		set_map_dirty();
+		pr_msg("stage secure storage: %d ok\n", index);
+
+		return 0;
+	}
 	memset(tmp_buf, 0x0, 4096);
 	memcpy(tmp_buf, buffer, length);
 	ret = sunxi_secstorage_write(index, (unsigned char *)tmp_buf, 4096);
@@ -645,8 +950,13 @@ int sunxi_secure_storage_erase_data_only(const char *item_name)
 
 		return -2;
 	}
-	memset(buffer, 0xff, 4096);
-	ret = sunxi_secstorage_write(index, buffer, 4096);
+	if (stage_item(index)) {
+		memset(stage_item(index), 0xff, 4096);
+		ret = 0;
+	} else {
+		memset(buffer, 0xff, 4096);
+		ret = sunxi_secstorage_write(index, buffer, 4096);
+	}
 	if (ret < 0) {
 		pr_err("erase secure storage block %d name %s err\n", index,
 		       item_name);
@@ -694,8 +1004,13 @@ int sunxi_secure_storage_erase(const char *item_name)
 
 		return -2;
 	}
-	memset(buffer, 0xff, 4096);
-	ret = sunxi_secstorage_write(index, buffer, 4096);
+	if (stage_item(index)) {
+		memset(stage_item(index), 0xff, 4096);
+		ret = 0;
+	} else {
+		memset(buffer, 0xff, 4096);
+		ret = sunxi_secstorage_write(index, buffer, 4096);
+	}
 	if (ret < 0) {
 		pr_err("erase secure storage block %d name %s err\n", index,
 		       item_name);
@@ -727,6 +1042,13 @@ int sunxi_secure_storage_erase_all(void)
 	}
 
 	memset(&secure_storage_map, 0x00, 4096);
+	if (secure_storage_trans) {
+		drop_staged_items();
+		set_map_dirty();
+		pr_force("erase secure storage: staged\n");
+
+		return 0;
+	}
 	ret = sunxi_secstorage_write(0, (unsigned char *)&secure_storage_map,
 				     4096);
 	if (ret < 0) {
@@ -11,27 +11,60 @@
 #include <sunxi_board.h>
 #include <sunxi_flash.h>
 #include "sparse/sparse.h"
+#include "sprite_pipe.h"
+#include "sprite_verify.h"
+#include <worker_pool.h>
 #ifdef CONFIG_SUNXI_CE_DRIVER
 #include <asm/arch/ce.h>
 #endif
+#ifdef CONFIG_SUNXI_SPRITE_VERIFY_SHA256
+#include <u-boot/sha256.h>
+#endif
+#ifdef CONFIG_SUNXI_SPRITE_DELTA
+#include <image-sparse.h>
+#endif
 
+/*
+ * total dram used by the verify pipe, split over the pipe buffers so a
+ * read back of the next chunk can run while the current one is summed
+ */
 #if defined(CONFIG_SUNXI_SPINOR)
 #define VERIFY_ONCE_BYTES (2 * 1024 * 1024)
 #else
 #define VERIFY_ONCE_BYTES (8 * 1024 * 1024)
 #endif
 
-#define VERIFY_ONCE_SECTORS (VERIFY_ONCE_BYTES / 512)
-
-uint add_sum(void *buffer, uint length)
+/*
+ * chunks are read back in whole sectors into cache aligned slots, and the
+ * next chunk starts where the last one ended, so keep them a multiple of
+ * both whatever the pipe depth
+ */
+#define VERIFY_CHUNK_BYTES                                                    \
+	ALIGN_DOWN(VERIFY_ONCE_BYTES / CONFIG_SUNXI_SPRITE_PIPE_DEPTH,        \
+		   max(512, ARCH_DMA_MINALIGN))
+
+static uint __add_sum(void *buffer, uint length)
 {
 	unsigned int *buf;
 	unsigned int count;
-	unsigned int sum;
+	unsigned int sum, sum1, sum2, sum3;
 
 	count = length >> 2;
 	sum   = 0;
+	sum1  = 0;
+	sum2  = 0;
+	sum3  = 0;
 	buf   = (unsigned int *)buffer;
+	/* 8 words a loop on four accumulators, the adds do not wait on each other */
+	while (count >= 8) {
+		sum += buf[0] + buf[4];
+		sum1 += buf[1] + buf[5];
+		sum2 += buf[2] + buf[6];
+		sum3 += buf[3] + buf[7];
+		buf += 8;
+		count -= 8;
+	}
+	sum += sum1 + sum2 + sum3;
 	while (count--) {
 		sum += *buf++;
 	};
@@ -52,65 +85,304 @@ uint add_sum(void *buffer, uint length)
 	return sum;
 }
 
-uint sunxi_sprite_part_rawdata_verify(uint base_start, long long base_bytes)
+/*
+ * larger buffers are summed in slices on the worker pool, the slices
+ * start on word boundaries so their sums add up to the same value
+ */
+#define ADD_SUM_SLICE_BYTES (1024 * 1024)
+#define ADD_SUM_SLICES	    8
+
+struct add_sum_batch {
+	u8 *buf;
+	uint length;
+	uint slice;
+	uint sum[ADD_SUM_SLICES];
+};
+
+static void __add_sum_job(void *priv, int job)
 {
-	uint checksum = 0;
-	uint unaligned_bytes, last_time_bytes;
-	uint rest_sectors;
-	uint crt_start;
-	char *tmp_buf = NULL;
+	struct add_sum_batch *batch = priv;
+	uint from = job * batch->slice;
+	uint len  = min(batch->slice, batch->length - from);
+
+	batch->sum[job] = __add_sum(batch->buf + from, len);
+}
+
+uint add_sum(void *buffer, uint length)
+{
+	struct add_sum_batch batch;
+	int slices, i;
+	uint sum = 0;
+
+	slices = min(worker_pool_size(), ADD_SUM_SLICES);
+	slices = min(slices, (int)(length / ADD_SUM_SLICE_BYTES));
+	if (slices < 2)
+		return __add_sum(buffer, length);
+
+	batch.buf    = buffer;
+	batch.length = length;
+	batch.slice  = ALIGN(DIV_ROUND_UP(length, slices), 4);
+	worker_pool_run(__add_sum_job, &batch, slices);
+	for (i = 0; i < slices; i++)
+		sum += batch.sum[i];
+
+	return sum;
+}
+
+/* read back source of the verify pipe, offsets are bytes on the target flash */
+static int verify_pipe_read(void *priv, u64 offset, void *buf, uint bytes)
+{
+	uint sectors = bytes >> 9;
+
+	if (sunxi_sprite_read((uint)(offset >> 9), sectors, buf) != sectors) {
+		printf("sunxi sprite: read flash error when verify\n");
+		return -1;
+	}
 
-	tmp_buf = (char *)memalign(64, VERIFY_ONCE_BYTES);
-	if (!tmp_buf) {
+	return 0;
+}
+
+static struct sunxi_flash_req verify_pipe_req;
+
+static int verify_pipe_submit(void *priv, u64 offset, void *buf, uint bytes)
+{
+	return sunxi_sprite_submit(&verify_pipe_req, (uint)(offset >> 9),
+				   bytes >> 9, buf, 0);
+}
+
+static int verify_pipe_wait(void *priv)
+{
+	if (sunxi_flash_complete(&verify_pipe_req) != verify_pipe_req.nblock) {
+		printf("sunxi sprite: read flash error when verify\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static struct sprite_pipe_src verify_pipe_src = {
+	.read	= verify_pipe_read,
+	.submit = verify_pipe_submit,
+	.wait	= verify_pipe_wait,
+};
+
+static int __verify_add_sum(void *priv, void *buf, uint bytes)
+{
+	uint *checksum = priv;
+
+	*checksum += add_sum(buf, bytes);
+
+	return 0;
+}
+
+static int __verify_scan(uint base_start, long long base_bytes,
+			 int (*consume)(void *priv, void *buf, uint bytes),
+			 void *priv)
+{
+	struct sprite_pipe pipe;
+	int ret;
+
+	if (sprite_pipe_init(&pipe, VERIFY_CHUNK_BYTES)) {
 		printf("sunxi sprite err: unable to malloc memory for verify\n");
+		return -1;
+	}
+	debug("read total bytes 0x%llx\n", base_bytes);
+	debug("read part start %d\n", base_start);
+	ret = sprite_pipe_scan(&pipe, &verify_pipe_src, (u64)base_start << 9,
+			       base_bytes, consume, priv);
+	pr_msg("verify 0x%llx bytes: read %lu ms (stall %lu ms), check %lu ms, total %lu ms\n",
+	       pipe.total_bytes, pipe.read_ms, pipe.stall_ms, pipe.write_ms,
+	       pipe.wall_ms);
+	sprite_pipe_exit(&pipe);
+
+	return ret;
+}
 
+uint sunxi_sprite_part_rawdata_verify(uint base_start, long long base_bytes)
+{
+	uint checksum = 0;
+
+	if (__verify_scan(base_start, base_bytes, __verify_add_sum, &checksum))
 		return 0;
+
+	return checksum;
+}
+
+#ifdef CONFIG_SUNXI_SPRITE_VERIFY_SHA256
+#ifdef CONFIG_SUNXI_CE_SHA256_MULTISTEP
+/* the CE takes the total length in bits as one 32-bit word */
+#define VERIFY_CE_HASH_MAX_BYTES (0xffffffffU >> 3)
+#endif
+
+struct verify_sha256 {
+	u8 *digest;
+	long long done;
+	long long total;
+	int use_ce;
+	sha256_context ctx;
+};
+
+static int __verify_sha256(void *priv, void *buf, uint bytes)
+{
+	struct verify_sha256 *vs = priv;
+	int ret			 = 0;
+
+#ifdef CONFIG_SUNXI_CE_SHA256_MULTISTEP
+	if (vs->use_ce) {
+		/* every chunk but the last is a multiple of the 64 byte block */
+		if (vs->done + bytes < vs->total)
+			ret = vs->done ? sunxi_hash_update(vs->digest, buf, bytes,
+							   vs->total) :
+					 sunxi_hash_init(vs->digest, buf, bytes,
+							 vs->total);
+		else
+			ret = vs->done ? sunxi_hash_final(vs->digest, buf, bytes,
+							  vs->total) :
+					 sunxi_sha_calc(vs->digest, 32, buf,
+							bytes);
+		vs->done += bytes;
+		return ret ? -1 : 0;
 	}
-	crt_start       = base_start;
-	rest_sectors    = (uint)((base_bytes + 511) >> 9);
-	unaligned_bytes = (uint)base_bytes & 0x1ff;
-
-	debug("read total sectors %d\n", rest_sectors);
-	debug("read part start %d\n", crt_start);
-	while (rest_sectors >= VERIFY_ONCE_SECTORS) {
-		if (sunxi_sprite_read(crt_start, VERIFY_ONCE_SECTORS,
-				      tmp_buf) != VERIFY_ONCE_SECTORS) {
-			printf("sunxi sprite: read flash error when verify\n");
-			checksum = 0;
-
-			goto __rawdata_verify_err;
-		}
-		crt_start += VERIFY_ONCE_SECTORS;
-		rest_sectors -= VERIFY_ONCE_SECTORS;
-		checksum += add_sum(tmp_buf, VERIFY_ONCE_BYTES);
-		debug("check sum = 0x%x\n", checksum);
+#endif
+	sha256_update(&vs->ctx, buf, bytes);
+	vs->done += bytes;
+	if (vs->done == vs->total)
+		sha256_finish(&vs->ctx, vs->digest);
+
+	return ret;
+}
+
+/*
+ * sha256 of @base_bytes starting at sector @base_start of the burned
+ * partition, the digest is stored in @digest (32 bytes)
+ */
+int sunxi_sprite_part_rawdata_sha256(uint base_start, long long base_bytes,
+				     u8 *digest)
+{
+	struct verify_sha256 vs;
+	ALLOC_CACHE_ALIGN_BUFFER(u8, hash, CONFIG_SYS_CACHELINE_SIZE);
+
+	memset(&vs, 0, sizeof(vs));
+	vs.digest = hash;
+	vs.total  = base_bytes;
+#ifdef CONFIG_SUNXI_CE_SHA256_MULTISTEP
+	if (base_bytes <= VERIFY_CE_HASH_MAX_BYTES) {
+		sunxi_ss_open();
+		vs.use_ce = 1;
 	}
-	if (rest_sectors) {
-		if (sunxi_sprite_read(crt_start, rest_sectors, tmp_buf) !=
-		    rest_sectors) {
-			printf("sunxi sprite: read flash error when verify\n");
-			checksum = 0;
+#endif
+	if (!vs.use_ce)
+		sha256_starts(&vs.ctx);
 
-			goto __rawdata_verify_err;
-		}
-		if (unaligned_bytes) {
-			last_time_bytes =
-				(rest_sectors - 1) * 512 + unaligned_bytes;
-		} else {
-			last_time_bytes = rest_sectors * 512;
+	if (__verify_scan(base_start, base_bytes, __verify_sha256, &vs))
+		return -1;
+	memcpy(digest, hash, SHA256_SUM_LEN);
+
+	return 0;
+}
+#endif
+
+/* the size the verify file must have, see sprite_verify.h */
+static uint sunxi_sprite_vf_len(dl_one_part_info *part_info, int sparse)
+{
+	if (part_info->verify != SUNXI_VERIFY_SHA256)
+		return SUNXI_VF_ADD_SUM_LEN;
+
+	return sparse ? SUNXI_VF_SHA256_SPARSE_LEN : SUNXI_VF_SHA256_LEN;
+}
+
+/*
+ * verify a burned partition the way its download map entry asks for,
+ * @vf_data holds the @vf_len bytes of the verify file. sparse images are
+ * checked with the add sum gathered by the sparse writer.
+ * return 0 when the partition matches, -1 otherwise
+ */
+int sunxi_sprite_part_verify(dl_one_part_info *part_info, uint base_start,
+			     long long base_bytes, int sparse, void *vf_data,
+			     uint vf_len)
+{
+	uint origin_verify;
+	uint active_verify;
+#ifdef CONFIG_SUNXI_SPRITE_VERIFY_SHA256
+	u8 digest[SHA256_SUM_LEN];
+	int i;
+#endif
+
+	if (vf_len != sunxi_sprite_vf_len(part_info, sparse)) {
+		printf("sunxi sprite err: verify file %s is %u bytes, not %u\n",
+		       part_info->vf_filename, vf_len,
+		       sunxi_sprite_vf_len(part_info, sparse));
+		return -1;
+	}
+
+#ifdef CONFIG_SUNXI_SPRITE_VERIFY_SHA256
+	if (part_info->verify == SUNXI_VERIFY_SHA256 && !sparse) {
+		if (sunxi_sprite_part_rawdata_sha256(base_start, base_bytes,
+						     digest))
+			return -1;
+		if (memcmp(digest, vf_data, SHA256_SUM_LEN)) {
+			printf("origin sha256=");
+			for (i = 0; i < SHA256_SUM_LEN; i++)
+				printf("%02x", ((u8 *)vf_data)[i]);
+			printf("\nactive sha256=");
+			for (i = 0; i < SHA256_SUM_LEN; i++)
+				printf("%02x", digest[i]);
+			printf("\n");
+			return -1;
 		}
-		checksum += add_sum(tmp_buf, last_time_bytes);
-		debug("check sum = 0x%x\n", checksum);
+		printf("part %s sha256 verify ok\n", part_info->name);
+
+		return 0;
+	}
+#else
+	if (part_info->verify == SUNXI_VERIFY_SHA256 && !sparse) {
+		printf("sunxi sprite err: sha256 verify is not supported\n");
+		return -1;
 	}
+#endif
 
-__rawdata_verify_err:
-	if (tmp_buf) {
-		free(tmp_buf);
+	/* the add sum follows the digest in a sha256 verify file */
+	origin_verify = *(uint *)(vf_data + vf_len - SUNXI_VF_ADD_SUM_LEN);
+	if (sparse)
+		active_verify = sunxi_sprite_part_sparsedata_verify();
+	else
+		active_verify =
+			sunxi_sprite_part_rawdata_verify(base_start, base_bytes);
+	printf("origin_verify value = %x, active_verify value = %x\n",
+	       origin_verify, active_verify);
+	if (origin_verify != active_verify) {
+		printf("origin checksum=%x, active checksum=%x\n",
+		       origin_verify, active_verify);
+		return -1;
 	}
 
-	return checksum;
+	return 0;
 }
 
+#ifdef CONFIG_SUNXI_SPRITE_DELTA
+/*
+ * delta burn: tell whether the partition on flash already holds the image
+ * the verify file @vf_data was made for, @head is the first sector of the
+ * image. Only the sha256 of a raw image is trusted for this, the add sum
+ * would not notice data that moved inside the partition.
+ * return 1 when the partition can be left as it is
+ */
+int sunxi_sprite_part_unchanged(dl_one_part_info *part_info, uint base_start,
+				long long base_bytes, void *head, void *vf_data,
+				uint vf_len)
+{
+	u8 digest[SHA256_SUM_LEN];
+
+	if (part_info->verify != SUNXI_VERIFY_SHA256 || is_sparse_image(head) ||
+	    vf_len != SUNXI_VF_SHA256_LEN)
+		return 0;
+	if (sunxi_sprite_part_rawdata_sha256(base_start, base_bytes, digest))
+		return 0;
+
+	return !memcmp(digest, vf_data, SHA256_SUM_LEN);
+}
+#endif
+
 uint sunxi_sprite_part_sparsedata_verify(void)
 {
 	return unsparse_checksum();
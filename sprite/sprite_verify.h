@@ -8,6 +8,7 @@
 #define  __SUNXI_SPRITE_VERIFY_H__
 
 #include <common.h>
+#include <sunxi_mbr.h>
 
 extern uint add_sum(void *buffer, uint length);
 
@@ -15,6 +16,29 @@ extern uint sunxi_sprite_part_rawdata_verify(uint base_start, long long base_byt
 
 extern uint sunxi_sprite_part_sparsedata_verify(void);
 
+extern int sunxi_sprite_part_rawdata_sha256(uint base_start, long long base_bytes, u8 *digest);
+
+/*
+ * The verify file of a partition (dl_one_part_info.vf_filename) holds, by
+ * dl_one_part_info.verify:
+ *   SUNXI_VERIFY_ADD_SUM	the add_sum() of the data written to the
+ *				partition, a little endian word
+ *   SUNXI_VERIFY_SHA256	the sha256 of a raw image. A sparse image is
+ *				checked by the add sum of its data, which
+ *				follows the digest
+ */
+#define SUNXI_VF_ADD_SUM_LEN		4
+#define SUNXI_VF_SHA256_LEN		32
+#define SUNXI_VF_SHA256_SPARSE_LEN	(SUNXI_VF_SHA256_LEN + SUNXI_VF_ADD_SUM_LEN)
+
+extern int sunxi_sprite_part_verify(dl_one_part_info *part_info, uint base_start,
+				    long long base_bytes, int sparse, void *vf_data,
+				    uint vf_len);
+
+extern int sunxi_sprite_part_unchanged(dl_one_part_info *part_info, uint base_start,
+				       long long base_bytes, void *head, void *vf_data,
+				       uint vf_len);
+
 extern uint sunxi_sprite_generate_checksum(void *buffer, uint length, uint src_sum);
 
 extern int sunxi_sprite_verify_checksum(void *buffer, uint length, uint src_sum);
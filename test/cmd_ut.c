@@ -43,12 +43,45 @@ static cmd_tbl_t cmd_ut_sub[] = {
 #if defined(CONFIG_UT_ENV)
 	U_BOOT_CMD_MKENT(env, CONFIG_SYS_MAXARGS, 1, do_ut_env, "", ""),
 #endif
+#ifdef CONFIG_UT_FDT_INDEX
+	U_BOOT_CMD_MKENT(fdt_index, CONFIG_SYS_MAXARGS, 1, do_ut_fdt_index,
+			 "", ""),
+#endif
+#ifdef CONFIG_UT_HASH_SG
+	U_BOOT_CMD_MKENT(hash_sg, CONFIG_SYS_MAXARGS, 1, do_ut_hash_sg, "", ""),
+#endif
+#ifdef CONFIG_UT_IMGDECODE
+	U_BOOT_CMD_MKENT(imgdecode, CONFIG_SYS_MAXARGS, 1, do_ut_imgdecode,
+			 "", ""),
+#endif
+#ifdef CONFIG_UT_MTD_BBT
+	U_BOOT_CMD_MKENT(mtd_bbt, CONFIG_SYS_MAXARGS, 1, do_ut_mtd_bbt, "", ""),
+#endif
+#ifdef CONFIG_UT_OF_LIVE_FIXUP
+	U_BOOT_CMD_MKENT(of_live_fixup, CONFIG_SYS_MAXARGS, 1,
+			 do_ut_of_live_fixup, "", ""),
+#endif
 #ifdef CONFIG_UT_OVERLAY
 	U_BOOT_CMD_MKENT(overlay, CONFIG_SYS_MAXARGS, 1, do_ut_overlay, "", ""),
 #endif
+#ifdef CONFIG_UT_PART_INDEX
+	U_BOOT_CMD_MKENT(part_index, CONFIG_SYS_MAXARGS, 1, do_ut_part_index,
+			 "", ""),
+#endif
+#ifdef CONFIG_UT_SHA
+	U_BOOT_CMD_MKENT(sha, CONFIG_SYS_MAXARGS, 1, do_ut_sha, "", ""),
+#endif
 #ifdef CONFIG_UT_TIME
 	U_BOOT_CMD_MKENT(time, CONFIG_SYS_MAXARGS, 1, do_ut_time, "", ""),
 #endif
+#ifdef CONFIG_UT_UBI_KAPI
+	U_BOOT_CMD_MKENT(ubi_kapi, CONFIG_SYS_MAXARGS, 1, do_ut_ubi_kapi,
+			 "", ""),
+#endif
+#ifdef CONFIG_UT_WORKER_POOL
+	U_BOOT_CMD_MKENT(worker_pool, CONFIG_SYS_MAXARGS, 1, do_ut_worker_pool,
+			 "", ""),
+#endif
 #ifdef CONFIG_SANDBOX
 	U_BOOT_CMD_MKENT(compression, CONFIG_SYS_MAXARGS, 1, do_ut_compression,
 			 "", ""),
@@ -99,12 +132,39 @@ static char ut_help_text[] =
 #ifdef CONFIG_UT_ENV
 	"ut env [test-name]\n"
 #endif
+#ifdef CONFIG_UT_FDT_INDEX
+	"ut fdt_index [test-name]\n"
+#endif
+#ifdef CONFIG_UT_HASH_SG
+	"ut hash_sg [test-name]\n"
+#endif
+#ifdef CONFIG_UT_IMGDECODE
+	"ut imgdecode [test-name]\n"
+#endif
+#ifdef CONFIG_UT_MTD_BBT
+	"ut mtd_bbt [test-name]\n"
+#endif
+#ifdef CONFIG_UT_OF_LIVE_FIXUP
+	"ut of_live_fixup [test-name]\n"
+#endif
 #ifdef CONFIG_UT_OVERLAY
 	"ut overlay [test-name]\n"
 #endif
+#ifdef CONFIG_UT_PART_INDEX
+	"ut part_index [test-name]\n"
+#endif
+#ifdef CONFIG_UT_SHA
+	"ut sha [test-name]\n"
+#endif
 #ifdef CONFIG_UT_TIME
 	"ut time - Very basic test of time functions\n"
 #endif
+#ifdef CONFIG_UT_UBI_KAPI
+	"ut ubi_kapi [test-name]\n"
+#endif
+#ifdef CONFIG_UT_WORKER_POOL
+	"ut worker_pool [test-name]\n"
+#endif
 #ifdef CONFIG_SANDBOX
 	"ut compression - Test compressors and bootm decompression\n"
 #endif
@@ -8,7 +8,9 @@
 #include <command.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <decomp_fast.h>
 #include <asm/io.h>
+#include <asm/unaligned.h>
 
 #include <u-boot/zlib.h>
 #include <bzlib.h>
@@ -436,6 +438,213 @@ static int compression_test_lz4(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_lz4, 0);
 
+#define BENCH_SIZE		(1 << 20)
+#define BENCH_LZ4_MAGIC		0x184d2204
+#define BENCH_LZ4_HASH_BITS	12
+
+static u32 bench_rand(u32 *seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+
+	return *seed >> 8;
+}
+
+/* pieces of plain[] glued together, many short and mid distance matches */
+static void bench_fill_text(u8 *buf, ulong size)
+{
+	u32 seed = 1;
+	ulong pos, len, off;
+
+	for (pos = 0; pos < size; pos += len) {
+		off = bench_rand(&seed) % (sizeof(plain) - 1);
+		len = min3(1 + bench_rand(&seed) % 32UL,
+			   sizeof(plain) - 1 - off, size - pos);
+		memcpy(buf + pos, plain + off, len);
+	}
+}
+
+/* runs, overlapping copies a few bytes back and some noise */
+static void bench_fill_binary(u8 *buf, ulong size)
+{
+	u32 seed = 2;
+	ulong pos, len, dist, i;
+
+	for (pos = 0; pos < size; pos += len) {
+		len = min(4 + bench_rand(&seed) % 60UL, size - pos);
+		dist = 1 + bench_rand(&seed) % 16;
+		switch (bench_rand(&seed) % 3) {
+		case 0:
+			memset(buf + pos, bench_rand(&seed), len);
+			break;
+		case 1:
+			if (dist <= pos) {
+				for (i = 0; i < len; i++)
+					buf[pos + i] = buf[pos + i - dist];
+				break;
+			}
+			/* fall through */
+		default:
+			for (i = 0; i < len; i++)
+				buf[pos + i] = bench_rand(&seed);
+			break;
+		}
+	}
+}
+
+static u8 *bench_lz4_length(u8 *op, ulong len)
+{
+	for (; len >= 255; len -= 255)
+		*op++ = 255;
+	*op++ = len;
+
+	return op;
+}
+
+static u8 *bench_lz4_sequence(u8 *op, const u8 *lit, ulong lit_len,
+			      ulong dist, ulong match_len)
+{
+	*op++ = min(lit_len, 15UL) << 4 |
+		(match_len ? min(match_len - 4, 15UL) : 0);
+	if (lit_len >= 15)
+		op = bench_lz4_length(op, lit_len - 15);
+	memcpy(op, lit, lit_len);
+	op += lit_len;
+	if (!match_len)
+		return op;
+
+	put_unaligned_le16(dist, op);
+	op += 2;
+	if (match_len - 4 >= 15)
+		op = bench_lz4_length(op, match_len - 4 - 15);
+
+	return op;
+}
+
+/*
+ * There is no lz4 compression in u-boot, a greedy single block frame will
+ * do. As the format wants, the last match starts 12 bytes before the end
+ * and the last 5 bytes are literals.
+ */
+static ulong bench_lz4_compress(const u8 *in, ulong size, u8 *out)
+{
+	const u8 *ip = in, *anchor = in, *ref;
+	const u8 *limit = in + size - 12, *match_end = in + size - 5;
+	u8 *op = out, *block;
+	ulong len;
+	u32 *table, seq, h;
+
+	table = calloc(1 << BENCH_LZ4_HASH_BITS, sizeof(*table));
+	if (!table)
+		return 0;
+
+	put_unaligned_le32(BENCH_LZ4_MAGIC, op);
+	op[4] = 0x60;		/* version 1, independent blocks */
+	op[5] = 0x70;		/* 4 MiB blocks */
+	op[6] = 0;		/* header checksum, not checked */
+	op += 7;
+	block = op;
+	op += 4;
+
+	while (ip < limit) {
+		seq = get_unaligned_le32(ip);
+		h = (seq * 2654435761U) >> (32 - BENCH_LZ4_HASH_BITS);
+		ref = in + table[h];
+		table[h] = ip - in;
+		if (ref >= ip || ip - ref > 0xffff ||
+		    get_unaligned_le32(ref) != seq) {
+			ip++;
+			continue;
+		}
+
+		for (len = 4; ip + len < match_end && ref[len] == ip[len];)
+			len++;
+		op = bench_lz4_sequence(op, anchor, ip - anchor, ip - ref, len);
+		ip += len;
+		anchor = ip;
+	}
+	op = bench_lz4_sequence(op, anchor, in + size - anchor, 0, 0);
+	put_unaligned_le32(op - block - 4, block);
+	put_unaligned_le32(0, op);
+	op += 4;
+	free(table);
+
+	return op - out;
+}
+
+static ulong bench_mbps(ulong size, ulong us)
+{
+	return size / max(us, 1UL);
+}
+
+static int run_fast_decomp(struct unit_test_state *uts, const char *name,
+			   const u8 *in, u8 *comp, u8 *out)
+{
+	ulong comp_size, gz_size, lz4_size, len, start;
+	size_t out_size;
+	int fast;
+
+	comp_size = 2 * BENCH_SIZE;
+	ut_assertok(gzip(comp, &comp_size, (u8 *)in, BENCH_SIZE));
+	gz_size = comp_size;
+	lz4_size = bench_lz4_compress(in, BENCH_SIZE, comp + gz_size);
+	ut_assert(lz4_size);
+
+	for (fast = 0; fast < 2; fast++) {
+		decomp_fast_set_enabled(fast);
+		if (fast && !decomp_fast_enabled())
+			break;
+
+		memset(out, 0, BENCH_SIZE);
+		len = gz_size;
+		start = timer_get_us();
+		ut_assertok(gunzip(out, BENCH_SIZE, comp, &len));
+		start = timer_get_us() - start;
+		ut_asserteq(BENCH_SIZE, len);
+		ut_assertok(memcmp(in, out, BENCH_SIZE));
+		printf("%-6s gzip %-8s %5lu MB/s\n", name,
+		       fast ? "fast" : "original", bench_mbps(len, start));
+
+		memset(out, 0, BENCH_SIZE);
+		out_size = BENCH_SIZE;
+		start = timer_get_us();
+		ut_assertok(ulz4fn(comp + gz_size, lz4_size, out, &out_size));
+		start = timer_get_us() - start;
+		ut_asserteq(BENCH_SIZE, out_size);
+		ut_assertok(memcmp(in, out, BENCH_SIZE));
+		printf("%-6s lz4  %-8s %5lu MB/s\n", name,
+		       fast ? "fast" : "original", bench_mbps(out_size, start));
+	}
+	decomp_fast_set_enabled(true);
+
+	return 0;
+}
+
+/* original and faster decoders (DECOMP_FAST) on 1 MiB each */
+static int compression_test_fast_decomp(struct unit_test_state *uts)
+{
+	u8 *in, *comp, *out;
+	int ret;
+
+	in = malloc(BENCH_SIZE);
+	comp = malloc(4 * BENCH_SIZE);
+	out = malloc(BENCH_SIZE);
+	ut_assert(in && comp && out);
+
+	bench_fill_text(in, BENCH_SIZE);
+	ret = run_fast_decomp(uts, "text", in, comp, out);
+	if (!ret) {
+		bench_fill_binary(in, BENCH_SIZE);
+		ret = run_fast_decomp(uts, "binary", in, comp, out);
+	}
+
+	free(out);
+	free(comp);
+	free(in);
+
+	return ret;
+}
+COMPRESSION_TEST(compression_test_fast_decomp, 0);
+
 static int compress_using_none(struct unit_test_state *uts,
 			       void *in, unsigned long in_size,
 			       void *out, unsigned long out_max,
@@ -5,6 +5,7 @@
 
 #include <common.h>
 #include <dm.h>
+#include <memalign.h>
 #include <mmc.h>
 #include <dm/test.h>
 #include <test/ut.h>
@@ -41,3 +42,36 @@ static int dm_test_mmc_blk(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_mmc_blk, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+static int dm_test_mmc_req(struct unit_test_state *uts)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(char, buf, 1024);
+	struct mmc_req req, other;
+	struct udevice *dev;
+	struct mmc *mmc;
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	mmc = mmc_get_mmc_dev(dev);
+
+	/* The sandbox host finishes the read on the second poll */
+	memset(buf, '\0', 1024);
+	ut_assertok(mmc_req_submit(mmc, &req, 0, 2, buf, false));
+	ut_asserteq(MMC_REQ_BUSY, req.state);
+	ut_asserteq(-EBUSY, mmc_req_submit(mmc, &other, 0, 1, buf, false));
+	ut_asserteq(-EBUSY, mmc_req_poll(&req));
+	ut_asserteq(2, mmc_req_wait(&req));
+	ut_asserteq(MMC_REQ_DONE, req.state);
+	ut_assertok(strcmp(buf, "this is a test"));
+
+	/* An unaligned buffer goes through the blocking path at submit */
+	memset(buf, '\0', 1024);
+	ut_assertok(mmc_req_submit(mmc, &req, 0, 2, buf + 1, false));
+	ut_asserteq(MMC_REQ_DONE, req.state);
+	ut_asserteq(2, mmc_req_wait(&req));
+	ut_assertok(strcmp(buf + 1, "this is a test"));
+
+	ut_asserteq(-EINVAL, mmc_req_submit(mmc, &req, 0, 0, buf, false));
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_req, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
@@ -6,6 +6,7 @@
 #include <common.h>
 #include <dm.h>
 #include <fdtdec.h>
+#include <malloc.h>
 #include <spi.h>
 #include <spi_flash.h>
 #include <asm/state.h>
@@ -40,3 +41,80 @@ static int dm_test_spi_flash(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_spi_flash, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Test that an update only erases and programs the sectors that change */
+static int dm_test_spi_flash_update(struct unit_test_state *uts)
+{
+	struct spi_flash_update_stats stats;
+	struct spi_flash *flash;
+	struct udevice *dev;
+	size_t len, sect;
+	u8 *buf, *cmp;
+	int i;
+
+	ut_asserteq(0, run_command_list(
+		"sb save hostfs - 0 spi.bin 200000;"
+		"sf probe", -1, 0));
+	ut_assertok(uclass_first_device_err(UCLASS_SPI_FLASH, &dev));
+	flash = dev_get_uclass_priv(dev);
+
+	/* three full sectors and part of a fourth */
+	sect = flash->erase_size;
+	len = 3 * sect + 0x100;
+	buf = malloc(len);
+	cmp = malloc(sect);
+	ut_assertnonnull(buf);
+	ut_assertnonnull(cmp);
+	for (i = 0; i < len; i++)
+		buf[i] = i * 7 + 1;
+
+	/* a whole flash erase, then data behind the range to keep */
+	ut_assertok(spi_flash_erase(flash, 0, flash->size));
+	ut_assertok(spi_flash_read(flash, 0, sect, cmp));
+	for (i = 0; i < sect; i++)
+		ut_asserteq(0xff, cmp[i]);
+	ut_assertok(spi_flash_write(flash, len, 4, "keep"));
+
+	/* blank sectors are only programmed, the last one is merged */
+	ut_assertok(spi_flash_update_range(flash, 0, len, buf, &stats));
+	ut_asserteq(0, stats.skipped);
+	ut_asserteq(sect, stats.erased);
+	ut_asserteq(4 * sect, stats.programmed);
+
+	/* nothing changed */
+	ut_assertok(spi_flash_update_range(flash, 0, len, buf, &stats));
+	ut_asserteq(len, stats.skipped);
+	ut_asserteq(0, stats.erased);
+	ut_asserteq(0, stats.programmed);
+
+	/* one byte in the second sector and one in the last */
+	buf[sect + 5] ^= 0xff;
+	buf[len - 1] ^= 0xff;
+	ut_assertok(spi_flash_update_range(flash, 0, len, buf, &stats));
+	ut_asserteq(2 * sect, stats.skipped);
+	ut_asserteq(2 * sect, stats.erased);
+	ut_asserteq(2 * sect, stats.programmed);
+
+	/* a sector going blank is only erased */
+	memset(buf + 2 * sect, 0xff, sect);
+	ut_assertok(spi_flash_update_range(flash, 0, len, buf, &stats));
+	ut_asserteq(sect, stats.erased);
+	ut_asserteq(0, stats.programmed);
+
+	for (i = 0; i < 4; i++) {
+		ut_assertok(spi_flash_read(flash, i * sect, sect, cmp));
+		ut_assertok(memcmp(cmp, buf + i * sect,
+				   min_t(size_t, sect, len - i * sect)));
+	}
+	ut_assertok(memcmp(cmp + 0x100, "keep", 4));
+
+	ut_asserteq(-EINVAL, spi_flash_update_range(flash, 1, len, buf,
+						    &stats));
+
+	free(cmp);
+	free(buf);
+	sandbox_sf_unbind_emul(state_get_current(), 0, 0);
+
+	return 0;
+}
+DM_TEST(dm_test_spi_flash_update, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
@@ -0,0 +1,272 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Tests for the device tree lookup index, against libfdt on a large tree
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <fdt_index.h>
+#include <fdt_support.h>
+#include <test/suites.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Declare a new fdt_index test */
+#define FDT_INDEX_TEST(_name, _flags) \
+		UNIT_TEST(_name, _flags, fdt_index_test)
+
+/* 64 buses of 64 devices, about the node count of a sunxi board tree */
+#define FI_TEST_BUSES		64
+#define FI_TEST_DEVS		64
+#define FI_TEST_NODES		(FI_TEST_BUSES * FI_TEST_DEVS)
+#define FI_TEST_SIZE		(1024 * 1024)
+#define FI_TEST_LOOKUPS		2000
+
+static u32 fi_test_phandle(int bus, int dev)
+{
+	return bus * FI_TEST_DEVS + dev + 1;
+}
+
+static int fi_test_make(struct unit_test_state *uts, void **fdtp)
+{
+	char name[32], path[64];
+	void *fdt;
+	int bus, dev;
+
+	fdt = malloc(FI_TEST_SIZE);
+	ut_assertnonnull(fdt);
+	ut_assertok(fdt_create(fdt, FI_TEST_SIZE));
+	ut_assertok(fdt_finish_reservemap(fdt));
+	ut_assertok(fdt_begin_node(fdt, ""));
+
+	ut_assertok(fdt_begin_node(fdt, "aliases"));
+	ut_assertok(fdt_property_string(fdt, "spi0", "/soc/bus@3/dev@5"));
+	ut_assertok(fdt_property_string(fdt, "bus7", "/soc/bus@7"));
+	ut_assertok(fdt_end_node(fdt));
+
+	ut_assertok(fdt_begin_node(fdt, "soc"));
+	for (bus = 0; bus < FI_TEST_BUSES; bus++) {
+		sprintf(name, "bus@%d", bus);
+		ut_assertok(fdt_begin_node(fdt, name));
+		for (dev = 0; dev < FI_TEST_DEVS; dev++) {
+			sprintf(name, "dev@%d", dev);
+			sprintf(path, "allwinner,pins-%d", dev);
+			ut_assertok(fdt_begin_node(fdt, name));
+			ut_assertok(fdt_property_string(fdt, "compatible",
+							"allwinner,test"));
+			ut_assertok(fdt_property_string(fdt, "allwinner,pins",
+							path));
+			ut_assertok(fdt_property_u32(fdt, "reg", dev));
+			ut_assertok(fdt_property_string(fdt, "status", "okay"));
+			ut_assertok(fdt_property_u32(fdt, "phandle",
+						     fi_test_phandle(bus, dev)));
+			ut_assertok(fdt_end_node(fdt));
+		}
+		ut_assertok(fdt_end_node(fdt));
+	}
+	ut_assertok(fdt_end_node(fdt));
+
+	ut_assertok(fdt_end_node(fdt));
+	ut_assertok(fdt_finish(fdt));
+	/* room for the writes */
+	ut_assertok(fdt_open_into(fdt, fdt, FI_TEST_SIZE));
+	fdt_index_invalidate();
+	*fdtp = fdt;
+
+	return 0;
+}
+
+/* Every lookup of the index agrees with libfdt for @phandle */
+static int fi_test_check_node(struct unit_test_state *uts, void *fdt,
+			      u32 phandle)
+{
+	char path[64], ipath[64];
+	int offset;
+
+	offset = fdt_node_offset_by_phandle(fdt, phandle);
+	ut_assert(offset > 0);
+	ut_asserteq(offset, fdt_index_node_offset_by_phandle(fdt, phandle));
+
+	ut_assertok(fdt_get_path(fdt, offset, path, sizeof(path)));
+	ut_assertok(fdt_index_get_path(fdt, offset, ipath, sizeof(ipath)));
+	ut_asserteq_str(path, ipath);
+	ut_asserteq(offset, fdt_index_path_offset(fdt, path));
+
+	return 0;
+}
+
+static int fdt_index_test_lookup(struct unit_test_state *uts)
+{
+	char path[64];
+	void *fdt;
+	u32 phandle;
+
+	ut_assertok(fi_test_make(uts, &fdt));
+
+	for (phandle = 1; phandle <= FI_TEST_NODES; phandle += 37)
+		ut_assertok(fi_test_check_node(uts, fdt, phandle));
+	ut_assertok(fi_test_check_node(uts, fdt, FI_TEST_NODES));
+
+	ut_asserteq(0, fdt_index_path_offset(fdt, "/"));
+	ut_asserteq(fdt_path_offset(fdt, "/soc/bus@3/dev@5"),
+		    fdt_index_path_offset(fdt, "spi0"));
+	ut_asserteq(fdt_path_offset(fdt, "/soc/bus@7/dev@9"),
+		    fdt_index_path_offset(fdt, "bus7/dev@9"));
+	/* left to libfdt */
+	ut_asserteq(fdt_path_offset(fdt, "/soc/bus@7/dev"),
+		    fdt_index_path_offset(fdt, "/soc/bus@7/dev"));
+	ut_asserteq(fdt_path_offset(fdt, "/soc/bus@7/"),
+		    fdt_index_path_offset(fdt, "/soc/bus@7/"));
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdt_index_path_offset(fdt, "/soc/bus@99"));
+	ut_asserteq(-FDT_ERR_BADPATH, fdt_index_path_offset(fdt, "nothing"));
+
+	ut_asserteq(-FDT_ERR_BADPHANDLE,
+		    fdt_index_node_offset_by_phandle(fdt, 0));
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdt_index_node_offset_by_phandle(fdt, FI_TEST_NODES + 1));
+
+	ut_asserteq(-FDT_ERR_NOSPACE,
+		    fdt_index_get_path(fdt, fdt_index_path_offset(fdt, "spi0"),
+				       path, 8));
+	ut_asserteq(fdt_get_path(fdt, 1, path, sizeof(path)),
+		    fdt_index_get_path(fdt, 1, path, sizeof(path)));
+
+	free(fdt);
+
+	return 0;
+}
+FDT_INDEX_TEST(fdt_index_test_lookup, 0);
+
+static int fdt_index_test_write(struct unit_test_state *uts)
+{
+	u32 phandle = fi_test_phandle(1, 2);
+	int offset, i;
+	void *fdt;
+
+	ut_assertok(fi_test_make(uts, &fdt));
+	for (i = 0; i < 8; i++)
+		ut_assertok(fi_test_check_node(uts, fdt, FI_TEST_NODES));
+
+	/* a longer property moves every node after it */
+	offset = fdt_index_node_offset_by_phandle(fdt, phandle);
+	ut_assertok(fdt_setprop_string(fdt, offset, "allwinner,pins",
+				       "PA0,PA1,PA2,PA3,PA4,PA5,PA6,PA7"));
+	for (i = 0; i < 8; i++)
+		ut_assertok(fi_test_check_node(uts, fdt, FI_TEST_NODES - i));
+
+	/* and so does a disabled status, through fdt_support */
+	offset = fdt_index_path_offset(fdt, "/soc/bus@0/dev@0");
+	ut_assertok(fdt_status_disabled(fdt, offset));
+	for (i = 0; i < 8; i++)
+		ut_assertok(fi_test_check_node(uts, fdt, FI_TEST_NODES - i));
+
+	/* a phandle replaced in place */
+	offset = fdt_index_node_offset_by_phandle(fdt, phandle);
+	ut_assertok(fdt_set_phandle(fdt, offset, FI_TEST_NODES + 10));
+	ut_asserteq(offset, fdt_index_node_offset_by_phandle(fdt,
+							     FI_TEST_NODES + 10));
+	for (i = 0; i < 8; i++)
+		ut_assertok(fi_test_check_node(uts, fdt, FI_TEST_NODES + 10));
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdt_index_node_offset_by_phandle(fdt, phandle));
+
+	/* written in place behind the back of the index */
+	phandle = fi_test_phandle(4, 9);
+	offset = fdt_index_path_offset(fdt, "/soc/bus@4/dev@9");
+	ut_assertok(fdt_setprop_inplace_u32(fdt, offset, "phandle",
+					    FI_TEST_NODES + 20));
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdt_index_node_offset_by_phandle(fdt, phandle));
+	for (i = 0; i < 8; i++)
+		ut_assertok(fi_test_check_node(uts, fdt, FI_TEST_NODES + 20));
+	ut_assertok(fdt_set_name(fdt, offset, "dev@Z"));
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdt_index_path_offset(fdt, "/soc/bus@4/dev@9"));
+	for (i = 0; i < 8; i++)
+		ut_assertok(fi_test_check_node(uts, fdt, FI_TEST_NODES + 20));
+
+	free(fdt);
+
+	return 0;
+}
+FDT_INDEX_TEST(fdt_index_test_write, 0);
+
+static int fdt_index_test_speed(struct unit_test_state *uts)
+{
+	ulong start, lib_us[3], idx_us[3];
+	int offset[FI_TEST_LOOKUPS];
+	char path[64];
+	u32 phandle;
+	void *fdt;
+	int i;
+
+	ut_assertok(fi_test_make(uts, &fdt));
+
+	/* phandles spread over the tree, as the pin groups of a board */
+	start = timer_get_us();
+	for (i = 0; i < FI_TEST_LOOKUPS; i++) {
+		phandle = (i * 2654435761u) % FI_TEST_NODES + 1;
+		offset[i] = fdt_node_offset_by_phandle(fdt, phandle);
+	}
+	lib_us[0] = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < FI_TEST_LOOKUPS; i++) {
+		phandle = (i * 2654435761u) % FI_TEST_NODES + 1;
+		ut_asserteq(offset[i],
+			    fdt_index_node_offset_by_phandle(fdt, phandle));
+	}
+	idx_us[0] = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < FI_TEST_LOOKUPS; i++)
+		ut_assertok(fdt_get_path(fdt, offset[i], path, sizeof(path)));
+	lib_us[1] = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < FI_TEST_LOOKUPS; i++)
+		ut_assertok(fdt_index_get_path(fdt, offset[i], path,
+					       sizeof(path)));
+	idx_us[1] = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < FI_TEST_LOOKUPS; i++) {
+		sprintf(path, "/soc/bus@%d/dev@%d", i % FI_TEST_BUSES,
+			(i * 7) % FI_TEST_DEVS);
+		ut_assert(fdt_path_offset(fdt, path) > 0);
+	}
+	lib_us[2] = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < FI_TEST_LOOKUPS; i++) {
+		sprintf(path, "/soc/bus@%d/dev@%d", i % FI_TEST_BUSES,
+			(i * 7) % FI_TEST_DEVS);
+		ut_assert(fdt_index_path_offset(fdt, path) > 0);
+	}
+	idx_us[2] = timer_get_us() - start;
+
+	free(fdt);
+
+	printf("fdt index: %d nodes, %d lookups, libfdt/index us:\n",
+	       FI_TEST_NODES, FI_TEST_LOOKUPS);
+	printf("  phandle %lu/%lu, get_path %lu/%lu, path %lu/%lu\n",
+	       lib_us[0], idx_us[0], lib_us[1], idx_us[1], lib_us[2],
+	       idx_us[2]);
+
+	return 0;
+}
+FDT_INDEX_TEST(fdt_index_test_speed, 0);
+
+int do_ut_fdt_index(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
+{
+	struct unit_test *tests = ll_entry_start(struct unit_test,
+						 fdt_index_test);
+	const int n_ents = ll_entry_count(struct unit_test, fdt_index_test);
+
+	return cmd_ut_category("fdt_index", tests, n_ents, argc, argv);
+}
@@ -0,0 +1,254 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Tests for the scatter-gather SHA256
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <hash_sg.h>
+#include <malloc.h>
+#include <test/suites.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <u-boot/sha256.h>
+
+/* Declare a new hash_sg test */
+#define HASH_SG_TEST(_name, _flags)	UNIT_TEST(_name, _flags, hash_sg_test)
+
+#define HS_TEST_BUF		(256 * 1024)
+#define HS_TEST_MAX_SG		8
+
+/* buffer lengths of one list, offsets are taken one after the other */
+struct hs_test_layout {
+	const char *name;
+	int nr_sg;
+	u32 off[HS_TEST_MAX_SG];
+	u32 len[HS_TEST_MAX_SG];
+};
+
+static const struct hs_test_layout hs_test_layouts[] = {
+	/* vbmeta salt in the descriptor, then the image */
+	{ "salt+image", 2, { 0x101, 0x1000 }, { 32, 100000 } },
+	/* boot image header page, kernel and ramdisk at their own places */
+	{ "hdr+kernel+ramdisk", 3, { 0, 0x4000, 0x30000 },
+	  { 2048, 0x20000, 70001 } },
+	{ "small pieces", 8, { 3, 40, 99, 300, 301, 700, 777, 1000 },
+	  { 1, 5, 63, 0, 64, 65, 2, 129 } },
+	{ "empty", 2, { 0, 0 }, { 0, 0 } },
+	{ "one block", 1, { 0 }, { 64 } },
+};
+
+static u8 *hs_test_buf(void)
+{
+	u8 *buf = malloc(HS_TEST_BUF);
+	int i;
+
+	if (buf)
+		for (i = 0; i < HS_TEST_BUF; i++)
+			buf[i] = i * 13 + (i >> 10);
+
+	return buf;
+}
+
+static void hs_test_list(const struct hs_test_layout *l, u8 *buf,
+			 struct hash_sg *sg)
+{
+	int i;
+
+	for (i = 0; i < l->nr_sg; i++) {
+		sg[i].addr = buf + l->off[i];
+		sg[i].len  = l->len[i];
+	}
+}
+
+/* digest of the buffers copied together */
+static void hs_test_expect(const struct hash_sg *sg, int nr_sg, u8 *digest)
+{
+	sha256_context ctx;
+	int i;
+
+	sha256_starts(&ctx);
+	for (i = 0; i < nr_sg; i++)
+		sha256_update(&ctx, sg[i].addr, sg[i].len);
+	sha256_finish(&ctx, digest);
+}
+
+static int hash_sg_test_digest(struct unit_test_state *uts)
+{
+	const struct hs_test_layout *l;
+	struct hash_sg sg[HS_TEST_MAX_SG];
+	u8 expect[SHA256_SUM_LEN], digest[SHA256_SUM_LEN];
+	u8 *buf;
+
+	buf = hs_test_buf();
+	ut_assertnonnull(buf);
+	for (l = hs_test_layouts; l < hs_test_layouts +
+	     ARRAY_SIZE(hs_test_layouts); l++) {
+		hs_test_list(l, buf, sg);
+		hs_test_expect(sg, l->nr_sg, expect);
+		memset(digest, 0, sizeof(digest));
+		ut_assertok(hash_sg_sha256(sg, l->nr_sg, digest));
+		if (memcmp(expect, digest, sizeof(digest)))
+			ut_failf(uts, __FILE__, __LINE__, __func__, "digest",
+				 "layout %s", l->name);
+	}
+	free(buf);
+
+	return 0;
+}
+HASH_SG_TEST(hash_sg_test_digest, 0);
+
+static int hash_sg_test_plan(struct unit_test_state *uts)
+{
+	const struct hs_test_layout *l;
+	struct hash_sg sg[HS_TEST_MAX_SG], piece[2 * HS_TEST_MAX_SG + 1];
+	u8 bounce[(HS_TEST_MAX_SG + 1) * HASH_SG_BLOCK] __aligned(4);
+	u8 expect[SHA256_SUM_LEN], digest[SHA256_SUM_LEN];
+	int nr_piece, i;
+	u8 *buf;
+
+	buf = hs_test_buf();
+	ut_assertnonnull(buf);
+	for (l = hs_test_layouts; l < hs_test_layouts +
+	     ARRAY_SIZE(hs_test_layouts); l++) {
+		hs_test_list(l, buf, sg);
+		nr_piece = hash_sg_plan(sg, l->nr_sg, piece, bounce);
+		ut_assert(nr_piece >= 0 && nr_piece <= 2 * l->nr_sg + 1);
+
+		/* what a DMA engine can take, in the same order */
+		for (i = 0; i < nr_piece; i++) {
+			ut_assert(piece[i].len);
+			ut_asserteq(0, (ulong)piece[i].addr & 3);
+			if (i < nr_piece - 1)
+				ut_asserteq(0, piece[i].len % HASH_SG_BLOCK);
+		}
+		hs_test_expect(sg, l->nr_sg, expect);
+		hs_test_expect(piece, nr_piece, digest);
+		if (memcmp(expect, digest, sizeof(digest)))
+			ut_failf(uts, __FILE__, __LINE__, __func__, "pieces",
+				 "layout %s", l->name);
+	}
+
+	/* a large buffer off word alignment can't be taken as it is */
+	sg[0].addr = buf + 1;
+	sg[0].len  = 4 * HASH_SG_BLOCK;
+	ut_asserteq(-EINVAL, hash_sg_plan(sg, 1, piece, bounce));
+	/* unless the buffers before bring it back onto a block boundary */
+	sg[0].addr = buf;
+	sg[0].len  = HASH_SG_BLOCK - 1;
+	sg[1].addr = buf + 0x1003;
+	sg[1].len  = 4 * HASH_SG_BLOCK + 1;
+	ut_asserteq(2, hash_sg_plan(sg, 2, piece, bounce));
+	ut_asserteq_ptr(buf + 0x1004, piece[1].addr);
+	free(buf);
+
+	return 0;
+}
+HASH_SG_TEST(hash_sg_test_plan, 0);
+
+static int hash_sg_test_async(struct unit_test_state *uts)
+{
+	struct hash_sg_req req = { 0 };
+	struct hash_sg sg[3];
+	u8 expect[SHA256_SUM_LEN], digest[SHA256_SUM_LEN];
+	int ret, polls = 0;
+	u8 *buf;
+
+	ut_asserteq(-EINVAL, hash_sg_poll(&req));
+
+	buf = hs_test_buf();
+	ut_assertnonnull(buf);
+	hs_test_list(&hs_test_layouts[1], buf, sg);
+	hs_test_expect(sg, 3, expect);
+
+	ut_assertok(hash_sg_submit(&req, sg, 3, digest));
+	do {
+		ret = hash_sg_poll(&req);
+		polls++;
+	} while (ret == -EBUSY);
+	ut_assertok(ret);
+	ut_asserteq(HASH_SG_DONE, req.state);
+	ut_assertok(memcmp(expect, digest, sizeof(digest)));
+
+	/* a finished request keeps its result and can be used again */
+	ut_assertok(hash_sg_wait(&req));
+	ut_assertok(hash_sg_submit(&req, sg, 1, digest));
+	ut_assertok(hash_sg_wait(&req));
+	hs_test_expect(sg, 1, expect);
+	ut_assertok(memcmp(expect, digest, sizeof(digest)));
+	free(buf);
+	debug("hash sg: %d polls\n", polls);
+
+	return 0;
+}
+HASH_SG_TEST(hash_sg_test_async, 0);
+
+static int hash_sg_test_ctx(struct unit_test_state *uts)
+{
+	static const u32 windows[] = { 64, 4096, 0x10000, 3 * 0x10000 };
+	const u32 total = HS_TEST_BUF - 61;
+	struct hash_sg_req req = { 0 };
+	struct hash_sg_ctx ctx;
+	struct hash_sg sg[2];
+	u8 expect[SHA256_SUM_LEN], digest[SHA256_SUM_LEN];
+	u32 off, len;
+	int i;
+	u8 *buf;
+
+	buf = hs_test_buf();
+	ut_assertnonnull(buf);
+	sha256_csum_wd(buf, total, expect, CHUNKSZ_SHA256);
+
+	/* window by window, the last one ends off a block */
+	for (i = 0; i < ARRAY_SIZE(windows); i++) {
+		memset(digest, 0, sizeof(digest));
+		hash_sg_ctx_init(&ctx, total, digest);
+		for (off = 0; off < total; off += len) {
+			len = min(windows[i], total - off);
+			sg[0].addr = buf + off;
+			sg[0].len  = len;
+			ut_assertok(hash_sg_ctx_submit(&req, &ctx, sg, 1));
+			ut_assertok(hash_sg_wait(&req));
+		}
+		ut_asserteq(total, ctx.done);
+		if (memcmp(expect, digest, sizeof(digest)))
+			ut_failf(uts, __FILE__, __LINE__, __func__, "digest",
+				 "window %u", windows[i]);
+	}
+
+	/* a part may be a list of its own, split off a block in the middle */
+	hash_sg_ctx_init(&ctx, total, digest);
+	sg[0].addr = buf;
+	sg[0].len  = 100;
+	sg[1].addr = buf + 100;
+	sg[1].len  = 4096 - 100;
+	ut_assertok(hash_sg_ctx_submit(&req, &ctx, sg, 2));
+	ut_assertok(hash_sg_wait(&req));
+	/* only the part ending the message may end off a block */
+	sg[0].addr = buf + 4096;
+	sg[0].len  = 100;
+	ut_asserteq(-EINVAL, hash_sg_ctx_submit(&req, &ctx, sg, 1));
+	sg[0].len  = total;
+	ut_asserteq(-EINVAL, hash_sg_ctx_submit(&req, &ctx, sg, 1));
+	sg[0].len  = total - 4096;
+	ut_assertok(hash_sg_ctx_submit(&req, &ctx, sg, 1));
+	ut_assertok(hash_sg_wait(&req));
+	ut_assertok(memcmp(expect, digest, sizeof(digest)));
+	free(buf);
+
+	return 0;
+}
+HASH_SG_TEST(hash_sg_test_ctx, 0);
+
+int do_ut_hash_sg(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
+{
+	struct unit_test *tests = ll_entry_start(struct unit_test,
+						 hash_sg_test);
+	const int n_ents = ll_entry_count(struct unit_test, hash_sg_test);
+
+	return cmd_ut_category("hash_sg", tests, n_ents, argc, argv);
+}
@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Tests for the item lookup of the firmware image decoder, on an image
+ * table built in RAM
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <test/suites.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include "../sprite/firmware/imgdecode.h"
+#include "../sprite/firmware/imagefile_new.h"
+
+/* Declare a new imgdecode test */
+#define IMGDECODE_TEST(_name, _flags) \
+		UNIT_TEST(_name, _flags, imgdecode_test)
+
+#define IMG_TEST_ITEMS		300
+/* the last item repeats the subType of this one */
+#define IMG_TEST_DUP		7
+/* more items open at once than the image handle keeps handles for */
+#define IMG_TEST_OPEN		20
+#define IMG_TEST_MAINTYPE	"12345678"
+
+static void img_test_name(char *name, int i)
+{
+	snprintf(name, SUBTYPE_LEN + 1, "ITEM%012d",
+		 i == IMG_TEST_ITEMS - 1 ? IMG_TEST_DUP : i);
+}
+
+/* head and item table of an image, item i is i + 1 bytes at i KiB */
+static void *img_test_build(void)
+{
+	char name[SUBTYPE_LEN + 1];
+	ImageHead_t *head;
+	ImageItem_t *item;
+	void *image;
+	int i;
+
+	image = malloc(IMAGE_HEAD_SIZE + IMG_TEST_ITEMS * sizeof(*item));
+	if (!image)
+		return NULL;
+	memset(image, 0, IMAGE_HEAD_SIZE + IMG_TEST_ITEMS * sizeof(*item));
+
+	head = image;
+	memcpy(head->magic, IMAGE_MAGIC, 8);
+	head->version = IMAGE_HEAD_VERSION;
+	head->size = sizeof(*head);
+	head->itemsize = sizeof(*item);
+	head->itemcount = IMG_TEST_ITEMS;
+	head->itemoffset = IMAGE_HEAD_SIZE;
+
+	item = image + IMAGE_HEAD_SIZE;
+	for (i = 0; i < IMG_TEST_ITEMS; i++) {
+		item[i].version = IMAGE_ITEM_VERSION;
+		item[i].size = sizeof(*item);
+		memcpy(item[i].mainType, IMG_TEST_MAINTYPE, MAINTYPE_LEN);
+		img_test_name(name, i);
+		memcpy(item[i].subType, name, SUBTYPE_LEN);
+		item[i].filelenLo = i + 1;
+		item[i].offsetLo = i * IMAGE_ALIGN_SIZE;
+	}
+
+	return image;
+}
+
+static int imgdecode_test_index(struct unit_test_state *uts)
+{
+	char name[SUBTYPE_LEN + 1];
+	HIMAGEITEM hitem;
+	HIMAGE himg;
+	void *image;
+	ulong start;
+	int i;
+
+	image = img_test_build();
+	ut_assertnonnull(image);
+	himg = Img_Mem_Open(image);
+	ut_assertnonnull(himg);
+
+	start = timer_get_us();
+	for (i = 0; i < IMG_TEST_ITEMS - 1; i++) {
+		img_test_name(name, i);
+		hitem = Img_OpenItem(himg, IMG_TEST_MAINTYPE, name);
+		ut_assertnonnull(hitem);
+		ut_asserteq(i + 1, Img_GetItemSize(himg, hitem));
+		ut_asserteq(i * IMAGE_ALIGN_SIZE,
+			    Img_GetItemOffset(himg, hitem));
+		ut_assertok(Img_CloseItem(himg, hitem));
+	}
+	printf("imgdecode: %d lookups in %lu us\n", IMG_TEST_ITEMS - 1,
+	       timer_get_us() - start);
+
+	/* a repeated subType finds the first item, the main type is ignored */
+	img_test_name(name, IMG_TEST_ITEMS - 1);
+	hitem = Img_OpenItem(himg, "RFSFAT16", name);
+	ut_assertnonnull(hitem);
+	ut_asserteq(IMG_TEST_DUP * IMAGE_ALIGN_SIZE,
+		    Img_GetItemOffset(himg, hitem));
+	ut_assertok(Img_CloseItem(himg, hitem));
+
+	ut_asserteq_ptr(NULL, Img_OpenItem(himg, IMG_TEST_MAINTYPE,
+					   "ITEM999999999999"));
+	ut_asserteq_ptr(NULL, Img_OpenItem(himg, IMG_TEST_MAINTYPE,
+					   "1234567890DLINFO"));
+	Img_Close(himg);
+
+	/* a table without the magic is refused */
+	memset(image, 0, 8);
+	ut_asserteq_ptr(NULL, Img_Mem_Open(image));
+	free(image);
+
+	return 0;
+}
+IMGDECODE_TEST(imgdecode_test_index, 0);
+
+static int imgdecode_test_handles(struct unit_test_state *uts)
+{
+	HIMAGEITEM hitem[IMG_TEST_OPEN], again;
+	char name[SUBTYPE_LEN + 1];
+	HIMAGE himg;
+	void *image;
+	int i, j;
+
+	image = img_test_build();
+	ut_assertnonnull(image);
+	himg = Img_Mem_Open(image);
+	ut_assertnonnull(himg);
+
+	/* handles open at the same time are apart and keep their item */
+	for (i = 0; i < IMG_TEST_OPEN; i++) {
+		img_test_name(name, i * 13);
+		hitem[i] = Img_OpenItem(himg, IMG_TEST_MAINTYPE, name);
+		ut_assertnonnull(hitem[i]);
+		for (j = 0; j < i; j++)
+			ut_assert(hitem[i] != hitem[j]);
+	}
+	for (i = 0; i < IMG_TEST_OPEN; i++)
+		ut_asserteq(i * 13 * IMAGE_ALIGN_SIZE,
+			    Img_GetItemOffset(himg, hitem[i]));
+
+	/* a closed handle is taken again, the others stay as they were */
+	for (i = 0; i < IMG_TEST_OPEN; i += 3) {
+		ut_assertok(Img_CloseItem(himg, hitem[i]));
+		img_test_name(name, 1);
+		again = Img_OpenItem(himg, IMG_TEST_MAINTYPE, name);
+		ut_assertnonnull(again);
+		ut_asserteq(IMAGE_ALIGN_SIZE, Img_GetItemOffset(himg, again));
+		for (j = 0; j < IMG_TEST_OPEN; j++)
+			if (j != i)
+				ut_assert(again != hitem[j]);
+		hitem[i] = again;
+	}
+	for (i = 0; i < IMG_TEST_OPEN; i++)
+		ut_asserteq(i % 3 ? i * 13 * IMAGE_ALIGN_SIZE :
+				    IMAGE_ALIGN_SIZE,
+			    Img_GetItemOffset(himg, hitem[i]));
+
+	for (i = IMG_TEST_OPEN - 1; i >= 0; i--)
+		ut_assertok(Img_CloseItem(himg, hitem[i]));
+	Img_Close(himg);
+	free(image);
+
+	return 0;
+}
+IMGDECODE_TEST(imgdecode_test_handles, 0);
+
+int do_ut_imgdecode(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
+{
+	struct unit_test *tests = ll_entry_start(struct unit_test,
+						 imgdecode_test);
+	const int n_ents = ll_entry_count(struct unit_test, imgdecode_test);
+
+	return cmd_ut_category("imgdecode", tests, n_ents, argc, argv);
+}
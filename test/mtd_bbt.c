@@ -0,0 +1,339 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Tests for the bad block table kept on flash, on a NAND-like MTD device
+ * in RAM
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <linux/mtd/mtd.h>
+#include <linux/mtd/mtdbbt.h>
+#include <test/suites.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Declare a new mtd_bbt test */
+#define MTD_BBT_TEST(_name, _flags) \
+		UNIT_TEST(_name, _flags, mtd_bbt_test)
+
+#define SIM_PAGE_SIZE		512
+#define SIM_BLOCK_SHIFT		11		/* 4 pages */
+#define SIM_BLOCK_SIZE		(1 << SIM_BLOCK_SHIFT)
+#define SIM_BLOCKS		16
+/* the copies go to the last blocks */
+#define SIM_AREA_FIRST		12
+#define SIM_AREA_BLOCKS		4
+/* one page of table, and one taking two pages */
+#define SIM_BITS		1000
+#define SIM_BITS_LARGE		6000
+
+static struct {
+	u8 data[SIM_BLOCKS * SIM_BLOCK_SIZE];
+	/* blocks reported bad and blocks failing to erase */
+	u32 bad;
+	u32 fail;
+	int page_reads;
+} sim;
+
+static struct mtd_info sim_mtd;
+static u8 bitmap[SIM_BITS_LARGE / 8];
+static u8 loaded[SIM_BITS_LARGE / 8];
+static u8 saved[SIM_BLOCK_SIZE];
+
+static int sim_erase(struct mtd_info *mtd, struct erase_info *instr)
+{
+	int block = instr->addr >> SIM_BLOCK_SHIFT;
+
+	if (sim.fail & BIT(block)) {
+		instr->state = MTD_ERASE_FAILED;
+		instr->fail_addr = instr->addr;
+		return -EIO;
+	}
+	memset(sim.data + instr->addr, 0xff, instr->len);
+	instr->state = MTD_ERASE_DONE;
+
+	return 0;
+}
+
+static int sim_read(struct mtd_info *mtd, loff_t from, size_t len,
+		    size_t *retlen, u_char *buf)
+{
+	memcpy(buf, sim.data + from, len);
+	sim.page_reads += DIV_ROUND_UP(len, SIM_PAGE_SIZE);
+	*retlen = len;
+
+	return 0;
+}
+
+/* programming only clears bits, as on NAND */
+static int sim_write(struct mtd_info *mtd, loff_t to, size_t len,
+		     size_t *retlen, const u_char *buf)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		sim.data[to + i] &= buf[i];
+	*retlen = len;
+
+	return 0;
+}
+
+static int sim_block_isbad(struct mtd_info *mtd, loff_t ofs)
+{
+	return !!(sim.bad & BIT(ofs >> SIM_BLOCK_SHIFT));
+}
+
+static void sim_reset(void)
+{
+	memset(&sim, 0, sizeof(sim));
+	memset(sim.data, 0xff, sizeof(sim.data));
+
+	memset(&sim_mtd, 0, sizeof(sim_mtd));
+	sim_mtd.name = "mtd_bbt_sim";
+	sim_mtd.type = MTD_NANDFLASH;
+	sim_mtd.flags = MTD_CAP_NANDFLASH;
+	sim_mtd.size = sizeof(sim.data);
+	sim_mtd.erasesize = SIM_BLOCK_SIZE;
+	sim_mtd.writesize = SIM_PAGE_SIZE;
+	sim_mtd._erase = sim_erase;
+	sim_mtd._read = sim_read;
+	sim_mtd._write = sim_write;
+	sim_mtd._block_isbad = sim_block_isbad;
+
+	memset(bitmap, 0, sizeof(bitmap));
+	bitmap[0] = 0x08;
+	bitmap[62] = 0x10;
+	bitmap[SIM_BITS / 8 - 1] = 0x80;
+}
+
+static int sim_bbt_init(struct mtd_bbt *bbt, u8 *map, int nr_bits)
+{
+	return mtd_bbt_init(bbt, &sim_mtd,
+			    (loff_t)SIM_AREA_FIRST << SIM_BLOCK_SHIFT,
+			    SIM_AREA_BLOCKS, map, nr_bits);
+}
+
+/* A fresh table loaded from flash, as on the next boot */
+static int sim_bbt_reload(struct mtd_bbt *bbt, int nr_bits)
+{
+	memset(loaded, 0, sizeof(loaded));
+	sim.page_reads = 0;
+	if (sim_bbt_init(bbt, loaded, nr_bits))
+		return -EINVAL;
+
+	return mtd_bbt_load(bbt);
+}
+
+static u8 *sim_copy(const struct mtd_bbt *bbt, int i)
+{
+	return sim.data + ((SIM_AREA_FIRST + bbt->copy[i]) << SIM_BLOCK_SHIFT);
+}
+
+static int mtd_bbt_test_empty(struct unit_test_state *uts)
+{
+	struct mtd_bbt bbt;
+
+	sim_reset();
+	memset(loaded, 0x5a, sizeof(loaded));
+	ut_assertok(sim_bbt_init(&bbt, loaded, SIM_BITS));
+	ut_asserteq(-ENOENT, mtd_bbt_load(&bbt));
+	/* nothing found, nothing touched */
+	ut_asserteq(0x5a, loaded[0]);
+
+	return 0;
+}
+MTD_BBT_TEST(mtd_bbt_test_empty, 0);
+
+static int mtd_bbt_test_init(struct unit_test_state *uts)
+{
+	struct mtd_bbt bbt;
+
+	sim_reset();
+	/* unaligned, too small, past the end */
+	ut_asserteq(-EINVAL, mtd_bbt_init(&bbt, &sim_mtd, SIM_PAGE_SIZE,
+					  SIM_AREA_BLOCKS, bitmap, SIM_BITS));
+	ut_asserteq(-EINVAL, mtd_bbt_init(&bbt, &sim_mtd, 0, 1, bitmap,
+					  SIM_BITS));
+	ut_asserteq(-EINVAL, mtd_bbt_init(&bbt, &sim_mtd,
+					  (loff_t)SIM_AREA_FIRST << SIM_BLOCK_SHIFT,
+					  SIM_AREA_BLOCKS + 1, bitmap, SIM_BITS));
+	/* a table larger than a block */
+	ut_asserteq(-EINVAL, sim_bbt_init(&bbt, bitmap, SIM_BLOCK_SIZE * 8));
+	ut_asserteq(-EINVAL, mtd_bbt_store(&bbt));
+
+	return 0;
+}
+MTD_BBT_TEST(mtd_bbt_test_init, 0);
+
+static int mtd_bbt_test_store_load(struct unit_test_state *uts)
+{
+	struct mtd_bbt bbt;
+
+	sim_reset();
+	ut_assertok(sim_bbt_init(&bbt, bitmap, SIM_BITS));
+	ut_assertok(mtd_bbt_store(&bbt));
+	ut_asserteq(1, bbt.version);
+	ut_assert(bbt.copy[0] >= 0 && bbt.copy[1] >= 0);
+	ut_assert(bbt.copy[0] != bbt.copy[1]);
+
+	ut_assertok(sim_bbt_reload(&bbt, SIM_BITS));
+	ut_asserteq(1, bbt.version);
+	ut_assertok(memcmp(bitmap, loaded, SIM_BITS / 8));
+	/* a page per block of the area and no rewrite */
+	ut_asserteq(SIM_AREA_BLOCKS, sim.page_reads);
+
+	return 0;
+}
+MTD_BBT_TEST(mtd_bbt_test_store_load, 0);
+
+static int mtd_bbt_test_large(struct unit_test_state *uts)
+{
+	struct mtd_bbt bbt;
+
+	sim_reset();
+	bitmap[SIM_BITS_LARGE / 8 - 1] = 0x01;
+	ut_assertok(sim_bbt_init(&bbt, bitmap, SIM_BITS_LARGE));
+	ut_assertok(mtd_bbt_store(&bbt));
+
+	ut_assertok(sim_bbt_reload(&bbt, SIM_BITS_LARGE));
+	ut_assertok(memcmp(bitmap, loaded, SIM_BITS_LARGE / 8));
+	/* the second page only for the two copies */
+	ut_asserteq(SIM_AREA_BLOCKS + 2, sim.page_reads);
+
+	/* a table of another size is not taken */
+	ut_asserteq(-ENOENT, sim_bbt_reload(&bbt, SIM_BITS));
+
+	return 0;
+}
+MTD_BBT_TEST(mtd_bbt_test_large, 0);
+
+static int mtd_bbt_test_update(struct unit_test_state *uts)
+{
+	struct mtd_bbt bbt;
+
+	sim_reset();
+	ut_assertok(sim_bbt_init(&bbt, bitmap, SIM_BITS));
+	ut_assertok(mtd_bbt_store(&bbt));
+	bitmap[100] |= 0x04;
+	ut_assertok(mtd_bbt_store(&bbt));
+	ut_asserteq(2, bbt.version);
+
+	ut_assertok(sim_bbt_reload(&bbt, SIM_BITS));
+	ut_asserteq(2, bbt.version);
+	ut_assertok(memcmp(bitmap, loaded, SIM_BITS / 8));
+
+	return 0;
+}
+MTD_BBT_TEST(mtd_bbt_test_update, 0);
+
+/* power cut while a copy is erased or written: the other one wins */
+static int mtd_bbt_test_power_cut(struct unit_test_state *uts)
+{
+	struct mtd_bbt bbt;
+	u8 *copy;
+
+	sim_reset();
+	ut_assertok(sim_bbt_init(&bbt, bitmap, SIM_BITS));
+	ut_assertok(mtd_bbt_store(&bbt));
+	bitmap[100] |= 0x04;
+	ut_assertok(mtd_bbt_store(&bbt));
+
+	/* erased, the copy is rewritten on load with the next version */
+	memset(sim_copy(&bbt, 1), 0xff, SIM_BLOCK_SIZE);
+	ut_assertok(sim_bbt_reload(&bbt, SIM_BITS));
+	ut_assertok(memcmp(bitmap, loaded, SIM_BITS / 8));
+	ut_asserteq(3, bbt.version);
+	ut_assertok(sim_bbt_reload(&bbt, SIM_BITS));
+	ut_asserteq(3, bbt.version);
+	ut_asserteq(SIM_AREA_BLOCKS, sim.page_reads);
+
+	/* half written, the checksum fails */
+	copy = sim_copy(&bbt, 0);
+	copy[sizeof(struct mtd_bbt_hdr) + 100] &= ~0x04;
+	ut_assertok(sim_bbt_reload(&bbt, SIM_BITS));
+	ut_assertok(memcmp(bitmap, loaded, SIM_BITS / 8));
+	ut_asserteq(4, bbt.version);
+
+	/* cut before the second copy of an update, it still has the last one */
+	memcpy(saved, sim_copy(&bbt, 1), SIM_BLOCK_SIZE);
+	loaded[110] |= 0x01;
+	ut_assertok(mtd_bbt_store(&bbt));
+	memcpy(sim_copy(&bbt, 1), saved, SIM_BLOCK_SIZE);
+	memcpy(bitmap, loaded, SIM_BITS / 8);
+	ut_assertok(sim_bbt_reload(&bbt, SIM_BITS));
+	ut_assertok(memcmp(bitmap, loaded, SIM_BITS / 8));
+	ut_asserteq(6, bbt.version);
+
+	return 0;
+}
+MTD_BBT_TEST(mtd_bbt_test_power_cut, 0);
+
+static int mtd_bbt_test_bad_area(struct unit_test_state *uts)
+{
+	struct mtd_bbt bbt;
+
+	sim_reset();
+	sim.bad = BIT(SIM_AREA_FIRST) | BIT(SIM_AREA_FIRST + 2);
+	ut_assertok(sim_bbt_init(&bbt, bitmap, SIM_BITS));
+	ut_assertok(mtd_bbt_store(&bbt));
+	ut_asserteq(1, bbt.copy[0]);
+	ut_asserteq(3, bbt.copy[1]);
+
+	/* bad blocks are not even read */
+	ut_assertok(sim_bbt_reload(&bbt, SIM_BITS));
+	ut_assertok(memcmp(bitmap, loaded, SIM_BITS / 8));
+	ut_asserteq(SIM_AREA_BLOCKS - 2, sim.page_reads);
+
+	return 0;
+}
+MTD_BBT_TEST(mtd_bbt_test_bad_area, 0);
+
+static int mtd_bbt_test_erase_fail(struct unit_test_state *uts)
+{
+	struct mtd_bbt bbt;
+
+	sim_reset();
+	ut_assertok(sim_bbt_init(&bbt, bitmap, SIM_BITS));
+	ut_assertok(mtd_bbt_store(&bbt));
+
+	/* a copy moves to another block */
+	sim.fail = BIT(SIM_AREA_FIRST + bbt.copy[0]);
+	ut_assertok(mtd_bbt_store(&bbt));
+	ut_assert(bbt.copy[0] >= 0 && bbt.copy[1] >= 0);
+	ut_assert(!(sim.fail & BIT(SIM_AREA_FIRST + bbt.copy[0])));
+	ut_assertok(sim_bbt_reload(&bbt, SIM_BITS));
+	ut_asserteq(2, bbt.version);
+
+	/* one copy is still a table */
+	sim_reset();
+	sim.fail = GENMASK(SIM_AREA_FIRST + SIM_AREA_BLOCKS - 2, SIM_AREA_FIRST);
+	ut_assertok(sim_bbt_init(&bbt, bitmap, SIM_BITS));
+	ut_assertok(mtd_bbt_store(&bbt));
+	ut_asserteq(SIM_AREA_BLOCKS - 1, bbt.copy[0]);
+	ut_asserteq(-1, bbt.copy[1]);
+	ut_assertok(sim_bbt_reload(&bbt, SIM_BITS));
+	ut_assertok(memcmp(bitmap, loaded, SIM_BITS / 8));
+
+	/* none is not */
+	sim_reset();
+	sim.fail = GENMASK(SIM_AREA_FIRST + SIM_AREA_BLOCKS - 1, SIM_AREA_FIRST);
+	ut_assertok(sim_bbt_init(&bbt, bitmap, SIM_BITS));
+	ut_asserteq(-EIO, mtd_bbt_store(&bbt));
+	ut_asserteq(0, bbt.version);
+
+	return 0;
+}
+MTD_BBT_TEST(mtd_bbt_test_erase_fail, 0);
+
+int do_ut_mtd_bbt(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
+{
+	struct unit_test *tests = ll_entry_start(struct unit_test,
+						 mtd_bbt_test);
+	const int n_ents = ll_entry_count(struct unit_test, mtd_bbt_test);
+
+	return cmd_ut_category("mtd_bbt", tests, n_ents, argc, argv);
+}
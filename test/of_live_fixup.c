@@ -0,0 +1,352 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Tests for device tree fixups on a live tree, against libfdt
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <of_live_fixup.h>
+#include <dm/of.h>
+#include <test/suites.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Declare a new of_live_fixup test */
+#define OF_LIVE_FIXUP_TEST(_name, _flags) \
+		UNIT_TEST(_name, _flags, of_live_fixup_test)
+
+/* 64 buses of 64 devices, about the node count of a sunxi board tree */
+#define LF_TEST_BUSES		64
+#define LF_TEST_DEVS		64
+#define LF_TEST_SIZE		(1024 * 1024)
+#define LF_TEST_DRAM_PARA	32
+
+struct lf_test_prop {
+	const char *path;
+	const char *name;
+	const void *val;
+	int len;
+};
+
+/* a u32 cell of 1 */
+static const u8 lf_test_one[] = { 0, 0, 0, 1 };
+
+/* The kind of fixups done before booting the kernel */
+static const struct lf_test_prop lf_test_props[] = {
+	/* new empty property */
+	{ "/soc/udc-controller", "charger_mode", NULL, 0 },
+	/* longer value, path without the unit address */
+	{ "/soc/nand0", "status", "disabled", sizeof("disabled") },
+	/* shorter value, alias */
+	{ "spi0", "status", "okay", sizeof("okay") },
+	/* new names, one a suffix of a name of the blob */
+	{ "spi0", "sample_mode", lf_test_one, sizeof(lf_test_one) },
+	{ "spi0", "pins", "PC0", sizeof("PC0") },
+	{ "/soc/bus@3/dev@5", "sample_mode", lf_test_one, sizeof(lf_test_one) },
+	{ "/soc/bus@3/dev@5", "compatible", "allwinner,sun50i-test",
+	  sizeof("allwinner,sun50i-test") },
+	{ "/soc/bus@63/dev@63", "status", "disabled", sizeof("disabled") },
+	{ "/soc/bus@63/dev@63", "status", "okay", sizeof("okay") },
+	{ "/soc/bus@0", "status", "disabled", sizeof("disabled") },
+};
+
+static int lf_test_make(struct unit_test_state *uts, void **fdtp)
+{
+	char name[32], pins[32];
+	void *fdt;
+	int bus, dev;
+
+	fdt = malloc(LF_TEST_SIZE);
+	ut_assertnonnull(fdt);
+	ut_assertok(fdt_create(fdt, LF_TEST_SIZE));
+	ut_assertok(fdt_add_reservemap_entry(fdt, 0x40000000, 0x100000));
+	ut_assertok(fdt_finish_reservemap(fdt));
+	ut_assertok(fdt_begin_node(fdt, ""));
+
+	ut_assertok(fdt_begin_node(fdt, "aliases"));
+	ut_assertok(fdt_property_string(fdt, "spi0", "/soc/spi@5010000"));
+	ut_assertok(fdt_end_node(fdt));
+
+	ut_assertok(fdt_begin_node(fdt, "dram"));
+	ut_assertok(fdt_property_string(fdt, "compatible",
+					"allwinner,dram"));
+	ut_assertok(fdt_end_node(fdt));
+
+	ut_assertok(fdt_begin_node(fdt, "soc"));
+	ut_assertok(fdt_begin_node(fdt, "udc-controller"));
+	ut_assertok(fdt_property_string(fdt, "status", "okay"));
+	ut_assertok(fdt_end_node(fdt));
+	ut_assertok(fdt_begin_node(fdt, "nand0@4011000"));
+	ut_assertok(fdt_property_string(fdt, "status", "okay"));
+	ut_assertok(fdt_end_node(fdt));
+	ut_assertok(fdt_begin_node(fdt, "spi@5010000"));
+	ut_assertok(fdt_property_string(fdt, "status", "disabled"));
+	ut_assertok(fdt_end_node(fdt));
+	for (bus = 0; bus < LF_TEST_BUSES; bus++) {
+		sprintf(name, "bus@%d", bus);
+		ut_assertok(fdt_begin_node(fdt, name));
+		for (dev = 0; dev < LF_TEST_DEVS; dev++) {
+			sprintf(name, "dev@%d", dev);
+			sprintf(pins, "PA%d", dev % 32);
+			ut_assertok(fdt_begin_node(fdt, name));
+			ut_assertok(fdt_property_string(fdt, "compatible",
+							"allwinner,test"));
+			ut_assertok(fdt_property_string(fdt, "allwinner,pins",
+							pins));
+			ut_assertok(fdt_property_u32(fdt, "reg", dev));
+			ut_assertok(fdt_property_string(fdt, "status", "okay"));
+			ut_assertok(fdt_end_node(fdt));
+		}
+		ut_assertok(fdt_end_node(fdt));
+	}
+	ut_assertok(fdt_end_node(fdt));
+
+	ut_assertok(fdt_end_node(fdt));
+	ut_assertok(fdt_finish(fdt));
+	/* room for the fixups */
+	ut_assertok(fdt_open_into(fdt, fdt, LF_TEST_SIZE));
+	*fdtp = fdt;
+
+	return 0;
+}
+
+static int lf_test_copy(struct unit_test_state *uts, const void *fdt,
+			void **copyp)
+{
+	*copyp = malloc(LF_TEST_SIZE);
+	ut_assertnonnull(*copyp);
+	memcpy(*copyp, fdt, LF_TEST_SIZE);
+
+	return 0;
+}
+
+static int lf_test_fixup_libfdt(struct unit_test_state *uts, void *fdt)
+{
+	const struct lf_test_prop *prop;
+	char name[32];
+	int offset, i;
+
+	for (i = 0; i < ARRAY_SIZE(lf_test_props); i++) {
+		prop = &lf_test_props[i];
+		offset = fdt_path_offset(fdt, prop->path);
+		ut_assert(offset >= 0);
+		ut_assertok(fdt_setprop(fdt, offset, prop->name, prop->val,
+					prop->len));
+	}
+
+	offset = fdt_path_offset(fdt, "/dram");
+	ut_assert(offset >= 0);
+	for (i = LF_TEST_DRAM_PARA - 1; i >= 0; i--) {
+		sprintf(name, "dram_para[%02d]", i);
+		ut_assertok(fdt_setprop_u32(fdt, offset, name, i * 0x1000));
+	}
+
+	ut_assertok(fdt_add_mem_rsv(fdt, 0x48000000, 0x1000000));
+	ut_assertok(fdt_add_mem_rsv(fdt, 0x4a000000, 0x200000));
+
+	return 0;
+}
+
+static int lf_test_fixup_live(struct unit_test_state *uts, void *fdt)
+{
+	const struct lf_test_prop *prop;
+	struct of_live_fixup lf;
+	struct device_node *np;
+	char name[32];
+	int i;
+
+	ut_assertok(of_live_fixup_open(&lf, fdt));
+	for (i = 0; i < ARRAY_SIZE(lf_test_props); i++) {
+		prop = &lf_test_props[i];
+		np = of_live_fixup_find_node(&lf, prop->path);
+		ut_assertnonnull(np);
+		ut_assertok(of_live_fixup_setprop(&lf, np, prop->name,
+						  prop->val, prop->len));
+	}
+
+	np = of_live_fixup_find_node(&lf, "/dram");
+	ut_assertnonnull(np);
+	for (i = LF_TEST_DRAM_PARA - 1; i >= 0; i--) {
+		sprintf(name, "dram_para[%02d]", i);
+		ut_assertok(of_live_fixup_setprop_u32(&lf, np, name,
+						      i * 0x1000));
+	}
+
+	ut_assertok(of_live_fixup_add_mem_rsv(&lf, 0x48000000, 0x1000000));
+	ut_assertok(of_live_fixup_add_mem_rsv(&lf, 0x4a000000, 0x200000));
+
+	return of_live_fixup_close(&lf);
+}
+
+/* @fdt and @ref are the same blob, but for the padding after values */
+static int lf_test_check_same(struct unit_test_state *uts, const void *fdt,
+			      const void *ref)
+{
+	const struct fdt_property *prop, *ref_prop;
+	int offset = 0, next, ref_next;
+	u32 tag;
+
+	ut_assertok(memcmp(fdt, ref, sizeof(struct fdt_header)));
+	ut_assertok(memcmp(fdt + fdt_off_mem_rsvmap(fdt),
+			   ref + fdt_off_mem_rsvmap(ref),
+			   fdt_off_dt_struct(ref) - fdt_off_mem_rsvmap(ref)));
+	ut_assertok(memcmp(fdt + fdt_off_dt_strings(fdt),
+			   ref + fdt_off_dt_strings(ref),
+			   fdt_size_dt_strings(ref)));
+
+	do {
+		tag = fdt_next_tag(ref, offset, &ref_next);
+		ut_asserteq(tag, fdt_next_tag(fdt, offset, &next));
+		ut_asserteq(ref_next, next);
+		if (tag == FDT_BEGIN_NODE) {
+			ut_asserteq_str(fdt_get_name(ref, offset, NULL),
+					fdt_get_name(fdt, offset, NULL));
+		} else if (tag == FDT_PROP) {
+			ref_prop = fdt_get_property_by_offset(ref, offset,
+							      NULL);
+			prop = fdt_get_property_by_offset(fdt, offset, NULL);
+			ut_asserteq(fdt32_to_cpu(ref_prop->len),
+				    fdt32_to_cpu(prop->len));
+			ut_asserteq(fdt32_to_cpu(ref_prop->nameoff),
+				    fdt32_to_cpu(prop->nameoff));
+			ut_assertok(memcmp(ref_prop->data, prop->data,
+					   fdt32_to_cpu(ref_prop->len)));
+		}
+		offset = next;
+	} while (tag != FDT_END);
+
+	return 0;
+}
+
+static int of_live_fixup_test_same(struct unit_test_state *uts)
+{
+	void *fdt, *ref;
+
+	ut_assertok(lf_test_make(uts, &ref));
+	ut_assertok(lf_test_copy(uts, ref, &fdt));
+
+	ut_assertok(lf_test_fixup_libfdt(uts, ref));
+	ut_assertok(lf_test_fixup_live(uts, fdt));
+	ut_assertok(lf_test_check_same(uts, fdt, ref));
+	ut_asserteq(3, fdt_num_mem_rsv(fdt));
+
+	free(fdt);
+	free(ref);
+
+	return 0;
+}
+OF_LIVE_FIXUP_TEST(of_live_fixup_test_same, 0);
+
+static int of_live_fixup_test_nodes(struct unit_test_state *uts)
+{
+	struct of_live_fixup lf;
+	struct device_node *np;
+	void *fdt, *ref;
+
+	ut_assertok(lf_test_make(uts, &fdt));
+	ut_assertok(lf_test_copy(uts, fdt, &ref));
+	ut_assertok(of_live_fixup_open(&lf, fdt));
+
+	ut_asserteq_str("/", of_live_fixup_find_node(&lf, "/")->full_name);
+	ut_asserteq_str("/soc/spi@5010000",
+			of_live_fixup_find_node(&lf, "spi0")->full_name);
+	ut_asserteq_str("/soc/bus@7/dev@9",
+			of_live_fixup_find_node(&lf,
+						"/soc/bus@7/dev@9")->full_name);
+	/* the first node of that name, as libfdt */
+	ut_asserteq_str("/soc/bus@0",
+			of_live_fixup_find_node(&lf, "/soc/bus")->full_name);
+	ut_asserteq_ptr(NULL, of_live_fixup_find_node(&lf, "/soc/bus@99"));
+	ut_asserteq_ptr(NULL, of_live_fixup_find_node(&lf, "nothing"));
+
+	/* a property set and set back still writes the blob */
+	np = of_live_fixup_find_node(&lf, "/soc/nand0@4011000");
+	ut_assertok(of_live_fixup_setprop_string(&lf, np, "status", "okay"));
+	ut_assertok(of_live_fixup_close(&lf));
+	ut_assertok(lf_test_check_same(uts, fdt, ref));
+
+	/* nothing set leaves the blob alone */
+	ut_assertok(of_live_fixup_open(&lf, fdt));
+	ut_assertok(of_live_fixup_close(&lf));
+	ut_assertok(memcmp(fdt, ref, LF_TEST_SIZE));
+
+	free(fdt);
+	free(ref);
+
+	return 0;
+}
+OF_LIVE_FIXUP_TEST(of_live_fixup_test_nodes, 0);
+
+static int of_live_fixup_test_nospace(struct unit_test_state *uts)
+{
+	struct of_live_fixup lf;
+	struct device_node *np;
+	void *fdt, *ref;
+
+	ut_assertok(lf_test_make(uts, &fdt));
+	ut_assertok(fdt_pack(fdt));
+	ut_assertok(lf_test_copy(uts, fdt, &ref));
+
+	ut_assertok(of_live_fixup_open(&lf, fdt));
+	np = of_live_fixup_find_node(&lf, "/soc/udc-controller");
+	ut_assertok(of_live_fixup_setprop(&lf, np, "charger_mode", NULL, 0));
+	ut_asserteq(-FDT_ERR_NOSPACE, of_live_fixup_close(&lf));
+	ut_assertok(memcmp(fdt, ref, LF_TEST_SIZE));
+
+	/* so does a reserve map entry, and abort drops the fixups */
+	ut_assertok(of_live_fixup_open(&lf, fdt));
+	ut_assertok(of_live_fixup_add_mem_rsv(&lf, 0x48000000, 0x1000000));
+	of_live_fixup_abort(&lf);
+	ut_assertok(memcmp(fdt, ref, LF_TEST_SIZE));
+	ut_asserteq(-FDT_ERR_NOSPACE,
+		    fdt_add_mem_rsv(fdt, 0x48000000, 0x1000000));
+
+	free(fdt);
+	free(ref);
+
+	return 0;
+}
+OF_LIVE_FIXUP_TEST(of_live_fixup_test_nospace, 0);
+
+static int of_live_fixup_test_speed(struct unit_test_state *uts)
+{
+	ulong start, lib_us, live_us;
+	void *fdt, *ref;
+
+	ut_assertok(lf_test_make(uts, &ref));
+	ut_assertok(lf_test_copy(uts, ref, &fdt));
+
+	start = timer_get_us();
+	ut_assertok(lf_test_fixup_libfdt(uts, ref));
+	lib_us = timer_get_us() - start;
+
+	start = timer_get_us();
+	ut_assertok(lf_test_fixup_live(uts, fdt));
+	live_us = timer_get_us() - start;
+
+	free(fdt);
+	free(ref);
+
+	printf("of_live_fixup: %d nodes, %d props, libfdt/live us: %lu/%lu\n",
+	       LF_TEST_BUSES * LF_TEST_DEVS,
+	       (int)ARRAY_SIZE(lf_test_props) + LF_TEST_DRAM_PARA, lib_us,
+	       live_us);
+
+	return 0;
+}
+OF_LIVE_FIXUP_TEST(of_live_fixup_test_speed, 0);
+
+int do_ut_of_live_fixup(cmd_tbl_t *cmdtp, int flag, int argc,
+			char *const argv[])
+{
+	struct unit_test *tests = ll_entry_start(struct unit_test,
+						 of_live_fixup_test);
+	const int n_ents = ll_entry_count(struct unit_test,
+					  of_live_fixup_test);
+
+	return cmd_ut_category("of_live_fixup", tests, n_ents, argc, argv);
+}
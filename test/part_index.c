@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Tests for the partition lookup index
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <part_index.h>
+#include <test/suites.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Declare a new partition index test */
+#define PART_INDEX_TEST(_name, _flags) \
+		UNIT_TEST(_name, _flags, part_index_test)
+
+static struct part_index idx;
+
+/*
+ * nand_mbr like map, added out of order:
+ * mbr [0, 0x8000) boot [0x8000, 0x10000) env empty at 0x10000,
+ * gap [0x10000, 0x12000), rootfs [0x12000, 0x20000)
+ */
+static int part_index_fill(void)
+{
+	part_index_reset(&idx);
+	if (part_index_add(&idx, "rootfs", 0x12000, 0xe000, 3) ||
+	    part_index_add(&idx, "mbr", 0, 0x8000, 0) ||
+	    part_index_add(&idx, "env", 0x10000, 0, 2) ||
+	    part_index_add(&idx, "boot", 0x8000, 0x8000, 1))
+		return -1;
+
+	return part_index_build(&idx);
+}
+
+static int part_index_test_addr(struct unit_test_state *uts)
+{
+	ut_assertok(part_index_fill());
+
+	ut_asserteq(0, part_index_find_addr(&idx, 0, 1));
+	ut_asserteq(0, part_index_find_addr(&idx, 0x7fff, 1));
+	/* a range ending right at the partition end */
+	ut_asserteq(0, part_index_find_addr(&idx, 0, 0x8000));
+	ut_asserteq(1, part_index_find_addr(&idx, 0x8000, 0x10));
+	ut_asserteq(1, part_index_find_addr(&idx, 0xfff0, 0x10));
+	ut_asserteq(3, part_index_find_addr(&idx, 0x1ffff, 1));
+	/* nothing to transfer still names the partition */
+	ut_asserteq(1, part_index_find_addr(&idx, 0x8000, 0));
+
+	return 0;
+}
+PART_INDEX_TEST(part_index_test_addr, 0);
+
+static int part_index_test_addr_bounds(struct unit_test_state *uts)
+{
+	ut_assertok(part_index_fill());
+
+	/* one sector over the end of a partition */
+	ut_asserteq(-ERANGE, part_index_find_addr(&idx, 0x7fff, 2));
+	ut_asserteq(-ERANGE, part_index_find_addr(&idx, 0xfff0, 0x11));
+	/* the gap behind the empty partition belongs to nobody */
+	ut_asserteq(-ENOENT, part_index_find_addr(&idx, 0x10000, 1));
+	ut_asserteq(-ENOENT, part_index_find_addr(&idx, 0x11fff, 1));
+	/* past the last partition */
+	ut_asserteq(-ENOENT, part_index_find_addr(&idx, 0x20000, 1));
+	ut_asserteq(-ENOENT, part_index_find_addr(&idx, 0xffffffff, 1));
+
+	return 0;
+}
+PART_INDEX_TEST(part_index_test_addr_bounds, 0);
+
+static int part_index_test_name(struct unit_test_state *uts)
+{
+	ut_assertok(part_index_fill());
+
+	ut_asserteq(0, part_index_find_name(&idx, "mbr"));
+	ut_asserteq(1, part_index_find_name(&idx, "boot"));
+	ut_asserteq(2, part_index_find_name(&idx, "env"));
+	ut_asserteq(3, part_index_find_name(&idx, "rootfs"));
+	ut_asserteq(-ENOENT, part_index_find_name(&idx, "boot_a"));
+	ut_asserteq(-ENOENT, part_index_find_name(&idx, "boo"));
+	ut_asserteq(-ENOENT, part_index_find_name(&idx, ""));
+	ut_asserteq(-ENOENT, part_index_find_name(&idx, NULL));
+
+	return 0;
+}
+PART_INDEX_TEST(part_index_test_name, 0);
+
+static int part_index_test_full(struct unit_test_state *uts)
+{
+	char name[PART_INDEX_NAME_LEN + 1];
+	int i;
+
+	/* every bucket chain of a full table still ends */
+	part_index_reset(&idx);
+	for (i = 0; i < PART_INDEX_MAX; i++) {
+		snprintf(name, sizeof(name), "part%d", i);
+		ut_assertok(part_index_add(&idx, name, i * 0x100, 0x100, i));
+	}
+	ut_asserteq(-ENOSPC, part_index_add(&idx, "extra", 0, 0, 0));
+	ut_assertok(part_index_build(&idx));
+
+	for (i = 0; i < PART_INDEX_MAX; i++) {
+		snprintf(name, sizeof(name), "part%d", i);
+		ut_asserteq(i, part_index_find_name(&idx, name));
+		ut_asserteq(i, part_index_find_addr(&idx, i * 0x100 + 0x80, 1));
+	}
+	ut_asserteq(-ENOENT, part_index_find_name(&idx, "part128"));
+
+	return 0;
+}
+PART_INDEX_TEST(part_index_test_full, 0);
+
+static int part_index_test_invalid(struct unit_test_state *uts)
+{
+	char name[] = "a_name_longer_than_16";
+
+	/* overlapping partitions leave the index invalid */
+	part_index_reset(&idx);
+	ut_assertok(part_index_add(&idx, "a", 0, 0x100, 0));
+	ut_assertok(part_index_add(&idx, "b", 0xff, 0x100, 1));
+	ut_asserteq(-EINVAL, part_index_build(&idx));
+	ut_asserteq(0, idx.valid);
+
+	/* names are kept to PART_INDEX_NAME_LEN characters */
+	part_index_reset(&idx);
+	ut_assertok(part_index_add(&idx, name, 0, 0x100, 0));
+	ut_assertok(part_index_build(&idx));
+	ut_asserteq(1, idx.valid);
+	ut_asserteq(0, part_index_find_name(&idx, "a_name_longer_th"));
+
+	return 0;
+}
+PART_INDEX_TEST(part_index_test_invalid, 0);
+
+int do_ut_part_index(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct unit_test *tests = ll_entry_start(struct unit_test,
+						 part_index_test);
+	const int n_ents = ll_entry_count(struct unit_test, part_index_test);
+
+	return cmd_ut_category("part_index", tests, n_ents, argc, argv);
+}
@@ -0,0 +1,275 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Known answer tests for SHA1/SHA256, run on the portable code and on the
+ * instruction backend where the CPU has one
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <test/suites.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+#include <u-boot/sha_arch.h>
+#ifdef CONFIG_SUNXI_CE_SHA256_MULTISTEP
+#include <memalign.h>
+#include <asm/arch/ce.h>
+#endif
+
+/* Declare a new sha test */
+#define SHA_TEST(_name, _flags)	UNIT_TEST(_name, _flags, sha_test)
+
+#define SHA_TEST_BUF		4100
+
+struct sha_test_vector {
+	const char *msg;	/* NULL for SHA_TEST_A 'a's */
+	int repeat;		/* times the message is hashed */
+	const char *sha1;
+	const char *sha256;
+};
+
+#define SHA_TEST_A		1000
+
+/* FIPS 180-2 examples */
+static const struct sha_test_vector sha_test_vectors[] = {
+	{ "abc", 1,
+	  "a9993e364706816aba3e25717850c26c9cd0d89d",
+	  "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+	{ "", 1,
+	  "da39a3ee5e6b4b0d3255bfef95601890afd80709",
+	  "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+	{ "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+	  "84983e441c3bd26ebaae4aa1f95129e5e54670f1",
+	  "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+	/* one million 'a' */
+	{ NULL, 1000,
+	  "34aa973cd4c4daa4f61eeb2bdbad27316534016f",
+	  "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" },
+};
+
+/* update lengths cycled through to cross every block boundary case */
+static const int sha_test_steps[] = { 1, 63, 64, 65, 3, 200, 128, 1000, 0 };
+
+union sha_test_ctx {
+	sha1_context sha1;
+	sha256_context sha256;
+};
+
+static void sha_test_starts(enum sha_arch_alg alg, union sha_test_ctx *ctx)
+{
+	if (alg == SHA_ARCH_SHA1)
+		sha1_starts(&ctx->sha1);
+	else
+		sha256_starts(&ctx->sha256);
+}
+
+static void sha_test_update(enum sha_arch_alg alg, union sha_test_ctx *ctx,
+			    const u8 *p, uint len)
+{
+	if (alg == SHA_ARCH_SHA1)
+		sha1_update(&ctx->sha1, p, len);
+	else
+		sha256_update(&ctx->sha256, p, len);
+}
+
+/* hex digest in @hex */
+static void sha_test_finish(enum sha_arch_alg alg, union sha_test_ctx *ctx,
+			    char *hex)
+{
+	u8 digest[SHA256_SUM_LEN];
+	int i, n;
+
+	if (alg == SHA_ARCH_SHA1) {
+		sha1_finish(&ctx->sha1, digest);
+		n = SHA1_SUM_LEN;
+	} else {
+		sha256_finish(&ctx->sha256, digest);
+		n = SHA256_SUM_LEN;
+	}
+	for (i = 0; i < n; i++)
+		sprintf(hex + 2 * i, "%02x", digest[i]);
+}
+
+/* hash @len bytes @repeat times */
+static void sha_test_hash(enum sha_arch_alg alg, const u8 *p, uint len,
+			  int repeat, char *hex)
+{
+	union sha_test_ctx ctx;
+	int i;
+
+	sha_test_starts(alg, &ctx);
+	for (i = 0; i < repeat; i++)
+		sha_test_update(alg, &ctx, p, len);
+	sha_test_finish(alg, &ctx, hex);
+}
+
+/* switch to the portable code (@arch false) or the backend, if there is one */
+static bool sha_test_backend(enum sha_arch_alg alg, bool arch)
+{
+	sha_arch_set_enabled(arch);
+
+	return !arch || sha_arch_usable(alg);
+}
+
+static int sha_test_kat(struct unit_test_state *uts, enum sha_arch_alg alg)
+{
+	const struct sha_test_vector *v;
+	char hex[2 * SHA256_SUM_LEN + 1];
+	char a[SHA_TEST_A];
+	const char *msg;
+	int arch;
+	uint len;
+
+	memset(a, 'a', sizeof(a));
+	for (arch = 0; arch < 2; arch++) {
+		if (!sha_test_backend(alg, arch))
+			continue;
+		for (v = sha_test_vectors; v < sha_test_vectors +
+		     ARRAY_SIZE(sha_test_vectors); v++) {
+			msg = v->msg ? v->msg : a;
+			len = v->msg ? strlen(v->msg) : sizeof(a);
+			sha_test_hash(alg, (const u8 *)msg, len, v->repeat,
+				      hex);
+			if (strcmp(alg == SHA_ARCH_SHA1 ? v->sha1 : v->sha256,
+				   hex))
+				ut_failf(uts, __FILE__, __LINE__, __func__,
+					 "digest", "%s, %d bytes: %s",
+					 arch ? sha_arch_name() : "portable",
+					 v->repeat * len, hex);
+		}
+	}
+	sha_arch_set_enabled(true);
+
+	return 0;
+}
+
+static int sha_test_sha1(struct unit_test_state *uts)
+{
+	return sha_test_kat(uts, SHA_ARCH_SHA1);
+}
+SHA_TEST(sha_test_sha1, 0);
+
+static int sha_test_sha256(struct unit_test_state *uts)
+{
+	return sha_test_kat(uts, SHA_ARCH_SHA256);
+}
+SHA_TEST(sha_test_sha256, 0);
+
+/* odd alignment and odd update lengths against one update */
+static int sha_test_split(struct unit_test_state *uts)
+{
+	char expect[2 * SHA256_SUM_LEN + 1], hex[2 * SHA256_SUM_LEN + 1];
+	union sha_test_ctx ctx;
+	int alg, arch, i, step;
+	uint len, off;
+	u8 *buf;
+
+	buf = malloc(SHA_TEST_BUF);
+	ut_assertnonnull(buf);
+	for (i = 0; i < SHA_TEST_BUF; i++)
+		buf[i] = i * 7 + (i >> 8);
+
+	for (alg = SHA_ARCH_SHA1; alg <= SHA_ARCH_SHA256; alg++) {
+		sha_arch_set_enabled(false);
+		sha_test_hash(alg, buf + 1, SHA_TEST_BUF - 1, 1, expect);
+
+		for (arch = 0; arch < 2; arch++) {
+			if (!sha_test_backend(alg, arch))
+				continue;
+			sha_test_starts(alg, &ctx);
+			for (off = 1, step = 0; off < SHA_TEST_BUF;
+			     off += len, step++) {
+				len = sha_test_steps[step %
+						     ARRAY_SIZE(sha_test_steps)];
+				len = min_t(uint, len, SHA_TEST_BUF - off);
+				sha_test_update(alg, &ctx, buf + off, len);
+			}
+			sha_test_finish(alg, &ctx, hex);
+			if (strcmp(expect, hex))
+				ut_failf(uts, __FILE__, __LINE__, __func__,
+					 "digest", "%s %s: %s",
+					 alg == SHA_ARCH_SHA1 ? "sha1" :
+								"sha256",
+					 arch ? sha_arch_name() : "portable",
+					 hex);
+		}
+	}
+	sha_arch_set_enabled(true);
+	free(buf);
+
+	return 0;
+}
+SHA_TEST(sha_test_split, 0);
+
+#ifdef CONFIG_SUNXI_CE_SHA256_MULTISTEP
+#define SHA_TEST_CE_STEP	4096
+#define SHA_TEST_CE_BUF		(4 * SHA_TEST_CE_STEP)
+
+/* CE 2.0 sha256 in steps, fed as the sprite verify does, against software */
+static int sha_test_ce_multistep(struct unit_test_state *uts)
+{
+	static const uint sizes[] = {
+		3 * SHA_TEST_CE_STEP + 100, 3 * SHA_TEST_CE_STEP,
+		SHA_TEST_CE_STEP + 1, 100,
+	};
+	ALLOC_CACHE_ALIGN_BUFFER(u8, digest, CONFIG_SYS_CACHELINE_SIZE);
+	char expect[2 * SHA256_SUM_LEN + 1], hex[2 * SHA256_SUM_LEN + 1];
+	uint n, off, len, total;
+	int i, ret;
+	u8 *buf;
+
+	buf = memalign(CONFIG_SYS_CACHELINE_SIZE, SHA_TEST_CE_BUF);
+	ut_assertnonnull(buf);
+	for (i = 0; i < SHA_TEST_CE_BUF; i++)
+		buf[i] = i * 7 + (i >> 8);
+
+	sunxi_ss_open();
+	for (n = 0; n < ARRAY_SIZE(sizes); n++) {
+		total = sizes[n];
+		sha_arch_set_enabled(false);
+		sha_test_hash(SHA_ARCH_SHA256, buf, total, 1, expect);
+		sha_arch_set_enabled(true);
+
+		/* every step but the last is a multiple of the block */
+		for (off = 0; off < total; off += len) {
+			len = min_t(uint, SHA_TEST_CE_STEP, total - off);
+			if (off + len < total)
+				ret = off ? sunxi_hash_update(digest, buf + off,
+							      len, total) :
+					    sunxi_hash_init(digest, buf, len,
+							    total);
+			else
+				ret = off ? sunxi_hash_final(digest, buf + off,
+							     len, total) :
+					    sunxi_sha_calc(digest, 32, buf,
+							   len);
+			ut_assertok(ret);
+		}
+		for (i = 0; i < SHA256_SUM_LEN; i++)
+			sprintf(hex + 2 * i, "%02x", digest[i]);
+		if (strcmp(expect, hex))
+			ut_failf(uts, __FILE__, __LINE__, __func__, "digest",
+				 "ce, %u bytes: %s", total, hex);
+	}
+	free(buf);
+
+	return 0;
+}
+SHA_TEST(sha_test_ce_multistep, 0);
+#endif
+
+int do_ut_sha(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
+{
+	struct unit_test *tests = ll_entry_start(struct unit_test, sha_test);
+	const int n_ents = ll_entry_count(struct unit_test, sha_test);
+
+	printf("sha backend: %s\n", sha_arch_usable(SHA_ARCH_SHA256) ||
+	       sha_arch_usable(SHA_ARCH_SHA1) ? sha_arch_name() : "portable");
+
+	return cmd_ut_category("sha", tests, n_ents, argc, argv);
+}
@@ -0,0 +1,230 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Volume writes and reads in batches, through ubi command lines as
+ * sunxi-ubi used to do and through a volume descriptor kept open as it
+ * does now, on a NAND-like MTD device in RAM
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <malloc.h>
+#include <memalign.h>
+#include <ubi_uboot.h>
+#include <linux/mtd/mtd.h>
+#include <test/suites.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Declare a new ubi_kapi test */
+#define UBI_KAPI_TEST(_name, _flags) \
+		UNIT_TEST(_name, _flags, ubi_kapi_test)
+
+#define SIM_PAGE_SIZE		2048
+#define SIM_BLOCK_SHIFT		16		/* 32 pages */
+#define SIM_BLOCKS		64
+#define SIM_VOL			"ubi_kapi_vol"
+#define SIM_VOL_SIZE		(1536 * 1024)
+/* written and read back in batches, as sunxi_flash hands sectors over */
+#define SIM_DATA		(1024 * 1024)
+#define SIM_BATCH		(16 * 1024)
+
+static u8 sim_data[SIM_BLOCKS << SIM_BLOCK_SHIFT];
+static struct mtd_info sim_mtd;
+
+static int sim_erase(struct mtd_info *mtd, struct erase_info *instr)
+{
+	memset(sim_data + instr->addr, 0xff, instr->len);
+	instr->state = MTD_ERASE_DONE;
+
+	return 0;
+}
+
+static int sim_read(struct mtd_info *mtd, loff_t from, size_t len,
+		    size_t *retlen, u_char *buf)
+{
+	memcpy(buf, sim_data + from, len);
+	*retlen = len;
+
+	return 0;
+}
+
+/* programming only clears bits, as on NAND */
+static int sim_write(struct mtd_info *mtd, loff_t to, size_t len,
+		     size_t *retlen, const u_char *buf)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		sim_data[to + i] &= buf[i];
+	*retlen = len;
+
+	return 0;
+}
+
+static int sim_block_isbad(struct mtd_info *mtd, loff_t ofs)
+{
+	return 0;
+}
+
+/* a fresh device attached as ubi0, with one empty volume */
+static int sim_attach(struct unit_test_state *uts)
+{
+	char cmd[64];
+
+	memset(sim_data, 0xff, sizeof(sim_data));
+	memset(&sim_mtd, 0, sizeof(sim_mtd));
+	sim_mtd.name = "ubi_kapi_sim";
+	sim_mtd.type = MTD_NANDFLASH;
+	sim_mtd.flags = MTD_CAP_NANDFLASH;
+	sim_mtd.size = sizeof(sim_data);
+	sim_mtd.erasesize = 1 << SIM_BLOCK_SHIFT;
+	sim_mtd.writesize = SIM_PAGE_SIZE;
+	sim_mtd._erase = sim_erase;
+	sim_mtd._read = sim_read;
+	sim_mtd._write = sim_write;
+	sim_mtd._block_isbad = sim_block_isbad;
+	ut_assertok(add_mtd_device(&sim_mtd));
+
+	ut_assertok(ubi_part((char *)sim_mtd.name, NULL));
+	sprintf(cmd, "ubi create %s %x", SIM_VOL, SIM_VOL_SIZE);
+	ut_assertok(run_command(cmd, 0));
+
+	return 0;
+}
+
+static void sim_detach(void)
+{
+	run_command("ubi detach", 0);
+	del_mtd_device(&sim_mtd);
+}
+
+/* ubi write.part address volume size [fullsize] */
+static int sim_cmd_write(void *buf, size_t bytes, size_t full_bytes)
+{
+	char cmd[6][20];
+	char *argv[6];
+	int i;
+
+	memset(cmd, 0x00, sizeof(cmd));
+	for (i = 0; i < 6; i++)
+		argv[i] = cmd[i];
+
+	sprintf(cmd[0], "ubi");
+	sprintf(cmd[1], "write.part");
+	sprintf(cmd[2], "0x%lx", (ulong)buf);
+	sprintf(cmd[3], "%s", SIM_VOL);
+	sprintf(cmd[4], "0x%lx", (ulong)bytes);
+	sprintf(cmd[5], "0x%lx", (ulong)full_bytes);
+
+	return sunxi_do_ubi(0, full_bytes ? 6 : 5, argv);
+}
+
+static int sim_kapi_write(struct ubi_volume_desc *desc, void *buf,
+			  size_t bytes, size_t full_bytes)
+{
+	struct ubi_volume *vol = desc->vol;
+	int err;
+
+	if (full_bytes) {
+		err = ubi_start_update(vol->ubi, vol, full_bytes);
+		if (err < 0)
+			return err;
+	}
+	err = ubi_more_update_data(vol->ubi, vol, buf, bytes);
+
+	return err < 0 ? err : 0;
+}
+
+static int sim_kapi_read(struct ubi_volume_desc *desc, loff_t offp,
+			 void *buf, size_t size)
+{
+	struct ubi_volume *vol = desc->vol;
+	int lnum, len, err;
+	u32 off;
+
+	lnum = div_u64_rem(offp, vol->usable_leb_size, &off);
+	while (size) {
+		len = min_t(size_t, size, vol->usable_leb_size - off);
+		err = ubi_leb_read(desc, lnum, buf, off, len, 0);
+		if (err)
+			return err;
+		lnum++;
+		off = 0;
+		buf += len;
+		size -= len;
+	}
+
+	return 0;
+}
+
+static int ubi_kapi_test_speed(struct unit_test_state *uts)
+{
+	struct ubi_volume_desc *desc;
+	ulong start, cmd_us[2], kapi_us[2];
+	u8 *src, *dst;
+	int i;
+
+	src = malloc_cache_aligned(SIM_DATA);
+	dst = malloc_cache_aligned(SIM_DATA);
+	ut_assertnonnull(src);
+	ut_assertnonnull(dst);
+	for (i = 0; i < SIM_DATA; i++)
+		src[i] = i * 2654435761u >> 24;
+	ut_assertok(sim_attach(uts));
+
+	start = timer_get_us();
+	for (i = 0; i < SIM_DATA; i += SIM_BATCH)
+		ut_assertok(sim_cmd_write(src + i, SIM_BATCH,
+					  i ? 0 : SIM_DATA));
+	cmd_us[0] = timer_get_us() - start;
+
+	memset(dst, 0, SIM_DATA);
+	start = timer_get_us();
+	for (i = 0; i < SIM_DATA; i += SIM_BATCH)
+		ut_assertok(sunxi_ubi_volume_read(SIM_VOL, i,
+						  (char *)dst + i, SIM_BATCH));
+	cmd_us[1] = timer_get_us() - start;
+	ut_assertok(memcmp(src, dst, SIM_DATA));
+
+	/* the same data again, now through the descriptor */
+	desc = ubi_open_volume_nm(0, SIM_VOL, UBI_READWRITE);
+	ut_assert(!IS_ERR(desc));
+	start = timer_get_us();
+	for (i = 0; i < SIM_DATA; i += SIM_BATCH)
+		ut_assertok(sim_kapi_write(desc, src + i, SIM_BATCH,
+					   i ? 0 : SIM_DATA));
+	kapi_us[0] = timer_get_us() - start;
+
+	memset(dst, 0, SIM_DATA);
+	start = timer_get_us();
+	for (i = 0; i < SIM_DATA; i += SIM_BATCH)
+		ut_assertok(sim_kapi_read(desc, i, dst + i, SIM_BATCH));
+	kapi_us[1] = timer_get_us() - start;
+	ut_assertok(memcmp(src, dst, SIM_DATA));
+
+	ubi_close_volume(desc);
+	sim_detach();
+	free(dst);
+	free(src);
+
+	printf("ubi kapi: %d KiB in %d KiB batches, command/kapi us:\n",
+	       SIM_DATA / 1024, SIM_BATCH / 1024);
+	printf("  write %lu/%lu, read %lu/%lu\n", cmd_us[0], kapi_us[0],
+	       cmd_us[1], kapi_us[1]);
+
+	return 0;
+}
+UBI_KAPI_TEST(ubi_kapi_test_speed, 0);
+
+int do_ut_ubi_kapi(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
+{
+	struct unit_test *tests = ll_entry_start(struct unit_test,
+						 ubi_kapi_test);
+	const int n_ents = ll_entry_count(struct unit_test, ubi_kapi_test);
+
+	return cmd_ut_category("ubi_kapi", tests, n_ents, argc, argv);
+}
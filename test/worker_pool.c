@@ -0,0 +1,241 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2018-2020
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Tests for the worker pool
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <worker_pool.h>
+#include <asm/unaligned.h>
+#include <test/suites.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Declare a new worker pool test */
+#define WORKER_POOL_TEST(_name, _flags) \
+		UNIT_TEST(_name, _flags, worker_pool_test)
+
+#define WP_TEST_JOBS		64
+#define WP_TEST_ROUNDS		200
+#define WP_TEST_CHUNK		(256 * 1024)
+/* slack of the pool over the boot core alone: a quarter, plus a tick */
+#define WP_TEST_SLACK(ms)	((ms) / 4 + 1)
+
+static void wp_test_count(void *priv, int job)
+{
+	int *hits = priv;
+
+	hits[job]++;
+}
+
+static int worker_pool_test_batch(struct unit_test_state *uts)
+{
+	int hits[WP_TEST_JOBS];
+	int round, i;
+
+	ut_assert(worker_pool_start() >= 1);
+	ut_asserteq(worker_pool_start(), worker_pool_size());
+
+	/* back to back batches, a late worker must not run into the next */
+	for (round = 0; round < WP_TEST_ROUNDS; round++) {
+		memset(hits, 0, sizeof(hits));
+		worker_pool_run(wp_test_count, hits, round % WP_TEST_JOBS + 1);
+		for (i = 0; i < WP_TEST_JOBS; i++)
+			ut_asserteq(i <= round % WP_TEST_JOBS, hits[i]);
+	}
+
+	/* an empty batch returns right away */
+	worker_pool_run(wp_test_count, hits, 0);
+
+	return 0;
+}
+WORKER_POOL_TEST(worker_pool_test_batch, 0);
+
+struct wp_test_hash {
+	u8 *buf;
+	u32 hash[WP_TEST_JOBS];
+};
+
+/* FNV-1a of one chunk, some cpu work without shared state */
+static void wp_test_hash_job(void *priv, int job)
+{
+	struct wp_test_hash *th = priv;
+	u8 *p = th->buf + job * WP_TEST_CHUNK;
+	u32 hash = 2166136261u;
+	int i;
+
+	for (i = 0; i < WP_TEST_CHUNK; i++) {
+		hash ^= p[i];
+		hash *= 16777619u;
+	}
+	th->hash[job] = hash;
+}
+
+static int worker_pool_test_speed(struct unit_test_state *uts)
+{
+	struct wp_test_hash th;
+	u32 alone[WP_TEST_JOBS];
+	ulong start, alone_ms, pool_ms;
+	int i;
+
+	th.buf = malloc(WP_TEST_JOBS * WP_TEST_CHUNK);
+	ut_assertnonnull(th.buf);
+	for (i = 0; i < WP_TEST_JOBS * WP_TEST_CHUNK; i++)
+		th.buf[i] = i * 7 + (i >> 13);
+
+	start = get_timer(0);
+	for (i = 0; i < WP_TEST_JOBS; i++)
+		wp_test_hash_job(&th, i);
+	alone_ms = get_timer(start);
+	memcpy(alone, th.hash, sizeof(alone));
+
+	memset(th.hash, 0, sizeof(th.hash));
+	start = get_timer(0);
+	worker_pool_run(wp_test_hash_job, &th, WP_TEST_JOBS);
+	pool_ms = get_timer(start);
+	free(th.buf);
+
+	for (i = 0; i < WP_TEST_JOBS; i++)
+		ut_asserteq(alone[i], th.hash[i]);
+	printf("worker pool: %d cores, %lu ms on the boot core, %lu ms on the pool\n",
+	       worker_pool_size(), alone_ms, pool_ms);
+	/* the pool is never slower than the boot core alone, give or take */
+	ut_assert(pool_ms <= alone_ms + WP_TEST_SLACK(alone_ms));
+
+	return 0;
+}
+WORKER_POOL_TEST(worker_pool_test_speed, 0);
+
+#ifdef CONFIG_LZ4
+/* append an LZ4 block holding @len literals only */
+static u8 *wp_test_lz4_literals(u8 *out, const u8 *in, int len)
+{
+	u8 *blk = out;
+	int rest;
+
+	out += 4;
+	*out++ = 0xf0;
+	for (rest = len - 15; rest >= 255; rest -= 255)
+		*out++ = 255;
+	*out++ = rest;
+	memcpy(out, in, len);
+	out += len;
+	put_unaligned_le32(out - blk - 4, blk);
+
+	return out;
+}
+
+/*
+ * build a frame of @len bytes of @src in independent blocks of @bsize, no
+ * checksums: one compressed, one stored and a short last block
+ */
+static u8 *wp_test_lz4_frame(u8 *p, const u8 *src, int len, int bsize)
+{
+	put_unaligned_le32(0x184d2204, p);
+	p += 4;
+	*p++ = 0x60;
+	*p++ = 0x40;
+	*p++ = 0;
+	p = wp_test_lz4_literals(p, src, bsize);
+	put_unaligned_le32(0x80000000 | bsize, p);
+	memcpy(p + 4, src + bsize, bsize);
+	p += 4 + bsize;
+	p = wp_test_lz4_literals(p, src + 2 * bsize, len - 2 * bsize);
+	put_unaligned_le32(0, p);
+
+	return p + 4;
+}
+
+/*
+ * the first batch brings the pool up itself, and ulz4fn() sizes its batch
+ * on worker_pool_size() before any worker_pool_run(). The pool is stopped
+ * first, so this holds whatever test ran before.
+ */
+static int worker_pool_test_autostart(struct unit_test_state *uts)
+{
+	const int bsize = 64 * 1024, len = 2 * bsize + 1000;
+	u8 *src, *frame, *dst, *p;
+	int hits[WP_TEST_JOBS];
+	size_t dst_len;
+	int size, i;
+
+	/* every job of a batch that has to start the pool runs once */
+	worker_pool_stop();
+	memset(hits, 0, sizeof(hits));
+	worker_pool_run(wp_test_count, hits, WP_TEST_JOBS);
+	for (i = 0; i < WP_TEST_JOBS; i++)
+		ut_asserteq(1, hits[i]);
+	size = worker_pool_size();
+	ut_assert(size >= 1);
+	ut_asserteq(size, worker_pool_start());
+
+	worker_pool_stop();
+	src = malloc(len);
+	frame = malloc(len + 1024);
+	dst = malloc(len);
+	ut_assert(src && frame && dst);
+	for (i = 0; i < len; i++)
+		src[i] = i * 3 + (i >> 9);
+	p = wp_test_lz4_frame(frame, src, len, bsize);
+
+	dst_len = len;
+	ut_assertok(ulz4fn(frame, p - frame, dst, &dst_len));
+	ut_asserteq(len, dst_len);
+	ut_assertok(memcmp(src, dst, len));
+	/* the pool ulz4fn() started is the same size again */
+	ut_asserteq(size, worker_pool_size());
+
+	free(dst);
+	free(frame);
+	free(src);
+
+	return 0;
+}
+WORKER_POOL_TEST(worker_pool_test_autostart, 0);
+
+static int worker_pool_test_lz4(struct unit_test_state *uts)
+{
+	const int bsize = 64 * 1024, len = 2 * bsize + 1000;
+	u8 *src, *frame, *dst, *p;
+	size_t dst_len;
+	int i;
+
+	src = malloc(len);
+	frame = malloc(len + 1024);
+	dst = malloc(len);
+	ut_assert(src && frame && dst);
+	for (i = 0; i < len; i++)
+		src[i] = i ^ (i >> 8);
+	p = wp_test_lz4_frame(frame, src, len, bsize);
+
+	dst_len = len;
+	ut_assertok(ulz4fn(frame, p - frame, dst, &dst_len));
+	ut_asserteq(len, dst_len);
+	ut_assertok(memcmp(src, dst, len));
+
+	/* too small an output fails as on the boot core alone */
+	dst_len = len - 1;
+	ut_assert(ulz4fn(frame, p - frame, dst, &dst_len) < 0);
+
+	free(dst);
+	free(frame);
+	free(src);
+
+	return 0;
+}
+WORKER_POOL_TEST(worker_pool_test_lz4, 0);
+#endif
+
+int do_ut_worker_pool(cmd_tbl_t *cmdtp, int flag, int argc,
+		      char *const argv[])
+{
+	struct unit_test *tests = ll_entry_start(struct unit_test,
+						 worker_pool_test);
+	const int n_ents = ll_entry_count(struct unit_test, worker_pool_test);
+
+	return cmd_ut_category("worker_pool", tests, n_ents, argc, argv);
+}
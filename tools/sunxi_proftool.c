@@ -3,7 +3,7 @@
  * Copyright (c) 2013 Google, Inc
  */
 
-/* Decode and dump U-Boot profiling information */
+/* Decode and dump U-Boot profiling and bootstage information */
 
 #include <assert.h>
 #include <ctype.h>
@@ -21,6 +21,7 @@
 
 #include <compiler.h>
 #include <trace.h>
+#include "fdt_host.h"
 
 #define MAX_LINE_LEN 500
 
@@ -60,6 +61,28 @@ int call_count;
 int verbose; /* Verbosity level 0=none, 1=warn, 2=notice, 3=info, 4=debug */
 unsigned long text_offset; /* text address of first function */
 
+/* As written by bootstage_stash() */
+enum {
+	BOOTSTAGE_HDR_SIZE	= 16,
+	BOOTSTAGE_MAGIC		= 0xb00757a3,
+	BOOTSTAGE_BAR_WIDTH	= 40,
+};
+
+/* A bootstage record, from a stash or from the /bootstage FDT node */
+struct stage_info {
+	const char *name;
+	uint32_t time_us;	/* mark time, or the accumulated time */
+	uint32_t start_us;	/* accum records: when it last started */
+	int accum;
+};
+
+struct stage_list {
+	struct stage_info *stage;
+	int count;
+};
+
+struct stage_list stages, base_stages;
+
 static void outf(int level, const char *fmt, ...)
 	__attribute__((format(__printf__, 2, 3)));
 #define error(fmt, b...) outf(0, fmt, ##b)
@@ -82,12 +105,17 @@ static void outf(int level, const char *fmt, ...)
 static void usage(void)
 {
 	fprintf(stderr,
-		"Usage: proftool -cds -v3 <cmd> <profdata>\n"
+		"Usage: sunxi_proftool -cds -v3 <cmd> <profdata>\n"
 		"\n"
 		"Commands\n"
 		"   dump-ftrace\t\tDump out textual data in ftrace format\n"
+		"   dump-bootstage\tShow the boot timeline from -b\n"
+		"   dump-flame\t\tFolded stacks from -b for flamegraph.pl\n"
+		"   diff-bootstage\tCompare the stages in -b against -c\n"
 		"\n"
 		"Options:\n"
+		"   -b <file>\tBootstage stash or device tree with /bootstage\n"
+		"   -c <file>\tBaseline bootstage data for diff-bootstage\n"
 		"   -m <map>\tSpecify Systen.map file\n"
 		"   -t <trace>\tSpecific trace data file (from U-Boot)\n"
 		"   -v <0-4>\tSpecify verbosity\n");
@@ -585,25 +613,342 @@ static int make_ftrace(void)
 	return 0;
 }
 
-static int prof_tool(int argc, char *const argv[], const char *prof_fname,
-		     const char *map_fname, const char *trace_config_fname)
+static uint32_t get_le32(const unsigned char *p)
 {
-	int err = 0;
+	return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void add_stage(struct stage_list *list, const char *name,
+		      uint32_t time_us, uint32_t start_us, int accum)
+{
+	struct stage_info *stage;
+
+	list->stage = realloc(list->stage,
+			      sizeof(*stage) * (list->count + 1));
+	assert(list->stage);
+	stage = &list->stage[list->count++];
+	stage->name	= strdup(name);
+	stage->time_us	= time_us;
+	stage->start_us = start_us;
+	stage->accum	= accum;
+}
+
+/*
+ * The stash holds the records as the board's struct bootstage_record, so
+ * 20 bytes on 32-bit U-Boot and 32 bytes on 64-bit, then one name for
+ * each record. Pick the layout for which the names fill the rest.
+ */
+static int read_bootstage_stash(struct stage_list *list,
+				const unsigned char *buf, size_t size)
+{
+	static const struct {
+		int size, start, id;
+	} layouts[] = { { 20, 4, 16 }, { 32, 8, 28 } };
+	uint32_t count = get_le32(buf + 4);
+	uint32_t total = get_le32(buf + 8);
+	const unsigned char *rec;
+	const char *name;
+	size_t n, pos, nuls;
+	int l;
 
-	if (read_map_file(map_fname))
+	if (total > size || total < BOOTSTAGE_HDR_SIZE) {
+		error("Bootstage stash size %u is invalid\n", total);
 		return -1;
-	if (prof_fname && read_profile_file(prof_fname))
+	}
+
+	for (l = 0; l < (int)(sizeof(layouts) / sizeof(layouts[0])); l++) {
+		for (n = count; BOOTSTAGE_HDR_SIZE + n * layouts[l].size < total;
+		     n++) {
+			pos = BOOTSTAGE_HDR_SIZE + n * layouts[l].size;
+			for (nuls = 0; pos < total; pos++)
+				nuls += !buf[pos];
+			if (nuls == n && !buf[total - 1])
+				goto found;
+		}
+	}
+	error("Cannot work out the bootstage record layout\n");
+	return -1;
+
+found:
+	notice("%zu bootstage records of %d bytes\n", n, layouts[l].size);
+	name = (const char *)buf + BOOTSTAGE_HDR_SIZE + n * layouts[l].size;
+	for (pos = 0; pos < n; pos++, name += strlen(name) + 1) {
+		uint32_t start_us;
+
+		rec = buf + BOOTSTAGE_HDR_SIZE + pos * layouts[l].size;
+		if (!get_le32(rec + layouts[l].id))
+			continue;
+		start_us = get_le32(rec + layouts[l].start);
+		add_stage(list, name, get_le32(rec), start_us, start_us != 0);
+	}
+
+	return 0;
+}
+
+static int read_bootstage_fdt(struct stage_list *list, const void *blob)
+{
+	const fdt32_t *mark, *accum, *start;
+	const char *name;
+	int bootstage, node;
+
+	bootstage = fdt_subnode_offset(blob, 0, "bootstage");
+	if (bootstage < 0) {
+		error("No /bootstage node in the device tree\n");
 		return -1;
-	if (trace_config_fname && read_trace_config_file(trace_config_fname))
+	}
+
+	fdt_for_each_subnode(node, blob, bootstage) {
+		name  = fdt_getprop(blob, node, "name", NULL);
+		mark  = fdt_getprop(blob, node, "mark", NULL);
+		accum = fdt_getprop(blob, node, "accum", NULL);
+		start = fdt_getprop(blob, node, "start", NULL);
+		if (!name || (!mark && !accum))
+			continue;
+		if (accum)
+			add_stage(list, name, fdt32_to_cpu(*accum),
+				  start ? fdt32_to_cpu(*start) : 0, 1);
+		else
+			add_stage(list, name, fdt32_to_cpu(*mark), 0, 0);
+	}
+
+	return 0;
+}
+
+static int read_bootstage_file(struct stage_list *list, const char *fname)
+{
+	unsigned char *buf = NULL;
+	size_t size = 0, alloced = 0;
+	FILE *fin;
+	int err;
+
+	fin = fopen(fname, "rb");
+	if (!fin) {
+		error("Cannot open bootstage file '%s'\n", fname);
+		return -1;
+	}
+	do {
+		alloced += 0x10000;
+		buf = realloc(buf, alloced);
+		assert(buf);
+		size += fread(buf + size, 1, alloced - size, fin);
+	} while (size == alloced);
+	fclose(fin);
+
+	if (size >= BOOTSTAGE_HDR_SIZE &&
+	    get_le32(buf + 12) == BOOTSTAGE_MAGIC)
+		err = read_bootstage_stash(list, buf, size);
+	else if (!fdt_check_header(buf) && fdt_totalsize(buf) <= size)
+		err = read_bootstage_fdt(list, buf);
+	else
+		err = -1;
+	if (err)
+		error("Cannot read bootstage data from '%s'\n", fname);
+	free(buf);
+
+	return err;
+}
+
+static int h_cmp_stage(const void *v1, const void *v2)
+{
+	const struct stage_info *s1 = v1, *s2 = v2;
+	uint32_t t1 = s1->accum ? s1->start_us : s1->time_us;
+	uint32_t t2 = s2->accum ? s2->start_us : s2->time_us;
+
+	if (t1 != t2)
+		return t1 < t2 ? -1 : 1;
+
+	/* an enclosing span first */
+	return s1->time_us > s2->time_us ? -1 : s1->time_us < s2->time_us;
+}
+
+static uint32_t stage_end(const struct stage_info *stage)
+{
+	return stage->accum ? stage->start_us + stage->time_us : stage->time_us;
+}
+
+/* Marks and spans in time order, spans get a bar on the boot timeline */
+static int dump_bootstage(struct stage_list *list)
+{
+	struct stage_info *stage, *end = list->stage + list->count;
+	uint32_t total = 0, prev = 0;
+	int from, to, i;
+
+	qsort(list->stage, list->count, sizeof(*stage), h_cmp_stage);
+	for (stage = list->stage; stage < end; stage++)
+		total = MAX(total, stage_end(stage));
+	if (!total)
+		total = 1;
+
+	printf("%11s%11s  %-*s  %s\n", "Start", "Elapsed", BOOTSTAGE_BAR_WIDTH,
+	       "Timeline", "Stage");
+	for (stage = list->stage; stage < end; stage++) {
+		if (stage->accum && !stage->start_us)
+			continue;
+
+		from = (uint64_t)(stage->accum ? stage->start_us :
+				  stage->time_us) * BOOTSTAGE_BAR_WIDTH / total;
+		to = (uint64_t)stage_end(stage) * BOOTSTAGE_BAR_WIDTH / total;
+		from = MIN(from, BOOTSTAGE_BAR_WIDTH - 1);
+		if (stage->accum) {
+			printf("%11u%11u  ", stage->start_us, stage->time_us);
+		} else {
+			printf("%11u%11u  ", stage->time_us,
+			       stage->time_us - prev);
+			prev = stage->time_us;
+		}
+		for (i = 0; i < BOOTSTAGE_BAR_WIDTH; i++)
+			putchar(!stage->accum ? (i == from ? '|' : ' ') :
+				i >= from && (i < to || i == from) ? '=' : ' ');
+		printf("  %s\n", stage->name);
+	}
+
+	printf("\nAccumulated time:\n");
+	for (stage = list->stage; stage < end; stage++) {
+		if (stage->accum)
+			printf("%11s%11u  %s\n", "", stage->time_us,
+			       stage->name);
+	}
+
+	return 0;
+}
+
+/*
+ * Folded stacks for flamegraph.pl: a span that lies within another is
+ * its child, each frame is weighted by its own time. What the spans do
+ * not cover up to the last record is put down as "other".
+ */
+static int dump_flame(struct stage_list *list)
+{
+	struct stage_info *stage, *end = list->stage + list->count;
+	struct stage_info *stack[32];
+	uint32_t child[32];
+	uint32_t total = 0, covered = 0;
+	int depth = 0, i;
+
+	qsort(list->stage, list->count, sizeof(*stage), h_cmp_stage);
+	for (stage = list->stage; stage < end; stage++)
+		total = MAX(total, stage_end(stage));
+
+	for (stage = list->stage; stage <= end; stage++) {
+		/* close the spans this one is not inside */
+		while (depth && (stage == end || !stage->accum ||
+				 !stage->start_us ||
+				 stage_end(stage) > stage_end(stack[depth - 1]) ||
+				 stage->start_us >= stage_end(stack[depth - 1]))) {
+			depth--;
+			printf("uboot");
+			for (i = 0; i <= depth; i++)
+				printf(";%s", stack[i]->name);
+			printf(" %u\n", stack[depth]->time_us - MIN(child[depth],
+			       stack[depth]->time_us));
+			if (depth)
+				child[depth - 1] += stack[depth]->time_us;
+			else
+				covered += stack[depth]->time_us;
+		}
+		if (stage == end || !stage->accum || !stage->start_us)
+			continue;
+		if (depth == (int)(sizeof(stack) / sizeof(stack[0]))) {
+			error("Bootstage spans nested too deep\n");
+			return -1;
+		}
+		stack[depth] = stage;
+		child[depth++] = 0;
+	}
+	if (total > covered)
+		printf("uboot;other %u\n", total - covered);
+
+	return 0;
+}
+
+/* Per stage change in time against the baseline, worst first */
+static int h_cmp_delta(const void *v1, const void *v2)
+{
+	const int64_t *d1 = v1, *d2 = v2;
+
+	return d1[0] < d2[0] ? 1 : d1[0] > d2[0] ? -1 : 0;
+}
+
+static int diff_bootstage(struct stage_list *list, struct stage_list *base)
+{
+	int64_t (*delta)[2];
+	int i, j, n = 0;
+
+	if (!base->count) {
+		error("diff-bootstage needs baseline data, see -c\n");
 		return -1;
+	}
+
+	delta = calloc(list->count, sizeof(*delta));
+	assert(delta);
+	for (i = 0; i < list->count; i++) {
+		for (j = 0; j < base->count; j++) {
+			if (!strcmp(list->stage[i].name, base->stage[j].name))
+				break;
+		}
+		if (j == base->count)
+			continue;
+		delta[n][0] = (int64_t)list->stage[i].time_us -
+			      base->stage[j].time_us;
+		delta[n++][1] = i;
+	}
+	qsort(delta, n, sizeof(*delta), h_cmp_delta);
 
-	check_functions();
+	printf("%11s%11s%11s  %s\n", "Base", "Now", "Delta", "Stage");
+	for (i = 0; i < n; i++) {
+		struct stage_info *stage = &list->stage[delta[i][1]];
+
+		printf("%11u%11u%+11lld  %s%s\n",
+		       (uint32_t)(stage->time_us - delta[i][0]), stage->time_us,
+		       (long long)delta[i][0], stage->name,
+		       stage->accum ? "" : " (mark)");
+	}
+	free(delta);
+
+	return 0;
+}
+
+static int prof_tool(int argc, char *const argv[], const char *prof_fname,
+		     const char *map_fname, const char *trace_config_fname,
+		     const char *stage_fname, const char *base_fname)
+{
+	int err = 0, ftrace = 0, i;
+
+	for (i = 0; i < argc; i++)
+		ftrace |= !strcmp(argv[i], "dump-ftrace");
+
+	/* the bootstage commands do without the map */
+	if (ftrace) {
+		if (read_map_file(map_fname))
+			return -1;
+		if (prof_fname && read_profile_file(prof_fname))
+			return -1;
+		if (trace_config_fname &&
+		    read_trace_config_file(trace_config_fname))
+			return -1;
+
+		check_functions();
+	}
+	if (!stage_fname && argc > ftrace) {
+		error("Bootstage commands need -b\n");
+		return -1;
+	}
+	if (stage_fname && read_bootstage_file(&stages, stage_fname))
+		return -1;
+	if (base_fname && read_bootstage_file(&base_stages, base_fname))
+		return -1;
 
 	for (; argc; argc--, argv++) {
 		const char *cmd = *argv;
 
 		if (0 == strcmp(cmd, "dump-ftrace"))
 			err = make_ftrace();
+		else if (0 == strcmp(cmd, "dump-bootstage"))
+			err = dump_bootstage(&stages);
+		else if (0 == strcmp(cmd, "dump-flame"))
+			err = dump_flame(&stages);
+		else if (0 == strcmp(cmd, "diff-bootstage"))
+			err = diff_bootstage(&stages, &base_stages);
 		else
 			warn("Unknown command '%s'\n", cmd);
 	}
@@ -616,11 +961,21 @@ int main(int argc, char *argv[])
 	const char *map_fname	       = "System.map";
 	const char *prof_fname	       = NULL;
 	const char *trace_config_fname = NULL;
+	const char *stage_fname	       = NULL;
+	const char *base_fname	       = NULL;
 	int opt;
 
 	verbose = 2;
-	while ((opt = getopt(argc, argv, "m:p:t:v:")) != -1) {
+	while ((opt = getopt(argc, argv, "b:c:m:p:t:v:")) != -1) {
 		switch (opt) {
+		case 'b':
+			stage_fname = optarg;
+			break;
+
+		case 'c':
+			base_fname = optarg;
+			break;
+
 		case 'm':
 			map_fname = optarg;
 			break;
@@ -647,5 +1002,6 @@ int main(int argc, char *argv[])
 		usage();
 
 	debug("Debug enabled\n");
-	return prof_tool(argc, argv, prof_fname, map_fname, trace_config_fname);
+	return prof_tool(argc, argv, prof_fname, map_fname, trace_config_fname,
+			 stage_fname, base_fname);
 }